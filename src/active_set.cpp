@@ -0,0 +1,254 @@
+#include "active_set.h"
+#include "task_scheduler.h"
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    // one member's stiffness in reduced coordinates as W W^T, with W stored densely over the
+    // few reduced rows it touches
+    struct MemberFactor
+    {
+        std::vector<int> rows;
+        Eigen::MatrixXd w; // rows.size() x rank
+        Eigen::MatrixXd z; // K0^-1 W over all reduced DOFs (filled on first use per base)
+    };
+
+    void factor_member(const DofMap &map, const Beam &beam, MemberFactor &out)
+    {
+        out.rows.clear();
+        out.w.resize(0, 0);
+        out.z.resize(0, 0);
+        if (beam.k_matrix.rows() != 6)
+            return;
+
+        // reduced rows of the six element DOFs (sliders fold two onto one)
+        int local_row[6];
+        for (int a = 0; a < 6; ++a)
+        {
+            int g = beam.nodes[a / 3] * 3 + a % 3;
+            int r = map.index[g];
+            local_row[a] = -1;
+            if (r < 0)
+                continue;
+            auto it = std::find(out.rows.begin(), out.rows.end(), r);
+            local_row[a] = static_cast<int>(it - out.rows.begin());
+            if (it == out.rows.end())
+                out.rows.push_back(r);
+        }
+
+        // element matrix = V diag(lambda) V^T, positive semidefinite
+        Eigen::SelfAdjointEigenSolver<Matrix6d> eig(Matrix6d(beam.k_matrix));
+        double lambda_max = eig.eigenvalues().cwiseAbs().maxCoeff();
+        int rank = 0;
+        for (int k = 0; k < 6; ++k)
+        {
+            if (eig.eigenvalues()(k) > 1e-12 * lambda_max)
+                ++rank;
+        }
+
+        out.w = Eigen::MatrixXd::Zero(out.rows.size(), rank);
+        int col = 0;
+        for (int k = 0; k < 6; ++k)
+        {
+            if (eig.eigenvalues()(k) <= 1e-12 * lambda_max)
+                continue;
+            double root = std::sqrt(eig.eigenvalues()(k));
+            for (int a = 0; a < 6; ++a)
+            {
+                if (local_row[a] >= 0)
+                {
+                    int g = beam.nodes[a / 3] * 3 + a % 3;
+                    out.w(local_row[a], col) += map.scale[g] * root * eig.eigenvectors()(a, k);
+                }
+            }
+            ++col;
+        }
+    }
+
+    // axial elongation of member i from the global displacements
+    double elongation(const ElementCache &cache, int i, const Eigen::VectorXd &u)
+    {
+        int a = cache.n1[i] * 3;
+        int b = cache.n2[i] * 3;
+        return cache.c[i] * (u(b) - u(a)) + cache.s[i] * (u(b + 1) - u(a + 1));
+    }
+} // namespace
+
+SparseMatrix assemble_active(const DofMap &map, const std::vector<Beam> &beams, const std::vector<char> &active)
+{
+    std::vector<Matrix6d> element(beams.size());
+    for (size_t i = 0; i < beams.size(); ++i)
+    {
+        if (beams[i].k_matrix.rows() == 6 && (active.empty() || active[i]))
+            element[i] = beams[i].k_matrix;
+        else
+            element[i].setZero(); // kept as structural zeros
+    }
+    return assemble_reduced(map, beams, element);
+}
+
+int solve_active_set(const DofMap &map,
+                     const std::vector<Beam> &beams,
+                     const ElementCache &cache,
+                     const Eigen::VectorXd &forces,
+                     const ActiveSetOptions &options,
+                     SparseSolver &solver,
+                     Eigen::VectorXd &displacement,
+                     ActiveSetResults &out)
+{
+    out = ActiveSetResults();
+    int num_beams = static_cast<int>(beams.size());
+    out.active.assign(num_beams, 1);
+
+    std::vector<int> flagged;
+    for (int i = 0; i < num_beams; ++i)
+    {
+        if (beams[i].tension_only || beams[i].compression_only)
+            flagged.push_back(i);
+    }
+
+    Eigen::VectorXd F_r = map.restrict(forces);
+    Eigen::VectorXd u0 = solver.solve(F_r); // base solution, every member of `base` active
+    Eigen::VectorXd u_r = u0;
+    map.expand(u_r, displacement);
+    if (flagged.empty())
+    {
+        out.converged = true;
+        return 0;
+    }
+
+    std::vector<char> base(num_beams, 1); // active set the factorization holds
+    std::vector<MemberFactor> factors(num_beams);
+    std::vector<char> factored(num_beams, 0);
+
+    for (int iteration = 0; iteration < options.max_iterations; ++iteration)
+    {
+        // switch members whose elongation has the wrong sign (dead band of +-tolerance)
+        int switched = 0;
+        for (int i : flagged)
+        {
+            double tol = options.strain_tolerance * cache.length[i];
+            double d = elongation(cache, i, displacement);
+            bool wants_in = beams[i].tension_only ? d > tol : d < -tol;
+            bool wants_out = beams[i].tension_only ? d < -tol : d > tol;
+            if ((out.active[i] && wants_out) || (!out.active[i] && wants_in))
+            {
+                out.active[i] = !out.active[i];
+                ++switched;
+            }
+        }
+        int inactive = static_cast<int>(std::count(out.active.begin(), out.active.end(), 0));
+        out.inactive_history.push_back(inactive);
+        out.iterations = iteration + 1;
+        out.changes += switched;
+        if (switched == 0)
+        {
+            out.converged = true;
+            break;
+        }
+
+        // members that differ from the factored base: +1 added back, -1 removed
+        std::vector<int> changed;
+        int rank = 0;
+        for (int i : flagged)
+        {
+            if (out.active[i] == base[i])
+                continue;
+            if (!factored[i])
+            {
+                factor_member(map, beams[i], factors[i]);
+                factored[i] = 1;
+            }
+            changed.push_back(i);
+            rank += static_cast<int>(factors[i].w.cols());
+        }
+
+        if (rank > options.max_update_rank)
+        {
+            // too many switches for a cheap correction: refactor the current set and rebase
+            if (solver.factorize(assemble_active(map, beams, out.active)) != 0)
+            {
+                out.solver_current = false; // the failed refactor left no factorization
+                return -1;
+            }
+            ++out.refactorizations;
+            base = out.active;
+            for (int i : flagged)
+                factors[i].z.resize(0, 0);
+            u0 = solver.solve(F_r);
+            u_r = u0;
+            out.update_rank = 0;
+            map.expand(u_r, displacement);
+            continue;
+        }
+
+        // K0^-1 W for members switched for the first time since the last base
+        TaskScheduler::instance().parallel_for(
+            0, static_cast<int>(changed.size()), 1, [&](int lo, int hi)
+            {
+                Eigen::VectorXd column(map.num_reduced);
+                for (int c = lo; c < hi; ++c)
+                {
+                    MemberFactor &f = factors[changed[c]];
+                    if (f.z.cols() == f.w.cols())
+                        continue;
+                    f.z.resize(map.num_reduced, f.w.cols());
+                    for (int k = 0; k < f.w.cols(); ++k)
+                    {
+                        column.setZero();
+                        for (size_t r = 0; r < f.rows.size(); ++r)
+                            column(f.rows[r]) = f.w(r, k);
+                        f.z.col(k) = solver.solve(column);
+                    }
+                } },
+            TaskPriority::High, "active_set_update");
+
+        // (K0 + W S W^T)^-1 F = u0 - Z (S + W^T Z)^-1 W^T u0
+        Eigen::MatrixXd Z(map.num_reduced, rank);
+        Eigen::MatrixXd capacitance = Eigen::MatrixXd::Zero(rank, rank);
+        Eigen::VectorXd Wu(rank);
+        int offset = 0;
+        for (int i : changed)
+        {
+            const MemberFactor &f = factors[i];
+            int r = static_cast<int>(f.w.cols());
+            Z.middleCols(offset, r) = f.z;
+            Eigen::VectorXd u_rows(f.rows.size());
+            for (size_t row = 0; row < f.rows.size(); ++row)
+                u_rows(row) = u0(f.rows[row]);
+            Wu.segment(offset, r) = f.w.transpose() * u_rows;
+            double sign = out.active[i] ? 1.0 : -1.0;
+            capacitance.block(offset, offset, r, r).diagonal().setConstant(sign);
+            offset += r;
+        }
+        offset = 0;
+        for (int i : changed)
+        {
+            const MemberFactor &f = factors[i];
+            int r = static_cast<int>(f.w.cols());
+            Eigen::MatrixXd z_rows(f.rows.size(), rank);
+            for (size_t row = 0; row < f.rows.size(); ++row)
+                z_rows.row(row) = Z.row(f.rows[row]);
+            capacitance.middleRows(offset, r) += f.w.transpose() * z_rows;
+            offset += r;
+        }
+
+        // singular exactly when the switched K is; rcond() is blind to the scale of a small
+        // or diagonal capacitance, the smallest singular value against 1 is not
+        Eigen::JacobiSVD<Eigen::MatrixXd> svd(capacitance);
+        const Eigen::VectorXd &sigma = svd.singularValues();
+        if (rank > 0 && !(sigma(rank - 1) > options.mechanism_tolerance * std::max(1.0, sigma(0))))
+        {
+            out.solver_current = false; // still the factorization of `base`
+            return -1;                  // the switched set leaves a mechanism
+        }
+        Eigen::PartialPivLU<Eigen::MatrixXd> lu(capacitance);
+        u_r = u0 - Z * lu.solve(Wu);
+        out.update_rank = rank;
+        map.expand(u_r, displacement);
+    }
+
+    out.solver_current = (base == out.active);
+    return out.converged ? 0 : -2;
+}
@@ -0,0 +1,52 @@
+#pragma once
+#include <vector>
+#include <Eigen/Eigen>
+#include "dof_map.h"
+#include "element_cache.h"
+#include "sparse_solver.h"
+
+struct ActiveSetOptions
+{
+    int max_iterations = 50;
+    double strain_tolerance = 1e-12; // |elongation| / L treated as zero (no switching inside it)
+    int max_update_rank = 100;       // refactor instead once the Woodbury update grows past this
+    double mechanism_tolerance = 1e-9; // smallest singular value of the update's capacitance
+                                       // (relative to 1) below which the switched K is singular
+};
+
+struct ActiveSetResults
+{
+    std::vector<char> active;      // per beam; members without a flag are always active
+    int iterations = 0;
+    int changes = 0;               // member switches over all iterations
+    int refactorizations = 0;      // full numeric refactors (rank limit reached)
+    int update_rank = 0;           // rank of the final low-rank correction
+    std::vector<int> inactive_history; // inactive members after each iteration
+    bool solver_current = true;    // `solver` holds the factorization of the final active set
+                                   // (false whenever the solve failed)
+    bool converged = false;
+};
+
+// K in dof_map numbering with the inactive members left out; the pattern does not change, so
+// a SparseSolver refactors it without a new symbolic analysis
+SparseMatrix assemble_active(const DofMap &map, const std::vector<Beam> &beams, const std::vector<char> &active);
+
+// Static solve with tension-only / compression-only members. Starting from every member
+// active, members whose elongation has the wrong sign are dropped (and dropped members that
+// would stretch the right way come back) until the set stops changing.
+// `solver` must hold the factorization of K with every member active. A change of the set
+// is applied as a low-rank correction of that factorization: each switched member adds
+// +-W W^T with W from its element matrix (rank 1 for truss members), and the Sherman-Morrison-
+// Woodbury formula only needs K0^-1 W for the newly switched members plus a small dense
+// solve. When the correction exceeds options.max_update_rank the current set is refactored
+// and becomes the new base.
+// Returns 0 on success, -1 if the active set is a mechanism, -2 if the set kept changing
+// (the last iterate is left in `displacement`).
+int solve_active_set(const DofMap &map,
+                     const std::vector<Beam> &beams,
+                     const ElementCache &cache,
+                     const Eigen::VectorXd &forces,
+                     const ActiveSetOptions &options,
+                     SparseSolver &solver,
+                     Eigen::VectorXd &displacement,
+                     ActiveSetResults &out);
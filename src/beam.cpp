@@ -95,3 +95,139 @@ void Beam::compute_stiffness(const std::vector<Node> &node_list,
 
     k_matrix = T.transpose() * k_prime * T;
 }
+
+// mass matrix for modal and transient analysis
+void Beam::compute_mass(const std::vector<Node> &node_list,
+                        const std::vector<MaterialProfile> &materials,
+                        const std::vector<BeamProfile> &shapes,
+                        bool lumped)
+{
+    int n1 = nodes[0];
+    int n2 = nodes[1];
+
+    const MaterialProfile &material = materials[material_idx];
+    const BeamProfile &shape = shapes[shape_idx];
+
+    m_matrix = Eigen::MatrixXd::Zero(6, 6);
+
+    double dx = node_list[n2].position[0] - node_list[n1].position[0];
+    double dy = node_list[n2].position[1] - node_list[n1].position[1];
+    double L = std::sqrt(dx * dx + dy * dy);
+
+    if (L < 1e-9)
+        return; // zero-length element carries no mass
+
+    double m = material.density * shape.area * L; // total member mass
+    bool bending = !is_truss && shape.moment_of_inertia > 0.0;
+
+    if (lumped)
+    {
+        // HRZ lumping: diagonal of the consistent matrix scaled so each direction carries m.
+        // Translations are the same in x and y, so no rotation to global is needed.
+        m_matrix(0, 0) = m_matrix(1, 1) = m_matrix(3, 3) = m_matrix(4, 4) = 0.5 * m;
+        if (bending)
+            m_matrix(2, 2) = m_matrix(5, 5) = m * L * L / 78.0; // (4L^2 / 312) * m
+        return;
+    }
+
+    Eigen::MatrixXd m_prime = Eigen::MatrixXd::Zero(6, 6);
+
+    // Axial (Row/Col 0 and 3)
+    m_prime(0, 0) = m_prime(3, 3) = m / 3.0;
+    m_prime(0, 3) = m_prime(3, 0) = m / 6.0;
+
+    if (bending)
+    {
+        // Transverse/rotation (Rows/Cols 1, 2, 4, 5)
+        double scale = m / 420.0;
+        int idx[4] = {1, 2, 4, 5};
+        double mb[4][4] = {
+            {156.0, 22.0 * L, 54.0, -13.0 * L},
+            {22.0 * L, 4.0 * L * L, 13.0 * L, -3.0 * L * L},
+            {54.0, 13.0 * L, 156.0, -22.0 * L},
+            {-13.0 * L, -3.0 * L * L, -22.0 * L, 4.0 * L * L}};
+        for (int i = 0; i < 4; ++i)
+            for (int j = 0; j < 4; ++j)
+                m_prime(idx[i], idx[j]) = scale * mb[i][j];
+    }
+    else
+    {
+        // pin-ended bar: rigid translation only, same as the axial terms
+        m_prime(1, 1) = m_prime(4, 4) = m / 3.0;
+        m_prime(1, 4) = m_prime(4, 1) = m / 6.0;
+    }
+
+    double c = dx / L;
+    double s = dy / L;
+
+    Eigen::MatrixXd T = Eigen::MatrixXd::Zero(6, 6);
+    T(0, 0) = c;
+    T(0, 1) = s;
+    T(1, 0) = -s;
+    T(1, 1) = c;
+    T(2, 2) = 1.0;
+    T(3, 3) = c;
+    T(3, 4) = s;
+    T(4, 3) = -s;
+    T(4, 4) = c;
+    T(5, 5) = 1.0;
+
+    m_matrix = T.transpose() * m_prime * T;
+}
+
+// geometric stiffness for linear buckling
+void Beam::compute_geometric_stiffness(const std::vector<Node> &node_list, double P)
+{
+    int n1 = nodes[0];
+    int n2 = nodes[1];
+
+    kg_matrix = Eigen::MatrixXd::Zero(6, 6);
+
+    double dx = node_list[n2].position[0] - node_list[n1].position[0];
+    double dy = node_list[n2].position[1] - node_list[n1].position[1];
+    double L = std::sqrt(dx * dx + dy * dy);
+
+    if (L < 1e-9)
+        return;
+
+    Eigen::MatrixXd kg_prime = Eigen::MatrixXd::Zero(6, 6);
+
+    // a truss member has no rotational stiffness, so it only gets the string terms
+    bool bending = k_matrix.rows() == 6 && (k_matrix(2, 2) > 0.0 || k_matrix(5, 5) > 0.0);
+    if (bending)
+    {
+        // Transverse/rotation (Rows/Cols 1, 2, 4, 5)
+        double scale = P / (30.0 * L);
+        int idx[4] = {1, 2, 4, 5};
+        double kb[4][4] = {
+            {36.0, 3.0 * L, -36.0, 3.0 * L},
+            {3.0 * L, 4.0 * L * L, -3.0 * L, -L * L},
+            {-36.0, -3.0 * L, 36.0, -3.0 * L},
+            {3.0 * L, -L * L, -3.0 * L, 4.0 * L * L}};
+        for (int i = 0; i < 4; ++i)
+            for (int j = 0; j < 4; ++j)
+                kg_prime(idx[i], idx[j]) = scale * kb[i][j];
+    }
+    else
+    {
+        kg_prime(1, 1) = kg_prime(4, 4) = P / L;
+        kg_prime(1, 4) = kg_prime(4, 1) = -P / L;
+    }
+
+    double c = dx / L;
+    double s = dy / L;
+
+    Eigen::MatrixXd T = Eigen::MatrixXd::Zero(6, 6);
+    T(0, 0) = c;
+    T(0, 1) = s;
+    T(1, 0) = -s;
+    T(1, 1) = c;
+    T(2, 2) = 1.0;
+    T(3, 3) = c;
+    T(3, 4) = s;
+    T(4, 3) = -s;
+    T(4, 4) = c;
+    T(5, 5) = 1.0;
+
+    kg_matrix = T.transpose() * kg_prime * T;
+}
@@ -10,15 +10,22 @@ class Beam
 public:
     int nodes[2];
     double k;
+    // results, filled lazily by FEMSystem::get_stresses()
     double axial_force;
     double max_moment;
     bool is_truss; // true if the beam is a truss element (no bending) and we set moment of inertia to zero
+    // cables / bracing rods: the member drops out of the static solve when it would carry the
+    // other sign of axial force (see solve_active_set)
+    bool tension_only = false;
+    bool compression_only = false;
     float stress;
 
     int material_idx;
     int shape_idx;
 
     Eigen::MatrixXd k_matrix;
+    Eigen::MatrixXd m_matrix;  // global 6x6 mass matrix, filled by compute_mass
+    Eigen::MatrixXd kg_matrix; // global 6x6 geometric stiffness, filled by compute_geometric_stiffness
 
     Beam() : nodes{-1, -1}, k(0.0), stress(0.0f), material_idx(-1), shape_idx(-1), is_truss(true) // just keep is_truss to true for simplicity
     {
@@ -35,4 +42,15 @@ public:
     void compute_stiffness(const std::vector<Node> &node_list,
                            const std::vector<MaterialProfile> &materials,
                            const std::vector<BeamProfile> &shapes);
+
+    // consistent mass (cubic Hermitian bending, linear axial) or HRZ lumped mass.
+    // Truss members get the bar mass in both directions and no rotational inertia.
+    void compute_mass(const std::vector<Node> &node_list,
+                      const std::vector<MaterialProfile> &materials,
+                      const std::vector<BeamProfile> &shapes,
+                      bool lumped);
+
+    // geometric (stress) stiffness for an axial force P (tension positive): the consistent
+    // cubic form for beams, the string stiffness P/L for truss members
+    void compute_geometric_stiffness(const std::vector<Node> &node_list, double P);
 };
\ No newline at end of file
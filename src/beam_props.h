@@ -4,6 +4,7 @@ struct MaterialProfile
 {
     std::string name;
     double youngs_modulus;
+    double density = 7850.0; // kg/m^3 (steel unless set), drives the mass matrices
 };
 
 struct BeamProfile
@@ -12,4 +13,5 @@ struct BeamProfile
     double area;
     double moment_of_inertia;
     double section_modulus;
+    double plastic_moment = 0.0; // N m, capacity for pushover hinges (0: stays elastic)
 };
@@ -0,0 +1,43 @@
+#include "buckling_analysis.h"
+#include "eigen_solver.h"
+
+int extract_buckling_modes(const DofMap &map, const SparseMatrix &K, const SparseSolver &solver,
+                           const SparseMatrix &Kg, int count, BucklingResults &out)
+{
+    out.count = 0;
+    out.load_factors.clear();
+    out.shapes.resize(map.total_dof, 0);
+    out.converged = false;
+    out.iterations = 0;
+
+    if (map.num_reduced == 0 || count <= 0 || !solver.factored())
+        return -1;
+
+    LinearOperator op = [&](const Eigen::VectorXd &x, Eigen::VectorXd &y)
+    { y = solver.solve(-(Kg * x)); };
+    LinearOperator apply_k = [&](const Eigen::VectorXd &x, Eigen::VectorXd &y)
+    { y = K * x; };
+
+    // theta = 1 / lambda, so the largest theta are the lowest critical load factors
+    EigenResult eig;
+    int result = lanczos_largest(map.num_reduced, count, op, apply_k, eig);
+
+    for (int k = 0; k < eig.values.size(); ++k)
+    {
+        if (eig.values(k) <= 0.0)
+            break; // members in tension only stiffen, nothing left that can buckle
+
+        Eigen::VectorXd global;
+        map.expand(eig.vectors.col(k), global);
+        out.shapes.conservativeResize(map.total_dof, out.count + 1);
+        out.shapes.col(out.count) = global;
+        out.load_factors.push_back(1.0 / eig.values(k));
+        ++out.count;
+    }
+    out.converged = eig.converged;
+    out.iterations = eig.iterations;
+
+    if (out.count == 0)
+        return -1;
+    return result;
+}
@@ -0,0 +1,22 @@
+#pragma once
+#include <vector>
+#include <Eigen/Eigen>
+#include "dof_map.h"
+#include "sparse_solver.h"
+
+// Critical load factors and buckled shapes from the last FEMSystem::solve_buckling()
+struct BucklingResults
+{
+    int count = 0;
+    std::vector<double> load_factors; // ascending; the applied loads times this factor buckle the structure
+    Eigen::MatrixXd shapes;           // total_dof x count in global DOFs
+    bool converged = false;
+    int iterations = 0;
+};
+
+// Lowest positive load factors of (K + lambda Kg) phi = 0. Lanczos runs on K^-1 (-Kg) in the
+// K inner product, so the already factored static stiffness is all it needs: every step is a
+// pair of triangular solves with `solver`. Returns 0 on success, -1 if nothing is in
+// compression (no positive factor), -2 if the solver did not converge.
+int extract_buckling_modes(const DofMap &map, const SparseMatrix &K, const SparseSolver &solver,
+                           const SparseMatrix &Kg, int count, BucklingResults &out);
@@ -0,0 +1,181 @@
+#include "dof_map.h"
+#include "task_scheduler.h"
+#include <cmath>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+void DofMap::build(const std::vector<Node> &nodes, const std::vector<Beam> &beams)
+{
+    int num_nodes = static_cast<int>(nodes.size());
+    total_dof = num_nodes * 3;
+    index.assign(total_dof, -1);
+    scale.assign(total_dof, 0.0);
+
+    // which nodes have any member at all, and which have rotational stiffness
+    std::vector<char> connected(num_nodes, 0);
+    std::vector<char> rotation_stiff(num_nodes, 0);
+    for (const auto &beam : beams)
+    {
+        if (beam.k_matrix.rows() != 6)
+            continue;
+        connected[beam.nodes[0]] = 1;
+        connected[beam.nodes[1]] = 1;
+        if (beam.k_matrix(2, 2) > 0.0)
+            rotation_stiff[beam.nodes[0]] = 1;
+        if (beam.k_matrix(5, 5) > 0.0)
+            rotation_stiff[beam.nodes[1]] = 1;
+    }
+
+    int next = 0;
+    for (int i = 0; i < num_nodes; ++i)
+    {
+        int dof_x = i * 3;
+        int dof_y = i * 3 + 1;
+        int dof_theta = i * 3 + 2;
+
+        if (!connected[i])
+            continue; // a loose node has nothing to solve for
+
+        switch (nodes[i].constraint_type)
+        {
+        case Free:
+            index[dof_x] = next++;
+            scale[dof_x] = 1.0;
+            index[dof_y] = next++;
+            scale[dof_y] = 1.0;
+            break;
+        case Slider:
+        {
+            // one DOF along the track, same convention as generate_constraint_row
+            double theta = nodes[i].constraint_angle * M_PI / 180.0;
+            index[dof_x] = next;
+            scale[dof_x] = std::cos(theta);
+            index[dof_y] = next;
+            scale[dof_y] = std::sin(theta);
+            ++next;
+            break;
+        }
+        case FixedPin:
+        case Fixed:
+            break;
+        }
+
+        if (nodes[i].constraint_type != Fixed && rotation_stiff[i])
+        {
+            index[dof_theta] = next++;
+            scale[dof_theta] = 1.0;
+        }
+    }
+    num_reduced = next;
+}
+
+Eigen::VectorXd DofMap::restrict(const Eigen::VectorXd &global) const
+{
+    Eigen::VectorXd reduced = Eigen::VectorXd::Zero(num_reduced);
+    for (int d = 0; d < total_dof && d < global.size(); ++d)
+    {
+        if (index[d] >= 0)
+            reduced(index[d]) += scale[d] * global(d);
+    }
+    return reduced;
+}
+
+void DofMap::expand(const Eigen::VectorXd &reduced, Eigen::VectorXd &global) const
+{
+    global = Eigen::VectorXd::Zero(total_dof);
+    for (int d = 0; d < total_dof; ++d)
+    {
+        if (index[d] >= 0)
+            global(d) = scale[d] * reduced(index[d]);
+    }
+}
+
+namespace
+{
+    // T^T * (sum of element matrices) * T, with matrix_of(e) giving element e's global 6x6
+    // matrix (or nullptr to skip it). Zeros inside an element block are kept so the pattern
+    // only depends on the connectivity, which keeps the solver's symbolic analysis reusable.
+    template <typename MatrixOf>
+    SparseMatrix assemble_blocks(const DofMap &map, const std::vector<Beam> &beams, MatrixOf &&matrix_of)
+    {
+        typedef Eigen::Triplet<double> Triplet;
+        int num_beams = static_cast<int>(beams.size());
+
+        // visit the retained (i, j) entries of one element
+        auto for_each_entry = [&](int b, auto &&emit)
+        {
+            const auto *ke = matrix_of(b);
+            if (ke == nullptr)
+                return;
+
+            const Beam &beam = beams[b];
+            int dofs[6] = {beam.nodes[0] * 3, beam.nodes[0] * 3 + 1, beam.nodes[0] * 3 + 2,
+                           beam.nodes[1] * 3, beam.nodes[1] * 3 + 1, beam.nodes[1] * 3 + 2};
+            for (int i = 0; i < 6; ++i)
+            {
+                int ri = map.index[dofs[i]];
+                if (ri < 0)
+                    continue;
+                for (int j = 0; j < 6; ++j)
+                {
+                    int rj = map.index[dofs[j]];
+                    if (rj < 0)
+                        continue;
+                    emit(ri, rj, map.scale[dofs[i]] * map.scale[dofs[j]] * (*ke)(i, j));
+                }
+            }
+        };
+
+        // count, prefix sum, then every beam fills its own slice of the triplet list in parallel
+        std::vector<int> offsets(num_beams + 1, 0);
+        TaskScheduler::instance().parallel_for(
+            0, num_beams, 2048, [&](int lo, int hi)
+            {
+                for (int b = lo; b < hi; ++b)
+                {
+                    int n = 0;
+                    for_each_entry(b, [&n](int, int, double)
+                                   { ++n; });
+                    offsets[b + 1] = n;
+                } },
+            TaskPriority::High, "sparse_assembly");
+        for (int b = 0; b < num_beams; ++b)
+            offsets[b + 1] += offsets[b];
+
+        std::vector<Triplet> triplets(offsets[num_beams]);
+        TaskScheduler::instance().parallel_for(
+            0, num_beams, 2048, [&](int lo, int hi)
+            {
+                for (int b = lo; b < hi; ++b)
+                {
+                    int k = offsets[b];
+                    for_each_entry(b, [&](int r, int c, double v)
+                                   { triplets[k++] = Triplet(r, c, v); });
+                } },
+            TaskPriority::High, "sparse_assembly");
+
+        SparseMatrix K(map.num_reduced, map.num_reduced);
+        K.setFromTriplets(triplets.begin(), triplets.end()); // duplicates are summed
+        return K;
+    }
+} // namespace
+
+SparseMatrix assemble_reduced(const DofMap &map,
+                              const std::vector<Beam> &beams,
+                              Eigen::MatrixXd Beam::*member)
+{
+    return assemble_blocks(map, beams, [&](int b) -> const Eigen::MatrixXd *
+                           {
+                               const Eigen::MatrixXd &ke = beams[b].*member;
+                               return ke.rows() == 6 ? &ke : nullptr; });
+}
+
+SparseMatrix assemble_reduced(const DofMap &map,
+                              const std::vector<Beam> &beams,
+                              const std::vector<Matrix6d> &element_matrices)
+{
+    return assemble_blocks(map, beams, [&](int b)
+                           { return &element_matrices[b]; });
+}
@@ -0,0 +1,41 @@
+#pragma once
+#include <vector>
+#include <Eigen/Eigen>
+#include <Eigen/Sparse>
+#include "node.h"
+#include "beam.h"
+
+typedef Eigen::SparseMatrix<double> SparseMatrix;
+typedef Eigen::Matrix<double, 6, 6> Matrix6d;
+
+// Numbering of the equations the sparse solvers work on. Every global DOF maps to at most
+// one reduced DOF times a scale factor (u_global = scale * u_reduced):
+//  - fixed DOFs are dropped,
+//  - a slider keeps one translation along its track (u = c * a, v = s * a), which removes
+//    the constraint rows of the dense saddle-point solve altogether,
+//  - rotations no member is stiff against (nodes reached only by truss members) are dropped
+//    so the reduced stiffness stays positive definite.
+struct DofMap
+{
+    int total_dof = 0;
+    int num_reduced = 0;
+    std::vector<int> index;    // global dof -> reduced dof, -1 if eliminated
+    std::vector<double> scale; // global dof = scale * reduced dof
+
+    // needs the element stiffness matrices to tell which rotations are restrained
+    void build(const std::vector<Node> &nodes, const std::vector<Beam> &beams);
+
+    Eigen::VectorXd restrict(const Eigen::VectorXd &global) const;             // T^T * global
+    void expand(const Eigen::VectorXd &reduced, Eigen::VectorXd &global) const; // global = T * reduced
+};
+
+// T^T * (sum of element matrices) * T in compressed column form. `member` picks which
+// element matrix to assemble (&Beam::k_matrix or &Beam::m_matrix).
+SparseMatrix assemble_reduced(const DofMap &map,
+                              const std::vector<Beam> &beams,
+                              Eigen::MatrixXd Beam::*member);
+
+// same, from one global 6x6 matrix per beam kept outside the Beam objects (e.g. tangents)
+SparseMatrix assemble_reduced(const DofMap &map,
+                              const std::vector<Beam> &beams,
+                              const std::vector<Matrix6d> &element_matrices);
@@ -0,0 +1,217 @@
+#include "eigen_solver.h"
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+namespace
+{
+    // deterministic start vector so repeated runs give identical modes
+    Eigen::VectorXd start_vector(int n, unsigned int seed)
+    {
+        Eigen::VectorXd v(n);
+        unsigned int state = 2463534242u ^ (seed * 747796405u);
+        for (int i = 0; i < n; ++i)
+        {
+            state ^= state << 13;
+            state ^= state >> 17;
+            state ^= state << 5;
+            v(i) = static_cast<double>(state) / 4294967296.0 - 0.5;
+        }
+        return v;
+    }
+
+    // remove the components of w along the first m basis vectors (B inner product), twice
+    void reorthogonalize(const Eigen::MatrixXd &Q, int m, const LinearOperator &apply_b,
+                         Eigen::VectorXd &w, Eigen::VectorXd &bw)
+    {
+        for (int pass = 0; pass < 2; ++pass)
+        {
+            apply_b(w, bw);
+            Eigen::VectorXd c = Q.leftCols(m).transpose() * bw;
+            w.noalias() -= Q.leftCols(m) * c;
+        }
+    }
+} // namespace
+
+int lanczos_largest(int n, int count, const LinearOperator &op, const LinearOperator &apply_b,
+                    EigenResult &out, int max_basis, double tol)
+{
+    out = EigenResult();
+    count = std::min(count, n);
+    if (count <= 0)
+        return 0;
+
+    if (max_basis <= 0)
+        max_basis = std::max(2 * count + 20, count + 40);
+    max_basis = std::max(std::min(max_basis, n), count);
+
+    Eigen::MatrixXd Q(n, max_basis);
+    std::vector<double> alpha;
+    std::vector<double> beta; // beta[j] couples q_j and q_j+1
+    Eigen::VectorXd q(n), w(n), bq(n), bw(n);
+
+    // pushing the start vector through the operator once strips any part in the null space of B
+    op(start_vector(n, 1), q);
+    apply_b(q, bq);
+    double norm = std::sqrt(std::max(q.dot(bq), 0.0));
+    if (norm <= 0.0)
+        return -2;
+    q /= norm;
+
+    Eigen::VectorXd theta;
+    Eigen::MatrixXd S;
+    double alpha_scale = 0.0;
+    int m = 0;
+
+    while (m < max_basis)
+    {
+        Q.col(m) = q;
+        op(q, w);
+        apply_b(q, bq);
+
+        double a = bq.dot(w);
+        alpha_scale = std::max(alpha_scale, std::abs(a));
+        w -= a * q;
+        if (m > 0)
+            w -= beta[m - 1] * Q.col(m - 1);
+        reorthogonalize(Q, m + 1, apply_b, w, bw);
+
+        apply_b(w, bw);
+        double b = std::sqrt(std::max(w.dot(bw), 0.0));
+        alpha.push_back(a);
+        ++m;
+
+        bool breakdown = b <= 1e-12 * alpha_scale;
+
+        // Ritz values of the tridiagonal projection, checked every few steps
+        if (m >= count && (m % 4 == 0 || m == max_basis || breakdown))
+        {
+            Eigen::MatrixXd T = Eigen::MatrixXd::Zero(m, m);
+            for (int j = 0; j < m; ++j)
+            {
+                T(j, j) = alpha[j];
+                if (j + 1 < m)
+                    T(j, j + 1) = T(j + 1, j) = beta[j];
+            }
+            Eigen::SelfAdjointEigenSolver<Eigen::MatrixXd> es(T);
+            theta = es.eigenvalues(); // ascending
+            S = es.eigenvectors();
+
+            // residual of a Ritz pair is |b * last component of its eigenvector|
+            bool all_converged = true;
+            for (int i = m - 1; i >= m - count; --i)
+            {
+                double res = std::abs(b * S(m - 1, i));
+                if (res > tol * std::max(std::abs(theta(i)), 1e-300))
+                {
+                    all_converged = false;
+                    break;
+                }
+            }
+            out.converged = all_converged && !breakdown;
+            if (out.converged)
+                break;
+        }
+
+        if (m == max_basis)
+        {
+            // a basis spanning the whole space is exact
+            out.converged = out.converged || m == n;
+            break;
+        }
+
+        if (breakdown)
+        {
+            // invariant subspace found (e.g. a disconnected part of the model): carry on with a
+            // fresh direction orthogonal to everything so far
+            op(start_vector(n, m + 1), w);
+            reorthogonalize(Q, m, apply_b, w, bw);
+            apply_b(w, bw);
+            double fresh = std::sqrt(std::max(w.dot(bw), 0.0));
+            if (fresh <= 1e-12 * alpha_scale)
+            {
+                out.converged = m >= count;
+                break; // the whole range of the operator is spanned
+            }
+            beta.push_back(0.0);
+            q = w / fresh;
+        }
+        else
+        {
+            beta.push_back(b);
+            q = w / b;
+        }
+    }
+
+    out.iterations = m;
+    if (S.cols() != m)
+    {
+        Eigen::MatrixXd T = Eigen::MatrixXd::Zero(m, m);
+        for (int j = 0; j < m; ++j)
+        {
+            T(j, j) = alpha[j];
+            if (j + 1 < m)
+                T(j, j + 1) = T(j + 1, j) = beta[j];
+        }
+        Eigen::SelfAdjointEigenSolver<Eigen::MatrixXd> es(T);
+        theta = es.eigenvalues();
+        S = es.eigenvectors();
+    }
+
+    int found = std::min(count, m);
+    out.values.resize(found);
+    out.vectors.resize(n, found);
+    for (int k = 0; k < found; ++k)
+    {
+        int i = m - 1 - k; // largest first
+        out.values(k) = theta(i);
+        out.vectors.col(k) = Q.leftCols(m) * S.col(i);
+    }
+    return out.converged ? 0 : -2;
+}
+
+int shift_invert_eigs(const SparseMatrix &K, const SparseMatrix &M, int count, double shift,
+                      EigenResult &out)
+{
+    out = EigenResult();
+    int n = static_cast<int>(K.rows());
+    if (n == 0 || count <= 0)
+        return 0;
+
+    SparseMatrix A = K - shift * M;
+    Eigen::SimplicialLDLT<SparseMatrix> ldlt(A);
+    if (ldlt.info() != Eigen::Success)
+        return -1;
+
+    Eigen::VectorXd D = ldlt.vectorD().cwiseAbs();
+    if (D.minCoeff() <= 1e-13 * D.maxCoeff())
+        return -1;
+
+    LinearOperator op = [&](const Eigen::VectorXd &x, Eigen::VectorXd &y)
+    { y = ldlt.solve(M * x); };
+    LinearOperator apply_m = [&](const Eigen::VectorXd &x, Eigen::VectorXd &y)
+    { y = M * x; };
+
+    EigenResult theta;
+    int rc = lanczos_largest(n, count, op, apply_m, theta);
+
+    // theta = 1 / (lambda - shift); the largest theta are the eigenvalues just above the shift
+    int found = static_cast<int>(theta.values.size());
+    std::vector<int> order;
+    for (int k = 0; k < found; ++k)
+    {
+        if (theta.values(k) > 0.0)
+            order.push_back(k);
+    }
+
+    out.values.resize(order.size());
+    out.vectors.resize(n, order.size());
+    for (size_t k = 0; k < order.size(); ++k)
+    {
+        out.values(k) = shift + 1.0 / theta.values(order[k]);
+        out.vectors.col(k) = theta.vectors.col(order[k]);
+    }
+    out.iterations = theta.iterations;
+    out.converged = theta.converged;
+    return rc;
+}
@@ -0,0 +1,29 @@
+#pragma once
+#include <functional>
+#include <Eigen/Eigen>
+#include "dof_map.h"
+
+typedef std::function<void(const Eigen::VectorXd &, Eigen::VectorXd &)> LinearOperator;
+
+struct EigenResult
+{
+    Eigen::VectorXd values;  // order given by the function that filled it
+    Eigen::MatrixXd vectors; // one column per value, B-orthonormal
+    int iterations = 0;      // Lanczos steps taken
+    bool converged = false;
+};
+
+// Lanczos with full reorthogonalization for the `count` algebraically largest eigenvalues of
+// an operator that is self-adjoint in the inner product <x, y> = x^T B y (B positive
+// semi-definite). The basis grows until the residual estimates of all wanted pairs drop
+// below `tol` or `max_basis` vectors are in use. Values come back largest first here.
+// Returns 0 on success, -2 if it ran out of basis before converging (results still filled).
+int lanczos_largest(int n, int count, const LinearOperator &op, const LinearOperator &apply_b,
+                    EigenResult &out, int max_basis = 0, double tol = 1e-10);
+
+// Lowest `count` eigenpairs of K x = lambda M x above `shift` by shift-invert Lanczos on
+// (K - shift M)^-1 M. Only one sparse LDL^T factorization is done; every Lanczos step is a
+// pair of triangular solves. Returns 0 on success, -1 if K - shift M could not be factored
+// (singular: pick a shift below the lowest eigenvalue), -2 if not converged.
+int shift_invert_eigs(const SparseMatrix &K, const SparseMatrix &M, int count, double shift,
+                      EigenResult &out);
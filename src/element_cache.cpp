@@ -0,0 +1,105 @@
+#include "element_cache.h"
+#include "task_scheduler.h"
+#include <atomic>
+#include <cmath>
+
+void ElementCache::build(const std::vector<Node> &nodes,
+                         const std::vector<Beam> &beams,
+                         const std::vector<MaterialProfile> &materials,
+                         const std::vector<BeamProfile> &shapes)
+{
+    bool same_count = (count == static_cast<int>(beams.size()));
+    count = static_cast<int>(beams.size());
+    std::atomic<bool> topology_changed{!same_count};
+
+    n1.resize(count);
+    n2.resize(count);
+    length.resize(count);
+    c.resize(count);
+    s.resize(count);
+    ea_over_l.resize(count);
+    ei_over_l.resize(count);
+    inv_area.resize(count);
+    inv_section_modulus.resize(count);
+
+    TaskScheduler::instance().parallel_for(
+        0, count, 1024, [&](int lo, int hi)
+        {
+            for (int i = lo; i < hi; ++i)
+            {
+                const Beam &beam = beams[i];
+                const MaterialProfile &material = materials[beam.material_idx];
+                const BeamProfile &shape = shapes[beam.shape_idx];
+
+                if (n1[i] != beam.nodes[0] || n2[i] != beam.nodes[1])
+                {
+                    topology_changed.store(true, std::memory_order_relaxed);
+                    n1[i] = beam.nodes[0];
+                    n2[i] = beam.nodes[1];
+                }
+
+                double dx = nodes[n2[i]].position[0] - nodes[n1[i]].position[0];
+                double dy = nodes[n2[i]].position[1] - nodes[n1[i]].position[1];
+                double L = std::sqrt(dx * dx + dy * dy);
+                length[i] = L;
+
+                double E = material.youngs_modulus;
+                double I = beam.is_truss ? 0.0 : shape.moment_of_inertia;
+
+                if (L < 1e-9)
+                {
+                    // zero-length element carries no load (matches compute_stiffness)
+                    c[i] = 1.0;
+                    s[i] = 0.0;
+                    ea_over_l[i] = 0.0;
+                    ei_over_l[i] = 0.0;
+                }
+                else
+                {
+                    c[i] = dx / L;
+                    s[i] = dy / L;
+                    ea_over_l[i] = E * shape.area / L;
+                    ei_over_l[i] = E * I / L;
+                }
+
+                inv_area[i] = 1.0 / shape.area;
+                inv_section_modulus[i] = (std::abs(shape.section_modulus) < 1e-12) ? 0.0 : 1.0 / shape.section_modulus;
+            } },
+        TaskPriority::High, "element_cache");
+
+    int num_nodes = static_cast<int>(nodes.size());
+    if (topology_changed.load() || static_cast<int>(node_offsets.size()) != num_nodes + 1)
+        build_adjacency(num_nodes);
+}
+
+void ElementCache::build_adjacency(int num_nodes)
+{
+    // counting sort of element ends by node
+    node_offsets.assign(num_nodes + 1, 0);
+    for (int i = 0; i < count; ++i)
+    {
+        node_offsets[n1[i] + 1]++;
+        node_offsets[n2[i] + 1]++;
+    }
+    for (int n = 0; n < num_nodes; ++n)
+        node_offsets[n + 1] += node_offsets[n];
+
+    node_ends.resize(2 * count);
+    std::vector<int> fill(node_offsets.begin(), node_offsets.end() - 1);
+    for (int i = 0; i < count; ++i)
+    {
+        node_ends[fill[n1[i]]++] = 2 * i;
+        node_ends[fill[n2[i]]++] = 2 * i + 1;
+    }
+}
+
+void ElementForces::resize(int count)
+{
+    p1.resize(count);
+    v1.resize(count);
+    m1.resize(count);
+    p2.resize(count);
+    v2.resize(count);
+    m2.resize(count);
+    stress.resize(count);
+}
@@ -0,0 +1,49 @@
+#pragma once
+#include <vector>
+#include "node.h"
+#include "beam.h"
+#include "beam_props.h"
+
+// Structure-of-arrays copy of everything post-processing needs to know about each beam.
+// Built once per static solve (or on first use after the model changes) so result recovery
+// can stream over contiguous arrays instead of chasing Node/Beam/profile objects and
+// rebuilding T per element.
+struct ElementCache
+{
+    int count = 0;
+
+    std::vector<int> n1, n2; // node indices
+
+    // geometry (direction cosines are cached so L, c and s are never recomputed)
+    std::vector<double> length;
+    std::vector<double> c, s;
+
+    // local stiffness terms: EA/L and EI/L (EI is zero for truss members)
+    std::vector<double> ea_over_l;
+    std::vector<double> ei_over_l;
+
+    // section data for stress evaluation; inv_section_modulus is 0 when the profile has none
+    std::vector<double> inv_area;
+    std::vector<double> inv_section_modulus;
+
+    // node -> incident element ends in CSR form, rebuilt only when the connectivity changes.
+    // node_ends holds 2 * element + end (end 0 = n1, end 1 = n2) for each node in turn.
+    std::vector<int> node_offsets;
+    std::vector<int> node_ends;
+
+    void build(const std::vector<Node> &nodes,
+               const std::vector<Beam> &beams,
+               const std::vector<MaterialProfile> &materials,
+               const std::vector<BeamProfile> &shapes);
+    void build_adjacency(int num_nodes);
+};
+
+// Local end forces {P1, V1, M1, P2, V2, M2} and combined stress per beam, also stored SoA.
+struct ElementForces
+{
+    std::vector<double> p1, v1, m1;
+    std::vector<double> p2, v2, m2;
+    std::vector<float> stress;
+
+    void resize(int count);
+};
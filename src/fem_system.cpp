@@ -9,12 +9,18 @@
 #endif
 
 #include "fem_system.h"
+#include "task_scheduler.h"
+#include <algorithm>
+#include <iomanip>
+#include <map>
+#include <sstream>
 
 // Unit conversion constants
 static constexpr double METERS_PER_FOOT = 0.3048;
 static constexpr double METERS_PER_INCH = 0.0254;
 static constexpr double NEWTONS_PER_POUND_FORCE = 4.4482216152605; // 1 lbf = 4.44822 N
 static constexpr double PASCAL_PER_PSI = 6894.757293168;           // 1 psi = 6894.757293168 Pa
+static constexpr double KILOGRAMS_PER_POUND = 0.45359237;
 
 FEMSystem::FEMSystem(std::vector<Node> &n, std::vector<Beam> &s, std::vector<MaterialProfile> &materials, std::vector<BeamProfile> &beam_profiles)
 
@@ -172,6 +178,39 @@ double FEMSystem::stressFromDisplay(double display) const
     return display * PASCAL_PER_PSI;
 }
 
+double FEMSystem::densityToDisplay(double kg_m3) const
+{
+    if (unit_system == Metric)
+        return kg_m3;
+    if (unit_system == ImperialFeet)
+        return kg_m3 / KILOGRAMS_PER_POUND * METERS_PER_FOOT * METERS_PER_FOOT * METERS_PER_FOOT; // lb/ft^3
+    return kg_m3 / KILOGRAMS_PER_POUND * METERS_PER_INCH * METERS_PER_INCH * METERS_PER_INCH;     // lb/in^3
+}
+
+double FEMSystem::densityFromDisplay(double display) const
+{
+    if (unit_system == Metric)
+        return display;
+    if (unit_system == ImperialFeet)
+        return display * KILOGRAMS_PER_POUND / (METERS_PER_FOOT * METERS_PER_FOOT * METERS_PER_FOOT);
+    return display * KILOGRAMS_PER_POUND / (METERS_PER_INCH * METERS_PER_INCH * METERS_PER_INCH);
+}
+
+double FEMSystem::momentToDisplay(double Nm) const
+{
+    return forceToDisplay(lengthToDisplay(Nm)); // N m, lbf ft or lbf in
+}
+
+double FEMSystem::momentFromDisplay(double display) const
+{
+    return forceFromDisplay(lengthFromDisplay(display));
+}
+
+double FEMSystem::massToDisplay(double kg) const
+{
+    return unit_system == Metric ? kg : kg / KILOGRAMS_PER_POUND; // kg or lb
+}
+
 // MPC (Multi-Point Constraint) for slider nodes
 // This generates a constraint equation: a_x * u + a_y * v = 0
 // which means displacement perpendicular to the slider direction is zero
@@ -211,6 +250,9 @@ void FEMSystem::generate_constraint_row(Eigen::MatrixXd &C, int row_index, int i
 //  attempt to solve the system
 int FEMSystem::solve_system()
 {
+    // only displacements are produced here; everything else is recovered on demand
+    invalidate_results();
+
     int num_nodes = static_cast<int>(nodes.size());
     if (num_nodes * 3 != total_dof) // check if total_dof needs updating
     {
@@ -221,13 +263,161 @@ int FEMSystem::solve_system()
         forces.conservativeResize(total_dof);
     }
 
-    // step 1 - compute stiffness matrices for each spring
-    for (auto &beam : beams)
+    // step 1 - compute stiffness matrices for each spring (independent per beam, so run in parallel)
+    TaskScheduler::instance().parallel_for(
+        0, static_cast<int>(beams.size()), 256, [this](int lo, int hi)
+        {
+            for (int i = lo; i < hi; ++i)
+                beams[i].compute_stiffness(nodes, materials_list, beam_profiles_list); },
+        TaskPriority::High, "element_stiffness");
+
+    // the post-processing copy of the same geometry and sections, kept until the model changes
+    element_cache.build(nodes, beams, materials_list, beam_profiles_list);
+    element_cache_valid = true;
+
+    // remember the supports so reactions only have to be recovered there
+    supported_nodes.clear();
+    bool all_fixed = true;
+    for (int i = 0; i < num_nodes; ++i)
+    {
+        if (nodes[i].constraint_type != Free)
+            supported_nodes.push_back(i);
+        if (nodes[i].constraint_type != Fixed)
+            all_fixed = false;
+    }
+
+    if (all_fixed)
+    {
+        if (debug)
+            std::cout << "No free DOFs to solve!" << std::endl;
+        return -1;
+    }
+
+    // step 2 - sparse reduced stiffness: fixed DOFs dropped, sliders reduced to their track
+    // direction, rotations without any stiffness behind them left out
+    dof_map.build(nodes, beams);
+    if (dof_map.num_reduced == 0)
+    {
+        displacement = Eigen::VectorXd::Zero(total_dof);
+        return 0;
+    }
+    reduced_stiffness = assemble_reduced(dof_map, beams, &Beam::k_matrix);
+    Eigen::VectorXd F_r = dof_map.restrict(forces);
+
+    // tension-only / compression-only members need the active-set iteration
+    bool one_way = false;
+    for (const Beam &beam : beams)
+        one_way |= beam.tension_only || beam.compression_only;
+    active_set_results = ActiveSetResults();
+
+    // step 3 - factor (the symbolic analysis is kept while the sparsity pattern is unchanged) and solve
+    if (static_solver.factorize(reduced_stiffness) == 0)
+    {
+        if (one_way)
+        {
+            int result = solve_active_set(dof_map, beams, element_cache, forces, active_set_options, static_solver,
+                                          displacement, active_set_results);
+            member_active = active_set_results.active;
+
+            // K of the final set, so buckling and later refactors see the slack members removed
+            if (std::count(member_active.begin(), member_active.end(), 0) > 0)
+                reduced_stiffness = assemble_active(dof_map, beams, member_active);
+
+            if (debug)
+                std::cout << "Active set: " << active_set_results.iterations << " iterations, "
+                          << active_set_results.changes << " switches, " << active_set_results.refactorizations
+                          << " refactorizations, final update rank " << active_set_results.update_rank << std::endl;
+            if (result != 0)
+                return result == -1 ? -3 : -4;
+        }
+        else
+        {
+            Eigen::VectorXd u_r = static_solver.solve(F_r);
+            dof_map.expand(u_r, displacement);
+        }
+
+        if (debug)
+            std::cout << "Sparse LDL^T solve: " << dof_map.num_reduced << " equations, "
+                      << reduced_stiffness.nonZeros() << " nonzeros" << std::endl;
+    }
+    else
+    {
+        // singular (a mechanism): fall back to the dense pivoted solve
+        if (debug)
+            std::cout << "Reduced stiffness is singular, using the dense solver" << std::endl;
+        int result = solve_dense();
+        if (result != 0)
+            return result;
+
+        // the dense solve has every member active, so the one-way flags were not applied
+        if (one_way)
+        {
+            if (debug)
+                std::cout << "Tension-/compression-only members ignored by the dense solve" << std::endl;
+            member_active.clear();
+            return -3;
+        }
+    }
+
+    // Print solution summary
+    if (debug)
     {
-        beam.compute_stiffness(nodes, materials_list, beam_profiles_list);
+        std::cout << "\n=== SOLUTION ===\n";
+        for (int i = 0; i < num_nodes; ++i)
+        {
+            // The three DOFs for node i are at indices i*3, i*3+1, and i*3+2
+            double u = displacement(i * 3);             // x-displacement
+            double v = displacement(i * 3 + 1);         // y-displacement
+            double theta_rad = displacement(i * 3 + 2); // Rotation (in radians)
+
+            // Convert rotation to degrees for readability
+            double theta_deg = theta_rad * 180.0 / M_PI;
+
+            double total_disp_mag = std::sqrt(u * u + v * v);
+
+            // Updated output includes rotation
+            std::cout << "  Node " << i << ": u=" << u << " m, v=" << v << " m, theta=" << theta_deg << " deg (total disp=" << total_disp_mag << " m)\n";
+
+            if (nodes[i].constraint_type == Slider)
+            {
+                // The stored angle in the node is the direction *along* the slider.
+                double slider_angle_rad = nodes[i].constraint_angle * static_cast<double>(M_PI) / 180.0f;
+
+                // Direction cosines of the slider track
+                double c_track = std::cos(slider_angle_rad);
+                double s_track = std::sin(slider_angle_rad);
+
+                // 1. Movement along the slider track (dot product of displacement vector and track vector)
+                double along_slider = u * c_track + v * s_track;
+
+                // 2. Movement perpendicular to the slider track (dot product of displacement and normal vector)
+                // Note: The normal vector cosines are ( -s_track, c_track )
+                double perp_slider = -u * s_track + v * c_track;
+
+                // The total displacement of the node should be explained as movement along the track.
+                std::cout << "    Movement along track (" << nodes[i].constraint_angle << "°): " << along_slider << " m\n";
+
+                // The perpendicular movement should be very close to zero if the constraint worked.
+                std::cout << "    Movement perpendicular to track: " << perp_slider << " m (should be ~0)\n";
+            }
+        }
+
+        // debug runs want the full report, so pull every view now
+        get_stresses();
+        get_reactions();
+        get_stations();
     }
 
-    // step 2 - assemble global stiffness matrix
+    return 0;
+}
+
+// Dense solve of the full system with Lagrange multipliers for the sliders. Only used when
+// the sparse reduced stiffness is singular, because full pivoting copes with mechanisms.
+int FEMSystem::solve_dense()
+{
+    int num_nodes = static_cast<int>(nodes.size());
+
+    // assemble global stiffness matrix
     assemble_global_stiffness();
 
     // step 3 Identify free DOFs (not FixedPin nodes)
@@ -376,67 +566,59 @@ int FEMSystem::solve_system()
         // Debugging to determine the condition number if this is
 
         // stupid high we know the system is ill-conditioned
-
-        // Compute a robust approximate condition number for the augmented (saddle) system
-        // (accounts for 3 DOF per node; uses largest / smallest non-negligible singular value)
-        Eigen::JacobiSVD<Eigen::MatrixXd> svd(saddle_matrix, Eigen::ComputeThinU | Eigen::ComputeThinV);
-        Eigen::VectorXd sv = svd.singularValues();
-
-        double cond = std::numeric_limits<double>::infinity();
-        if (sv.size() > 0)
+        // (the SVD is far more expensive than the solve itself, so only in debug builds of a run)
+        if (debug)
         {
-            double smax = sv(0);
-            // find smallest non-negligible singular value to avoid divide-by-zero/noise
-            const double tol = 1e-16;
-            double smin = 0.0;
-            for (int i = sv.size() - 1; i >= 0; --i)
+            // Compute a robust approximate condition number for the augmented (saddle) system
+            // (accounts for 3 DOF per node; uses largest / smallest non-negligible singular value)
+            Eigen::JacobiSVD<Eigen::MatrixXd> svd(saddle_matrix, Eigen::ComputeThinU | Eigen::ComputeThinV);
+            Eigen::VectorXd sv = svd.singularValues();
+
+            double cond = std::numeric_limits<double>::infinity();
+            if (sv.size() > 0)
             {
-                if (sv(i) > tol)
+                double smax = sv(0);
+                // find smallest non-negligible singular value to avoid divide-by-zero/noise
+                const double tol = 1e-16;
+                double smin = 0.0;
+                for (int i = sv.size() - 1; i >= 0; --i)
                 {
-                    smin = sv(i);
-                    break;
+                    if (sv(i) > tol)
+                    {
+                        smin = sv(i);
+                        break;
+                    }
                 }
+                if (smin > 0.0)
+                    cond = smax / smin;
             }
-            if (smin > 0.0)
-                cond = smax / smin;
-        }
 
-        if (std::isfinite(cond))
-            if (debug)
+            if (std::isfinite(cond))
                 std::cout << "Saddle approx cond num: " << cond << std::endl;
-            else if (debug)
+            else
                 std::cout << "Saddle approx cond num: INF or ill-conditioned (smallest singular value ~ 0)" << std::endl;
 
-        if (debug)
             std::cout << "Node constraint types:\n";
-        for (int i = 0; i < num_nodes; ++i)
-            if (debug)
+            for (int i = 0; i < num_nodes; ++i)
                 std::cout << "  Node " << i << " type=" << nodes[i].constraint_type << " angle=" << nodes[i].constraint_angle << "\n";
 
-        if (debug)
             std::cout << "free_dof_indices (" << num_free_dofs << "): ";
-        for (int d : free_dof_indices)
-            if (debug)
+            for (int d : free_dof_indices)
                 std::cout << d << " ";
-        if (debug)
             std::cout << std::endl;
 
-        if (debug)
             std::cout << "slider_nodes (" << num_constraints << "): ";
-        for (int s : slider_nodes)
-            if (debug)
+            for (int s : slider_nodes)
                 std::cout << s << " ";
-        if (debug)
             std::cout << std::endl;
 
-        if (debug)
             std::cout << "Displacement (all DOFs) before reactions:\n"
                       << displacement.transpose() << std::endl;
 
-        // And print the constraint matrix
-        if (debug)
+            // And print the constraint matrix
             std::cout << "C_r:\n"
                       << C_r << std::endl;
+        }
 
         // Solve the saddle point system
 
@@ -471,67 +653,200 @@ int FEMSystem::solve_system()
         }
     }
 
-    // Print solution summary
-    if (debug)
-        std::cout << "\n=== SOLUTION ===\n";
-    for (int i = 0; i < num_nodes; ++i)
-    {
-        // The three DOFs for node i are at indices i*3, i*3+1, and i*3+2
-        double u = displacement(i * 3);             // x-displacement
-        double v = displacement(i * 3 + 1);         // y-displacement
-        double theta_rad = displacement(i * 3 + 2); // Rotation (in radians)
+    return 0;
+}
 
-        // Convert rotation to degrees for readability
-        double theta_deg = theta_rad * 180.0 / M_PI;
+void FEMSystem::invalidate_results()
+{
+    member_active.clear(); // the active set belongs to the static displacement
+    hinge_ends.clear();
+    forces_valid = false;
+    stresses_valid = false;
+    reactions_valid = false;
+    stations_valid = false;
+    summary_valid = false;
+    envelope_shown = false;
+    modal_preview = false;
+}
 
-        double total_disp_mag = std::sqrt(u * u + v * v);
+// Every analysis result, and every node or member index in the analysis options, belongs to
+// the model it was made for. topology_results is kept: it carries its own ground structure.
+void FEMSystem::reset_analyses()
+{
+    // node and member indices into the old model mean nothing in the new one
+    moving_load_options.deck_nodes.clear();
+    influence_lines = InfluenceLines();
+    moving_load_results = MovingLoadResults();
+    shape_options.variables.clear();
+    shape_results = ShapeResults();
+    sensitivity_responses.clear();
+    sensitivity_results = SensitivityResults();
+    superelement_options.instances.clear();
+    superelements = SuperelementModel();
+    sizing_results = SizingResults();
+    redundancy_results = RedundancyResults();
+
+    // results of the other analyses describe the old model, even where the node count matches
+    modal_results = ModalResults();
+    buckling_results = BucklingResults();
+    nonlinear_results = NonlinearResults();
+    transient_results = TransientResults();
+    modal_response = ModalSuperposition();
+    frequency_results = FrequencyResponseResults();
+    spectrum_results = ResponseSpectrumResults();
+    pushover_results = PushoverResults();
+    pushover_options.control_node = -1;
+
+    // material and profile parameters still apply; node ones do not
+    std::vector<SweepParameter> &sweep = sweep_options.parameters;
+    sweep.erase(std::remove_if(sweep.begin(), sweep.end(), [](const SweepParameter &p)
+                               { return p.kind == SweepParameter::Force || p.kind == SweepParameter::Coordinate ||
+                                        p.kind == SweepParameter::SliderAngle; }),
+                sweep.end());
+    sweep_results = SweepResults();
+    std::vector<RandomVariable> &random = reliability_options.variables;
+    random.erase(std::remove_if(random.begin(), random.end(), [](const RandomVariable &v)
+                                { return v.kind == RandomVariable::Force; }),
+                 random.end());
+    reliability_results = ReliabilityResults();
+    std::vector<RomParameter> &rom = rom_options.parameters;
+    rom.erase(std::remove_if(rom.begin(), rom.end(), [](const RomParameter &p)
+                             { return p.kind == RomParameter::Force; }),
+              rom.end());
+    reduced_model = ReducedModel();
+    active_set_results = ActiveSetResults();
+    element_cache_valid = false;
+    invalidate_results();
+}
 
-        // Updated output includes rotation
-        if (debug)
-            std::cout << "  Node " << i << ": u=" << u << " m, v=" << v << " m, theta=" << theta_deg << " deg (total disp=" << total_disp_mag << " m)\n";
+// force a fresh recovery from the current displacement vector (e.g. after swapping in
+// another load case's displacements) without touching the stiffness
+void FEMSystem::recover_stresses()
+{
+    invalidate_results();
+    get_stresses();
+}
 
-        if (nodes[i].constraint_type == Slider)
-        {
-            // The stored angle in the node is the direction *along* the slider.
-            double slider_angle_rad = nodes[i].constraint_angle * static_cast<double>(M_PI) / 180.0f;
+const Eigen::VectorXd &FEMSystem::get_displacements() const
+{
+    return displacement;
+}
 
-            // Direction cosines of the slider track
-            double c_track = std::cos(slider_angle_rad);
-            double s_track = std::sin(slider_angle_rad);
+// local end forces and stress per beam, recovered from the displacements on first use
+// element_cache for the current model, rebuilt only if the model changed since it was built
+void FEMSystem::refresh_element_cache() const
+{
+    if (element_cache_valid && element_cache.count == static_cast<int>(beams.size()))
+        return;
+    element_cache.build(nodes, beams, materials_list, beam_profiles_list);
+    element_cache_valid = true;
+}
 
-            // 1. Movement along the slider track (dot product of displacement vector and track vector)
-            double along_slider = u * c_track + v * s_track;
+const ElementForces &FEMSystem::get_element_forces() const
+{
+    if (forces_valid)
+        return element_forces;
 
-            // 2. Movement perpendicular to the slider track (dot product of displacement and normal vector)
-            // Note: The normal vector cosines are ( -s_track, c_track )
-            double perp_slider = -u * s_track + v * c_track;
+    refresh_element_cache();
 
-            // The total displacement of the node should be explained as movement along the track.
-            if (debug)
-                std::cout << "    Movement along track (" << nodes[i].constraint_angle << "°): " << along_slider << " m\n";
+    StressRange range = recover_element_forces(element_cache, displacement, element_forces);
 
-            // The perpendicular movement should be very close to zero if the constraint worked.
-            if (debug)
-                std::cout << "    Movement perpendicular to track: " << perp_slider << " m (should be ~0)\n";
+    // slack tension-/compression-only members carry nothing
+    if (static_cast<int>(member_active.size()) == element_cache.count &&
+        std::count(member_active.begin(), member_active.end(), 0) > 0)
+    {
+        range = {1e10f, -1e10f};
+        for (int i = 0; i < element_cache.count; ++i)
+        {
+            if (!member_active[i])
+            {
+                element_forces.p1[i] = element_forces.v1[i] = element_forces.m1[i] = 0.0;
+                element_forces.p2[i] = element_forces.v2[i] = element_forces.m2[i] = 0.0;
+                element_forces.stress[i] = 0.0f;
+            }
+            range.min_stress = std::min(range.min_stress, element_forces.stress[i]);
+            range.max_stress = std::max(range.max_stress, element_forces.stress[i]);
         }
     }
+    max_stress = range.max_stress;
+    min_stress = range.min_stress;
+    forces_valid = true;
 
-    // Calculate reaction forces and moments at supports
-    // R = K*u - F. This 3N vector contains forces (Fx, Fy) and moments (Mz)
-    Eigen::VectorXd reactions = global_k_matrix * displacement - forces;
-    // Store reactions for external inspection/visualization
-    this->reactions = reactions;
     if (debug)
-        std::cout << "\nReaction Forces & Moments (N, Nm):\n";
+    {
+        std::cout << "\nBeam Internal Forces (N, tension positive):\n";
+        for (int i = 0; i < static_cast<int>(beams.size()); ++i)
+            std::cout << "  Beam " << i << " (nodes " << beams[i].nodes[0] << "-" << beams[i].nodes[1] << "): P=" << element_forces.p2[i]
+                      << " N, M1=" << element_forces.m1[i] << " Nm, M2=" << element_forces.m2[i] << " Nm\n";
+    }
 
-    double total_reaction_x = 0.0;
-    double total_reaction_y = 0.0;
-    double total_reaction_m = 0.0; // Total Reaction Moment
+    return element_forces;
+}
 
-    for (int i = 0; i < num_nodes; ++i)
+// combined stress per beam; also refreshes the result fields on the beams themselves
+// (stress, axial_force, max_moment) and the min/max stress range used for coloring
+const std::vector<float> &FEMSystem::get_stresses()
+{
+    const ElementForces &ef = get_element_forces();
+    if (stresses_valid)
+        return ef.stress;
+
+    // copy the per-beam results back onto the beams for the GUI and file output
+    TaskScheduler::instance().parallel_for(
+        0, static_cast<int>(beams.size()), 4096, [this, &ef](int lo, int hi)
+        {
+            for (int i = lo; i < hi; ++i)
+            {
+                beams[i].axial_force = ef.p2[i];
+                beams[i].max_moment = std::max(std::abs(ef.m1[i]), std::abs(ef.m2[i]));
+                beams[i].stress = ef.stress[i];
+            } },
+        TaskPriority::High, "stress_writeback");
+    stresses_valid = true;
+
+    if (debug)
     {
-        // Only constrained nodes (Fixed, FixedPin, Slider) have reactions
-        if (nodes[i].constraint_type != Free)
+        std::cout << "\nBeam Maximum Absolute Combined Stresses (MPa):\n";
+        for (int i = 0; i < static_cast<int>(beams.size()); ++i)
+            std::cout << "  Beam " << i << " (nodes " << beams[i].nodes[0] << "-" << beams[i].nodes[1]
+                      << "): " << beams[i].stress << " MPa\n";
+        std::cout << "\nStress Range: " << min_stress << " to " << max_stress << " MPa (Max Absolute Combined Stress)\n";
+    }
+
+    return ef.stress;
+}
+
+// Reactions at the supported nodes, summed from the element end forces of their incident
+// members. Entries of unsupported nodes are zero.
+const Eigen::VectorXd &FEMSystem::get_reactions() const
+{
+    if (reactions_valid)
+        return reactions;
+
+    const ElementForces &ef = get_element_forces();
+
+    if (reactions.size() != total_dof)
+    {
+        reactions = Eigen::VectorXd::Zero(total_dof);
+    }
+    else
+    {
+        // clear the supports written last time (a node may have been released since)
+        for (int node : reaction_nodes)
+        {
+            if (node * 3 + 2 < total_dof)
+                reactions.segment<3>(node * 3).setZero();
+        }
+    }
+
+    recover_reactions_at(element_cache, ef, supported_nodes, forces, reactions, equilibrium);
+    reaction_nodes = supported_nodes;
+    reactions_valid = true;
+
+    if (debug)
+    {
+        std::cout << "\nReaction Forces & Moments (N, Nm):\n";
+        for (int i : supported_nodes)
         {
             std::string constraint_str;
             if (nodes[i].constraint_type == Fixed)
@@ -541,175 +856,1125 @@ int FEMSystem::solve_system()
             else
                 constraint_str = "Slider"; // Handles the Slider constraint
 
-            double rx = reactions(i * 3);     // x-Reaction Force
-            double ry = reactions(i * 3 + 1); // y-Reaction Force
-            double rm = reactions(i * 3 + 2); // z-Reaction Moment
+            std::cout << "  Node " << i << " (" << constraint_str << "): Fx=" << reactions(i * 3) << " N, Fy=" << reactions(i * 3 + 1)
+                      << " N, Mz=" << reactions(i * 3 + 2) << " Nm\n";
+        }
 
-            if (debug)
-                std::cout << "  Node " << i << " (" << constraint_str << "): Fx=" << rx << " N, Fy=" << ry << " N, Mz=" << rm << " Nm\n";
+        std::cout << "\nEquilibrium Check:\n";
+        std::cout << "  Applied Fx = " << equilibrium.applied[0] << " N\n";
+        std::cout << "  Applied Fy = " << equilibrium.applied[1] << " N\n";
+        std::cout << "  Applied Mz = " << equilibrium.applied[2] << " Nm\n";
+        std::cout << "  Reaction Fx = " << equilibrium.reaction[0] << " N\n";
+        std::cout << "  Reaction Fy = " << equilibrium.reaction[1] << " N\n";
+        std::cout << "  Reaction Mz = " << equilibrium.reaction[2] << " Nm\n";
+        std::cout << "  Balance (Fx): " << (equilibrium.applied[0] + equilibrium.reaction[0]) << " N (should be ~0)\n";
+        std::cout << "  Balance (Fy): " << (equilibrium.applied[1] + equilibrium.reaction[1]) << " N (should be ~0)\n";
+        std::cout << "  Balance (Mz): " << (equilibrium.applied[2] + equilibrium.reaction[2]) << " Nm (should be ~0)\n";
+    }
 
-            total_reaction_x += rx;
-            total_reaction_y += ry;
-            total_reaction_m += rm; // Summing total reaction moment
-        }
+    return reactions;
+}
+
+const EquilibriumTotals &FEMSystem::get_equilibrium() const
+{
+    get_reactions();
+    return equilibrium;
+}
+
+// internal forces and fibre stress at num_stations points along each member
+const StationResults &FEMSystem::get_stations() const
+{
+    // an envelope's end values do not come from one load state, so nothing lies between them
+    if (envelope_shown)
+    {
+        if (!stations_valid)
+            envelope_stations(element_cache, element_forces, station_results);
+        stations_valid = true;
+        return station_results;
     }
+    if (stations_valid && station_results.stations == std::max(num_stations, 2))
+        return station_results;
+
+    const ElementForces &ef = get_element_forces();
+    evaluate_stations(element_cache, ef, std::max(num_stations, 2), station_results);
+    stations_valid = true;
+    return station_results;
+}
 
-    // Equilibrium check
-    double total_applied_x = 0.0;
-    double total_applied_y = 0.0;
-    double total_applied_m = 0.0;
+const StressSummary &FEMSystem::get_stress_summary() const
+{
+    const std::vector<float> &stress = get_element_forces().stress;
+    if (modal_preview) // held from the envelope while frames only recover what is on screen
+        return stress_summary;
+    if (summary_valid && stress_summary.top_k == top_k && stress_summary.percentile == color_percentile &&
+        stress_summary.bins == histogram_bins)
+        return stress_summary;
+
+    summarize_stresses(stress, min_stress, max_stress, top_k, color_percentile, histogram_bins, stress_summary);
+    summary_valid = true;
+    return stress_summary;
+}
 
-    for (int i = 0; i < num_nodes; ++i)
+// sparse reduced K and M for the dynamic analyses (sliders move along their track only)
+void FEMSystem::assemble_dynamic(bool lumped, SparseMatrix &K, SparseMatrix &M)
+{
+    int num_nodes = static_cast<int>(nodes.size());
+    if (num_nodes * 3 != total_dof)
     {
-        total_applied_x += forces(i * 3);
-        total_applied_y += forces(i * 3 + 1);
-        total_applied_m += forces(i * 3 + 2);
+        total_dof = num_nodes * 3;
+        displacement.conservativeResize(total_dof);
+        forces.conservativeResize(total_dof);
     }
 
+    // element stiffness and mass matrices (independent per beam)
+    TaskScheduler::instance().parallel_for(
+        0, static_cast<int>(beams.size()), 256, [this, lumped](int lo, int hi)
+        {
+            for (int i = lo; i < hi; ++i)
+            {
+                beams[i].compute_stiffness(nodes, materials_list, beam_profiles_list);
+                beams[i].compute_mass(nodes, materials_list, beam_profiles_list, lumped);
+            } },
+        TaskPriority::High, "element_mass");
+
+    dof_map.build(nodes, beams);
+    K = assemble_reduced(dof_map, beams, &Beam::k_matrix);
+    M = assemble_reduced(dof_map, beams, &Beam::m_matrix);
+}
+
+int FEMSystem::solve_modes(int count, bool lumped)
+{
+    SparseMatrix K, M;
+    assemble_dynamic(lumped, K, M);
+
+    int result = extract_modes(dof_map, K, M, count, modal_results);
+    modal_results.lumped = lumped;
+
     if (debug)
     {
-        std::cout << "\nEquilibrium Check:\n";
-        std::cout << "  Applied Fx = " << total_applied_x << " N\n";
-        std::cout << "  Applied Fy = " << total_applied_y << " N\n";
-        std::cout << "  Applied Mz = " << total_applied_m << " Nm\n";
-        std::cout << "  Reaction Fx = " << total_reaction_x << " N\n";
-        std::cout << "  Reaction Fy = " << total_reaction_y << " N\n";
-        std::cout << "  Reaction Mz = " << total_reaction_m << " Nm\n";
-        std::cout << "  Balance (Fx): " << (total_applied_x + total_reaction_x) << " N (should be ~0)\n";
-        std::cout << "  Balance (Fy): " << (total_applied_y + total_reaction_y) << " N (should be ~0)\n";
-        std::cout << "  Balance (Mz): " << (total_applied_m + total_reaction_m) << " Nm (should be ~0)\n";
-    }
-
-    // Calculate internal forces and stresses in beams
-    if (debug)
-        std::cout << "\nBeam Internal Forces (N, tension positive):\n";
+        std::cout << "\n=== MODES (" << dof_map.num_reduced << " DOFs, " << modal_results.iterations
+                  << " Lanczos steps" << (modal_results.converged ? "" : ", NOT converged") << ") ===\n";
+        for (int k = 0; k < modal_results.count; ++k)
+            std::cout << "  Mode " << k + 1 << ": " << modal_results.frequency[k] << " Hz (omega=" << modal_results.omega[k] << " rad/s)\n";
+    }
 
-    max_stress = -1e10f;
-    min_stress = 1e10f;
-
-    int index = 0;
-    for (auto &beam : beams) // Renamed 'spring' to 'beam' for clarity
-    {
-        int n1 = beam.nodes[0];
-        int n2 = beam.nodes[1];
-
-        // --- 1. Get Element Displacement Vector (6 DOFs) ---
-        // The vector must be 6x1 in the order: {u1, v1, theta1, u2, v2, theta2}
-        Eigen::VectorXd element_disp(6);
-        element_disp << displacement(n1 * 3), // u1
-            displacement(n1 * 3 + 1),         // v1
-            displacement(n1 * 3 + 2),         // theta1
-            displacement(n2 * 3),             // u2
-            displacement(n2 * 3 + 1),         // v2
-            displacement(n2 * 3 + 2);         // theta2
-
-        // --- 2. Calculate Global Element End Forces/Moments (6x1 vector) ---
-        // F_global = K_global * u_global
-        Eigen::VectorXd global_end_forces = beam.k_matrix * element_disp; // 6x6 * 6x1 -> 6x1
-
-        // --- 3. Setup Transformation Matrix (T) ---
-        const Node &node1 = nodes[n1];
-        const Node &node2 = nodes[n2];
-        double dx = node2.position[0] - node1.position[0];
-        double dy = node2.position[1] - node1.position[1];
-        double L = std::sqrt(dx * dx + dy * dy);
-        double c = dx / L;
-        double s = dy / L;
-
-        // Build the full 6x6 transformation matrix T
-        Eigen::MatrixXd T = Eigen::MatrixXd::Zero(6, 6);
-        // Block 1 (Node 1)
-        T(0, 0) = c;
-        T(0, 1) = s;
-        T(1, 0) = -s;
-        T(1, 1) = c;
-        T(2, 2) = 1.0;
-        // Block 2 (Node 2)
-        T(3, 3) = c;
-        T(3, 4) = s;
-        T(4, 3) = -s;
-        T(4, 4) = c;
-        T(5, 5) = 1.0;
-
-        // --- 4. Transform Forces to Local Coordinates ---
-        // F_local = T * F_global
-        // This gives the internal forces/moments in the order {P1, V1, M1, P2, V2, M2}
-        Eigen::VectorXd local_end_forces = T * global_end_forces;
-
-        // --- 5. Extract and Store Results ---
-        // Axial Force (P): Must be taken from the end of the element (P2) or checked for sign.
-        // Axial Force is typically constant along the beam, and should equal -P1 (local_end_forces(0)) or P2 (local_end_forces(3)).
-        // P = Axial Force (Tension is positive)
-        double P = local_end_forces(3); // Use P2 (index 3)
-
-        // Shear Force (V)
-        // double V1 = local_end_forces(1); // Shear at Node 1
-
-        // Bending Moments (M)
-        double M1 = local_end_forces(2);                     // Moment at Node 1 (local theta1 DOF)
-        double M2 = local_end_forces(5);                     // Moment at Node 2 (local theta2 DOF)
-        double max_M = std::max(std::abs(M1), std::abs(M2)); // Max moment magnitude
-
-        // Update the beam object to store the results
-        beam.axial_force = P;
-        beam.max_moment = max_M;
-
-        // Output Internal Forces and Moments
-        if (debug)
-            std::cout << "  Beam " << index << " (nodes " << n1 << "-" << n2 << "): P=" << P << " N, M1=" << M1 << " Nm, M2=" << M2 << " Nm\n";
+    return result;
+}
 
-        // --- 6. Calculate Combined Stress ---
-        const BeamProfile &shape = beam_profiles_list[beam.shape_idx];
+void FEMSystem::show_mode(int mode, double amplitude)
+{
+    show_shape(modal_results.shapes, mode, amplitude);
+}
 
-        // Ensure Z_modulus is non-zero to avoid division by zero
-        if (std::abs(shape.section_modulus) < 1e-12)
-        {
-            // Handle pure axial stress case or pure shear case if Z is effectively zero (e.g., truss I=0)
-            beam.stress = P / shape.area;
-        }
-        else
+// linear buckling: K + lambda * Kg(P) singular, with P the member forces of the static solution
+int FEMSystem::solve_buckling(int count)
+{
+    int result = current_static_factorization();
+    if (result != 0)
+    {
+        if (debug && result == -3)
+            std::cout << "Buckling needs a stable structure (the static solve found a mechanism)" << std::endl;
+        return result;
+    }
+
+    // axial forces of the reference state
+    get_stresses();
+    TaskScheduler::instance().parallel_for(
+        0, static_cast<int>(beams.size()), 256, [this](int lo, int hi)
         {
-            // Combined Stress = Axial Stress (P/A) +/- Bending Stress (M/Z)
-            // We calculate the maximum absolute stress using the max moment magnitude
-            double axial_stress = P / shape.area;
-            double bending_stress_max = max_M / shape.section_modulus;
+            for (int i = lo; i < hi; ++i)
+                beams[i].compute_geometric_stiffness(nodes, beams[i].axial_force); },
+        TaskPriority::High, "element_geometric_stiffness");
 
-            // Max tension stress (P/A + M/Z)
-            double stress_tension = axial_stress + bending_stress_max;
-            // Max compression stress (P/A - M/Z)
-            double stress_compression = axial_stress - bending_stress_max;
+    SparseMatrix Kg = assemble_reduced(dof_map, beams, &Beam::kg_matrix);
+    result = extract_buckling_modes(dof_map, reduced_stiffness, static_solver, Kg, count, buckling_results);
 
-            // Store the stress with correct sign: positive for tension, negative for compression
-            if (std::abs(stress_tension) > std::abs(stress_compression))
-                beam.stress = stress_tension;
-            else
-                beam.stress = stress_compression;
-        }
+    if (debug)
+    {
+        std::cout << "\n=== BUCKLING (" << buckling_results.iterations << " Lanczos steps"
+                  << (buckling_results.converged ? "" : ", NOT converged") << ") ===\n";
+        for (int k = 0; k < buckling_results.count; ++k)
+            std::cout << "  Mode " << k + 1 << ": load factor " << buckling_results.load_factors[k] << "\n";
+    }
+
+    return result;
+}
+
+void FEMSystem::show_buckling_mode(int mode, double amplitude)
+{
+    show_shape(buckling_results.shapes, mode, amplitude);
+}
 
-        // Update global min/max stress trackers
-        max_stress = std::max(max_stress, beam.stress);
-        min_stress = std::min(min_stress, beam.stress);
+// HHT-alpha time history of forces * transient_options.load(t), starting from rest
+int FEMSystem::solve_transient()
+{
+    SparseMatrix K, M;
+    assemble_dynamic(transient_options.lumped_mass, K, M);
 
-        ++index;
+    // supports for the reactions of the frames shown later
+    supported_nodes.clear();
+    for (int i = 0; i < static_cast<int>(nodes.size()); ++i)
+    {
+        if (nodes[i].constraint_type != Free)
+            supported_nodes.push_back(i);
     }
 
+    int result = integrate_transient(dof_map, K, M, forces, transient_options, transient_solver, transient_results);
+
     if (debug)
-        std::cout << "\nBeam Maximum Absolute Combined Stresses (MPa):\n";
-    index = 0;
-    for (const auto &beam : beams)
     {
-        if (debug)
-            std::cout << "  Beam " << index << " (nodes " << beam.nodes[0] << "-" << beam.nodes[1]
-                      << "): " << beam.stress << " MPa\n";
-        ++index;
+        std::cout << "\n=== TRANSIENT (" << dof_map.num_reduced << " DOFs, " << transient_results.steps << " steps of "
+                  << transient_results.time_step << " s) ===\n";
+        if (transient_results.wall_seconds > 0.0)
+            std::cout << "  " << transient_results.wall_seconds << " s wall time, "
+                      << transient_options.duration / transient_results.wall_seconds << "x real time\n";
     }
 
-    if (debug)
-        std::cout << "\nStress Range: " << min_stress << " to " << max_stress << " MPa (Max Absolute Combined Stress)\n";
+    if (result == 0)
+        show_transient_frame(static_cast<int>(transient_results.times.size()) - 1);
+    return result;
+}
+
+void FEMSystem::show_transient_frame(int frame)
+{
+    const Eigen::MatrixXf &frames = transient_results.frames;
+    if (frame < 0 || frame >= frames.cols() || frames.rows() != total_dof)
+        return;
+
+    // linear dynamics, so the usual recovery applies (reactions then include the inertia forces)
+    displacement = frames.col(frame).cast<double>();
+    invalidate_results();
+}
+
+int FEMSystem::prepare_modal_response(int modes, double damping_ratio)
+{
+    int result = solve_modes(modes, transient_options.lumped_mass);
+    if (modal_results.count == 0)
+        return result == 0 ? -1 : result;
+
+    modal_response.prepare(modal_results, forces, transient_options.load, damping_ratio, modes);
+    displacement = Eigen::VectorXd::Zero(total_dof);
+    invalidate_results();
+
+    // envelope for the held summary: mode k peaks near 2 |phi_k^T F| a / w_k^2 under a load
+    // of peak factor a applied suddenly; member stresses of the modes are combined by SRSS
+    const LoadHistory &load = transient_options.load;
+    double peak_factor = std::abs(load.amplitude);
+    if (load.type == LoadHistory::Table)
+    {
+        double largest = 0.0;
+        for (const Eigen::Vector2d &point : load.table)
+            largest = std::max(largest, std::abs(point(1)));
+        peak_factor *= largest;
+    }
 
+    refresh_element_cache();
+    std::vector<float> envelope(element_cache.count, 0.0f);
+    ElementForces mode_forces;
+    for (int k = 0; k < modal_response.modes; ++k)
+    {
+        double w = modal_response.omega[k];
+        if (w < 1e-12)
+            continue;
+        double q = 2.0 * std::abs(modal_response.modal_force[k]) * peak_factor / (w * w);
+        recover_element_forces(element_cache, modal_results.shapes.col(k) * q, mode_forces);
+        for (int i = 0; i < element_cache.count; ++i)
+            envelope[i] += mode_forces.stress[i] * mode_forces.stress[i];
+    }
+    float peak = 0.0f;
+    for (float &value : envelope)
+    {
+        value = std::sqrt(value);
+        peak = std::max(peak, value);
+    }
+    summarize_stresses(envelope, 0.0f, peak, top_k, color_percentile, histogram_bins, stress_summary);
+    stress_summary.color_min = -stress_summary.color_max;
+    summary_valid = true;
+    min_stress = -peak;
+    max_stress = peak;
+
+    // the preview starts at rest; reactions stay empty until it stops
+    recover_element_forces(element_cache, displacement, element_forces);
+    forces_valid = true;
+    reactions.resize(0);
+    reaction_nodes.clear();
+    reactions_valid = true;
+    modal_preview = true;
     return 0;
 }
 
+void FEMSystem::show_modal_response(double t, const std::vector<int> *visible_nodes,
+                                    const std::vector<int> *visible_members)
+{
+    if (modal_response.modes == 0 || modal_results.shapes.rows() != total_dof)
+        return;
+    if (displacement.size() != total_dof)
+        displacement = Eigen::VectorXd::Zero(total_dof);
+
+    modal_response.advance_to(t);
+    if (visible_nodes != nullptr)
+    {
+        modal_response.reconstruct(modal_results.shapes, *visible_nodes, displacement);
+    }
+    else
+    {
+        Eigen::Map<const Eigen::VectorXd> q(modal_response.q.data(), modal_response.modes);
+        displacement = modal_results.shapes.leftCols(modal_response.modes) * q;
+    }
+
+    if (!modal_preview || element_cache.count != static_cast<int>(beams.size()))
+    {
+        invalidate_results();
+        return;
+    }
+    // only members whose ends were rebuilt this frame are recovered; the summary stays held
+    if (visible_nodes != nullptr && visible_members != nullptr)
+        recover_element_forces_at(element_cache, displacement, *visible_members, element_forces);
+    else
+        recover_element_forces(element_cache, displacement, element_forces);
+    stations_valid = false;
+}
+
+int FEMSystem::solve_frequency_response()
+{
+    const FrequencyResponseOptions &options = frequency_options;
+    int result = 0;
+
+    if (options.method == FrequencyResponseOptions::Modal)
+    {
+        result = solve_modes(options.modes, options.lumped_mass);
+        if (modal_results.count == 0)
+        {
+            frequency_results = FrequencyResponseResults();
+            return result == 0 ? -1 : result;
+        }
+        refresh_element_cache();
+        result = frequency_response_modal(modal_results, element_cache, forces, options, frequency_results);
+    }
+    else
+    {
+        SparseMatrix K, M;
+        assemble_dynamic(options.lumped_mass, K, M);
+        refresh_element_cache();
+        result = frequency_response_direct(dof_map, K, M, element_cache, forces, options, frequency_results);
+    }
+
+    if (debug)
+    {
+        const FrequencyResponseResults &r = frequency_results;
+        std::cout << "\n=== FREQUENCY RESPONSE (" << r.num_frequencies << " frequencies, "
+                  << (options.method == FrequencyResponseOptions::Modal ? "modal" : "direct") << ") ===\n";
+        if (options.method == FrequencyResponseOptions::Modal)
+            std::cout << "  " << r.modes_used << " modes";
+        else
+            std::cout << "  " << r.factorizations << " complex factorizations";
+        std::cout << ", " << r.wall_seconds << " s" << std::endl;
+    }
+    return result;
+}
+
+int FEMSystem::solve_response_spectrum()
+{
+    const ResponseSpectrumOptions &options = spectrum_options;
+    SparseMatrix K, M;
+    assemble_dynamic(options.lumped_mass, K, M);
+
+    int result = extract_modes(dof_map, K, M, options.modes, modal_results);
+    modal_results.lumped = options.lumped_mass;
+    if (modal_results.count == 0)
+    {
+        spectrum_results = ResponseSpectrumResults();
+        return result == 0 ? -1 : result;
+    }
+
+    supported_nodes.clear();
+    for (int i = 0; i < static_cast<int>(nodes.size()); ++i)
+    {
+        if (nodes[i].constraint_type != Free)
+            supported_nodes.push_back(i);
+    }
+    refresh_element_cache();
+    result = response_spectrum(dof_map, M, modal_results, element_cache, supported_nodes, options, spectrum_results);
+
+    if (debug)
+    {
+        const ResponseSpectrumResults &r = spectrum_results;
+        std::cout << "\n=== RESPONSE SPECTRUM (" << r.modes << " modes, "
+                  << (options.combination == ResponseSpectrumOptions::CQC ? "CQC" : "SRSS") << ") ===\n";
+        for (int k = 0; k < r.modes; ++k)
+            std::cout << "  Mode " << k + 1 << ": T=" << r.period[k] << " s, Sa=" << r.spectral_acceleration[k]
+                      << " m/s^2, mass " << 100.0 * r.mass_ratio[k] << "%\n";
+        std::cout << "  Captured mass " << 100.0 * r.captured_mass << "%, base shear " << r.base_shear[0] << ", "
+                  << r.base_shear[1] << " N" << std::endl;
+    }
+
+    if (result == 0)
+        show_spectrum_envelope();
+    return result;
+}
+
+void FEMSystem::show_spectrum_envelope()
+{
+    const ResponseSpectrumResults &r = spectrum_results;
+    if (static_cast<int>(r.envelope.stress.size()) != static_cast<int>(beams.size()) || r.reactions.size() != total_dof)
+        return;
+
+    // peak values of different modes do not occur together, so there is no deformed shape
+    invalidate_results();
+    displacement = Eigen::VectorXd::Zero(total_dof);
+
+    refresh_element_cache();
+    element_forces = r.envelope;
+    envelope_shown = true;
+    min_stress = 0.0f;
+    max_stress = r.max_stress;
+    forces_valid = true;
+
+    if (reactions.size() != total_dof)
+        reactions = Eigen::VectorXd::Zero(total_dof);
+    for (int node : reaction_nodes)
+    {
+        if (node * 3 + 2 < total_dof)
+            reactions.segment<3>(node * 3).setZero();
+    }
+    for (int node : supported_nodes)
+        reactions.segment<3>(node * 3) = r.reactions.segment<3>(node * 3);
+    for (int d = 0; d < 3; ++d)
+    {
+        equilibrium.applied[d] = 0.0;
+        equilibrium.reaction[d] = r.base_shear[d];
+    }
+    reaction_nodes = supported_nodes;
+    reactions_valid = true;
+}
+
+// large-displacement static solve: corotational members, incremental load, Newton iterations
+int FEMSystem::solve_nonlinear()
+{
+    int num_nodes = static_cast<int>(nodes.size());
+    if (num_nodes * 3 != total_dof)
+    {
+        total_dof = num_nodes * 3;
+        displacement.conservativeResize(total_dof);
+        forces.conservativeResize(total_dof);
+    }
+
+    // the linear element stiffness only decides which rotations are kept in the DOF map
+    TaskScheduler::instance().parallel_for(
+        0, static_cast<int>(beams.size()), 256, [this](int lo, int hi)
+        {
+            for (int i = lo; i < hi; ++i)
+                beams[i].compute_stiffness(nodes, materials_list, beam_profiles_list); },
+        TaskPriority::High, "element_stiffness");
+
+    supported_nodes.clear();
+    for (int i = 0; i < num_nodes; ++i)
+    {
+        if (nodes[i].constraint_type != Free)
+            supported_nodes.push_back(i);
+    }
+
+    dof_map.build(nodes, beams);
+    refresh_element_cache();
+
+    if (debug)
+        std::cout << "\n=== NONLINEAR (" << dof_map.num_reduced << " DOFs, " << nonlinear_options.load_steps
+                  << " increments, " << (nonlinear_options.modified_newton ? "modified Newton" : "Newton-Raphson") << ") ===\n";
+
+    int result = solve_corotational(dof_map, beams, element_cache, forces, nonlinear_options, tangent_solver,
+                                    nonlinear_results, debug);
+
+    if (debug)
+        std::cout << "Reached load factor " << nonlinear_results.reached_load_factor << " in "
+                  << nonlinear_results.total_iterations << " iterations, " << nonlinear_results.factorizations
+                  << " factorizations" << std::endl;
+
+    if (nonlinear_results.increments.empty())
+    {
+        displacement = Eigen::VectorXd::Zero(total_dof);
+        invalidate_results();
+    }
+    else
+    {
+        show_increment(static_cast<int>(nonlinear_results.increments.size()) - 1);
+    }
+    return result;
+}
+
+void FEMSystem::show_increment(int increment)
+{
+    if (increment < 0 || increment >= static_cast<int>(nonlinear_results.increments.size()))
+        return;
+
+    const NonlinearIncrement &inc = nonlinear_results.increments[increment];
+    if (inc.displacement.size() != total_dof || static_cast<int>(inc.element_forces.stress.size()) != static_cast<int>(beams.size()))
+        return;
+
+    invalidate_results();
+    displacement = inc.displacement;
+
+    // member forces come from the increment; the linear recovery would see the rigid
+    // rotations as bending
+    refresh_element_cache();
+    element_forces = inc.element_forces;
+    min_stress = inc.min_stress;
+    max_stress = inc.max_stress;
+    forces_valid = true;
+
+    // reactions straight from the internal forces: R = f_int - lambda * F at the supports
+    if (reactions.size() != total_dof)
+        reactions = Eigen::VectorXd::Zero(total_dof);
+    for (int node : reaction_nodes)
+    {
+        if (node * 3 + 2 < total_dof)
+            reactions.segment<3>(node * 3).setZero();
+    }
+    for (int d = 0; d < 3; ++d)
+    {
+        equilibrium.applied[d] = 0.0;
+        equilibrium.reaction[d] = 0.0;
+    }
+    for (int node : supported_nodes)
+    {
+        for (int d = 0; d < 3; ++d)
+        {
+            double r = inc.internal_force(node * 3 + d) - inc.load_factor * forces(node * 3 + d);
+            reactions(node * 3 + d) = r;
+            equilibrium.reaction[d] += r;
+        }
+    }
+    for (int i = 0; i < total_dof; ++i)
+        equilibrium.applied[i % 3] += inc.load_factor * forces(i);
+    reaction_nodes = supported_nodes;
+    reactions_valid = true;
+}
+
+// event-to-event plastic hinge analysis of forces * lambda up to a collapse mechanism
+int FEMSystem::solve_pushover()
+{
+    int num_nodes = static_cast<int>(nodes.size());
+    if (num_nodes * 3 != total_dof)
+    {
+        total_dof = num_nodes * 3;
+        displacement.conservativeResize(total_dof);
+        forces.conservativeResize(total_dof);
+    }
+
+    TaskScheduler::instance().parallel_for(
+        0, static_cast<int>(beams.size()), 256, [this](int lo, int hi)
+        {
+            for (int i = lo; i < hi; ++i)
+                beams[i].compute_stiffness(nodes, materials_list, beam_profiles_list); },
+        TaskPriority::High, "element_stiffness");
+
+    supported_nodes.clear();
+    for (int i = 0; i < num_nodes; ++i)
+    {
+        if (nodes[i].constraint_type != Free)
+            supported_nodes.push_back(i);
+    }
+
+    dof_map.build(nodes, beams);
+    refresh_element_cache();
+    pushover_results = PushoverResults();
+    if (dof_map.num_reduced == 0)
+        return -1;
+
+    // the elastic structure is the base every hinge is a correction of
+    if (pushover_solver.factorize(assemble_reduced(dof_map, beams, &Beam::k_matrix)) != 0)
+        return -3;
+
+    std::vector<double> plastic_moment(beams.size(), 0.0);
+    for (size_t i = 0; i < beams.size(); ++i)
+    {
+        int shape = beams[i].shape_idx;
+        if (!beams[i].is_truss && shape >= 0 && shape < static_cast<int>(beam_profiles_list.size()))
+            plastic_moment[i] = beam_profiles_list[shape].plastic_moment;
+    }
+
+    int result = plastic_pushover(dof_map, beams, element_cache, plastic_moment, forces, pushover_options,
+                                  pushover_solver, pushover_results, debug);
+
+    if (debug)
+    {
+        const PushoverResults &r = pushover_results;
+        std::cout << "\n=== PUSHOVER ===\n";
+        for (size_t k = 1; k < r.steps.size(); ++k)
+        {
+            const PushoverStep &step = r.steps[k];
+            std::cout << "  Event " << k << ": load factor " << step.load_factor << ", control displacement "
+                      << step.control_displacement;
+            if (step.hinges > r.steps[k - 1].hinges)
+            {
+                int hinge = r.hinge_sequence[step.hinges - 1];
+                std::cout << ", hinge at member " << (hinge >> 1) << " end " << (hinge & 1) + 1;
+            }
+            std::cout << "\n";
+        }
+        std::cout << (r.mechanism ? "  Collapse mechanism at load factor " : "  Stopped at load factor ")
+                  << r.collapse_load_factor << std::endl;
+    }
+
+    if (!pushover_results.steps.empty())
+        show_pushover_step(static_cast<int>(pushover_results.steps.size()) - 1);
+    return result;
+}
+
+void FEMSystem::show_pushover_step(int step)
+{
+    if (step < 0 || step >= static_cast<int>(pushover_results.steps.size()))
+        return;
+
+    const PushoverStep &s = pushover_results.steps[step];
+    if (s.displacement.size() != total_dof || static_cast<int>(s.element_forces.stress.size()) != static_cast<int>(beams.size()))
+        return;
+
+    invalidate_results();
+    displacement = s.displacement;
+    hinge_ends.assign(pushover_results.hinge_sequence.begin(), pushover_results.hinge_sequence.begin() + s.hinges);
+
+    // the hinged members no longer follow the elastic recovery, so the forces come from the step
+    refresh_element_cache();
+    element_forces = s.element_forces;
+    min_stress = s.min_stress;
+    max_stress = s.max_stress;
+    forces_valid = true;
+
+    if (reactions.size() != total_dof)
+        reactions = Eigen::VectorXd::Zero(total_dof);
+    for (int node : reaction_nodes)
+    {
+        if (node * 3 + 2 < total_dof)
+            reactions.segment<3>(node * 3).setZero();
+    }
+    recover_reactions_at(element_cache, element_forces, supported_nodes, s.load_factor * forces, reactions, equilibrium);
+    reaction_nodes = supported_nodes;
+    reactions_valid = true;
+}
+
+int FEMSystem::current_static_factorization()
+{
+    int result = solve_system();
+    if (result != 0)
+        return result;
+    if (!static_solver.factored())
+        return -3; // the dense fallback leaves nothing to reuse
+
+    // the active set may have ended on a low-rank update of an older factorization
+    if (!active_set_results.solver_current)
+    {
+        if (static_solver.factorize(reduced_stiffness) != 0)
+            return -3;
+        active_set_results.solver_current = true;
+    }
+    return 0;
+}
+
+int FEMSystem::solve_influence_lines()
+{
+    influence_lines = InfluenceLines();
+    int result = current_static_factorization();
+    if (result != 0)
+        return result;
+
+    refresh_element_cache();
+    result = compute_influence_lines(nodes, dof_map, element_cache, static_solver, moving_load_options.deck_nodes,
+                                     influence_lines);
+    if (result != 0)
+        return result;
+
+    // slack one-way members stay slack: the lines are those of the static active set
+    for (int i = 0; i < static_cast<int>(member_active.size()); ++i)
+    {
+        if (!member_active[i])
+        {
+            influence_lines.axial.row(i).setZero();
+            influence_lines.moment1.row(i).setZero();
+            influence_lines.moment2.row(i).setZero();
+        }
+    }
+
+    if (debug)
+        std::cout << "Influence lines: " << influence_lines.deck_nodes.size() << " deck nodes over "
+                  << influence_lines.deck_length() << " m, " << influence_lines.wall_seconds << " s" << std::endl;
+    return 0;
+}
+
+int FEMSystem::solve_moving_load()
+{
+    if (influence_lines.deck_nodes != moving_load_options.deck_nodes ||
+        influence_lines.axial.rows() != static_cast<int>(beams.size()))
+    {
+        int result = solve_influence_lines();
+        if (result != 0)
+            return result;
+    }
+
+    refresh_element_cache();
+    int result = moving_load_envelope(influence_lines, element_cache, moving_load_options, moving_load_results);
+    if (debug)
+        std::cout << "Moving load: " << moving_load_results.positions << " train positions, stress "
+                  << moving_load_results.envelope_min_stress << " .. " << moving_load_results.envelope_max_stress
+                  << ", " << moving_load_results.wall_seconds << " s" << std::endl;
+
+    if (result == 0)
+        show_moving_load_envelope();
+    return result;
+}
+
+void FEMSystem::show_moving_load_envelope()
+{
+    const MovingLoadResults &r = moving_load_results;
+    if (static_cast<int>(r.envelope.stress.size()) != static_cast<int>(beams.size()))
+        return;
+
+    // the extremes come from different train positions, so there is no deformed shape
+    invalidate_results();
+    displacement = Eigen::VectorXd::Zero(total_dof);
+
+    refresh_element_cache();
+    element_forces = r.envelope;
+    envelope_shown = true;
+    min_stress = r.envelope_min_stress;
+    max_stress = r.envelope_max_stress;
+    forces_valid = true;
+
+    if (reactions.size() != total_dof)
+        reactions = Eigen::VectorXd::Zero(total_dof);
+    for (int node : reaction_nodes)
+    {
+        if (node * 3 + 2 < total_dof)
+            reactions.segment<3>(node * 3).setZero();
+    }
+    for (int d = 0; d < 3; ++d)
+    {
+        equilibrium.applied[d] = 0.0;
+        equilibrium.reaction[d] = 0.0;
+    }
+    reaction_nodes.clear();
+    reactions_valid = true;
+}
+
+int FEMSystem::solve_sensitivities()
+{
+    sensitivity_results = SensitivityResults();
+    int result = current_static_factorization();
+    if (result != 0)
+        return result;
+
+    refresh_element_cache();
+    result = compute_sensitivities(nodes, beams, materials_list, beam_profiles_list, dof_map, element_cache,
+                                   static_solver, forces, displacement, member_active, sensitivity_responses,
+                                   sensitivity_results);
+    if (debug)
+        std::cout << "Sensitivities: " << sensitivity_results.responses.size() << " responses, "
+                  << sensitivity_results.wall_seconds << " s" << std::endl;
+    return result;
+}
+
+int FEMSystem::solve_sizing()
+{
+    sizing_results = SizingResults();
+    int result = solve_system();
+    if (result != 0)
+        return result;
+
+    refresh_element_cache();
+    result = optimize_sizing(nodes, beams, materials_list, beam_profiles_list, dof_map, element_cache, forces,
+                             member_active, sizing_options, sizing_solver, sizing_results);
+    if (debug)
+        std::cout << "Sizing: " << sizing_results.initial_weight << " -> " << sizing_results.weight << " kg, "
+                  << sizing_results.analyses << " analyses, " << sizing_results.refactorizations
+                  << " refactorizations, " << sizing_results.wall_seconds << " s"
+                  << (sizing_results.feasible ? "" : " (limits not met)") << std::endl;
+    return result;
+}
+
+int FEMSystem::apply_sizing()
+{
+    const SizingResults &r = sizing_results;
+    int num_beams = static_cast<int>(beams.size());
+    if (static_cast<int>(r.area.size()) != num_beams)
+        return -1;
+
+    int changed = 0;
+    if (sizing_options.discrete)
+    {
+        for (int i = 0; i < num_beams; ++i)
+        {
+            changed += beams[i].shape_idx != r.profile[i];
+            beams[i].shape_idx = r.profile[i];
+        }
+    }
+    else
+    {
+        // one new profile per base profile and area (to 4 significant digits)
+        std::map<std::pair<int, double>, int> made;
+        for (int i = 0; i < num_beams; ++i)
+        {
+            const BeamProfile base = beam_profiles_list[r.profile[i]];
+            if (base.area <= 0.0 || std::abs(r.area[i] - base.area) <= 1e-9 * base.area)
+                continue;
+            double scale = std::pow(10.0, std::floor(std::log10(r.area[i])) - 3);
+            double area = std::round(r.area[i] / scale) * scale;
+            auto key = std::make_pair(r.profile[i], area);
+            auto it = made.find(key);
+            if (it == made.end())
+            {
+                double ratio = area / base.area;
+                BeamProfile sized = base;
+                std::ostringstream name;
+                name << base.name << " x" << std::setprecision(4) << ratio;
+                sized.name = name.str();
+                sized.area = area;
+                sized.moment_of_inertia = base.moment_of_inertia * ratio * ratio;
+                sized.section_modulus = base.section_modulus * std::pow(ratio, 1.5);
+                sized.plastic_moment = base.plastic_moment * std::pow(ratio, 1.5);
+                beam_profiles_list.push_back(sized);
+                it = made.emplace(key, static_cast<int>(beam_profiles_list.size()) - 1).first;
+            }
+            beams[i].shape_idx = it->second;
+            ++changed;
+        }
+    }
+
+    solve_system();
+    return changed;
+}
+
+int FEMSystem::solve_shape()
+{
+    shape_results = ShapeResults();
+    int result = solve_system();
+    if (result != 0)
+        return result;
+
+    // static_solver holds the ordering of this connectivity for every candidate's copy
+    refresh_element_cache();
+    result = optimize_shape(nodes, beams, materials_list, beam_profiles_list, dof_map, element_cache, forces,
+                            member_active, shape_options, static_solver, shape_results);
+    if (debug)
+        std::cout << "Shape: " << shape_results.initial_weight << " -> " << shape_results.weight << " kg, max stress "
+                  << shape_results.initial_max_stress << " -> " << shape_results.max_stress << " Pa, "
+                  << shape_results.history.size() << " iterations, " << shape_results.evaluations << " analyses, "
+                  << shape_results.wall_seconds << " s" << std::endl;
+    return result;
+}
+
+int FEMSystem::apply_shape()
+{
+    const std::vector<ShapeVariable> &variables = shape_options.variables;
+    int count = static_cast<int>(variables.size());
+    if (static_cast<int>(shape_results.coordinates.size()) != count)
+        return -1;
+    for (int j = 0; j < count; ++j)
+    {
+        if (variables[j].node < 0 || variables[j].node >= static_cast<int>(nodes.size()))
+            return -1;
+    }
+    for (int j = 0; j < count; ++j)
+        nodes[variables[j].node].position[variables[j].dof] = static_cast<float>(shape_results.coordinates[j]);
+
+    solve_system();
+    return count;
+}
+
+int FEMSystem::solve_sweep()
+{
+    sweep_results = SweepResults();
+    int result = current_static_factorization();
+    if (result != 0)
+        return result;
+
+    refresh_element_cache();
+    result = run_sweep(nodes, beams, materials_list, beam_profiles_list, dof_map, element_cache, forces,
+                       member_active, sweep_options, static_solver, sweep_results);
+    if (debug)
+        std::cout << "Sweep: " << sweep_results.table.rows << " points, " << sweep_results.failed << " failed, "
+                  << sweep_results.factorizations << " factorizations, " << sweep_results.wall_seconds << " s"
+                  << std::endl;
+    return result;
+}
+
+int FEMSystem::solve_reliability()
+{
+    reliability_results = ReliabilityResults();
+    int result = current_static_factorization();
+    if (result != 0)
+        return result;
+
+    refresh_element_cache();
+    result = run_reliability(nodes, beams, materials_list, beam_profiles_list, dof_map, element_cache, forces,
+                             member_active, reliability_options, static_solver, reliability_results);
+    if (debug)
+        std::cout << "Reliability: " << reliability_results.samples << " samples, P_f = "
+                  << reliability_results.failure_probability << " +- " << reliability_results.standard_error << ", "
+                  << reliability_results.factorizations << " factorizations, " << reliability_results.wall_seconds
+                  << " s" << std::endl;
+    return result;
+}
+
+int FEMSystem::solve_redundancy()
+{
+    redundancy_results = RedundancyResults();
+    int result = current_static_factorization();
+    if (result != 0)
+        return result;
+
+    refresh_element_cache();
+    result = scan_redundancy(nodes, beams, materials_list, beam_profiles_list, dof_map, element_cache, forces,
+                             member_active, redundancy_options, static_solver, redundancy_results);
+    if (debug)
+        std::cout << "Redundancy: " << redundancy_results.removals.size() << " removals, "
+                  << redundancy_results.mechanisms << " mechanisms, " << redundancy_results.overstressing
+                  << " overstressing, " << redundancy_results.solves << " solves, " << redundancy_results.wall_seconds
+                  << " s" << std::endl;
+    return result;
+}
+
+int FEMSystem::build_reduced_model()
+{
+    reduced_model = ReducedModel();
+    int result = solve_system();
+    if (result != 0)
+        return result;
+
+    result = reduced_model.build(nodes, beams, materials_list, beam_profiles_list, dof_map, forces, member_active,
+                                 rom_options.parameters, static_solver);
+    if (result == 0)
+        result = reduced_model.train(rom_options) < 0 ? -1 : 0;
+    if (debug)
+        std::cout << "Reduced model: " << reduced_model.size() << " basis vectors for " << reduced_model.dofs()
+                  << " equations, " << reduced_model.snapshots << " full solves, "
+                  << reduced_model.build_seconds + reduced_model.train_seconds << " s" << std::endl;
+    return result;
+}
+
+int FEMSystem::place_substructure(const std::vector<int> &members, double dx, double dy, int copies)
+{
+    int num_beams = static_cast<int>(beams.size());
+    if (members.empty() || copies < 0)
+        return -1;
+    for (int i : members)
+    {
+        if (i < 0 || i >= num_beams)
+            return -1;
+    }
+    if (forces.size() != static_cast<int>(nodes.size()) * 3)
+        forces.conservativeResizeLike(Eigen::VectorXd::Zero(nodes.size() * 3));
+
+    // the original is an instance too, unless it already is one
+    std::vector<int> sorted = members;
+    std::sort(sorted.begin(), sorted.end());
+    bool placed = false;
+    for (std::vector<int> instance : superelement_options.instances)
+    {
+        std::sort(instance.begin(), instance.end());
+        placed = placed || instance == sorted;
+    }
+    if (!placed)
+        superelement_options.instances.push_back(members);
+
+    std::vector<int> source_nodes;
+    for (int i : members)
+    {
+        source_nodes.push_back(beams[i].nodes[0]);
+        source_nodes.push_back(beams[i].nodes[1]);
+    }
+    std::sort(source_nodes.begin(), source_nodes.end());
+    source_nodes.erase(std::unique(source_nodes.begin(), source_nodes.end()), source_nodes.end());
+
+    // nodes by grid cell of the merge tolerance, so finding one is a look at 3 x 3 cells
+    double cell = std::max(superelement_options.tolerance, 1e-9);
+    std::map<std::pair<long long, long long>, std::vector<int>> grid;
+    auto cell_of = [cell](double v) { return static_cast<long long>(std::floor(v / cell)); };
+    for (int m = 0; m < static_cast<int>(nodes.size()); ++m)
+        grid[{cell_of(nodes[m].position[0]), cell_of(nodes[m].position[1])}].push_back(m);
+
+    int added = 0;
+    for (int k = 1; k <= copies; ++k)
+    {
+        // an existing node at the shifted position joins the copy to the model
+        std::map<int, int> copied;
+        for (int n : source_nodes)
+        {
+            float x = static_cast<float>(nodes[n].position[0] + k * dx);
+            float y = static_cast<float>(nodes[n].position[1] + k * dy);
+            long long cx = cell_of(x), cy = cell_of(y);
+            int found = -1;
+            for (long long i = cx - 1; i <= cx + 1 && found < 0; ++i)
+            {
+                for (long long j = cy - 1; j <= cy + 1 && found < 0; ++j)
+                {
+                    auto it = grid.find({i, j});
+                    if (it == grid.end())
+                        continue;
+                    for (int m : it->second)
+                    {
+                        if (std::abs(nodes[m].position[0] - x) <= superelement_options.tolerance &&
+                            std::abs(nodes[m].position[1] - y) <= superelement_options.tolerance)
+                        {
+                            found = m;
+                            break;
+                        }
+                    }
+                }
+            }
+            if (found < 0)
+            {
+                nodes.emplace_back(x, y, Free, 0.0f);
+                found = static_cast<int>(nodes.size()) - 1;
+                grid[{cx, cy}].push_back(found);
+            }
+            copied[n] = found;
+        }
+        std::vector<int> instance;
+        for (int i : members)
+        {
+            Beam copy(copied[beams[i].nodes[0]], copied[beams[i].nodes[1]], beams[i].material_idx, beams[i].shape_idx,
+                      beams[i].is_truss);
+            copy.tension_only = beams[i].tension_only;
+            copy.compression_only = beams[i].compression_only;
+            beams.push_back(copy);
+            instance.push_back(static_cast<int>(beams.size()) - 1);
+            ++added;
+        }
+        superelement_options.instances.push_back(instance);
+    }
+
+    total_dof = static_cast<int>(nodes.size()) * 3;
+    forces.conservativeResizeLike(Eigen::VectorXd::Zero(total_dof));
+    displacement = Eigen::VectorXd::Zero(total_dof);
+    element_cache_valid = false;
+    invalidate_results();
+    return added;
+}
+
+int FEMSystem::solve_superelements()
+{
+    int num_nodes = static_cast<int>(nodes.size());
+    total_dof = num_nodes * 3;
+    if (forces.size() != total_dof)
+        forces.conservativeResizeLike(Eigen::VectorXd::Zero(total_dof));
+    if (displacement.size() != total_dof)
+        displacement = Eigen::VectorXd::Zero(total_dof);
+
+    TaskScheduler::instance().parallel_for(
+        0, static_cast<int>(beams.size()), 256, [this](int lo, int hi)
+        {
+            for (int i = lo; i < hi; ++i)
+                beams[i].compute_stiffness(nodes, materials_list, beam_profiles_list); },
+        TaskPriority::High, "element_stiffness");
+    supported_nodes.clear();
+    for (int i = 0; i < num_nodes; ++i)
+    {
+        if (nodes[i].constraint_type != Free)
+            supported_nodes.push_back(i);
+    }
+    dof_map.build(nodes, beams);
+    if (dof_map.num_reduced == 0)
+        return -1;
+
+    int result = superelements.condense(nodes, beams, materials_list, beam_profiles_list, dof_map, forces,
+                                        superelement_options);
+    if (result == 0)
+        result = superelements.solve();
+    if (debug)
+        std::cout << "Superelements: " << superelements.instance_count() << " instances of "
+                  << superelements.definition_count() << " substructures (" << superelements.condensations
+                  << " condensed, " << superelements.reuses << " reused), " << superelements.boundary_dofs()
+                  << " boundary of " << dof_map.num_reduced << " equations, "
+                  << superelements.condense_seconds + superelements.solve_seconds << " s" << std::endl;
+    return result;
+}
+
+int FEMSystem::show_superelements()
+{
+    if (superelements.boundary_solution().size() != dof_map.num_reduced || dof_map.total_dof != total_dof)
+        return -1;
+    Eigen::VectorXd x;
+    superelements.recover_all(x);
+    dof_map.expand(x, displacement);
+    invalidate_results();
+    return 0;
+}
+
+int FEMSystem::solve_topology()
+{
+    int num_nodes = static_cast<int>(nodes.size());
+    if (forces.size() != num_nodes * 3)
+        forces.conservativeResizeLike(Eigen::VectorXd::Zero(num_nodes * 3));
+
+    int result = optimize_topology(nodes, forces, topology_options, topology_results);
+    if (debug)
+        std::cout << "Topology: " << topology_results.potential_members << " potential members, "
+                  << topology_results.history.size() << " rounds, volume " << topology_results.volume << " m^3, "
+                  << topology_results.member_area.size() << " members in the layout, "
+                  << topology_results.wall_seconds << " s" << std::endl;
+    return result;
+}
+
+int FEMSystem::apply_topology(int material_idx)
+{
+    const TopologyResults &r = topology_results;
+    int count = static_cast<int>(r.member_area.size());
+    if (count == 0 || material_idx < 0 || material_idx >= static_cast<int>(materials_list.size()))
+        return -1;
+
+    // areas rounded up to 3 significant digits, one profile each
+    std::map<double, int> made;
+    beams.clear();
+    for (int k = 0; k < count; ++k)
+    {
+        double scale = std::pow(10.0, std::floor(std::log10(r.member_area[k])) - 2);
+        double area = std::ceil(r.member_area[k] / scale - 1e-9) * scale;
+        auto it = made.find(area);
+        if (it == made.end())
+        {
+            std::ostringstream name;
+            name << "Layout " << std::setprecision(3) << area;
+            BeamProfile profile;
+            profile.name = name.str();
+            profile.area = area;
+            profile.moment_of_inertia = 0.0;
+            profile.section_modulus = 0.0;
+            beam_profiles_list.push_back(profile);
+            it = made.emplace(area, static_cast<int>(beam_profiles_list.size()) - 1).first;
+        }
+        beams.emplace_back(r.member_nodes[k * 2], r.member_nodes[k * 2 + 1], material_idx, it->second, true);
+    }
+
+    nodes = r.nodes;
+    forces = r.forces;
+    total_dof = static_cast<int>(nodes.size()) * 3;
+    displacement = Eigen::VectorXd::Zero(total_dof);
+    reset_analyses();
+    solve_system();
+    return count;
+}
+
+void FEMSystem::show_shape(const Eigen::MatrixXd &shapes, int mode, double amplitude)
+{
+    if (mode < 0 || mode >= shapes.cols() || shapes.rows() != total_dof)
+        return;
+
+    // largest nodal translation of the shape, so `amplitude` is a real length
+    double peak = 0.0;
+    for (int i = 0; i < total_dof / 3; ++i)
+    {
+        double u = shapes(i * 3, mode);
+        double v = shapes(i * 3 + 1, mode);
+        peak = std::max(peak, std::sqrt(u * u + v * v));
+    }
+    if (peak <= 0.0)
+        peak = shapes.col(mode).cwiseAbs().maxCoeff();
+    if (peak <= 0.0)
+        return;
+
+    displacement = shapes.col(mode) * (amplitude / peak);
+    invalidate_results();
+}
+
 void FEMSystem::assemble_global_stiffness()
 {
     int num_nodes = static_cast<int>(nodes.size());
@@ -5,6 +5,30 @@
 #include "node.h"
 #include "beam.h"
 #include "beam_props.h"
+#include "element_cache.h"
+#include "stress_recovery.h"
+#include "result_queries.h"
+#include "dof_map.h"
+#include "sparse_solver.h"
+#include "modal_analysis.h"
+#include "buckling_analysis.h"
+#include "nonlinear_solver.h"
+#include "transient_analysis.h"
+#include "modal_superposition.h"
+#include "frequency_response.h"
+#include "response_spectrum.h"
+#include "active_set.h"
+#include "pushover.h"
+#include "moving_load.h"
+#include "sensitivity.h"
+#include "sizing.h"
+#include "topology.h"
+#include "shape.h"
+#include "sweep.h"
+#include "reliability.h"
+#include "redundancy.h"
+#include "reduced_model.h"
+#include "superelement.h"
 #include <iostream>
 #include <cmath>
 
@@ -43,13 +67,155 @@ public:
     double stressToDisplay(double Pa) const; // Pa -> MPa or psi etc.
     double stressFromDisplay(double display) const;
 
+    double densityToDisplay(double kg_m3) const; // kg/m^3 -> kg/m^3, lb/ft^3 or lb/in^3
+    double densityFromDisplay(double display) const;
+
+    double momentToDisplay(double Nm) const; // N m -> N m, lbf ft or lbf in
+    double momentFromDisplay(double display) const;
+
+    double massToDisplay(double kg) const; // kg -> kg or lb
+
     // set unit system and recompute any cached values
     void setUnitSystem(UnitSystem u);
 
     void generate_constraint_row(Eigen::MatrixXd &C, int row_index, int node_id, const std::vector<int> &free_dof_indices);
+    // static solve of the current forces; with tension-/compression-only members this is the
+    // active-set iteration (-3: the remaining members form a mechanism, or every member together
+    // does and the dense fallback ignored the one-way flags; -4: the set did not settle)
     int solve_system();
     void assemble_global_stiffness();
 
+    // Result views. solve_system() only produces displacements; each view below is
+    // recovered from them on first access and cached until the next solve, so callers
+    // that only need displacements (sweeps, optimizer loops) never pay for the rest.
+    const Eigen::VectorXd &get_displacements() const;
+    const ElementForces &get_element_forces() const; // local end forces {P, V, M} per beam
+    const std::vector<float> &get_stresses();         // also updates Beam::stress/axial_force/max_moment
+    const Eigen::VectorXd &get_reactions() const;     // nonzero at supported nodes only
+    const EquilibriumTotals &get_equilibrium() const;
+    const StationResults &get_stations() const; // num_stations points along every member
+    // top_k most stressed members, percentile color range and histogram of the stresses
+    const StressSummary &get_stress_summary() const;
+    // drop every cached view (call after changing displacement or forces by hand)
+    void invalidate_results();
+    // drop every analysis result and the node and member references of the analysis options
+    // (call after editing, deleting or loading nodes, members, supports, sections or loads)
+    void reset_analyses();
+    // recompute element forces/stresses for the current displacement without touching the stiffness
+    void recover_stresses();
+
+    // lowest `count` natural frequencies and mode shapes into modal_results
+    int solve_modes(int count, bool lumped = false);
+    // load mode `mode` into `displacement` (scaled so its largest translation is `amplitude`)
+    // so it renders through the normal deformed-shape path; solve_system() restores the statics
+    void show_mode(int mode, double amplitude);
+
+    // linear buckling about the static solution for the current forces: the lowest `count`
+    // load factors into buckling_results (reuses the static factorization)
+    int solve_buckling(int count);
+    void show_buckling_mode(int mode, double amplitude); // like show_mode
+
+    // dynamic response to forces * transient_options.load(t) by implicit time integration;
+    // the stored frames go into transient_results and the last one is shown
+    int solve_transient();
+    void show_transient_frame(int frame); // load a stored frame into displacement
+
+    // fast dynamic preview by mode superposition: solves the lowest `modes` modes once and
+    // sets up modal_response for the current forces and transient_options.load. The stress
+    // summary (color range, critical members, histogram) is taken from a modal envelope here
+    // and held, and reactions are not recovered, until something else is shown.
+    int prepare_modal_response(int modes, double damping_ratio);
+    // advance modal_response to time t and rebuild displacement for `visible_nodes` only and
+    // the element forces of `visible_members` only (every node and member when null), so a
+    // frame costs O(modes * visible nodes). Entries off screen keep older frames' values.
+    void show_modal_response(double t, const std::vector<int> *visible_nodes = nullptr,
+                             const std::vector<int> *visible_members = nullptr);
+    bool modal_preview_shown() const { return modal_preview; }
+
+    // steady-state harmonic response to forces * sin(w t) over frequency_options' range,
+    // by mode superposition or direct complex solves, into frequency_results
+    int solve_frequency_response();
+
+    // seismic peak response from spectrum_options by SRSS/CQC modal combination; the member
+    // envelopes are then shown through the normal result views (stress, axial_force, ...)
+    int solve_response_spectrum();
+    void show_spectrum_envelope(); // load spectrum_results back into the result views
+
+    // geometrically nonlinear (corotational) static solve of the current forces with
+    // nonlinear_options; ends showing the last converged increment
+    int solve_nonlinear();
+    // load increment `increment` of nonlinear_results into displacement and the result views
+    // (the member forces are the corotational ones, not a linear recovery); ignored if the
+    // node or member count changed since
+    void show_increment(int increment);
+
+    // plastic hinge pushover of forces * lambda with pushover_options: hinges form where the
+    // end moments reach the profiles' plastic_moment until a collapse mechanism (-3: the
+    // elastic structure already is one); ends showing the last step
+    int solve_pushover();
+    void show_pushover_step(int step); // load a stored step, with its hinges in hinge_ends
+
+    // influence lines of every member for a unit downward load travelling along
+    // moving_load_options.deck_nodes, from the static factorization
+    int solve_influence_lines();
+    // envelopes of moving_load_options.train crossing the deck (the influence lines are
+    // recomputed first if the deck or the member count changed); ends showing the envelope
+    int solve_moving_load();
+    void show_moving_load_envelope(); // load moving_load_results back into the result views
+
+    // adjoint derivatives of each of sensitivity_responses with respect to every member's area,
+    // inertia and modulus and every node's coordinates, about the static solution of the
+    // current forces (one back-substitution per response on the static factorization)
+    int solve_sensitivities();
+
+    // minimum-weight member sizes under sizing_options' stress and deflection limits for the
+    // current forces, into sizing_results (the model itself is left unchanged)
+    int solve_sizing();
+    // give every member its sizing_results section: the chosen library profile, or new profiles
+    // for continuous areas; re-solves and returns how many members changed (-1: no results)
+    int apply_sizing();
+
+    // minimum-volume truss layout for the current supports and loads on a ground structure
+    // grid over the model (topology_options), into topology_results
+    int solve_topology();
+    // replace the model by the layout: truss members of material `material_idx`, one new
+    // profile per distinct area; drops every result and option that indexes the old nodes or
+    // members, re-solves and returns the member count (-1: no layout)
+    int apply_topology(int material_idx);
+
+    // node coordinates (shape_options.variables, within their bounds) that minimize the weight
+    // or the largest stress for the current forces, into shape_results (the model is unchanged)
+    int solve_shape();
+    // move the variables' nodes to shape_results; re-solves and returns how many coordinates
+    // were set (-1: no results for the current variables)
+    int apply_shape();
+
+    // the model at every combination of sweep_options' parameter values, run in parallel into
+    // sweep_results' table (the model itself is left unchanged)
+    int solve_sweep();
+
+    // Monte Carlo failure probability and member stress distributions for the uncertain
+    // inputs in reliability_options, into reliability_results (the model is left unchanged)
+    int solve_reliability();
+
+    // the response with each member removed in turn, ranked by severity into
+    // redundancy_results (the model is left unchanged)
+    int solve_redundancy();
+
+    // reduced-basis model of the static solve over rom_options' parameters, trained greedily
+    // from full solves; queries go through reduced_model.solve() (the model is left unchanged)
+    int build_reduced_model();
+
+    // copies of `members` (and their nodes) shifted by k * (dx, dy) for k = 1..copies, merged
+    // with the nodes already there; the original and every copy become superelement instances.
+    // Returns the number of members added, -1 if a member does not exist
+    int place_substructure(const std::vector<int> &members, double dx, double dy, int copies);
+    // static solve through superelements: the instances' interiors are condensed (reusing the
+    // cached condensations) and only the boundary is solved; `displacement` is left unchanged
+    int solve_superelements();
+    // every instance's interior recovered in parallel into `displacement` and the result views
+    int show_superelements();
+
     std::vector<Node> nodes;
     std::vector<Beam> beams;
     std::vector<MaterialProfile> materials_list;
@@ -57,9 +223,86 @@ public:
     Eigen::MatrixXd global_k_matrix;
     Eigen::VectorXd forces;       // forces in x and y directions [F1x, F1y, F2x, F2y, ...]
     Eigen::VectorXd displacement; // displacements in x and y [u1, v1, u2, v2, ...]
-    Eigen::VectorXd reactions;    // reaction forces/moments at DOFs (computed after solve)
+    mutable Eigen::VectorXd reactions; // reaction forces/moments at DOFs (see get_reactions())
     bool debug = false;           // enable verbose printing for debugging
     int total_dof;
-    float max_stress;
-    float min_stress;
+    mutable float max_stress = 0.0f; // valid after get_stresses()
+    mutable float min_stress = 0.0f;
+
+    mutable ElementCache element_cache;   // SoA per-beam geometry/section data, rebuilt per static solve
+    mutable ElementForces element_forces; // backing store of get_element_forces()
+    std::vector<int> supported_nodes;     // nodes with any constraint, refreshed every solve
+    mutable std::vector<int> reaction_nodes; // supports whose entries in `reactions` were last written
+    mutable EquilibriumTotals equilibrium;   // backing store of get_equilibrium()
+    int num_stations = 5;                    // stations per member for station results (>= 2)
+    mutable StationResults station_results;  // backing store of get_stations()
+    int top_k = 20;                          // members listed by get_stress_summary()
+    float color_percentile = 98.0f;          // color range clips the outer (100 - p)% of stresses
+    int histogram_bins = 40;
+    mutable StressSummary stress_summary;    // backing store of get_stress_summary()
+
+    DofMap dof_map;               // reduced equation numbering of the sparse solvers
+    SparseMatrix reduced_stiffness; // K in dof_map numbering from the last solve_system()
+    SparseSolver static_solver;   // its factorization (invalid if the dense fallback was used)
+    ActiveSetOptions active_set_options;
+    ActiveSetResults active_set_results; // of the last solve_system() with tension/compression-only members
+    std::vector<char> member_active;     // members carrying force in `displacement` (empty: all of them)
+    ModalResults modal_results;  // from the last solve_modes()
+    BucklingResults buckling_results; // from the last solve_buckling()
+    NonlinearOptions nonlinear_options;
+    NonlinearResults nonlinear_results; // from the last solve_nonlinear()
+    SparseSolver tangent_solver;        // keeps its ordering between nonlinear solves
+    TransientOptions transient_options;
+    TransientResults transient_results; // from the last solve_transient()
+    SparseSolver transient_solver;      // factored effective stiffness of the last run
+    ModalSuperposition modal_response;  // set up by prepare_modal_response()
+    FrequencyResponseOptions frequency_options;
+    FrequencyResponseResults frequency_results; // from the last solve_frequency_response()
+    ResponseSpectrumOptions spectrum_options;
+    ResponseSpectrumResults spectrum_results;   // from the last solve_response_spectrum()
+    PushoverOptions pushover_options;
+    PushoverResults pushover_results; // from the last solve_pushover()
+    SparseSolver pushover_solver;     // elastic K, or the last rebase of the hinged structure
+    std::vector<int> hinge_ends;      // plastic hinges open in `displacement` (2 * member + end)
+    MovingLoadOptions moving_load_options;
+    InfluenceLines influence_lines;       // from the last solve_influence_lines()
+    MovingLoadResults moving_load_results; // from the last solve_moving_load()
+    std::vector<SensitivityResponse> sensitivity_responses;
+    SensitivityResults sensitivity_results; // from the last solve_sensitivities()
+    SizingOptions sizing_options;
+    SizingResults sizing_results; // from the last solve_sizing()
+    SparseSolver sizing_solver;   // K of the last refactor inside the optimizer
+    TopologyOptions topology_options;
+    TopologyResults topology_results; // from the last solve_topology()
+    ShapeOptions shape_options;
+    ShapeResults shape_results; // from the last solve_shape()
+    SweepOptions sweep_options;
+    SweepResults sweep_results; // from the last solve_sweep()
+    ReliabilityOptions reliability_options;
+    ReliabilityResults reliability_results; // from the last solve_reliability()
+    RedundancyOptions redundancy_options;
+    RedundancyResults redundancy_results; // from the last solve_redundancy()
+    RomOptions rom_options;
+    ReducedModel reduced_model; // from the last build_reduced_model()
+    SuperelementOptions superelement_options;
+    SuperelementModel superelements; // condensations persist between solve_superelements()
+
+private:
+    int solve_dense();
+    int current_static_factorization(); // solve_system() with static_solver holding its K
+    void assemble_dynamic(bool lumped, SparseMatrix &K, SparseMatrix &M); // element K, M and dof_map
+    void show_shape(const Eigen::MatrixXd &shapes, int mode, double amplitude);
+    void refresh_element_cache() const; // rebuild element_cache if the model changed since
+
+    // element_cache matches the model (built by solve_system(), cleared by reset_analyses())
+    mutable bool element_cache_valid = false;
+
+    // which views are current for the last solve
+    mutable bool forces_valid = false;
+    mutable bool stresses_valid = false;
+    mutable bool reactions_valid = false;
+    mutable bool stations_valid = false;
+    mutable bool summary_valid = false;
+    bool envelope_shown = false; // element_forces holds an envelope, not one load state
+    bool modal_preview = false;  // show_modal_response() frames with a held summary
 };
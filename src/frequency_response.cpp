@@ -0,0 +1,286 @@
+#include "frequency_response.h"
+#include "task_scheduler.h"
+#include <Eigen/SparseLU>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <complex>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+namespace
+{
+    typedef std::complex<double> Complex;
+    typedef Eigen::SparseMatrix<Complex> ComplexSparse;
+
+    bool valid_options(const FrequencyResponseOptions &options)
+    {
+        return options.num_frequencies >= 1 && options.min_frequency >= 0.0 &&
+               options.max_frequency >= options.min_frequency &&
+               !(options.log_spacing && options.min_frequency <= 0.0);
+    }
+
+    void allocate(const FrequencyResponseOptions &options, int members, FrequencyResponseResults &out)
+    {
+        out = FrequencyResponseResults();
+        out.frequency = sweep_frequencies(options);
+        out.num_frequencies = static_cast<int>(out.frequency.size());
+        out.num_members = members;
+        out.member_displacement.assign(static_cast<size_t>(members) * out.num_frequencies, 0.0f);
+        out.member_stress.assign(static_cast<size_t>(members) * out.num_frequencies, 0.0f);
+        out.peak_displacement.assign(out.num_frequencies, 0.0f);
+        out.peak_stress.assign(out.num_frequencies, 0.0f);
+        out.peak_member.assign(out.num_frequencies, -1);
+    }
+
+    // local axial force and end moments of one member for a real global displacement vector
+    // (same element arithmetic as recover_element_forces)
+    void end_forces(const ElementCache &cache, int i, const double *u, double &P, double &Ma, double &Mb)
+    {
+        const double *d1 = u + cache.n1[i] * 3;
+        const double *d2 = u + cache.n2[i] * 3;
+        double c = cache.c[i];
+        double s = cache.s[i];
+
+        double u1 = c * d1[0] + s * d1[1];
+        double w1 = -s * d1[0] + c * d1[1];
+        double u2 = c * d2[0] + s * d2[1];
+        double w2 = -s * d2[0] + c * d2[1];
+
+        double L = cache.length[i];
+        double inv_L = L > 1e-9 ? 1.0 / L : 0.0;
+        double EI_L = cache.ei_over_l[i];
+        double EI_L2 = EI_L * inv_L;
+        double dw = w1 - w2;
+
+        P = cache.ea_over_l[i] * (u2 - u1);
+        Ma = 6.0 * EI_L2 * dw + EI_L * (4.0 * d1[2] + 2.0 * d2[2]);
+        Mb = 6.0 * EI_L2 * dw + EI_L * (2.0 * d1[2] + 4.0 * d2[2]);
+    }
+
+    // largest |u(t)| over a cycle of u(t) = re cos(wt) - im sin(wt): the major semi-axis of the
+    // ellipse the node traces
+    double peak_translation(double xr, double yr, double xi, double yi)
+    {
+        double rr = xr * xr + yr * yr;
+        double ii = xi * xi + yi * yi;
+        double ri = xr * xi + yr * yi;
+        double half = 0.5 * (rr - ii);
+        return std::sqrt(0.5 * (rr + ii) + std::sqrt(half * half + ri * ri));
+    }
+
+    // member amplitudes at frequency k from the real and imaginary global displacements
+    void record_frequency(const ElementCache &cache, const double *re, const double *im, int k,
+                          FrequencyResponseResults &out)
+    {
+        int nf = out.num_frequencies;
+        float peak_u = 0.0f;
+        float peak_s = 0.0f;
+        int peak_member = -1;
+
+        for (int i = 0; i < cache.count; ++i)
+        {
+            const double *r1 = re + cache.n1[i] * 3;
+            const double *r2 = re + cache.n2[i] * 3;
+            const double *i1 = im + cache.n1[i] * 3;
+            const double *i2 = im + cache.n2[i] * 3;
+            double u = std::max(peak_translation(r1[0], r1[1], i1[0], i1[1]),
+                                peak_translation(r2[0], r2[1], i2[0], i2[1]));
+
+            // every fibre stress is harmonic too, so its amplitude is the modulus
+            double Pr, Mar, Mbr, Pi, Mai, Mbi;
+            end_forces(cache, i, re, Pr, Mar, Mbr);
+            end_forces(cache, i, im, Pi, Mai, Mbi);
+            Complex axial = Complex(Pr, Pi) * cache.inv_area[i];
+            Complex bend_a = Complex(Mar, Mai) * cache.inv_section_modulus[i];
+            Complex bend_b = Complex(Mbr, Mbi) * cache.inv_section_modulus[i];
+            double stress = std::max(std::max(std::abs(axial + bend_a), std::abs(axial - bend_a)),
+                                     std::max(std::abs(axial + bend_b), std::abs(axial - bend_b)));
+
+            size_t slot = static_cast<size_t>(i) * nf + k;
+            out.member_displacement[slot] = static_cast<float>(u);
+            out.member_stress[slot] = static_cast<float>(stress);
+
+            peak_u = std::max(peak_u, static_cast<float>(u));
+            if (peak_member < 0 || stress > peak_s)
+            {
+                peak_s = static_cast<float>(stress);
+                peak_member = i;
+            }
+        }
+
+        out.peak_displacement[k] = peak_u;
+        out.peak_stress[k] = peak_s;
+        out.peak_member[k] = peak_member;
+    }
+} // namespace
+
+std::vector<double> sweep_frequencies(const FrequencyResponseOptions &options)
+{
+    std::vector<double> f;
+    if (!valid_options(options))
+        return f;
+
+    int n = options.num_frequencies;
+    f.resize(n);
+    for (int k = 0; k < n; ++k)
+    {
+        double x = n > 1 ? static_cast<double>(k) / (n - 1) : 0.0;
+        if (options.log_spacing)
+            f[k] = options.min_frequency * std::pow(options.max_frequency / options.min_frequency, x);
+        else
+            f[k] = options.min_frequency + (options.max_frequency - options.min_frequency) * x;
+    }
+    return f;
+}
+
+int frequency_response_modal(const ModalResults &modal,
+                             const ElementCache &cache,
+                             const Eigen::VectorXd &forces,
+                             const FrequencyResponseOptions &options,
+                             FrequencyResponseResults &out)
+{
+    out = FrequencyResponseResults();
+    if (!valid_options(options))
+        return -3;
+    int m = std::min(options.modes, modal.count);
+    if (m <= 0 || modal.shapes.rows() != forces.size())
+        return -1;
+
+    auto start = std::chrono::steady_clock::now();
+    allocate(options, cache.count, out);
+    out.modes_used = m;
+
+    const Eigen::MatrixXd basis = modal.shapes.leftCols(m);
+    Eigen::VectorXd p = basis.transpose() * forces;
+    Eigen::VectorXd c(m); // modal damping 2 zeta w_k (+ Rayleigh)
+    for (int j = 0; j < m; ++j)
+    {
+        double w = modal.omega[j];
+        c(j) = 2.0 * options.damping_ratio * w + options.rayleigh_mass + options.rayleigh_stiffness * w * w;
+    }
+
+    // a block of frequencies turns into two matrix products instead of many mat-vecs
+    const int block = 8;
+    std::atomic<bool> failed{false};
+    TaskScheduler::instance().parallel_for(
+        0, out.num_frequencies, block, [&](int lo, int hi)
+        {
+            for (int first = lo; first < hi; first += block)
+            {
+                int count = std::min(block, hi - first);
+                Eigen::MatrixXd q_re(m, count), q_im(m, count);
+                bool resonant[block] = {};
+                for (int b = 0; b < count; ++b)
+                {
+                    double W = 2.0 * M_PI * out.frequency[first + b];
+                    for (int j = 0; j < m; ++j)
+                    {
+                        double w = modal.omega[j];
+                        Complex h = Complex(w * w - W * W, W * c(j));
+                        if (std::abs(h) == 0.0)
+                        {
+                            // undamped resonance: unbounded, like the singular direct matrix
+                            resonant[b] = true;
+                            h = Complex(1.0, 0.0);
+                        }
+                        Complex q = p(j) / h;
+                        q_re(j, b) = q.real();
+                        q_im(j, b) = q.imag();
+                    }
+                }
+
+                Eigen::MatrixXd u_re = basis * q_re;
+                Eigen::MatrixXd u_im = basis * q_im;
+                for (int b = 0; b < count; ++b)
+                {
+                    if (resonant[b])
+                    {
+                        failed = true; // left at zero response, as the direct sweep does
+                        continue;
+                    }
+                    record_frequency(cache, u_re.col(b).data(), u_im.col(b).data(), first + b, out);
+                }
+            } },
+        TaskPriority::High, "frf_modal");
+
+    out.wall_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return failed ? -1 : 0;
+}
+
+int frequency_response_direct(const DofMap &map,
+                              const SparseMatrix &K,
+                              const SparseMatrix &M,
+                              const ElementCache &cache,
+                              const Eigen::VectorXd &forces,
+                              const FrequencyResponseOptions &options,
+                              FrequencyResponseResults &out)
+{
+    out = FrequencyResponseResults();
+    if (!valid_options(options) || map.num_reduced == 0)
+        return -3;
+
+    auto start = std::chrono::steady_clock::now();
+    allocate(options, cache.count, out);
+
+    const ComplexSparse Kc = K.cast<Complex>();
+    const ComplexSparse Mc = M.cast<Complex>();
+    const Eigen::VectorXcd F_r = map.restrict(forces).cast<Complex>();
+
+    // one LU per range of frequencies; the pattern of K - w^2 M + i w C never changes, so each
+    // LU only computes its column ordering once
+    struct PatternLU
+    {
+        Eigen::SparseLU<ComplexSparse> lu;
+        bool analyzed = false;
+    };
+    ScratchPool<PatternLU> pool;
+    std::atomic<int> factorizations{0};
+    std::atomic<bool> failed{false};
+
+    TaskScheduler::instance().parallel_for(
+        0, out.num_frequencies, 1, [&](int lo, int hi)
+        {
+            PatternLU *scratch = pool.acquire();
+            Eigen::SparseLU<ComplexSparse> &lu = scratch->lu;
+            ComplexSparse A;
+            Eigen::VectorXd re, im, re_global, im_global;
+
+            for (int k = lo; k < hi; ++k)
+            {
+                double W = 2.0 * M_PI * out.frequency[k];
+                A = Complex(1.0, W * options.rayleigh_stiffness) * Kc +
+                    Complex(-W * W, W * options.rayleigh_mass) * Mc;
+                A.makeCompressed();
+
+                if (!scratch->analyzed)
+                {
+                    lu.isSymmetric(true); // K and M are, so prefer diagonal pivots
+                    lu.analyzePattern(A);
+                    scratch->analyzed = true;
+                }
+                lu.factorize(A);
+                factorizations++;
+                if (lu.info() != Eigen::Success)
+                {
+                    failed = true; // left at zero response
+                    continue;
+                }
+
+                Eigen::VectorXcd x = lu.solve(F_r);
+                re = x.real();
+                im = x.imag();
+                map.expand(re, re_global);
+                map.expand(im, im_global);
+                record_frequency(cache, re_global.data(), im_global.data(), k, out);
+            }
+            pool.release(scratch); },
+        TaskPriority::High, "frf_direct");
+
+    out.factorizations = factorizations;
+    out.wall_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return failed ? -1 : 0;
+}
@@ -0,0 +1,74 @@
+#pragma once
+#include <vector>
+#include <Eigen/Eigen>
+#include "dof_map.h"
+#include "element_cache.h"
+#include "modal_analysis.h"
+
+struct FrequencyResponseOptions
+{
+    enum Method
+    {
+        Modal, // superpose the lowest `modes` modes (fast, approximate above the last mode)
+        Direct // one complex sparse solve per frequency (exact, every mode included)
+    };
+
+    Method method = Modal;
+    double min_frequency = 0.5;  // Hz
+    double max_frequency = 50.0; // Hz
+    int num_frequencies = 200;
+    bool log_spacing = false;
+    int modes = 20;              // modal basis size
+    double damping_ratio = 0.02; // modal method: viscous ratio added to every mode
+    double rayleigh_mass = 0.0;  // C = rayleigh_mass * M + rayleigh_stiffness * K (both methods)
+    double rayleigh_stiffness = 0.0;
+    bool lumped_mass = false;
+};
+
+// Steady-state amplitudes of the response to forces * sin(omega t), per member and frequency.
+// Member arrays are member-major, value[member * num_frequencies + k], so one member's curve
+// is contiguous for plotting; floats keep hundreds of frequencies affordable on large models.
+struct FrequencyResponseResults
+{
+    int num_frequencies = 0;
+    int num_members = 0;
+    std::vector<double> frequency;          // Hz
+    std::vector<float> member_displacement; // largest translation of either end over a cycle
+    std::vector<float> member_stress;       // largest |combined fibre stress| at either end over a cycle
+
+    // envelope over all members at each frequency
+    std::vector<float> peak_displacement;
+    std::vector<float> peak_stress;
+    std::vector<int> peak_member; // member with the peak stress
+
+    int modes_used = 0;     // modal method
+    int factorizations = 0; // direct method
+    double wall_seconds = 0.0;
+};
+
+// the frequencies of a sweep, in Hz (evenly or geometrically spaced, ends included)
+std::vector<double> sweep_frequencies(const FrequencyResponseOptions &options);
+
+// Modal sweep from mass-normalized modes: q_k = phi_k^T F / (w_k^2 - w^2 + i w c_k) with
+// c_k = 2 zeta w_k + rayleigh_mass + rayleigh_stiffness w_k^2. Frequencies are handled in
+// blocks across the scheduler, each block rebuilding its displacements with one product.
+// Returns 0 on success, -1 if there are no modes or a frequency sits exactly on an undamped
+// mode (that frequency is left at zero response, as in the direct sweep), -3 for bad options.
+int frequency_response_modal(const ModalResults &modal,
+                             const ElementCache &cache,
+                             const Eigen::VectorXd &forces,
+                             const FrequencyResponseOptions &options,
+                             FrequencyResponseResults &out);
+
+// Direct sweep: (K - w^2 M + i w C) u = F solved on the reduced equations of `map` for every
+// frequency. The complex matrices all share one pattern, so each thread analyzes it once and
+// only refactors numerically per frequency. damping_ratio is not used (no modes to apply it to).
+// Returns 0 on success, -1 if a frequency hit a singular matrix (undamped resonance),
+// -3 for bad options.
+int frequency_response_direct(const DofMap &map,
+                              const SparseMatrix &K,
+                              const SparseMatrix &M,
+                              const ElementCache &cache,
+                              const Eigen::VectorXd &forces,
+                              const FrequencyResponseOptions &options,
+                              FrequencyResponseResults &out);
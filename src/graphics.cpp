@@ -260,6 +260,54 @@ void GraphicsRenderer::updateView(sf::RenderWindow &window)
     view.setCenter(viewCenter);
     view.setSize(sf::Vector2f(viewSize.x, -viewSize.y)); // negative y = y-up
     window.setView(view);
+
+    // culling rectangle, with a margin so deformed members near the edge still show
+    float margin = 0.1f;
+    cullLeft = viewCenter.x - viewSize.x * (0.5f + margin);
+    cullRight = viewCenter.x + viewSize.x * (0.5f + margin);
+    cullBottom = viewCenter.y - viewSize.y * (0.5f + margin);
+    cullTop = viewCenter.y + viewSize.y * (0.5f + margin);
+}
+
+void GraphicsRenderer::updateVisibility() const
+{
+    size_t num_nodes = system.nodes.size();
+    size_t num_beams = system.beams.size();
+    nodeVisible.assign(num_nodes, 0);
+    beamVisible.assign(num_beams, 0);
+    visibleBeamList.clear();
+
+    for (size_t i = 0; i < num_nodes; ++i)
+    {
+        float x = static_cast<float>(system.nodes[i].position[0]);
+        float y = static_cast<float>(system.nodes[i].position[1]);
+        nodeVisible[i] = (x >= cullLeft && x <= cullRight && y >= cullBottom && y <= cullTop) ? 1 : 0;
+    }
+
+    // a member is drawn when its bounding box overlaps the view, and then so are both its ends
+    for (size_t i = 0; i < num_beams; ++i)
+    {
+        const Node &a = system.nodes[system.beams[i].nodes[0]];
+        const Node &b = system.nodes[system.beams[i].nodes[1]];
+        float x0 = static_cast<float>(std::min(a.position[0], b.position[0]));
+        float x1 = static_cast<float>(std::max(a.position[0], b.position[0]));
+        float y0 = static_cast<float>(std::min(a.position[1], b.position[1]));
+        float y1 = static_cast<float>(std::max(a.position[1], b.position[1]));
+        if (x1 < cullLeft || x0 > cullRight || y1 < cullBottom || y0 > cullTop)
+            continue;
+
+        beamVisible[i] = 1;
+        visibleBeamList.push_back(static_cast<int>(i));
+        nodeVisible[system.beams[i].nodes[0]] = 1;
+        nodeVisible[system.beams[i].nodes[1]] = 1;
+    }
+
+    visibleNodeList.clear();
+    for (size_t i = 0; i < num_nodes; ++i)
+    {
+        if (nodeVisible[i])
+            visibleNodeList.push_back(static_cast<int>(i));
+    }
 }
 
 void GraphicsRenderer::drawGrid(sf::RenderWindow &window) const
@@ -342,6 +390,12 @@ float GraphicsRenderer::getViewScale(const sf::RenderWindow &window) const
     return scale;
 }
 
+sf::Color GraphicsRenderer::getStressColor(float stress) const
+{
+    const StressSummary &summary = system.get_stress_summary();
+    return getStressColor(stress, summary.color_min, summary.color_max);
+}
+
 sf::Color GraphicsRenderer::getStressColor(float stress, float min_stress, float max_stress) const
 {
     float abs_max = std::max(std::abs(min_stress), std::abs(max_stress));
@@ -350,7 +404,7 @@ sf::Color GraphicsRenderer::getStressColor(float stress, float min_stress, float
         return sf::Color(200, 200, 200); // Light gray for zero stress
     }
 
-    float normalized = stress / abs_max; // Range: -1 to 1
+    float normalized = std::min(std::max(stress / abs_max, -1.0f), 1.0f); // Range: -1 to 1
 
     if (normalized < 0)
     {
@@ -372,6 +426,21 @@ sf::Color GraphicsRenderer::getStressColor(float stress, float min_stress, float
     }
 }
 
+sf::Color GraphicsRenderer::getSensitivityColor(float value) const
+{
+    if (sensitivityRange <= 0.0f)
+        return sf::Color(200, 200, 200);
+
+    float t = std::min(std::abs(value) / sensitivityRange, 1.0f);
+    if (value < 0)
+    {
+        // White -> Green
+        return sf::Color(static_cast<uint8_t>(255 * (1 - t)), static_cast<uint8_t>(255 - 95 * t), static_cast<uint8_t>(255 * (1 - t)));
+    }
+    // White -> Orange
+    return sf::Color(255, static_cast<uint8_t>(255 - 115 * t), static_cast<uint8_t>(255 * (1 - t)));
+}
+
 void GraphicsRenderer::drawThickLine(sf::RenderTarget &target,
                                      const sf::Vector2f &a,
                                      const sf::Vector2f &b,
@@ -454,6 +523,48 @@ void GraphicsRenderer::drawCubicBezierThick(sf::RenderTarget &target,
     }
 }
 
+void GraphicsRenderer::drawCubicBezierStations(sf::RenderTarget &target,
+                                               const sf::Vector2f &p0,
+                                               const sf::Vector2f &p1,
+                                               const sf::Vector2f &p2,
+                                               const sf::Vector2f &p3,
+                                               float thickness,
+                                               const float *station_stress,
+                                               int stations,
+                                               int segments) const
+{
+    if (segments < 1)
+        segments = 1;
+
+    sf::Vector2f previousPoint = p0;
+
+    for (int i = 1; i <= segments; ++i)
+    {
+        float t = static_cast<float>(i) / segments;
+        float u = 1.0f - t;
+        float tt = t * t;
+        float uu = u * u;
+        float uuu = uu * u;
+        float ttt = tt * t;
+
+        sf::Vector2f currentPoint =
+            (uuu * p0) +
+            (3 * uu * t * p1) +
+            (3 * u * tt * p2) +
+            (ttt * p3);
+
+        // stress at the segment midpoint, linearly interpolated between neighbouring stations
+        float t_mid = (static_cast<float>(i) - 0.5f) / segments;
+        float station_pos = t_mid * (stations - 1);
+        int k = std::min(static_cast<int>(station_pos), stations - 2);
+        float frac = station_pos - k;
+        float stress = station_stress[k] * (1.0f - frac) + station_stress[k + 1] * frac;
+
+        drawThickLine(target, previousPoint, currentPoint, thickness, getStressColor(stress));
+        previousPoint = currentPoint;
+    }
+}
+
 void GraphicsRenderer::drawSystem(sf::RenderWindow &window) const
 {
     // Draw grid background first
@@ -476,6 +587,9 @@ void GraphicsRenderer::drawSystem(sf::RenderWindow &window) const
     float nodeSize = baseNodeSize * viewScale;
     float arrowSize = baseArrowSize * viewScale;
 
+    // skip everything outside the view (large models)
+    updateVisibility();
+
     // draw undeformed system under the deformed one when toggled on
     if (visualize_undeformed)
     {
@@ -485,6 +599,8 @@ void GraphicsRenderer::drawSystem(sf::RenderWindow &window) const
         // draw beams (undeformed positions)
         for (size_t i = 0; i < system.beams.size(); ++i)
         {
+            if (!beamVisible[i])
+                continue;
             const auto &beam = system.beams[i];
             int n1_idx = beam.nodes[0];
             int n2_idx = beam.nodes[1];
@@ -535,6 +651,8 @@ void GraphicsRenderer::drawSystem(sf::RenderWindow &window) const
         // draw undeformed nodes
         for (size_t idx = 0; idx < system.nodes.size(); ++idx)
         {
+            if (!nodeVisible[idx])
+                continue;
             const auto &node = system.nodes[idx];
             sf::Vector2f pos(static_cast<float>(node.position[0]), static_cast<float>(node.position[1]));
 
@@ -550,13 +668,20 @@ void GraphicsRenderer::drawSystem(sf::RenderWindow &window) const
     // -------------------------
     // Draw beams with stress-based colors (deformed)
     // -------------------------
+    // recovered on the first frame after a solve, cached after that
+    const std::vector<float> &stress = system.get_element_forces().stress;
     for (size_t i = 0; i < system.beams.size(); ++i)
     {
+        if (!beamVisible[i])
+            continue;
         const auto &beam = system.beams[i];
         int n1_idx = beam.nodes[0];
         int n2_idx = beam.nodes[1];
 
-        sf::Color beamColor = getStressColor(beam.stress, system.min_stress, system.max_stress);
+        bool bySensitivity = colorBySensitivity && sensitivityField.size() == system.beams.size();
+        sf::Color beamColor = bySensitivity ? getSensitivityColor(sensitivityField[i]) : getStressColor(stress[i]);
+        if (i < system.member_active.size() && !system.member_active[i])
+            beamColor = sf::Color(150, 150, 150, 110); // slack tension-/compression-only member
 
         // 1. Get Displaced Endpoints positions (P0 and P3 for Bezier)
         sf::Vector2f p0_displaced(
@@ -619,8 +744,21 @@ void GraphicsRenderer::drawSystem(sf::RenderWindow &window) const
                                                      std::cos(tangent2Angle) * controlDist2,
                                                      std::sin(tangent2Angle) * controlDist2);
 
-        // Draw the curved beam
-        drawCubicBezierThick(window, p0_displaced, p1_control, p2_control, p3_displaced, beamThickness, beamColor, curveSegments);
+        // Draw the curved beam (a modal preview frame only recovers the members on screen, so
+        // it is colored by end stresses rather than stations of every member)
+        const StationResults *stations = colorByStation && !bySensitivity && !system.modal_preview_shown()
+                                             ? &system.get_stations()
+                                             : nullptr;
+        if (stations && stations->stations >= 2 &&
+            stations->stress.size() == system.beams.size() * static_cast<size_t>(stations->stations))
+        {
+            const float *station_stress = stations->stress.data() + i * stations->stations;
+            drawCubicBezierStations(window, p0_displaced, p1_control, p2_control, p3_displaced, beamThickness, station_stress, stations->stations, curveSegments);
+        }
+        else
+        {
+            drawCubicBezierThick(window, p0_displaced, p1_control, p2_control, p3_displaced, beamThickness, beamColor, curveSegments);
+        }
 
         // Draw beam number label at the true center of the Bezier curve
         // fun calculation time to find the true center that follows the curve!
@@ -659,12 +797,47 @@ void GraphicsRenderer::drawSystem(sf::RenderWindow &window) const
         window.draw(labelText);
     }
 
+    // -------------------------
+    // Draw plastic hinges (open circles just inside the member end)
+    // -------------------------
+    for (int hinge : system.hinge_ends)
+    {
+        size_t i = static_cast<size_t>(hinge >> 1);
+        if (i >= system.beams.size() || !beamVisible[i])
+            continue;
+        int at = system.beams[i].nodes[hinge & 1];
+        int other = system.beams[i].nodes[1 - (hinge & 1)];
+        sf::Vector2f p_at(system.nodes[at].position[0] + displacementScale * static_cast<float>(system.displacement(at * 3)),
+                          system.nodes[at].position[1] + displacementScale * static_cast<float>(system.displacement(at * 3 + 1)));
+        sf::Vector2f p_other(system.nodes[other].position[0] + displacementScale * static_cast<float>(system.displacement(other * 3)),
+                             system.nodes[other].position[1] + displacementScale * static_cast<float>(system.displacement(other * 3 + 1)));
+        sf::Vector2f dir = p_other - p_at;
+        float length = std::sqrt(dir.x * dir.x + dir.y * dir.y);
+        if (length < 1e-6f)
+            continue;
+
+        float radius = nodeSize * 0.35f;
+        float offset = std::min(nodeSize, 0.25f * length);
+        sf::CircleShape circle(radius);
+        circle.setOrigin(sf::Vector2f(radius, radius));
+        circle.setPosition(p_at + dir * (offset / length));
+        circle.setFillColor(sf::Color::White);
+        circle.setOutlineColor(sf::Color::Black);
+        circle.setOutlineThickness(radius * 0.35f);
+        window.draw(circle);
+    }
+
     // -------------------------
     // Draw nodes
     // -------------------------
     int index = 0;
     for (const auto &node : system.nodes)
     {
+        if (!nodeVisible[index])
+        {
+            ++index;
+            continue;
+        }
         sf::Vector2f pos(node.position[0] + displacementScale * static_cast<float>(system.displacement(index * 3)),
                          node.position[1] + displacementScale * static_cast<float>(system.displacement(index * 3 + 1)));
 
@@ -744,6 +917,8 @@ void GraphicsRenderer::drawSystem(sf::RenderWindow &window) const
     // -------------------------
     for (int i = 0; i < system.nodes.size(); ++i)
     {
+        if (!nodeVisible[i])
+            continue;
         const Node &node = system.nodes[i];
 
         // scale factor for force visualization (use renderer setting)
@@ -785,15 +960,52 @@ void GraphicsRenderer::drawSystem(sf::RenderWindow &window) const
         }
     }
 
+    // -------------------------
+    // Draw node sensitivity arrows (direction that increases the response)
+    // -------------------------
+    if (colorBySensitivity && sensitivityArrows.size() == system.nodes.size())
+    {
+        const sf::Color arrowColor(0, 150, 90);
+        for (int i = 0; i < static_cast<int>(system.nodes.size()); ++i)
+        {
+            if (!nodeVisible[i])
+                continue;
+            sf::Vector2f dir = sensitivityArrows[i];
+            float length = std::sqrt(dir.x * dir.x + dir.y * dir.y);
+            if (length < 1e-6f)
+                continue;
+
+            const Node &node = system.nodes[i];
+            sf::Vector2f start(node.position[0] + displacementScale * static_cast<float>(system.displacement(i * 3)),
+                               node.position[1] + displacementScale * static_cast<float>(system.displacement(i * 3 + 1)));
+            sf::Vector2f end = start + dir;
+            drawThickLine(window, start, end, beamThickness * 0.6f, arrowColor);
+
+            sf::Vector2f unit = dir / length;
+            sf::Vector2f perp(-unit.y, unit.x);
+            sf::Vertex arrow[3];
+            arrow[0].position = end + unit * arrowSize;
+            arrow[0].color = arrowColor;
+            arrow[1].position = end + perp * (arrowSize / 2);
+            arrow[1].color = arrowColor;
+            arrow[2].position = end - perp * (arrowSize / 2);
+            arrow[2].color = arrowColor;
+            window.draw(arrow, 3, sf::PrimitiveType::Triangles);
+        }
+    }
+
     // -------------------------
     // Draw reaction forces as blue arrows (if available)
     // -------------------------
-    if (system.reactions.size() == static_cast<int>(system.nodes.size()) * 3)
+    const Eigen::VectorXd &reactions = system.get_reactions();
+    if (reactions.size() == static_cast<int>(system.nodes.size()) * 3)
     {
         for (int i = 0; i < static_cast<int>(system.nodes.size()); ++i)
         {
-            float rx = static_cast<float>(system.reactions(i * 3)) / this->reactionScale;
-            float ry = static_cast<float>(system.reactions(i * 3 + 1)) / this->reactionScale;
+            if (!nodeVisible[i])
+                continue;
+            float rx = static_cast<float>(reactions(i * 3)) / this->reactionScale;
+            float ry = static_cast<float>(reactions(i * 3 + 1)) / this->reactionScale;
 
             if (std::abs(rx) < 1e-6f && std::abs(ry) < 1e-6f)
                 continue;
@@ -50,9 +50,33 @@ private:
                               const sf::Color &color,
                               int segments) const;
 
+    // same curve as drawCubicBezierThick, but each segment is colored from the member's
+    // station stresses interpolated at that point along the curve
+    void drawCubicBezierStations(sf::RenderTarget &target,
+                                 const sf::Vector2f &p0,
+                                 const sf::Vector2f &p1,
+                                 const sf::Vector2f &p2,
+                                 const sf::Vector2f &p3,
+                                 float thickness,
+                                 const float *station_stress,
+                                 int stations,
+                                 int segments) const;
+
     void drawGrid(sf::RenderWindow &window) const;
     float getViewScale(const sf::RenderWindow &window) const;
 
+    // World rectangle of the last updateView(), grown by a margin. Members and nodes whose
+    // undeformed position is outside it are not drawn.
+    float cullLeft = -1e30f;
+    float cullRight = 1e30f;
+    float cullBottom = -1e30f;
+    float cullTop = 1e30f;
+    mutable std::vector<char> beamVisible;
+    mutable std::vector<char> nodeVisible;
+    mutable std::vector<int> visibleNodeList;
+    mutable std::vector<int> visibleBeamList;
+    void updateVisibility() const;
+
 public:
     GraphicsRenderer(FEMSystem const &system);
 
@@ -74,14 +98,22 @@ public:
     // Draw the spring system
     void drawSystem(sf::RenderWindow &window) const;
 
+    // nodes the last drawSystem() drew (ends of members overlapping the view and free nodes
+    // inside it); empty before the first frame
+    const std::vector<int> &visibleNodes() const { return visibleNodeList; }
+    // members the last drawSystem() drew; both ends of each are in visibleNodes()
+    const std::vector<int> &visibleBeams() const { return visibleBeamList; }
+
     // center view on the world
     void centerView();
 
     // auto zoom to fit the entire system
     void autoZoomToFit();
 
-    // Get stress color
+    // Get stress color (stresses beyond the range saturate)
     sf::Color getStressColor(float stress, float min_stress, float max_stress) const;
+    // same, over the system's percentile color range so a few outliers don't wash out the rest
+    sf::Color getStressColor(float stress) const;
 
     // Scale factor applied to computed displacements when rendering.
     // Public so UI or external code can adjust for visibility (default = 1.0 = no scaling).
@@ -90,4 +122,14 @@ public:
     float forceScale = 500.0f;
     // Visual scaling for reaction forces (N -> world units)
     float reactionScale = 500.0f;
+    // Color each beam along its length from the station results instead of one color per beam
+    bool colorByStation = false;
+    // Color beams by a per-member field (e.g. a sensitivity) instead of their stress:
+    // green below zero, orange above, saturating at +-sensitivityRange. Node arrows are drawn
+    // from sensitivityArrows (world units) when it holds one entry per node.
+    bool colorBySensitivity = false;
+    std::vector<float> sensitivityField;
+    float sensitivityRange = 0.0f;
+    std::vector<sf::Vector2f> sensitivityArrows;
+    sf::Color getSensitivityColor(float value) const;
 };
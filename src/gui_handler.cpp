@@ -2,14 +2,13 @@
 #include <imgui-SFML.h>
 #include <fstream>
 #include "serialization.h"
+#include "task_scheduler.h"
 #include <filesystem>
 #include <sstream>
 #include <iomanip>
 #include <thread>
-#include <mutex>
-#include <condition_variable>
-#include <deque>
 #include <atomic>
+#include <algorithm>
 
 #ifdef _MSC_VER
 #ifndef _USE_MATH_DEFINES
@@ -105,6 +104,7 @@ void GUIHandler::processEvent(const sf::Event &event)
         {
             fem_system.nodes.clear();
             fem_system.beams.clear();
+            fem_system.reset_analyses();
             fem_system.solve_system();
         }
     }
@@ -132,6 +132,9 @@ void GUIHandler::render()
     handleLoadPopup();
     handleDPIAdjust();
     helpPage();
+    taskProfiler();
+    analysisWindow();
+    updateShape();
     headerBar();
 }
 
@@ -267,6 +270,7 @@ void GUIHandler::nodeEditor()
             fem_system.nodes.erase(fem_system.nodes.begin() + removed_index);
 
             ImGui::PopID();
+            fem_system.reset_analyses();
             fem_system.solve_system();
             --i;
             continue;
@@ -320,6 +324,7 @@ void GUIHandler::nodeEditor()
         }
 
         // Re-solve so system matrices/vectors are rebuilt (solve_system should handle resizing state)
+        fem_system.reset_analyses();
         fem_system.solve_system();
     }
 
@@ -327,6 +332,7 @@ void GUIHandler::nodeEditor()
 
     if (constraints_changed)
     {
+        fem_system.reset_analyses();
         fem_system.solve_system();
     }
 }
@@ -362,6 +368,18 @@ void GUIHandler::beamEditor()
 
     bool beams_changed = false;
 
+    // outcome of the tension-/compression-only iteration of the last static solve
+    const ActiveSetResults &active_set = fem_system.active_set_results;
+    if (active_set.iterations > 0)
+    {
+        int slack = static_cast<int>(std::count(active_set.active.begin(), active_set.active.end(), 0));
+        if (active_set.converged)
+            ImGui::Text("Active set: %d slack members after %d iterations", slack, active_set.iterations);
+        else
+            ImGui::TextColored(ImVec4(1.f, 0.4f, 0.4f, 1.f), "Active set did not settle (%d slack members)", slack);
+        ImGui::Separator();
+    }
+
     // --- Existing beams ---
     for (int i = 0; i < static_cast<int>(fem_system.beams.size()); ++i)
     {
@@ -467,9 +485,25 @@ void GUIHandler::beamEditor()
         ImGui::SameLine();
         ImGui::TextDisabled("(moment of inertia ignored)");
 
+        // cables and rods: drop out of the static solve when they would carry the other sign
+        const char *axial_modes[] = {"Tension and Compression", "Tension Only", "Compression Only"};
+        int axial_mode = beam.tension_only ? 1 : (beam.compression_only ? 2 : 0);
+        if (ImGui::Combo("Axial Behavior", &axial_mode, axial_modes, IM_ARRAYSIZE(axial_modes)))
+        {
+            beam.tension_only = axial_mode == 1;
+            beam.compression_only = axial_mode == 2;
+            beams_changed = true;
+        }
+
         // Display stress
+        fem_system.get_stresses();
         ImGui::SameLine();
         ImGui::Text("Stress: %.2f", beam.stress);
+        if (i < static_cast<int>(fem_system.member_active.size()) && !fem_system.member_active[i])
+        {
+            ImGui::SameLine();
+            ImGui::TextDisabled("(slack)");
+        }
 
         // Remove button
         if (ImGui::Button("Remove Beam"))
@@ -512,6 +546,9 @@ void GUIHandler::beamEditor()
         ImGui::Checkbox("Truss", &new_is_truss);
         ImGui::SameLine();
         ImGui::TextDisabled("(moment of inertia ignored)");
+        static int new_axial_mode = 0;
+        const char *new_axial_modes[] = {"Tension and Compression", "Tension Only", "Compression Only"};
+        ImGui::Combo("Axial Behavior##NewBeam", &new_axial_mode, new_axial_modes, IM_ARRAYSIZE(new_axial_modes));
 
         if (new_node_a == new_node_b)
         {
@@ -529,6 +566,8 @@ void GUIHandler::beamEditor()
             {
                 // Constructor assumed Beam(int n1, int n2, int material_idx, int shape_idx)
                 fem_system.beams.emplace_back(new_node_a, new_node_b, new_material_idx, new_profile_idx, new_is_truss);
+                fem_system.beams.back().tension_only = new_axial_mode == 1;
+                fem_system.beams.back().compression_only = new_axial_mode == 2;
                 // If Beam has an 'is_truss' member, set it here. If not, adjust Beam definition accordingly.
                 beams_changed = true;
             }
@@ -559,6 +598,7 @@ void GUIHandler::beamEditor()
             }
         }
 
+        fem_system.reset_analyses();
         fem_system.solve_system();
     }
 }
@@ -626,7 +666,10 @@ void GUIHandler::systemControls()
         }
 
         if (forces_changed)
+        {
+            fem_system.reset_analyses();
             fem_system.solve_system();
+        }
 
         // Solution display
         ImGui::Text("Solution:");
@@ -648,16 +691,31 @@ void GUIHandler::systemControls()
                         theta_deg);
         }
 
-        // Beam stresses
+        // Beam stresses: distribution plus only the most stressed members
         const char *stress_label = (fem_system.unit_system == Metric) ? "MPa" : "psi";
-        ImGui::Text("Beam Stresses (%s):", stress_label);
-        int index = 1;
-        for (const auto &beam : fem_system.beams)
+        const std::vector<float> &stress = fem_system.get_stresses();
+        const StressSummary &summary = fem_system.get_stress_summary();
+
+        ImGui::Text("Beam Stresses (%s): %.2f to %.2f", stress_label,
+                    fem_system.stressToDisplay(fem_system.min_stress), fem_system.stressToDisplay(fem_system.max_stress));
+
+        const std::vector<int> &counts = summary.histogram.counts;
+        if (!counts.empty())
         {
-            sf::Color color = renderer.getStressColor(beam.stress, fem_system.min_stress, fem_system.max_stress);
-            double stress_disp = fem_system.stressToDisplay(beam.stress);
+            std::vector<float> bars(counts.begin(), counts.end());
+            ImGui::PlotHistogram("##stress_histogram", bars.data(), static_cast<int>(bars.size()), 0,
+                                 nullptr, 0.0f, FLT_MAX, ImVec2(0.0f, 60.0f));
+        }
+
+        ImGui::SliderInt("Critical Members", &fem_system.top_k, 1, 100);
+        ImGui::SliderFloat("Color Range Percentile", &fem_system.color_percentile, 50.0f, 100.0f, "%.1f");
+
+        for (int i : summary.critical)
+        {
+            sf::Color color = renderer.getStressColor(stress[i]);
+            double stress_disp = fem_system.stressToDisplay(stress[i]);
             ImGui::TextColored(ImVec4(color.r / 255.f, color.g / 255.f, color.b / 255.f, 1.f),
-                               "Beam %d: %.2f %s", index++, stress_disp, stress_label);
+                               "Beam %d: %.2f %s", i + 1, stress_disp, stress_label);
         }
     }
 
@@ -740,6 +798,7 @@ void GUIHandler::outputEditor()
         ImGui::TableSetupColumn("Material/Profile");
         ImGui::TableHeadersRow();
 
+        fem_system.get_stresses();
         int idx = 1;
         for (const auto &b : fem_system.beams)
         {
@@ -776,25 +835,10 @@ void GUIHandler::outputEditor()
         ImGui::TableSetupColumn("Rtheta");
         ImGui::TableHeadersRow();
 
-        if (fem_system.reactions.size() == fem_system.total_dof && fem_system.total_dof > 0)
+        if (fem_system.total_dof > 0 && fem_system.displacement.size() == fem_system.total_dof)
         {
-            reactions = fem_system.reactions;
-            have_reactions = true;
-        }
-        else
-        {
-            try
-            {
-                if (fem_system.global_k_matrix.size() > 0 && fem_system.displacement.size() > 0 && fem_system.global_k_matrix.rows() == fem_system.displacement.size())
-                {
-                    reactions = fem_system.global_k_matrix * fem_system.displacement - fem_system.forces;
-                    have_reactions = (reactions.size() == fem_system.displacement.size());
-                }
-            }
-            catch (...)
-            {
-                have_reactions = false;
-            }
+            reactions = fem_system.get_reactions();
+            have_reactions = (reactions.size() == fem_system.total_dof);
         }
 
         for (int i = 0; i < fem_system.nodes.size(); ++i)
@@ -877,6 +921,7 @@ void GUIHandler::outputEditor()
 
             ofs << "\nBeams\n";
             ofs << "Index,NodeA,NodeB,Stress,Material,Profile\n";
+            fem_system.get_stresses();
             for (int i = 0; i < fem_system.beams.size(); ++i)
             {
                 const auto &b = fem_system.beams[i];
@@ -1007,7 +1052,7 @@ void GUIHandler::handleLoadPopup()
         return;
     }
 
-    if (next_u32 == FILE_FORMAT_VERSION)
+    if (next_u32 >= 2 && next_u32 <= FILE_FORMAT_VERSION)
     {
         // New format: next_u32 is the format version
         format_version = next_u32;
@@ -1086,6 +1131,9 @@ void GUIHandler::handleLoadPopup()
         MaterialProfile &m = fem_system.materials_list[i];
         m.name = readString(ifs);
         ifs.read(reinterpret_cast<char *>(&m.youngs_modulus), sizeof(m.youngs_modulus));
+        // density was added in version 3; older files keep the default
+        if (format_version >= 3)
+            ifs.read(reinterpret_cast<char *>(&m.density), sizeof(m.density));
         if (!ifs)
         {
             error_msg = "Failed reading material profile " + std::to_string(i);
@@ -1111,6 +1159,10 @@ void GUIHandler::handleLoadPopup()
         ifs.read(reinterpret_cast<char *>(&p.area), sizeof(p.area));
         ifs.read(reinterpret_cast<char *>(&p.moment_of_inertia), sizeof(p.moment_of_inertia));
         ifs.read(reinterpret_cast<char *>(&p.section_modulus), sizeof(p.section_modulus));
+        // plastic moment capacity was added in version 5; older profiles stay elastic
+        p.plastic_moment = 0.0;
+        if (format_version >= 5)
+            ifs.read(reinterpret_cast<char *>(&p.plastic_moment), sizeof(p.plastic_moment));
         if (!ifs)
         {
             error_msg = "Failed reading beam profile " + std::to_string(i);
@@ -1207,6 +1259,21 @@ void GUIHandler::handleLoadPopup()
         }
         s.is_truss = (is_truss_flag != 0);
 
+        // one-way flags (uint8_t, bit 0 tension-only, bit 1 compression-only) since version 4
+        if (format_version >= 4)
+        {
+            uint8_t one_way = 0;
+            ifs.read(reinterpret_cast<char *>(&one_way), sizeof(one_way));
+            if (!ifs)
+            {
+                error_msg = "Failed reading beam tension/compression flags for beam " + std::to_string(i);
+                load_error = true;
+                return;
+            }
+            s.tension_only = (one_way & 1u) != 0;
+            s.compression_only = (one_way & 2u) != 0;
+        }
+
         // Validate indices
         if (mat_idx < 0 || mat_idx >= static_cast<int32_t>(fem_system.materials_list.size()) ||
             shape_idx < 0 || shape_idx >= static_cast<int32_t>(fem_system.beam_profiles_list.size()))
@@ -1279,6 +1346,7 @@ void GUIHandler::handleLoadPopup()
     fem_system.total_dof = static_cast<int>(fem_system.nodes.size()) * 3;
     fem_system.displacement = Eigen::VectorXd::Zero(fem_system.total_dof);
     // forces already set (either loaded or zeroed)
+    fem_system.reset_analyses();
     fem_system.solve_system();
     renderer.autoZoomToFit();
 
@@ -1384,6 +1452,7 @@ void GUIHandler::handleSavePopup()
     {
         writeString(ofs, m.name);
         ofs.write(reinterpret_cast<const char *>(&m.youngs_modulus), sizeof(m.youngs_modulus));
+        ofs.write(reinterpret_cast<const char *>(&m.density), sizeof(m.density));
     }
 
     // 3. Beam Profiles
@@ -1395,6 +1464,7 @@ void GUIHandler::handleSavePopup()
         ofs.write(reinterpret_cast<const char *>(&p.area), sizeof(p.area));
         ofs.write(reinterpret_cast<const char *>(&p.moment_of_inertia), sizeof(p.moment_of_inertia));
         ofs.write(reinterpret_cast<const char *>(&p.section_modulus), sizeof(p.section_modulus));
+        ofs.write(reinterpret_cast<const char *>(&p.plastic_moment), sizeof(p.plastic_moment));
     }
 
     // 4. Nodes
@@ -1411,6 +1481,7 @@ void GUIHandler::handleSavePopup()
     // 5. Beams (write node indices, stress, material_idx, shape_idx)
     std::uint32_t beam_count = static_cast<std::uint32_t>(fem_system.beams.size());
     ofs.write(reinterpret_cast<const char *>(&beam_count), sizeof(beam_count));
+    fem_system.get_stresses();
     for (const auto &s : fem_system.beams)
     {
         // Nodes indices (int32_t[2])
@@ -1433,6 +1504,12 @@ void GUIHandler::handleSavePopup()
             uint8_t is_truss_flag = s.is_truss ? 1u : 0u;
             ofs.write(reinterpret_cast<const char *>(&is_truss_flag), sizeof(is_truss_flag));
         }
+
+        // ONE-WAY FLAGS (uint8_t): bit 0 tension-only, bit 1 compression-only
+        {
+            uint8_t one_way = (s.tension_only ? 1u : 0u) | (s.compression_only ? 2u : 0u);
+            ofs.write(reinterpret_cast<const char *>(&one_way), sizeof(one_way));
+        }
     }
 
     // 6. Forces (Eigen::VectorXd)
@@ -1461,6 +1538,7 @@ void GUIHandler::profileEditor()
     ImGui::Begin("Profile Editor", &show_profile_editor, ImGuiWindowFlags_AlwaysAutoResize);
 
     bool profiles_changed = false;
+    const char *moment_unit = fem_system.unit_system == Metric ? "N m" : (fem_system.unit_system == ImperialInches ? "lbf in" : "lbf ft");
 
     // --- Existing profiles ---
     if (fem_system.beam_profiles_list.empty())
@@ -1521,6 +1599,15 @@ void GUIHandler::profileEditor()
                 profiles_changed = true;
             }
 
+            // --- Editable Plastic Moment (pushover hinges; 0 keeps the profile elastic) ---
+            float Mp_disp = static_cast<float>(fem_system.momentToDisplay(profile.plastic_moment));
+            std::string Mp_label = std::string("Plastic Moment Mp (") + moment_unit + ")";
+            if (ImGui::InputFloat(Mp_label.c_str(), &Mp_disp))
+            {
+                profile.plastic_moment = std::max(0.0, fem_system.momentFromDisplay(Mp_disp));
+                profiles_changed = true;
+            }
+
             // Remove profile button
             ImGui::SameLine();
             if (ImGui::Button("Remove Profile"))
@@ -1556,6 +1643,7 @@ void GUIHandler::profileEditor()
     static float new_profile_area = 0.1963f;
     static float new_profile_I = 0.005f;
     static float new_profile_S = 0.01f;
+    static float new_profile_Mp = 0.0f;
 
     ImGui::InputText("Name", new_profile_name, sizeof(new_profile_name));
     std::string new_area_label = std::string("Area (") + (fem_system.unit_system == Metric ? "m^2" : "ft^2") + ")";
@@ -1564,6 +1652,8 @@ void GUIHandler::profileEditor()
     ImGui::InputFloat(new_area_label.c_str(), &new_profile_area);
     ImGui::InputFloat(new_I_label.c_str(), &new_profile_I);
     ImGui::InputFloat(new_S_label.c_str(), &new_profile_S);
+    std::string new_Mp_label = std::string("Plastic Moment Mp (") + moment_unit + ")";
+    ImGui::InputFloat(new_Mp_label.c_str(), &new_profile_Mp);
 
     ImGui::SameLine();
     if (ImGui::Button("Add Profile"))
@@ -1588,6 +1678,7 @@ void GUIHandler::profileEditor()
             new_p.area = static_cast<float>(fem_system.areaFromDisplay(new_profile_area));
             new_p.moment_of_inertia = static_cast<float>(fem_system.inertiaFromDisplay(new_profile_I));
             new_p.section_modulus = static_cast<float>(fem_system.sectionModulusFromDisplay(new_profile_S));
+            new_p.plastic_moment = std::max(0.0, fem_system.momentFromDisplay(new_profile_Mp));
 
             fem_system.beam_profiles_list.push_back(new_p);
 
@@ -1596,6 +1687,7 @@ void GUIHandler::profileEditor()
             new_profile_area = 0.1963f;
             new_profile_I = 0.005f;
             new_profile_S = 0.01f;
+            new_profile_Mp = 0.0f;
 
             profiles_changed = true;
         }
@@ -1605,6 +1697,7 @@ void GUIHandler::profileEditor()
 
     if (profiles_changed)
     {
+        fem_system.reset_analyses();
         fem_system.solve_system();
     }
 }
@@ -1647,6 +1740,15 @@ void GUIHandler::materialEditor()
                 materials_changed = true;
             }
 
+            // Editable density (only used by the dynamic analyses)
+            float density_disp = static_cast<float>(fem_system.densityToDisplay(mat.density));
+            const char *density_unit = fem_system.unit_system == Metric ? "kg/m^3" : (fem_system.unit_system == ImperialFeet ? "lb/ft^3" : "lb/in^3");
+            std::string density_label = std::string("Density (") + density_unit + ")";
+            if (ImGui::InputFloat(density_label.c_str(), &density_disp))
+            {
+                mat.density = fem_system.densityFromDisplay(density_disp);
+            }
+
             // Remove material button
             ImGui::SameLine();
             if (ImGui::Button("Remove Material"))
@@ -1681,10 +1783,14 @@ void GUIHandler::materialEditor()
     ImGui::Text("Create New Material:");
     static char new_mat_name[128] = "";
     static float new_mat_youngs = 30e6f;
+    static float new_mat_density = 7850.0f; // kg/m^3
 
     ImGui::InputText("Name", new_mat_name, sizeof(new_mat_name));
     std::string new_ym_label = std::string("Young's Modulus (") + (fem_system.unit_system == Metric ? "Pa" : "psi") + ")";
     ImGui::InputFloat(new_ym_label.c_str(), &new_mat_youngs);
+    float new_density_disp = static_cast<float>(fem_system.densityToDisplay(new_mat_density));
+    if (ImGui::InputFloat("Density", &new_density_disp))
+        new_mat_density = static_cast<float>(fem_system.densityFromDisplay(new_density_disp));
 
     ImGui::SameLine();
     if (ImGui::Button("Add Material"))
@@ -1705,6 +1811,7 @@ void GUIHandler::materialEditor()
             MaterialProfile new_mat;
             new_mat.name = name_str;
             new_mat.youngs_modulus = static_cast<double>(fem_system.modulusFromDisplay(new_mat_youngs));
+            new_mat.density = new_mat_density;
             fem_system.materials_list.push_back(new_mat);
 
             // Reset fields
@@ -1719,6 +1826,7 @@ void GUIHandler::materialEditor()
 
     if (materials_changed)
     {
+        fem_system.reset_analyses();
         fem_system.solve_system();
     }
 }
@@ -1800,6 +1908,7 @@ void GUIHandler::headerBar()
             {
                 fem_system.nodes.clear();
                 fem_system.beams.clear();
+                fem_system.reset_analyses();
                 fem_system.solve_system();
             }
             if (ImGui::MenuItem("Open...", "Ctrl+O"))
@@ -1884,6 +1993,16 @@ void GUIHandler::headerBar()
             {
                 request_dpi_adjust = true;
             }
+
+            if (ImGui::MenuItem("Task Profiler"))
+            {
+                show_task_profiler = !show_task_profiler;
+            }
+
+            if (ImGui::MenuItem("Analysis"))
+            {
+                show_analysis = !show_analysis;
+            }
             ImGui::EndMenu();
         }
 
@@ -1919,6 +2038,22 @@ void GUIHandler::headerBar()
                 ImGui::EndMenu();
             }
 
+            if (ImGui::BeginMenu("Worker Threads"))
+            {
+                // total threads shared by solver, renderer and recorder tasks (includes the GUI thread)
+                TaskScheduler &scheduler = TaskScheduler::instance();
+                if (!worker_threads_dragging)
+                    worker_threads = scheduler.thread_count();
+                int max_threads = std::max(2, static_cast<int>(std::thread::hardware_concurrency()) * 2);
+                ImGui::SliderInt("Threads", &worker_threads, 1, max_threads);
+                worker_threads_dragging = ImGui::IsItemActive();
+                // restarting the workers waits for the tasks they are running, so only once
+                // the drag (or typed value) is done
+                if (ImGui::IsItemDeactivatedAfterEdit())
+                    scheduler.set_thread_count(worker_threads);
+                ImGui::EndMenu();
+            }
+
             ImGui::EndMenu();
         }
 
@@ -2005,204 +2140,3255 @@ void GUIHandler::helpPage()
     ImGui::End();
 }
 
-namespace
+void GUIHandler::taskProfiler()
 {
-    struct FrameTask
-    {
-        std::string filename;
-        sf::Image image; // store the captured image (copied on enqueue)
-    };
+    if (!show_task_profiler)
+        return;
+
+    ImGui::Begin("Task Profiler", &show_task_profiler, ImGuiWindowFlags_AlwaysAutoResize);
 
-    static std::deque<FrameTask> g_frame_queue;
-    static std::mutex g_frame_mutex;
-    static std::condition_variable g_frame_cv;
-    static std::atomic<bool> g_writer_running{false};
-    static std::atomic<bool> g_writer_started{false};
+    TaskScheduler &scheduler = TaskScheduler::instance();
+    ImGui::Text("Threads: %d", scheduler.thread_count());
 
-    static void writerThreadFunc()
+    bool profiling = scheduler.profiling_enabled.load();
+    if (ImGui::Checkbox("Record Task Timings", &profiling))
     {
-        g_writer_running = true;
-        while (g_writer_running)
+        scheduler.profiling_enabled = profiling;
+    }
+    ImGui::SameLine();
+    if (ImGui::Button("Reset"))
+    {
+        scheduler.reset_timing();
+    }
+
+    std::vector<TaskTiming> timings = scheduler.timing_snapshot();
+    if (timings.empty())
+    {
+        ImGui::TextDisabled("No timings recorded.");
+    }
+    else if (ImGui::BeginTable("task_timings", 5, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg))
+    {
+        ImGui::TableSetupColumn("Task");
+        ImGui::TableSetupColumn("Count");
+        ImGui::TableSetupColumn("Total (ms)");
+        ImGui::TableSetupColumn("Mean (ms)");
+        ImGui::TableSetupColumn("Max (ms)");
+        ImGui::TableHeadersRow();
+
+        for (const auto &t : timings)
         {
-            FrameTask task;
-            {
-                std::unique_lock<std::mutex> l(g_frame_mutex);
-                g_frame_cv.wait(l, []
-                                { return !g_frame_queue.empty() || !g_writer_running; });
-                if (!g_writer_running && g_frame_queue.empty())
-                    break;
-                if (g_frame_queue.empty())
-                    continue;
-                task = std::move(g_frame_queue.front());
-                g_frame_queue.pop_front();
-            }
+            ImGui::TableNextRow();
+            ImGui::TableSetColumnIndex(0);
+            ImGui::TextUnformatted(t.name.c_str());
+            ImGui::TableSetColumnIndex(1);
+            ImGui::Text("%llu", static_cast<unsigned long long>(t.count));
+            ImGui::TableSetColumnIndex(2);
+            ImGui::Text("%.3f", t.total_ms);
+            ImGui::TableSetColumnIndex(3);
+            ImGui::Text("%.3f", t.count > 0 ? t.total_ms / static_cast<double>(t.count) : 0.0);
+            ImGui::TableSetColumnIndex(4);
+            ImGui::Text("%.3f", t.max_ms);
+        }
 
-            // Save outside lock using sf::Image::saveToFile (no GL context required)
-            try
+        ImGui::EndTable();
+    }
+
+    ImGui::End();
+}
+
+namespace
+{
+    // frames handed to the task scheduler that have not been written to disk yet
+    static std::atomic<int> g_frames_in_flight{0};
+    static constexpr int max_frames_in_flight = 500;
+
+    static void enqueueFrameWrite(sf::Image image, std::string filename)
+    {
+        g_frames_in_flight++;
+        // Save on a worker using sf::Image::saveToFile (no GL context required).
+        // Low priority so solver work queued at the same time is picked first.
+        TaskScheduler::instance().submit(
+            [image = std::move(image), filename = std::move(filename)]()
             {
-                if (!task.image.saveToFile(task.filename))
+                try
                 {
-                    std::cerr << "Writer thread: failed to save frame " << task.filename << "\n";
+                    if (!image.saveToFile(filename))
+                    {
+                        std::cerr << "Frame writer: failed to save frame " << filename << "\n";
+                    }
                 }
-            }
-            catch (const std::exception &e)
-            {
-                std::cerr << "Writer thread exception: " << e.what() << "\n";
-            }
-        }
+                catch (const std::exception &e)
+                {
+                    std::cerr << "Frame writer exception: " << e.what() << "\n";
+                }
+                g_frames_in_flight--;
+            },
+            TaskPriority::Low, "frame_encode");
     }
 } // namespace
 
-// New: Visualization GUI window
-void GUIHandler::visualizationEditor()
+// dynamic / stability analyses, one collapsing section each
+void GUIHandler::analysisWindow()
 {
-    if (!show_visualization_editor)
+    if (!show_analysis)
         return;
 
-    ImGui::Begin("Visualization", &show_visualization_editor, ImGuiWindowFlags_AlwaysAutoResize);
+    ImGui::Begin("Analysis", &show_analysis, ImGuiWindowFlags_AlwaysAutoResize);
+
+    if (ImGui::CollapsingHeader("Modal Analysis", ImGuiTreeNodeFlags_DefaultOpen))
+        modalPanel();
+    if (ImGui::CollapsingHeader("Linear Buckling"))
+        bucklingPanel();
+    if (ImGui::CollapsingHeader("Nonlinear Static"))
+        nonlinearPanel();
+    if (ImGui::CollapsingHeader("Transient Dynamics"))
+        transientPanel();
+    if (ImGui::CollapsingHeader("Modal Response Preview"))
+        modalResponsePanel();
+    if (ImGui::CollapsingHeader("Frequency Response"))
+        frequencyResponsePanel();
+    if (ImGui::CollapsingHeader("Response Spectrum"))
+        responseSpectrumPanel();
+    if (ImGui::CollapsingHeader("Pushover"))
+        pushoverPanel();
+    if (ImGui::CollapsingHeader("Moving Load"))
+        movingLoadPanel();
+    if (ImGui::CollapsingHeader("Sensitivities"))
+        sensitivityPanel();
+    if (ImGui::CollapsingHeader("Sizing"))
+        sizingPanel();
+    if (ImGui::CollapsingHeader("Shape"))
+        shapePanel();
+    if (ImGui::CollapsingHeader("Parameter Sweep"))
+        sweepPanel();
+    if (ImGui::CollapsingHeader("Monte Carlo Reliability"))
+        reliabilityPanel();
+    if (ImGui::CollapsingHeader("Redundancy Scan"))
+        redundancyPanel();
+    if (ImGui::CollapsingHeader("Reduced-Order Model"))
+        reducedModelPanel();
+    if (ImGui::CollapsingHeader("Superelements"))
+        superelementPanel();
+    if (ImGui::CollapsingHeader("Topology"))
+        topologyPanel();
+
+    shapeControls();
+
+    ImGui::End();
+}
+
+// which mode is drawn and how; shared by every panel that produces shapes
+void GUIHandler::shapeControls()
+{
+    if (shape_source == ShapeSource::Static)
+        return;
 
-    ImGui::Text("Rendering / Visualization Settings");
     ImGui::Separator();
+    if (shape_source == ShapeSource::Increment)
+    {
+        // real displacements of the load path, so there is no amplitude to pick
+        const NonlinearResults &path = fem_system.nonlinear_results;
+        int count = static_cast<int>(path.increments.size());
+        ImGui::Checkbox("Play Load Path", &shape_animate);
+        ImGui::SliderFloat("Increments per Second", &increments_per_second, 0.5f, 30.0f, "%.1f");
+        if (count > 0 && ImGui::SliderInt("Increment", &shape_index, 0, count - 1))
+            shape_animate = false;
+        if (shape_index >= 0 && shape_index < count)
+            ImGui::Text("Load factor %.3f", path.increments[shape_index].load_factor);
+    }
+    else if (shape_source == ShapeSource::Transient)
+    {
+        const TransientResults &history = fem_system.transient_results;
+        int count = static_cast<int>(history.times.size());
+        ImGui::Checkbox("Play Response", &shape_animate);
+        ImGui::SliderFloat("Playback Speed (sim s / s)", &playback_speed, 0.0001f, 10.0f, "%.4f", ImGuiSliderFlags_Logarithmic);
+        if (count > 0 && ImGui::SliderInt("Frame", &shape_index, 0, count - 1))
+            shape_animate = false;
+        if (shape_index >= 0 && shape_index < count)
+            ImGui::Text("t = %.5f s", history.times[shape_index]);
+    }
+    else if (shape_source == ShapeSource::Pushover)
+    {
+        const PushoverResults &r = fem_system.pushover_results;
+        int count = static_cast<int>(r.steps.size());
+        ImGui::Checkbox("Play Hinge Sequence", &shape_animate);
+        ImGui::SliderFloat("Events per Second", &increments_per_second, 0.5f, 30.0f, "%.1f");
+        if (count > 0 && ImGui::SliderInt("Event", &shape_index, 0, count - 1))
+            shape_animate = false;
+        if (shape_index >= 0 && shape_index < count)
+            ImGui::Text("Load factor %.4f, %d hinges", r.steps[shape_index].load_factor, r.steps[shape_index].hinges);
+    }
+    else if (shape_source == ShapeSource::ModalResponse)
+    {
+        // evaluated at any time, so there are no frames to step through
+        ImGui::Checkbox("Play Response", &shape_animate);
+        ImGui::SliderFloat("Playback Speed (sim s / s)", &playback_speed, 0.0001f, 10.0f, "%.4f", ImGuiSliderFlags_Logarithmic);
+        ImGui::Text("t = %.5f s", shape_time);
+        ImGui::SameLine();
+        if (ImGui::SmallButton("Restart"))
+            shape_time = 0.0f;
+    }
+    else
+    {
+        ImGui::Checkbox("Animate Shape", &shape_animate);
+        ImGui::SliderFloat("Shape Amplitude", &shape_amplitude, 0.001f, 5.0f, "%.3f", ImGuiSliderFlags_Logarithmic);
+        ImGui::SliderFloat("Shape Speed (Hz)", &shape_speed, 0.05f, 3.0f, "%.2f");
+    }
 
-    // Show and control displacement scale (public member on renderer)
-    float ds = renderer.displacementScale;
-    if (ImGui::SliderFloat("Displacement Scale", &ds, 0.0f, 50.0f, "%.2f"))
+    if (ImGui::Button("Back to Static Solution"))
     {
-        renderer.displacementScale = ds;
+        shape_source = ShapeSource::Static;
+        fem_system.solve_system();
     }
+}
 
-    ImGui::SameLine();
-    ImGui::TextDisabled("(?)");
-    if (ImGui::IsItemHovered())
+void GUIHandler::selectShape(ShapeSource source, int index)
+{
+    shape_source = source;
+    shape_index = index;
+    shape_time = 0.0f;
+}
+
+// drive the normal deformed-shape rendering from the selected shape (displacementScale
+// still applies); runs every frame whether or not the window that picked it is open
+void GUIHandler::updateShape()
+{
+    if (shape_source == ShapeSource::Static)
+        return;
+
+    if (shape_source == ShapeSource::Increment)
     {
-        ImGui::BeginTooltip();
-        ImGui::PushTextWrapPos(ImGui::GetFontSize() * 35.0f);
-        ImGui::TextUnformatted("Scale applied to computed displacements for visualization only (does not affect solver).");
-        ImGui::PopTextWrapPos();
-        ImGui::EndTooltip();
+        int count = static_cast<int>(fem_system.nonlinear_results.increments.size());
+        if (count == 0)
+        {
+            shape_source = ShapeSource::Static;
+            return;
+        }
+        if (shape_animate)
+        {
+            // loop over the increments, holding the last one for a moment
+            shape_time += ImGui::GetIO().DeltaTime;
+            shape_index = static_cast<int>(shape_time * increments_per_second) % (count + 2);
+        }
+        shape_index = std::min(std::max(shape_index, 0), count - 1);
+        fem_system.show_increment(shape_index);
+        return;
     }
 
-    // Option: quick reset
-    if (ImGui::Button("Reset Scale"))
+    if (shape_source == ShapeSource::Transient)
     {
-        renderer.displacementScale = 1.0f;
+        const TransientResults &history = fem_system.transient_results;
+        int count = static_cast<int>(history.times.size());
+        if (count == 0)
+        {
+            shape_source = ShapeSource::Static;
+            return;
+        }
+        if (shape_animate)
+        {
+            // the stored frames are evenly spaced, so the frame follows simulated time directly
+            shape_time += ImGui::GetIO().DeltaTime * playback_speed;
+            double frame_dt = history.time_step * history.store_every;
+            shape_index = frame_dt > 0.0 ? static_cast<int>(shape_time / frame_dt) % count : 0;
+        }
+        shape_index = std::min(std::max(shape_index, 0), count - 1);
+        fem_system.show_transient_frame(shape_index);
+        return;
     }
-    ImGui::SameLine();
-    if (ImGui::Button("Auto Fit View"))
+
+    if (shape_source == ShapeSource::Pushover)
     {
-        renderer.centerView();
-        renderer.autoZoomToFit();
+        const PushoverResults &r = fem_system.pushover_results;
+        int count = static_cast<int>(r.steps.size());
+        if (count == 0)
+        {
+            shape_source = ShapeSource::Static;
+            return;
+        }
+        if (shape_animate)
+        {
+            // steps without stored displacements are skipped by show_pushover_step
+            shape_time += ImGui::GetIO().DeltaTime;
+            shape_index = static_cast<int>(shape_time * increments_per_second) % (count + 2);
+        }
+        shape_index = std::min(std::max(shape_index, 0), count - 1);
+        fem_system.show_pushover_step(shape_index);
+        return;
     }
 
-    // Visual scaling for force/reaction arrows
+    if (shape_source == ShapeSource::ModalResponse)
+    {
+        if (fem_system.modal_response.modes == 0)
+        {
+            shape_source = ShapeSource::Static;
+            return;
+        }
+        if (shape_animate)
+            shape_time += ImGui::GetIO().DeltaTime * playback_speed;
 
-    float fvs = renderer.forceScale;
-    if (ImGui::SliderFloat("Force Visual Scale (N->world)", &fvs, 1.0f, 40000.0f, "%.0f"))
-        renderer.forceScale = fvs;
+        // only the nodes and members drawn last frame are rebuilt; before the first frame, all of them
+        const std::vector<int> &visible = renderer.visibleNodes();
+        if (visible.empty())
+            fem_system.show_modal_response(shape_time);
+        else
+            fem_system.show_modal_response(shape_time, &visible, &renderer.visibleBeams());
+        return;
+    }
 
-    ImGui::SameLine();
-    ImGui::TextDisabled("(larger = shorter arrows)");
+    double amplitude = fem_system.lengthFromDisplay(shape_amplitude);
+    if (shape_animate)
+    {
+        shape_time += ImGui::GetIO().DeltaTime;
+        amplitude *= std::cos(2.0 * M_PI * shape_speed * shape_time);
+    }
 
-    float rvs = renderer.reactionScale;
-    if (ImGui::SliderFloat("Reaction Visual Scale (N->world)", &rvs, 1.0f, 40000.0f, "%.0f"))
-        renderer.reactionScale = rvs;
+    if (shape_source == ShapeSource::Mode)
+        fem_system.show_mode(shape_index, amplitude);
+    else if (shape_source == ShapeSource::Buckling)
+        fem_system.show_buckling_mode(shape_index, amplitude);
+}
 
-    // --- Force animation controls ---
-    ImGui::Separator();
-    ImGui::Text("Force Animation");
-    ImGui::Spacing();
+void GUIHandler::modalPanel()
+{
+    // Persistent state across frames
+    static int mode_count = 6;
+    static bool lumped_mass = false;
+    static int last_result = 0;
 
-    // Persistent animation state across frames (kept local to this function)
-    static bool animate_forces = false;
-    static bool prev_animate_forces = false;
-    static float animate_time = 0.0f;
-    static float animate_speed = 0.5f;     // Hz
-    static float animate_amplitude = 1.0f; // multiplier (0 = no change, 1 = ±100%)
-    static Eigen::VectorXd saved_forces;
-    // New: whether animation applies both positive and negative directions
-    static bool bidirectional_forces = true;
-
-    ImGui::Checkbox("Animate Forces", &animate_forces);
+    ImGui::PushID("modal");
+    ImGui::SliderInt("Modes", &mode_count, 1, 50);
+    ImGui::Checkbox("Lumped Mass (HRZ)", &lumped_mass);
     ImGui::SameLine();
-    ImGui::Checkbox("Bidirectional Forces", &bidirectional_forces);
-    ImGui::SameLine();
-    if (ImGui::SmallButton("Capture Current Forces"))
+    if (ImGui::Button("Solve Modes"))
     {
-        // Capture baseline forces for the animation
-        saved_forces = fem_system.forces;
-        animate_time = 0.0f;
+        last_result = fem_system.solve_modes(mode_count, lumped_mass);
+        if (fem_system.modal_results.count > 0)
+            selectShape(ShapeSource::Mode, 0);
     }
 
-    ImGui::SliderFloat("Speed (Hz)", &animate_speed, 0.05f, 5.0f, "%.2f");
-    ImGui::SliderFloat("Amplitude (multiplier)", &animate_amplitude, 0.0f, 3.0f, "%.2f");
-    ImGui::TextWrapped("Animation scales the captured forces by sin(2*pi*speed*t) * amplitude. Use 'Bidirectional Forces' to clamp to positive-only.");
+    const ModalResults &modes = fem_system.modal_results;
+    if (last_result == -1)
+        ImGui::TextColored(ImVec4(1.f, 0.4f, 0.4f, 1.f), "Could not factor the system (no mass or no members?)");
+    else if (last_result == -2)
+        ImGui::TextColored(ImVec4(1.f, 0.8f, 0.2f, 1.f), "Eigen solver did not fully converge.");
 
-    // Handle start/stop transitions
-    if (animate_forces && !prev_animate_forces)
-    {
-        // starting animation: ensure we have a baseline
-        if (saved_forces.size() != fem_system.forces.size())
-            saved_forces = fem_system.forces;
-        animate_time = 0.0f;
-    }
-    else if (!animate_forces && prev_animate_forces)
+    if (modes.count > 0 && ImGui::BeginTable("modes_table", 3, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg))
     {
-        // stopped: restore captured forces (if available) and re-solve once
-        if (saved_forces.size() == fem_system.forces.size())
+        ImGui::TableSetupColumn("Mode");
+        ImGui::TableSetupColumn("Frequency (Hz)");
+        ImGui::TableSetupColumn("Period (s)");
+        ImGui::TableHeadersRow();
+
+        for (int k = 0; k < modes.count; ++k)
         {
-            fem_system.forces = saved_forces;
-            fem_system.solve_system();
+            ImGui::TableNextRow();
+            ImGui::TableSetColumnIndex(0);
+            char label[32];
+            std::snprintf(label, sizeof(label), "%d", k + 1);
+            bool selected = shape_source == ShapeSource::Mode && shape_index == k;
+            if (ImGui::Selectable(label, selected, ImGuiSelectableFlags_SpanAllColumns))
+                selectShape(ShapeSource::Mode, k);
+            ImGui::TableSetColumnIndex(1);
+            ImGui::Text("%.4f", modes.frequency[k]);
+            ImGui::TableSetColumnIndex(2);
+            if (modes.frequency[k] > 0.0)
+                ImGui::Text("%.5f", 1.0 / modes.frequency[k]);
+            else
+                ImGui::TextDisabled("-");
         }
+        ImGui::EndTable();
     }
-    prev_animate_forces = animate_forces;
+    ImGui::PopID();
+}
+
+void GUIHandler::bucklingPanel()
+{
+    static int buckling_count = 3;
+    static int last_result = 0;
 
-    // Perform per-frame animation update when enabled
-    if (animate_forces)
+    ImGui::PushID("buckling");
+    ImGui::TextWrapped("Load factors that make the current applied loads buckle the structure.");
+    ImGui::SliderInt("Modes", &buckling_count, 1, 10);
+    ImGui::SameLine();
+    if (ImGui::Button("Solve Buckling"))
     {
-        float dt = ImGui::GetIO().DeltaTime; // frame delta
-        animate_time += dt;
+        last_result = fem_system.solve_buckling(buckling_count);
+        if (fem_system.buckling_results.count > 0)
+            selectShape(ShapeSource::Buckling, 0);
+    }
+
+    const BucklingResults &buckling = fem_system.buckling_results;
+    if (last_result == -1)
+        ImGui::TextColored(ImVec4(1.f, 0.8f, 0.2f, 1.f), "No member is in compression under the current loads.");
+    else if (last_result == -2)
+        ImGui::TextColored(ImVec4(1.f, 0.8f, 0.2f, 1.f), "Eigen solver did not fully converge.");
+    else if (last_result == -3)
+        ImGui::TextColored(ImVec4(1.f, 0.4f, 0.4f, 1.f), "The structure is a mechanism; buckling is undefined.");
 
-        float phase = 2.0f * static_cast<float>(M_PI) * animate_speed * animate_time;
-        float wave = std::sin(phase);
+    if (buckling.count > 0 && ImGui::BeginTable("buckling_table", 2, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg))
+    {
+        ImGui::TableSetupColumn("Mode");
+        ImGui::TableSetupColumn("Load Factor");
+        ImGui::TableHeadersRow();
 
-        float factor;
-        if (bidirectional_forces)
+        for (int k = 0; k < buckling.count; ++k)
         {
-            factor = wave * animate_amplitude;
+            ImGui::TableNextRow();
+            ImGui::TableSetColumnIndex(0);
+            char label[32];
+            std::snprintf(label, sizeof(label), "%d", k + 1);
+            bool selected = shape_source == ShapeSource::Buckling && shape_index == k;
+            if (ImGui::Selectable(label, selected, ImGuiSelectableFlags_SpanAllColumns))
+                selectShape(ShapeSource::Buckling, k);
+            ImGui::TableSetColumnIndex(1);
+            ImGui::Text("%.4f", buckling.load_factors[k]);
         }
-        else
+        ImGui::EndTable();
+    }
+    ImGui::PopID();
+}
+
+void GUIHandler::nonlinearPanel()
+{
+    static int last_result = 0;
+    NonlinearOptions &options = fem_system.nonlinear_options;
+
+    ImGui::PushID("nonlinear");
+    ImGui::TextWrapped("Large-displacement solve of the current loads (corotational members).");
+    ImGui::SliderInt("Load Steps", &options.load_steps, 1, 100);
+    ImGui::SliderInt("Max Iterations", &options.max_iterations, 1, 200);
+    float tolerance = static_cast<float>(options.tolerance);
+    if (ImGui::InputFloat("Tolerance", &tolerance, 0.0f, 0.0f, "%.1e"))
+        options.tolerance = std::max(tolerance, 1e-12f);
+    ImGui::Checkbox("Modified Newton", &options.modified_newton);
+    ImGui::SameLine();
+    ImGui::Checkbox("Line Search", &options.line_search);
+    ImGui::SameLine();
+    ImGui::Checkbox("Store Increments", &options.store_increments);
+
+    if (ImGui::Button("Solve Nonlinear"))
+    {
+        last_result = fem_system.solve_nonlinear();
+        int count = static_cast<int>(fem_system.nonlinear_results.increments.size());
+        if (count > 0)
         {
-            // Ease in/out: use (sin(phase) + 1) / 2 for smooth 0→1→0
-            factor = ((wave + 1.0f) * 0.5f) * animate_amplitude;
+            selectShape(ShapeSource::Increment, count - 1);
+            shape_animate = false;
         }
+    }
 
-        if (saved_forces.size() == fem_system.forces.size() && saved_forces.size() > 0)
+    const NonlinearResults &path = fem_system.nonlinear_results;
+    if (last_result == -1)
+        ImGui::TextColored(ImVec4(1.f, 0.4f, 0.4f, 1.f), "Tangent became singular (limit point or mechanism).");
+    else if (last_result == -2)
+        ImGui::TextColored(ImVec4(1.f, 0.8f, 0.2f, 1.f), "An increment did not converge; try more load steps.");
+
+    if (path.total_iterations > 0 || !path.increments.empty())
+    {
+        ImGui::Text("Reached load factor %.3f: %d iterations, %d factorizations",
+                    path.reached_load_factor, path.total_iterations, path.factorizations);
+
+        // convergence history, one point per iteration over all increments
+        if (!path.residual_history.empty())
         {
-            fem_system.forces = saved_forces * factor;
-            fem_system.solve_system(); // update deformation for visualization
+            std::vector<float> history(path.residual_history.size());
+            for (size_t i = 0; i < history.size(); ++i)
+                history[i] = static_cast<float>(std::log10(std::max(path.residual_history[i], 1e-16)));
+            ImGui::PlotLines("log10 Residual", history.data(), static_cast<int>(history.size()), 0, nullptr,
+                             FLT_MAX, FLT_MAX, ImVec2(0, 60));
         }
     }
 
-    // --- Recording controls ---
-    ImGui::Separator();
-    ImGui::Text("Recording / Export");
-    ImGui::Spacing();
-
-    // Persistent state across frames
-    static bool recording = false;
-    static float record_fps = 24.0;
-    static int recorded_frames = 0;
-    static double record_accum = 0.0;
-    // New: user-configurable recording length (seconds) and elapsed time accumulator
-    static float record_length_seconds = 5.0f;
-    static double record_time_accum = 0.0;
-    static std::string out_dir = "record_frames";
-    static std::string out_prefix = "frame";
-    static bool auto_build_gif = false;
-    static bool delete_frames_after = false;
+    if (!path.increments.empty() &&
+        ImGui::BeginTable("increments_table", 4, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg | ImGuiTableFlags_ScrollY,
+                          ImVec2(0, 160)))
+    {
+        ImGui::TableSetupColumn("Increment");
+        ImGui::TableSetupColumn("Load Factor");
+        ImGui::TableSetupColumn("Iterations");
+        ImGui::TableSetupColumn("Residual");
+        ImGui::TableHeadersRow();
 
-    // Input fields
-    char dir_buf[512];
+        for (int k = 0; k < static_cast<int>(path.increments.size()); ++k)
+        {
+            const NonlinearIncrement &inc = path.increments[k];
+            ImGui::TableNextRow();
+            ImGui::TableSetColumnIndex(0);
+            char label[32];
+            std::snprintf(label, sizeof(label), "%d", k + 1);
+            bool selected = shape_source == ShapeSource::Increment && shape_index == k;
+            if (ImGui::Selectable(label, selected, ImGuiSelectableFlags_SpanAllColumns))
+            {
+                selectShape(ShapeSource::Increment, k);
+                shape_animate = false;
+            }
+            ImGui::TableSetColumnIndex(1);
+            ImGui::Text("%.3f", inc.load_factor);
+            ImGui::TableSetColumnIndex(2);
+            ImGui::Text("%d", inc.iterations);
+            ImGui::TableSetColumnIndex(3);
+            ImGui::Text("%.2e", inc.residual);
+        }
+        ImGui::EndTable();
+    }
+    ImGui::PopID();
+}
+
+void GUIHandler::transientPanel()
+{
+    static int last_result = 0;
+    static float damping_ratio = 0.02f;
+    static int load_type = 0;
+    TransientOptions &options = fem_system.transient_options;
+    LoadHistory &load = options.load;
+
+    ImGui::PushID("transient");
+    ImGui::TextWrapped("Dynamic response from rest to the current loads times a load history.");
+
+    // time stepping (the effective stiffness is factored once for the fixed step)
+    float time_step = static_cast<float>(options.time_step);
+    if (ImGui::InputFloat("Time Step (s)", &time_step, 0.0f, 0.0f, "%.2e"))
+        options.time_step = std::max(time_step, 1e-9f);
+    float duration = static_cast<float>(options.duration);
+    if (ImGui::InputFloat("Duration (s)", &duration, 0.0f, 0.0f, "%.3f"))
+        options.duration = std::max(duration, 1e-9f);
+    float hht_alpha = static_cast<float>(options.hht_alpha);
+    if (ImGui::SliderFloat("HHT Alpha", &hht_alpha, -1.0f / 3.0f, 0.0f, "%.3f"))
+        options.hht_alpha = hht_alpha;
+    ImGui::SameLine();
+    ImGui::TextDisabled("(?)");
+    if (ImGui::IsItemHovered())
+        ImGui::SetTooltip("0 = Newmark average acceleration (no numerical damping).\nNegative values damp the highest modes.");
+    ImGui::Checkbox("Lumped Mass (HRZ)", &options.lumped_mass);
+    ImGui::SliderInt("Stored Frames", &options.max_frames, 10, 5000);
+
+    // Rayleigh damping, either directly or from a damping ratio at the first two modes
+    ImGui::Separator();
+    float c_mass = static_cast<float>(options.rayleigh_mass);
+    float c_stiff = static_cast<float>(options.rayleigh_stiffness);
+    if (ImGui::InputFloat("Mass Damping a0 (1/s)", &c_mass, 0.0f, 0.0f, "%.4e"))
+        options.rayleigh_mass = std::max(c_mass, 0.0f);
+    if (ImGui::InputFloat("Stiffness Damping a1 (s)", &c_stiff, 0.0f, 0.0f, "%.4e"))
+        options.rayleigh_stiffness = std::max(c_stiff, 0.0f);
+    ImGui::SliderFloat("Damping Ratio", &damping_ratio, 0.0f, 0.2f, "%.3f");
+    ImGui::SameLine();
+    if (ImGui::Button("Set from Modes 1-2"))
+    {
+        if (fem_system.modal_results.count < 2)
+            fem_system.solve_modes(2, options.lumped_mass);
+        const ModalResults &modes = fem_system.modal_results;
+        if (modes.count >= 2)
+            rayleigh_coefficients(damping_ratio, modes.omega[0], modes.omega[1], options.rayleigh_mass, options.rayleigh_stiffness);
+    }
+
+    // load history
+    ImGui::Separator();
+    const char *load_types[] = {"Step", "Ramp", "Harmonic", "Half-Sine Pulse", "Table"};
+    load_type = static_cast<int>(load.type);
+    if (ImGui::Combo("Load History", &load_type, load_types, IM_ARRAYSIZE(load_types)))
+        load.type = static_cast<LoadHistory::Type>(load_type);
+    float amplitude = static_cast<float>(load.amplitude);
+    if (ImGui::InputFloat("Load Multiplier", &amplitude, 0.0f, 0.0f, "%.3f"))
+        load.amplitude = amplitude;
+    if (load.type == LoadHistory::Harmonic)
+    {
+        float frequency = static_cast<float>(load.frequency);
+        if (ImGui::InputFloat("Frequency (Hz)", &frequency, 0.0f, 0.0f, "%.3f"))
+            load.frequency = std::max(frequency, 0.0f);
+    }
+    else if (load.type == LoadHistory::Ramp || load.type == LoadHistory::Pulse)
+    {
+        float length = static_cast<float>(load.duration);
+        if (ImGui::InputFloat(load.type == LoadHistory::Ramp ? "Rise Time (s)" : "Pulse Length (s)", &length, 0.0f, 0.0f, "%.4f"))
+            load.duration = std::max(length, 0.0f);
+    }
+    else if (load.type == LoadHistory::Table)
+    {
+        // (time, factor) points, linear in between and held after the last one
+        int remove = -1;
+        bool reorder = false;
+        for (int i = 0; i < static_cast<int>(load.table.size()); ++i)
+        {
+            ImGui::PushID(i);
+            float point[2] = {static_cast<float>(load.table[i](0)), static_cast<float>(load.table[i](1))};
+            if (ImGui::InputFloat2("t, factor", point, "%.4f"))
+                load.table[i] = Eigen::Vector2d(point[0], point[1]);
+            reorder |= ImGui::IsItemDeactivatedAfterEdit(); // keep rows still while typing
+            ImGui::SameLine();
+            if (ImGui::SmallButton("X"))
+                remove = i;
+            ImGui::PopID();
+        }
+        if (remove >= 0)
+            load.table.erase(load.table.begin() + remove);
+        if (ImGui::SmallButton("Add Point"))
+        {
+            double t = load.table.empty() ? 0.0 : load.table.back()(0) + 0.1;
+            load.table.push_back(Eigen::Vector2d(t, 1.0));
+        }
+        if (reorder)
+            std::sort(load.table.begin(), load.table.end(), [](const Eigen::Vector2d &a, const Eigen::Vector2d &b)
+                      { return a(0) < b(0); });
+    }
+
+    ImGui::Separator();
+    if (ImGui::Button("Solve Transient"))
+    {
+        last_result = fem_system.solve_transient();
+        if (last_result == 0)
+        {
+            selectShape(ShapeSource::Transient, 0);
+            shape_animate = true;
+        }
+    }
+
+    const TransientResults &history = fem_system.transient_results;
+    if (last_result == -1)
+        ImGui::TextColored(ImVec4(1.f, 0.4f, 0.4f, 1.f), "Could not factor the effective stiffness (no mass or a mechanism?)");
+    else if (last_result == -3)
+        ImGui::TextColored(ImVec4(1.f, 0.8f, 0.2f, 1.f), "Nothing to integrate: check the time step, duration and supports.");
+
+    if (!history.times.empty())
+    {
+        double simulated = history.steps * history.time_step;
+        ImGui::Text("%d steps in %.2f s (%.1fx real time), %d frames", history.steps, history.wall_seconds,
+                    history.wall_seconds > 0.0 ? simulated / history.wall_seconds : 0.0,
+                    static_cast<int>(history.times.size()));
+        ImGui::PlotLines("Peak Translation", history.peak_translation.data(), static_cast<int>(history.peak_translation.size()),
+                         0, nullptr, 0.0f, FLT_MAX, ImVec2(0, 60));
+    }
+    ImGui::PopID();
+}
+
+// real-time response of the lowest modes to the Transient Dynamics load history
+void GUIHandler::modalResponsePanel()
+{
+    static int mode_count = 10;
+    static float damping_ratio = 0.02f;
+    static int last_result = 0;
+
+    ImGui::PushID("modal_response");
+    ImGui::TextWrapped("Sums the response of the lowest modes, each a damped oscillator driven by the "
+                       "current loads times the load history set under Transient Dynamics. Each frame "
+                       "only updates the nodes and members on screen, and colors keep the range of the "
+                       "modes' envelope, so it plays in real time on large models.");
+    ImGui::SliderInt("Modes", &mode_count, 1, 100);
+    ImGui::SliderFloat("Damping Ratio", &damping_ratio, 0.0f, 0.2f, "%.3f");
+    if (ImGui::Button("Start Preview"))
+    {
+        last_result = fem_system.prepare_modal_response(mode_count, damping_ratio);
+        if (last_result == 0)
+        {
+            selectShape(ShapeSource::ModalResponse, 0);
+            shape_animate = true;
+        }
+    }
+
+    const ModalSuperposition &response = fem_system.modal_response;
+    if (last_result != 0)
+        ImGui::TextColored(ImVec4(1.f, 0.4f, 0.4f, 1.f), "No modes found (no mass, or a mechanism?)");
+    else if (response.modes > 0)
+        ImGui::Text("%d modes, highest %.3f Hz", response.modes, response.omega.back() / (2.0 * M_PI));
+    ImGui::PopID();
+}
+
+// steady-state harmonic sweep: envelope plots, one member's curves and CSV export
+void GUIHandler::frequencyResponsePanel()
+{
+    static int last_result = 0;
+    static int member = 0; // 0-based; follows the peak member after each sweep
+    static bool export_all_members = false;
+    static char frf_name_buf[512] = "frequency_response.csv";
+    FrequencyResponseOptions &options = fem_system.frequency_options;
+
+    ImGui::PushID("frequency_response");
+    ImGui::TextWrapped("Amplitudes of the response to the current loads applied as F sin(wt).");
+
+    const char *methods[] = {"Modal Superposition", "Direct (Complex Solves)"};
+    int method = static_cast<int>(options.method);
+    if (ImGui::Combo("Method", &method, methods, IM_ARRAYSIZE(methods)))
+        options.method = static_cast<FrequencyResponseOptions::Method>(method);
+
+    float range[2] = {static_cast<float>(options.min_frequency), static_cast<float>(options.max_frequency)};
+    if (ImGui::InputFloat2("Range (Hz)", range, "%.3f"))
+    {
+        options.min_frequency = std::max(range[0], 0.0f);
+        options.max_frequency = std::max(range[1], range[0]);
+    }
+    ImGui::SliderInt("Frequencies", &options.num_frequencies, 2, 2000);
+    ImGui::Checkbox("Log Spacing", &options.log_spacing);
+    ImGui::SameLine();
+    ImGui::Checkbox("Lumped Mass (HRZ)", &options.lumped_mass);
+
+    if (options.method == FrequencyResponseOptions::Modal)
+    {
+        ImGui::SliderInt("Modes", &options.modes, 1, 200);
+        float zeta = static_cast<float>(options.damping_ratio);
+        if (ImGui::SliderFloat("Damping Ratio", &zeta, 0.0f, 0.2f, "%.3f"))
+            options.damping_ratio = zeta;
+    }
+    float c_mass = static_cast<float>(options.rayleigh_mass);
+    float c_stiff = static_cast<float>(options.rayleigh_stiffness);
+    if (ImGui::InputFloat("Mass Damping a0 (1/s)", &c_mass, 0.0f, 0.0f, "%.4e"))
+        options.rayleigh_mass = std::max(c_mass, 0.0f);
+    if (ImGui::InputFloat("Stiffness Damping a1 (s)", &c_stiff, 0.0f, 0.0f, "%.4e"))
+        options.rayleigh_stiffness = std::max(c_stiff, 0.0f);
+
+    if (ImGui::Button("Run Sweep"))
+    {
+        last_result = fem_system.solve_frequency_response();
+        const FrequencyResponseResults &r = fem_system.frequency_results;
+        if (!r.peak_stress.empty())
+        {
+            int worst = static_cast<int>(std::max_element(r.peak_stress.begin(), r.peak_stress.end()) - r.peak_stress.begin());
+            member = std::max(r.peak_member[worst], 0);
+        }
+    }
+
+    const FrequencyResponseResults &r = fem_system.frequency_results;
+    if (last_result == -1)
+        ImGui::TextColored(ImVec4(1.f, 0.4f, 0.4f, 1.f), "No modes, or an undamped resonance made the matrix singular.");
+    else if (last_result == -3)
+        ImGui::TextColored(ImVec4(1.f, 0.8f, 0.2f, 1.f), "Check the frequency range and supports.");
+
+    if (r.num_frequencies > 0 && r.num_members > 0)
+    {
+        const char *len_unit = (fem_system.unit_system == Metric) ? "m" : (fem_system.unit_system == ImperialInches ? "in" : "ft");
+        const char *stress_label = (fem_system.unit_system == Metric) ? "MPa" : "psi";
+        int nf = r.num_frequencies;
+
+        if (options.method == FrequencyResponseOptions::Modal)
+            ImGui::Text("%d frequencies, %d modes, %.2f s", nf, r.modes_used, r.wall_seconds);
+        else
+            ImGui::Text("%d frequencies, %d factorizations, %.2f s", nf, r.factorizations, r.wall_seconds);
+        ImGui::Text("%.3f Hz to %.3f Hz%s", r.frequency.front(), r.frequency.back(), options.log_spacing ? " (log)" : "");
+
+        ImGui::PlotLines("Peak Displacement", r.peak_displacement.data(), nf, 0, nullptr, 0.0f, FLT_MAX, ImVec2(0, 60));
+        ImGui::PlotLines("Peak Stress", r.peak_stress.data(), nf, 0, nullptr, 0.0f, FLT_MAX, ImVec2(0, 60));
+
+        // one member's curves straight from the member-major arrays
+        int shown = member + 1;
+        if (ImGui::InputInt("Member", &shown))
+            member = std::min(std::max(shown - 1, 0), r.num_members - 1);
+        member = std::min(member, r.num_members - 1);
+        const float *u = r.member_displacement.data() + static_cast<size_t>(member) * nf;
+        const float *sigma = r.member_stress.data() + static_cast<size_t>(member) * nf;
+        int peak = static_cast<int>(std::max_element(sigma, sigma + nf) - sigma);
+        ImGui::PlotLines("Member Displacement", u, nf, 0, nullptr, 0.0f, FLT_MAX, ImVec2(0, 60));
+        ImGui::PlotLines("Member Stress", sigma, nf, 0, nullptr, 0.0f, FLT_MAX, ImVec2(0, 60));
+        ImGui::Text("Beam %d peaks at %.3f Hz: %.4g %s, %.2f %s", member + 1, r.frequency[peak],
+                    fem_system.lengthToDisplay(u[peak]), len_unit, fem_system.stressToDisplay(sigma[peak]), stress_label);
+
+        ImGui::InputText("CSV Filename", frf_name_buf, sizeof(frf_name_buf));
+        ImGui::Checkbox("All Members", &export_all_members);
+        ImGui::SameLine();
+        if (ImGui::Button("Export CSV"))
+        {
+            std::string fname(frf_name_buf);
+            if (fname.size() < 4 || fname.substr(fname.size() - 4) != ".csv")
+                fname += ".csv";
+
+            std::ofstream ofs(fname);
+            if (!ofs)
+            {
+                error_msg = "Could not open CSV for writing.";
+                save_error = true;
+            }
+            else
+            {
+                ofs << "Envelope\n";
+                ofs << "Frequency_Hz,PeakDisplacement,PeakStress,PeakMember\n";
+                for (int k = 0; k < nf; ++k)
+                    ofs << r.frequency[k] << "," << fem_system.lengthToDisplay(r.peak_displacement[k]) << ","
+                        << fem_system.stressToDisplay(r.peak_stress[k]) << "," << (r.peak_member[k] + 1) << "\n";
+
+                // long format, one row per member and frequency
+                ofs << "\nMembers\n";
+                ofs << "Member,Frequency_Hz,Displacement,Stress\n";
+                int first = export_all_members ? 0 : member;
+                int last = export_all_members ? r.num_members : member + 1;
+                for (int i = first; i < last; ++i)
+                {
+                    size_t row = static_cast<size_t>(i) * nf;
+                    for (int k = 0; k < nf; ++k)
+                        ofs << (i + 1) << "," << r.frequency[k] << "," << fem_system.lengthToDisplay(r.member_displacement[row + k])
+                            << "," << fem_system.stressToDisplay(r.member_stress[row + k]) << "\n";
+                }
+
+                if (!ofs)
+                {
+                    error_msg = "Error writing CSV file.";
+                    save_error = true;
+                }
+            }
+        }
+    }
+    ImGui::PopID();
+}
+
+// seismic envelopes: spectrum table, modal combination, results in the normal stress views
+void GUIHandler::responseSpectrumPanel()
+{
+    static int last_result = 0;
+    static float pga = 0.3f; // g
+    static float plateau = 2.5f;
+    static float corner[2] = {0.15f, 0.5f}; // s
+    ResponseSpectrumOptions &options = fem_system.spectrum_options;
+    ResponseSpectrum &spectrum = options.spectrum;
+
+    ImGui::PushID("response_spectrum");
+    ImGui::TextWrapped("Peak member forces for ground acceleration from a design spectrum (Sa in g against period).");
+
+    // spectrum: quick code shape, or edit the points
+    ImGui::InputFloat("PGA (g)", &pga, 0.0f, 0.0f, "%.3f");
+    ImGui::InputFloat("Plateau Factor", &plateau, 0.0f, 0.0f, "%.2f");
+    ImGui::InputFloat2("Plateau Tb, Tc (s)", corner, "%.3f");
+    if (ImGui::Button("Set Design Shape"))
+        spectrum.set_design_shape(pga, plateau, corner[0], std::max(corner[1], corner[0]));
+
+    if (ImGui::TreeNode("Spectrum Points"))
+    {
+        int remove = -1;
+        bool reorder = false;
+        for (int i = 0; i < static_cast<int>(spectrum.table.size()); ++i)
+        {
+            ImGui::PushID(i);
+            float point[2] = {static_cast<float>(spectrum.table[i](0)), static_cast<float>(spectrum.table[i](1))};
+            if (ImGui::InputFloat2("T, Sa", point, "%.4f"))
+                spectrum.table[i] = Eigen::Vector2d(std::max(point[0], 0.0f), point[1]);
+            reorder |= ImGui::IsItemDeactivatedAfterEdit();
+            ImGui::SameLine();
+            if (ImGui::SmallButton("X"))
+                remove = i;
+            ImGui::PopID();
+        }
+        if (remove >= 0)
+            spectrum.table.erase(spectrum.table.begin() + remove);
+        if (ImGui::SmallButton("Add Point"))
+        {
+            double T = spectrum.table.empty() ? 0.0 : spectrum.table.back()(0) + 0.5;
+            spectrum.table.push_back(Eigen::Vector2d(T, spectrum.table.empty() ? pga : spectrum.table.back()(1)));
+        }
+        if (reorder)
+            std::sort(spectrum.table.begin(), spectrum.table.end(), [](const Eigen::Vector2d &a, const Eigen::Vector2d &b)
+                      { return a(0) < b(0); });
+        ImGui::TreePop();
+    }
+    if (!spectrum.table.empty())
+    {
+        // sampled over the table's periods for a quick look at the shape
+        float samples[64];
+        double T_max = std::max(spectrum.table.back()(0), 1e-3);
+        for (int k = 0; k < 64; ++k)
+            samples[k] = static_cast<float>(spectrum.acceleration(T_max * k / 63.0) / spectrum.scale);
+        ImGui::PlotLines("Sa (g)", samples, 64, 0, nullptr, 0.0f, FLT_MAX, ImVec2(0, 50));
+    }
+
+    ImGui::Separator();
+    ImGui::SliderInt("Modes", &options.modes, 1, 200);
+    const char *combinations[] = {"SRSS", "CQC"};
+    int combination = static_cast<int>(options.combination);
+    if (ImGui::Combo("Combination", &combination, combinations, IM_ARRAYSIZE(combinations)))
+        options.combination = static_cast<ResponseSpectrumOptions::Combination>(combination);
+    if (options.combination == ResponseSpectrumOptions::CQC)
+    {
+        float zeta = static_cast<float>(options.damping_ratio);
+        if (ImGui::SliderFloat("Damping Ratio", &zeta, 0.0f, 0.2f, "%.3f"))
+            options.damping_ratio = zeta;
+    }
+    float direction = static_cast<float>(options.direction);
+    if (ImGui::SliderFloat("Direction (deg from x)", &direction, 0.0f, 180.0f, "%.0f"))
+        options.direction = direction;
+    ImGui::Checkbox("Lumped Mass (HRZ)", &options.lumped_mass);
+
+    if (ImGui::Button("Run Spectrum Analysis"))
+    {
+        last_result = fem_system.solve_response_spectrum();
+        shape_source = ShapeSource::Static; // the envelope has no deformed shape to animate
+    }
+    ImGui::SameLine();
+    if (ImGui::Button("Show Static Solution"))
+        fem_system.solve_system();
+
+    const ResponseSpectrumResults &r = fem_system.spectrum_results;
+    if (last_result != 0)
+        ImGui::TextColored(ImVec4(1.f, 0.4f, 0.4f, 1.f), "No modes found (no mass, or a mechanism?)");
+    else if (r.modes > 0)
+    {
+        const char *stress_label = (fem_system.unit_system == Metric) ? "MPa" : "psi";
+        ImGui::Text("%d modes capture %.1f%% of the mass", r.modes, 100.0 * r.captured_mass);
+        if (r.captured_mass < 0.9)
+            ImGui::TextColored(ImVec4(1.f, 0.8f, 0.2f, 1.f), "Below 90%%: add modes");
+        ImGui::Text("Base shear %.4g, %.4g", fem_system.forceToDisplay(r.base_shear[0]), fem_system.forceToDisplay(r.base_shear[1]));
+        ImGui::Text("Peak stress %.2f %s (shown as the member colors)", fem_system.stressToDisplay(r.max_stress), stress_label);
+        if (ImGui::SmallButton("Show Envelope Again"))
+            fem_system.show_spectrum_envelope();
+
+        if (ImGui::BeginTable("spectrum_modes", 4, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg | ImGuiTableFlags_ScrollY,
+                              ImVec2(0, 150)))
+        {
+            ImGui::TableSetupColumn("Mode");
+            ImGui::TableSetupColumn("T (s)");
+            ImGui::TableSetupColumn("Sa (g)");
+            ImGui::TableSetupColumn("Mass %");
+            ImGui::TableHeadersRow();
+            for (int k = 0; k < r.modes; ++k)
+            {
+                ImGui::TableNextRow();
+                ImGui::TableNextColumn();
+                ImGui::Text("%d", k + 1);
+                ImGui::TableNextColumn();
+                ImGui::Text("%.4f", r.period[k]);
+                ImGui::TableNextColumn();
+                ImGui::Text("%.3f", r.spectral_acceleration[k] / spectrum.scale);
+                ImGui::TableNextColumn();
+                ImGui::Text("%.1f", 100.0 * r.mass_ratio[k]);
+            }
+            ImGui::EndTable();
+        }
+    }
+    ImGui::PopID();
+}
+
+// plastic hinge pushover: capacity from the profiles' Mp, load-displacement curve, hinge sequence
+void GUIHandler::pushoverPanel()
+{
+    static int last_result = 0;
+    static char pushover_name_buf[512] = "pushover.csv";
+    PushoverOptions &options = fem_system.pushover_options;
+
+    ImGui::PushID("pushover");
+    ImGui::TextWrapped("Scales the current loads up until plastic hinges (at the profiles' Mp) form a collapse mechanism.");
+
+    int with_capacity = 0;
+    for (const BeamProfile &p : fem_system.beam_profiles_list)
+        with_capacity += p.plastic_moment > 0.0 ? 1 : 0;
+    if (with_capacity == 0)
+        ImGui::TextColored(ImVec4(1.f, 0.8f, 0.2f, 1.f), "Set a plastic moment Mp on a beam profile first.");
+
+    float max_factor = static_cast<float>(options.max_load_factor);
+    if (ImGui::InputFloat("Max Load Factor", &max_factor, 0.0f, 0.0f, "%.3f"))
+        options.max_load_factor = std::max(max_factor, 1e-6f);
+    ImGui::SliderInt("Max Hinges", &options.max_events, 1, 5000);
+    int control_node = options.control_node + 1;
+    if (ImGui::InputInt("Control Node (0: auto)", &control_node))
+        options.control_node = std::min(std::max(control_node, 0), static_cast<int>(fem_system.nodes.size())) - 1;
+    ImGui::Checkbox("Store Every Event", &options.store_steps);
+
+    if (ImGui::Button("Run Pushover"))
+    {
+        last_result = fem_system.solve_pushover();
+        int count = static_cast<int>(fem_system.pushover_results.steps.size());
+        if (count > 0)
+        {
+            selectShape(ShapeSource::Pushover, count - 1);
+            shape_animate = false;
+        }
+    }
+
+    const PushoverResults &r = fem_system.pushover_results;
+    if (last_result == -1)
+        ImGui::TextColored(ImVec4(1.f, 0.4f, 0.4f, 1.f), "No member has a plastic moment.");
+    else if (last_result == -3)
+        ImGui::TextColored(ImVec4(1.f, 0.4f, 0.4f, 1.f), "The elastic structure already is a mechanism.");
+    else if (last_result == -2)
+        ImGui::TextColored(ImVec4(1.f, 0.8f, 0.2f, 1.f), "Stopped at the hinge limit before a mechanism formed.");
+
+    int count = static_cast<int>(r.steps.size());
+    if (count > 1)
+    {
+        const char *len_unit = (fem_system.unit_system == Metric) ? "m" : (fem_system.unit_system == ImperialInches ? "in" : "ft");
+        if (r.mechanism)
+            ImGui::Text("Collapse at load factor %.4f after %d hinges", r.collapse_load_factor, static_cast<int>(r.hinge_sequence.size()));
+        else
+            ImGui::Text("Load factor %.4f reached with %d hinges", r.collapse_load_factor, static_cast<int>(r.hinge_sequence.size()));
+        ImGui::Text("Control: node %d %s, %.4g %s", r.control_dof / 3 + 1, r.control_dof % 3 == 0 ? "x" : "y",
+                    fem_system.lengthToDisplay(r.steps.back().control_displacement), len_unit);
+        ImGui::Text("%d refactorizations, update rank %d, %.3f s", r.refactorizations, r.update_rank, r.wall_seconds);
+
+        // the curve is piecewise linear between events, so sample it evenly in displacement
+        const int samples = 128;
+        float curve[samples];
+        double d_end = r.steps.back().control_displacement;
+        int segment = 1;
+        for (int k = 0; k < samples; ++k)
+        {
+            double d = d_end * k / (samples - 1);
+            while (segment < count - 1 && std::abs(r.steps[segment].control_displacement) < std::abs(d))
+                ++segment;
+            const PushoverStep &a = r.steps[segment - 1];
+            const PushoverStep &b = r.steps[segment];
+            double span = b.control_displacement - a.control_displacement;
+            double w = std::abs(span) > 0.0 ? std::min(std::max((d - a.control_displacement) / span, 0.0), 1.0) : 1.0;
+            curve[k] = static_cast<float>((1.0 - w) * a.load_factor + w * b.load_factor);
+        }
+        ImGui::PlotLines("Load Factor vs Displacement", curve, samples, 0, nullptr, 0.0f, FLT_MAX, ImVec2(0, 80));
+
+        if (ImGui::BeginTable("pushover_events", 4, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg | ImGuiTableFlags_ScrollY,
+                              ImVec2(0, 160)))
+        {
+            ImGui::TableSetupColumn("Event");
+            ImGui::TableSetupColumn("Load Factor");
+            ImGui::TableSetupColumn("Displacement");
+            ImGui::TableSetupColumn("Hinge");
+            ImGui::TableHeadersRow();
+            for (int k = 0; k < count; ++k)
+            {
+                const PushoverStep &step = r.steps[k];
+                ImGui::TableNextRow();
+                ImGui::TableSetColumnIndex(0);
+                char label[32];
+                std::snprintf(label, sizeof(label), "%d", k);
+                bool selected = shape_source == ShapeSource::Pushover && shape_index == k;
+                if (ImGui::Selectable(label, selected, ImGuiSelectableFlags_SpanAllColumns))
+                {
+                    selectShape(ShapeSource::Pushover, k);
+                    shape_animate = false;
+                }
+                ImGui::TableSetColumnIndex(1);
+                ImGui::Text("%.4f", step.load_factor);
+                ImGui::TableSetColumnIndex(2);
+                ImGui::Text("%.4g", fem_system.lengthToDisplay(step.control_displacement));
+                ImGui::TableSetColumnIndex(3);
+                int hinge = k > 0 && step.hinges > r.steps[k - 1].hinges ? r.hinge_sequence[step.hinges - 1] : -1;
+                if (hinge >= 0 && (hinge >> 1) < static_cast<int>(fem_system.beams.size()))
+                {
+                    ImGui::Text("Beam %d, node %d", (hinge >> 1) + 1, fem_system.beams[hinge >> 1].nodes[hinge & 1] + 1);
+                }
+            }
+            ImGui::EndTable();
+        }
+
+        ImGui::InputText("CSV Filename", pushover_name_buf, sizeof(pushover_name_buf));
+        ImGui::SameLine();
+        if (ImGui::Button("Export CSV"))
+        {
+            std::string fname(pushover_name_buf);
+            if (fname.size() < 4 || fname.substr(fname.size() - 4) != ".csv")
+                fname += ".csv";
+
+            std::ofstream ofs(fname);
+            if (!ofs)
+            {
+                error_msg = "Could not open CSV for writing.";
+                save_error = true;
+            }
+            else
+            {
+                ofs << "Event,LoadFactor,ControlDisplacement,HingeBeam,HingeNode\n";
+                for (int k = 0; k < count; ++k)
+                {
+                    const PushoverStep &step = r.steps[k];
+                    ofs << k << "," << step.load_factor << "," << fem_system.lengthToDisplay(step.control_displacement) << ",";
+                    int hinge = k > 0 && step.hinges > r.steps[k - 1].hinges ? r.hinge_sequence[step.hinges - 1] : -1;
+                    if (hinge >= 0 && (hinge >> 1) < static_cast<int>(fem_system.beams.size()))
+                    {
+                        ofs << (hinge >> 1) + 1 << "," << fem_system.beams[hinge >> 1].nodes[hinge & 1] + 1;
+                    }
+                    else
+                    {
+                        ofs << ",";
+                    }
+                    ofs << "\n";
+                }
+                if (!ofs)
+                {
+                    error_msg = "Error writing CSV file.";
+                    save_error = true;
+                }
+            }
+        }
+    }
+    ImGui::PopID();
+}
+
+namespace
+{
+    // "1-5, 8, 12-10" (1-based, ranges either way) -> 0-based node indices in that order
+    bool parseNodeList(const std::string &text, int num_nodes, std::vector<int> &out)
+    {
+        out.clear();
+        std::stringstream ss(text);
+        std::string item;
+        while (std::getline(ss, item, ','))
+        {
+            int first = 0, last = 0;
+            char dash = 0;
+            std::stringstream part(item);
+            if (!(part >> first))
+            {
+                if (item.find_first_not_of(" \t") == std::string::npos)
+                    continue;
+                return false;
+            }
+            last = first;
+            if (part >> dash)
+            {
+                if (dash != '-' || !(part >> last))
+                    return false;
+            }
+            if (first < 1 || last < 1 || first > num_nodes || last > num_nodes)
+                return false;
+            int step = last >= first ? 1 : -1;
+            for (int n = first; n != last + step; n += step)
+                out.push_back(n - 1);
+        }
+        return !out.empty();
+    }
+} // namespace
+
+// influence lines along a deck path and envelopes of a load train crossing it
+void GUIHandler::movingLoadPanel()
+{
+    static int last_result = 0;
+    static char deck_buf[256] = "";
+    static float deck_level = 0.0f;
+    static int member = 0; // 0-based
+    static char moving_name_buf[512] = "moving_load.csv";
+    MovingLoadOptions &options = fem_system.moving_load_options;
+    LoadTrain &train = options.train;
+    const char *len_unit = (fem_system.unit_system == Metric) ? "m" : (fem_system.unit_system == ImperialInches ? "in" : "ft");
+    const char *force_unit = (fem_system.unit_system == Metric) ? "N" : "lbf";
+
+    ImGui::PushID("moving_load");
+    ImGui::TextWrapped("Envelopes of a train of axle loads crossing a deck, from one influence line per member.");
+
+    // deck path: typed node list, or every node at one height from left to right
+    int num_nodes = static_cast<int>(fem_system.nodes.size());
+    if (ImGui::InputText("Deck Nodes", deck_buf, sizeof(deck_buf), ImGuiInputTextFlags_EnterReturnsTrue))
+    {
+        std::vector<int> deck;
+        if (parseNodeList(deck_buf, num_nodes, deck))
+            options.deck_nodes = deck;
+    }
+    ImGui::SameLine();
+    ImGui::TextDisabled("(?)");
+    if (ImGui::IsItemHovered())
+        ImGui::SetTooltip("Node numbers in travel order, e.g. 1-9 or 1, 3, 5-7 (Enter to apply)");
+    ImGui::InputFloat("Deck Level Y", &deck_level, 0.0f, 0.0f, "%.3f");
+    ImGui::SameLine();
+    if (ImGui::Button("Nodes at Level"))
+    {
+        double y = fem_system.lengthFromDisplay(deck_level);
+        double tolerance = 1e-3 * std::max(1.0, std::abs(y));
+        std::vector<int> deck;
+        for (int i = 0; i < num_nodes; ++i)
+        {
+            if (std::abs(fem_system.nodes[i].position[1] - y) <= tolerance)
+                deck.push_back(i);
+        }
+        std::sort(deck.begin(), deck.end(), [&](int a, int b)
+                  { return fem_system.nodes[a].position[0] < fem_system.nodes[b].position[0]; });
+        options.deck_nodes = deck;
+        deck_buf[0] = '\0';
+    }
+    if (options.deck_nodes.empty())
+        ImGui::TextDisabled("No deck defined.");
+    else
+        ImGui::Text("Deck: %d nodes, node %d to node %d", static_cast<int>(options.deck_nodes.size()),
+                    options.deck_nodes.front() + 1, options.deck_nodes.back() + 1);
+
+    // axles
+    if (ImGui::TreeNode("Load Train"))
+    {
+        int remove = -1;
+        for (int a = 0; a < static_cast<int>(train.loads.size()); ++a)
+        {
+            ImGui::PushID(a);
+            float axle[2] = {static_cast<float>(fem_system.lengthToDisplay(train.offsets[a])),
+                             static_cast<float>(fem_system.forceToDisplay(train.loads[a]))};
+            std::string axle_label = std::string("Offset (") + len_unit + "), Load (" + force_unit + ")";
+            if (ImGui::InputFloat2(axle_label.c_str(), axle, "%.3f"))
+            {
+                train.offsets[a] = std::max(0.0, fem_system.lengthFromDisplay(axle[0]));
+                train.loads[a] = fem_system.forceFromDisplay(axle[1]);
+            }
+            ImGui::SameLine();
+            if (ImGui::SmallButton("X"))
+                remove = a;
+            ImGui::PopID();
+        }
+        if (remove >= 0)
+        {
+            train.offsets.erase(train.offsets.begin() + remove);
+            train.loads.erase(train.loads.begin() + remove);
+        }
+        if (ImGui::SmallButton("Add Axle"))
+        {
+            train.offsets.push_back(train.length() + 1.0);
+            train.loads.push_back(train.loads.empty() ? 1e4 : train.loads.back());
+        }
+        ImGui::SameLine();
+        if (ImGui::SmallButton("Design Truck"))
+            train = LoadTrain();
+        ImGui::TreePop();
+    }
+
+    float step = static_cast<float>(fem_system.lengthToDisplay(options.position_step));
+    std::string step_label = std::string("Position Step (") + len_unit + ", 0: auto)";
+    if (ImGui::InputFloat(step_label.c_str(), &step, 0.0f, 0.0f, "%.3f"))
+        options.position_step = std::max(0.0, fem_system.lengthFromDisplay(step));
+    ImGui::Checkbox("Both Directions", &options.both_directions);
+
+    if (ImGui::Button("Compute Influence Lines"))
+        last_result = fem_system.solve_influence_lines();
+    ImGui::SameLine();
+    if (ImGui::Button("Run Train"))
+    {
+        last_result = fem_system.solve_moving_load();
+        shape_source = ShapeSource::Static; // the envelope has no deformed shape to animate
+        if (last_result == 0 && !fem_system.moving_load_results.max_stress.empty())
+        {
+            // follow the member with the largest stress range
+            const MovingLoadResults &r = fem_system.moving_load_results;
+            member = 0;
+            for (int i = 1; i < static_cast<int>(r.max_stress.size()); ++i)
+            {
+                if (r.max_stress[i] - r.min_stress[i] > r.max_stress[member] - r.min_stress[member])
+                    member = i;
+            }
+        }
+    }
+    ImGui::SameLine();
+    if (ImGui::Button("Show Static Solution"))
+        fem_system.solve_system();
+
+    if (last_result == -1)
+        ImGui::TextColored(ImVec4(1.f, 0.4f, 0.4f, 1.f), "Needs a deck of two or more separate nodes and at least one axle.");
+    else if (last_result != 0)
+        ImGui::TextColored(ImVec4(1.f, 0.4f, 0.4f, 1.f), "The static solve failed (mechanism?)");
+
+    const InfluenceLines &lines = fem_system.influence_lines;
+    const MovingLoadResults &r = fem_system.moving_load_results;
+    int members = static_cast<int>(lines.axial.rows());
+    if (members > 0 && lines.station.size() >= 2)
+    {
+        ImGui::Separator();
+        ImGui::Text("Influence lines: %d deck nodes, %.3f s", static_cast<int>(lines.station.size()), lines.wall_seconds);
+        int shown = member + 1;
+        if (ImGui::InputInt("Member", &shown))
+            member = std::min(std::max(shown, 1), members) - 1;
+        member = std::min(std::max(member, 0), members - 1);
+
+        // piecewise linear between the deck nodes, sampled evenly along the deck
+        const int samples = 128;
+        float axial[samples];
+        double deck = lines.deck_length();
+        int j = 0;
+        for (int k = 0; k < samples; ++k)
+        {
+            double x = deck * k / (samples - 1);
+            while (j < static_cast<int>(lines.station.size()) - 2 && lines.station[j + 1] < x)
+                ++j;
+            double w = (x - lines.station[j]) / (lines.station[j + 1] - lines.station[j]);
+            w = std::min(std::max(w, 0.0), 1.0);
+            axial[k] = static_cast<float>((1.0 - w) * lines.axial(member, j) + w * lines.axial(member, j + 1));
+        }
+        ImGui::PlotLines("Axial Force per Unit Load", axial, samples, 0, nullptr, FLT_MAX, FLT_MAX, ImVec2(0, 70));
+
+        if (static_cast<int>(r.max_stress.size()) == members)
+        {
+            const char *stress_label = (fem_system.unit_system == Metric) ? "MPa" : "psi";
+            ImGui::Text("Train: %d positions in %.2f ms (member colors show the envelope)", r.positions, 1000.0 * r.wall_seconds);
+            ImGui::Text("Axial %.4g .. %.4g %s", fem_system.forceToDisplay(r.min_axial[member]),
+                        fem_system.forceToDisplay(r.max_axial[member]), force_unit);
+            ImGui::Text("Moment %.4g .. %.4g", fem_system.momentToDisplay(r.min_moment[member]),
+                        fem_system.momentToDisplay(r.max_moment[member]));
+            ImGui::Text("Stress %.2f .. %.2f %s", fem_system.stressToDisplay(r.min_stress[member]),
+                        fem_system.stressToDisplay(r.max_stress[member]), stress_label);
+            ImGui::Text("Worst with the front axle at %.3f %s%s", fem_system.lengthToDisplay(r.critical_position[member]), len_unit,
+                        r.critical_reversed[member] ? " (reverse run)" : "");
+            if (ImGui::SmallButton("Show Envelope Again"))
+                fem_system.show_moving_load_envelope();
+
+            ImGui::InputText("CSV Filename", moving_name_buf, sizeof(moving_name_buf));
+            ImGui::SameLine();
+            if (ImGui::Button("Export CSV"))
+            {
+                std::string fname(moving_name_buf);
+                if (fname.size() < 4 || fname.substr(fname.size() - 4) != ".csv")
+                    fname += ".csv";
+
+                std::ofstream ofs(fname);
+                if (!ofs)
+                {
+                    error_msg = "Could not open CSV for writing.";
+                    save_error = true;
+                }
+                else
+                {
+                    ofs << "Envelope\n";
+                    ofs << "Member,MinAxial,MaxAxial,MinMoment,MaxMoment,MinStress,MaxStress,CriticalPosition,Reversed\n";
+                    for (int i = 0; i < members; ++i)
+                        ofs << (i + 1) << "," << fem_system.forceToDisplay(r.min_axial[i]) << "," << fem_system.forceToDisplay(r.max_axial[i])
+                            << "," << fem_system.momentToDisplay(r.min_moment[i]) << "," << fem_system.momentToDisplay(r.max_moment[i])
+                            << "," << fem_system.stressToDisplay(r.min_stress[i]) << "," << fem_system.stressToDisplay(r.max_stress[i])
+                            << "," << fem_system.lengthToDisplay(r.critical_position[i]) << "," << (r.critical_reversed[i] ? 1 : 0) << "\n";
+
+                    // axial force per unit load, one row per member and deck node
+                    ofs << "\nInfluence\n";
+                    ofs << "Member,DeckNode,Station,AxialPerUnitLoad\n";
+                    for (int i = 0; i < members; ++i)
+                    {
+                        for (size_t k = 0; k < lines.station.size(); ++k)
+                            ofs << (i + 1) << "," << (lines.deck_nodes[k] + 1) << "," << fem_system.lengthToDisplay(lines.station[k])
+                                << "," << lines.axial(i, static_cast<int>(k)) << "\n";
+                    }
+
+                    if (!ofs)
+                    {
+                        error_msg = "Error writing CSV file.";
+                        save_error = true;
+                    }
+                }
+            }
+        }
+    }
+    ImGui::PopID();
+}
+
+void GUIHandler::sensitivityPanel()
+{
+    static int last_result = 0;
+    static int response_type = 0;
+    static int response_node = 1; // 1-based, as shown in the editors
+    static int response_dof = 1;
+    static int response_member = 1;
+    static int shown = 0;
+    static int parameter = 0;
+    static bool relative = true;
+    static char sensitivity_name_buf[512] = "sensitivities.csv";
+    std::vector<SensitivityResponse> &responses = fem_system.sensitivity_responses;
+    const SensitivityResults &results = fem_system.sensitivity_results;
+    const char *len_unit = (fem_system.unit_system == Metric) ? "m" : (fem_system.unit_system == ImperialInches ? "in" : "ft");
+    const char *stress_label = (fem_system.unit_system == Metric) ? "MPa" : "psi";
+    int num_nodes = static_cast<int>(fem_system.nodes.size());
+    int num_beams = static_cast<int>(fem_system.beams.size());
+
+    ImGui::PushID("sensitivity");
+    ImGui::TextWrapped("Derivatives of chosen responses with respect to every member's section and material and every "
+                       "node's position, from one extra back-substitution per response.");
+
+    auto describe = [&](const SensitivityResponse &r)
+    {
+        const char *dofs[] = {"x", "y", "rotation"};
+        char text[64];
+        if (r.type == SensitivityResponse::Compliance)
+            std::snprintf(text, sizeof(text), "Compliance");
+        else if (r.type == SensitivityResponse::Displacement)
+            std::snprintf(text, sizeof(text), "Node %d %s", r.node + 1, dofs[std::min(std::max(r.dof, 0), 2)]);
+        else if (r.type == SensitivityResponse::Stress)
+            std::snprintf(text, sizeof(text), "Beam %d stress", r.member + 1);
+        else
+            std::snprintf(text, sizeof(text), "Max stress (aggregate)");
+        return std::string(text);
+    };
+    // response values in display units
+    auto toDisplay = [&](const SensitivityResponse &r, double value)
+    {
+        if (r.type == SensitivityResponse::Compliance)
+            return fem_system.forceToDisplay(fem_system.lengthToDisplay(value));
+        if (r.type == SensitivityResponse::Displacement)
+            return r.dof == 2 ? value : fem_system.lengthToDisplay(value);
+        return fem_system.stressToDisplay(value);
+    };
+
+    // response list
+    const char *types[] = {"Compliance", "Displacement", "Member Stress", "Max Stress"};
+    ImGui::Combo("Response", &response_type, types, IM_ARRAYSIZE(types));
+    if (response_type == 3 && ImGui::IsItemHovered())
+        ImGui::SetTooltip("Smooth upper bound of the largest member stress, differentiable where the maximum is not.");
+    if (response_type == 1)
+    {
+        const char *dofs[] = {"x", "y", "Rotation"};
+        ImGui::InputInt("Node", &response_node);
+        ImGui::Combo("Direction", &response_dof, dofs, IM_ARRAYSIZE(dofs));
+    }
+    else if (response_type == 2)
+    {
+        ImGui::InputInt("Beam", &response_member);
+    }
+    if (ImGui::Button("Add Response"))
+    {
+        SensitivityResponse r;
+        r.type = static_cast<SensitivityResponse::Type>(response_type);
+        r.node = std::min(std::max(response_node, 1), std::max(num_nodes, 1)) - 1;
+        r.dof = response_dof;
+        r.member = std::min(std::max(response_member, 1), std::max(num_beams, 1)) - 1;
+        responses.push_back(r);
+    }
+    int remove = -1;
+    for (int k = 0; k < static_cast<int>(responses.size()); ++k)
+    {
+        ImGui::PushID(k);
+        ImGui::BulletText("%s", describe(responses[k]).c_str());
+        ImGui::SameLine();
+        if (ImGui::SmallButton("X"))
+            remove = k;
+        ImGui::PopID();
+    }
+    if (remove >= 0)
+        responses.erase(responses.begin() + remove);
+
+    if (ImGui::Button("Compute Sensitivities"))
+    {
+        last_result = fem_system.solve_sensitivities();
+        shape_source = ShapeSource::Static;
+        shown = 0;
+    }
+    if (last_result == -1)
+        ImGui::TextColored(ImVec4(1.f, 0.4f, 0.4f, 1.f), "A response refers to a node or beam that no longer exists.");
+    else if (last_result != 0)
+        ImGui::TextColored(ImVec4(1.f, 0.4f, 0.4f, 1.f), "The static solve failed (mechanism?)");
+
+    int count = static_cast<int>(results.responses.size());
+    bool current = count > 0 && static_cast<int>(results.responses[0].area.size()) == num_beams &&
+                   static_cast<int>(results.responses[0].node_x.size()) == num_nodes;
+    if (!current)
+    {
+        renderer.colorBySensitivity = false;
+        ImGui::PopID();
+        return;
+    }
+
+    ImGui::Separator();
+    ImGui::Text("%d responses in %.2f ms", count, 1000.0 * results.wall_seconds);
+    shown = std::min(std::max(shown, 0), count - 1);
+    if (ImGui::BeginCombo("Show", describe(results.responses[shown].response).c_str()))
+    {
+        for (int k = 0; k < count; ++k)
+        {
+            if (ImGui::Selectable(describe(results.responses[k].response).c_str(), k == shown))
+                shown = k;
+        }
+        ImGui::EndCombo();
+    }
+    const ResponseSensitivity &s = results.responses[shown];
+    ImGui::Text("Value: %.5g", toDisplay(s.response, s.value));
+
+    const char *parameters[] = {"Area", "Inertia", "Modulus", "Node Position"};
+    ImGui::Combo("Parameter", &parameter, parameters, IM_ARRAYSIZE(parameters));
+    ImGui::Checkbox("Scale by Parameter (response change per 100% change)", &relative);
+
+    // member field of the chosen parameter, optionally times the parameter itself
+    std::vector<float> field;
+    if (parameter < 3)
+    {
+        field.resize(num_beams);
+        for (int i = 0; i < num_beams; ++i)
+        {
+            const Beam &beam = fem_system.beams[i];
+            const BeamProfile &shape = fem_system.beam_profiles_list[beam.shape_idx];
+            double value = parameter == 0 ? s.area[i] : (parameter == 1 ? s.inertia[i] : s.modulus[i]);
+            if (relative)
+            {
+                double p = parameter == 0 ? shape.area
+                                          : (parameter == 1 ? shape.moment_of_inertia
+                                                            : fem_system.materials_list[beam.material_idx].youngs_modulus);
+                value = toDisplay(s.response, value * p);
+            }
+            field[i] = static_cast<float>(value);
+        }
+    }
+
+    ImGui::Checkbox("Color by Sensitivity", &renderer.colorBySensitivity);
+    if (renderer.colorBySensitivity)
+    {
+        renderer.sensitivityField = field;
+        renderer.sensitivityRange = 0.0f;
+        for (float value : field)
+            renderer.sensitivityRange = std::max(renderer.sensitivityRange, std::abs(value));
+        renderer.sensitivityArrows.clear();
+        if (parameter == 3)
+        {
+            // longest arrow a tenth of the model's extent
+            float lo[2] = {FLT_MAX, FLT_MAX}, hi[2] = {-FLT_MAX, -FLT_MAX};
+            double largest = 0.0;
+            for (int n = 0; n < num_nodes; ++n)
+            {
+                for (int a = 0; a < 2; ++a)
+                {
+                    lo[a] = std::min(lo[a], fem_system.nodes[n].position[a]);
+                    hi[a] = std::max(hi[a], fem_system.nodes[n].position[a]);
+                }
+                largest = std::max(largest, std::hypot(s.node_x[n], s.node_y[n]));
+            }
+            double extent = std::max(hi[0] - lo[0], hi[1] - lo[1]);
+            double scale = largest > 0.0 ? 0.1 * extent / largest : 0.0;
+            renderer.sensitivityArrows.resize(num_nodes);
+            for (int n = 0; n < num_nodes; ++n)
+                renderer.sensitivityArrows[n] = sf::Vector2f(static_cast<float>(s.node_x[n] * scale), static_cast<float>(s.node_y[n] * scale));
+        }
+        ImGui::SameLine();
+        ImGui::TextDisabled("(green lowers the response, orange raises it)");
+    }
+
+    // largest entries first
+    if (parameter < 3)
+    {
+        std::vector<int> order(num_beams);
+        for (int i = 0; i < num_beams; ++i)
+            order[i] = i;
+        int top = std::min(10, num_beams);
+        std::partial_sort(order.begin(), order.begin() + top, order.end(), [&](int a, int b)
+                          { return std::abs(field[a]) > std::abs(field[b]); });
+        if (ImGui::BeginTable("sensitivity_members", 2, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg))
+        {
+            ImGui::TableSetupColumn("Beam");
+            ImGui::TableSetupColumn(relative ? "p d(value)/dp" : "d(value)/dp (SI)");
+            ImGui::TableHeadersRow();
+            for (int k = 0; k < top; ++k)
+            {
+                ImGui::TableNextRow();
+                ImGui::TableSetColumnIndex(0);
+                ImGui::Text("%d", order[k] + 1);
+                ImGui::TableSetColumnIndex(1);
+                ImGui::Text("%.4g", field[order[k]]);
+            }
+            ImGui::EndTable();
+        }
+    }
+    else
+    {
+        std::vector<int> order(num_nodes);
+        for (int n = 0; n < num_nodes; ++n)
+            order[n] = n;
+        int top = std::min(10, num_nodes);
+        std::partial_sort(order.begin(), order.begin() + top, order.end(), [&](int a, int b)
+                          { return std::hypot(s.node_x[a], s.node_y[a]) > std::hypot(s.node_x[b], s.node_y[b]); });
+        if (ImGui::BeginTable("sensitivity_nodes", 3, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg))
+        {
+            ImGui::TableSetupColumn("Node");
+            ImGui::TableSetupColumn((std::string("d/dx per ") + len_unit).c_str());
+            ImGui::TableSetupColumn((std::string("d/dy per ") + len_unit).c_str());
+            ImGui::TableHeadersRow();
+            for (int k = 0; k < top; ++k)
+            {
+                int n = order[k];
+                ImGui::TableNextRow();
+                ImGui::TableSetColumnIndex(0);
+                ImGui::Text("%d", n + 1);
+                ImGui::TableSetColumnIndex(1);
+                ImGui::Text("%.4g", toDisplay(s.response, s.node_x[n] / fem_system.lengthToDisplay(1.0)));
+                ImGui::TableSetColumnIndex(2);
+                ImGui::Text("%.4g", toDisplay(s.response, s.node_y[n] / fem_system.lengthToDisplay(1.0)));
+            }
+            ImGui::EndTable();
+        }
+    }
+    if (s.response.type == SensitivityResponse::Stress || s.response.type == SensitivityResponse::MaxStress)
+        ImGui::TextDisabled("Stress values in %s", stress_label);
+
+    ImGui::InputText("CSV Filename", sensitivity_name_buf, sizeof(sensitivity_name_buf));
+    ImGui::SameLine();
+    if (ImGui::Button("Export CSV"))
+    {
+        std::string fname(sensitivity_name_buf);
+        if (fname.size() < 4 || fname.substr(fname.size() - 4) != ".csv")
+            fname += ".csv";
+
+        std::ofstream ofs(fname);
+        if (!ofs)
+        {
+            error_msg = "Could not open CSV for writing.";
+            save_error = true;
+        }
+        else
+        {
+            // raw derivatives in SI units, one section per response
+            for (const ResponseSensitivity &r : results.responses)
+            {
+                ofs << describe(r.response) << "," << r.value << "\n";
+                ofs << "Beam,dArea,dInertia,dModulus\n";
+                for (int i = 0; i < num_beams; ++i)
+                    ofs << (i + 1) << "," << r.area[i] << "," << r.inertia[i] << "," << r.modulus[i] << "\n";
+                ofs << "Node,dX,dY\n";
+                for (int n = 0; n < num_nodes; ++n)
+                    ofs << (n + 1) << "," << r.node_x[n] << "," << r.node_y[n] << "\n";
+                ofs << "\n";
+            }
+            if (!ofs)
+            {
+                error_msg = "Error writing CSV file.";
+                save_error = true;
+            }
+        }
+    }
+    ImGui::PopID();
+}
+
+// minimum-weight member sizes under stress and deflection limits
+void GUIHandler::sizingPanel()
+{
+    static int last_result = 0;
+    static int last_applied = -1;
+    static char sizing_name_buf[512] = "sizing.csv";
+    SizingOptions &options = fem_system.sizing_options;
+    const SizingResults &r = fem_system.sizing_results;
+    const char *len_unit = (fem_system.unit_system == Metric) ? "m" : (fem_system.unit_system == ImperialInches ? "in" : "ft");
+    const char *area_unit = (fem_system.unit_system == Metric) ? "m^2" : (fem_system.unit_system == ImperialInches ? "in^2" : "ft^2");
+    const char *stress_label = (fem_system.unit_system == Metric) ? "MPa" : "psi";
+    const char *mass_unit = (fem_system.unit_system == Metric) ? "kg" : "lb";
+    int num_beams = static_cast<int>(fem_system.beams.size());
+
+    ImGui::PushID("sizing");
+    ImGui::TextWrapped("Resizes every member to the lightest section that keeps its stress and the largest node "
+                       "deflection within the limits, reanalysing with low-rank updates of one factorization.");
+
+    const char *methods[] = {"Fully Stressed", "Optimality Criteria"};
+    int method = static_cast<int>(options.method);
+    if (ImGui::Combo("Method", &method, methods, IM_ARRAYSIZE(methods)))
+        options.method = static_cast<SizingOptions::Method>(method);
+    ImGui::Checkbox("Pick from Profile Library", &options.discrete);
+    if (ImGui::IsItemHovered())
+        ImGui::SetTooltip("Otherwise each member gets its own area, with I and Z scaled from its current profile.");
+
+    float stress_limit = static_cast<float>(fem_system.stressToDisplay(options.stress_limit));
+    if (ImGui::InputFloat((std::string("Stress Limit (") + stress_label + ")").c_str(), &stress_limit, 0.0f, 0.0f, "%.4g"))
+        options.stress_limit = std::max(stress_limit, 1e-6f) / fem_system.stressToDisplay(1.0);
+    float deflection_limit = static_cast<float>(fem_system.lengthToDisplay(options.deflection_limit));
+    if (ImGui::InputFloat((std::string("Deflection Limit (") + len_unit + ", 0: none)").c_str(), &deflection_limit, 0.0f, 0.0f, "%.4g"))
+        options.deflection_limit = std::max(deflection_limit, 0.0f) / fem_system.lengthToDisplay(1.0);
+    if (!options.discrete)
+    {
+        float bounds[2] = {static_cast<float>(fem_system.areaToDisplay(options.min_area)),
+                           static_cast<float>(fem_system.areaToDisplay(options.max_area))};
+        if (ImGui::InputFloat2((std::string("Area Bounds (") + area_unit + ")").c_str(), bounds, "%.4g"))
+        {
+            options.min_area = std::max(bounds[0], 1e-12f) / fem_system.areaToDisplay(1.0);
+            options.max_area = std::max(static_cast<double>(bounds[1]) / fem_system.areaToDisplay(1.0), options.min_area);
+        }
+        float move = static_cast<float>(options.move_limit);
+        if (ImGui::SliderFloat("Move Limit", &move, 0.05f, 1.0f, "%.2f"))
+            options.move_limit = move;
+    }
+    ImGui::SliderInt("Max Iterations", &options.max_iterations, 1, 500);
+
+    if (ImGui::Button("Optimize"))
+    {
+        last_result = fem_system.solve_sizing();
+        last_applied = -1;
+    }
+    if (last_result < 0)
+        ImGui::TextColored(ImVec4(1.f, 0.4f, 0.4f, 1.f), "Sizing failed: a member without area, or a mechanism.");
+
+    if (static_cast<int>(r.area.size()) != num_beams || r.history.empty())
+    {
+        ImGui::PopID();
+        return;
+    }
+
+    ImGui::Separator();
+    if (r.feasible)
+        ImGui::Text("Feasible design");
+    else
+        ImGui::TextColored(ImVec4(1.f, 0.8f, 0.2f, 1.f), "Limits not met%s", r.converged ? "" : " (iteration limit reached)");
+    ImGui::Text("Mass: %.4g -> %.4g %s (%.1f%%)", fem_system.massToDisplay(r.initial_weight), fem_system.massToDisplay(r.weight),
+                mass_unit, r.initial_weight > 0.0 ? 100.0 * (r.weight / r.initial_weight - 1.0) : 0.0);
+    ImGui::Text("Max stress ratio %.3f, max deflection %.4g %s", r.max_stress_ratio, fem_system.lengthToDisplay(r.max_deflection), len_unit);
+    ImGui::Text("%d analyses, %d refactorizations, %.3f s", r.analyses, r.refactorizations, r.wall_seconds);
+
+    std::vector<float> weights(r.history.size());
+    for (size_t k = 0; k < r.history.size(); ++k)
+        weights[k] = static_cast<float>(fem_system.massToDisplay(r.history[k].weight));
+    ImGui::PlotLines("Mass per Iteration", weights.data(), static_cast<int>(weights.size()), 0, nullptr, 0.0f, FLT_MAX, ImVec2(0, 80));
+
+    // most highly stressed members first
+    std::vector<int> order(num_beams);
+    for (int i = 0; i < num_beams; ++i)
+        order[i] = i;
+    int top = std::min(10, num_beams);
+    std::partial_sort(order.begin(), order.begin() + top, order.end(), [&](int a, int b)
+                      { return r.stress_ratio[a] > r.stress_ratio[b]; });
+    if (ImGui::BeginTable("sizing_members", 3, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg))
+    {
+        ImGui::TableSetupColumn("Beam");
+        ImGui::TableSetupColumn(options.discrete ? "Profile" : (std::string("Area (") + area_unit + ")").c_str());
+        ImGui::TableSetupColumn("Stress Ratio");
+        ImGui::TableHeadersRow();
+        for (int k = 0; k < top; ++k)
+        {
+            int i = order[k];
+            ImGui::TableNextRow();
+            ImGui::TableSetColumnIndex(0);
+            ImGui::Text("%d", i + 1);
+            ImGui::TableSetColumnIndex(1);
+            if (options.discrete && r.profile[i] >= 0 && r.profile[i] < static_cast<int>(fem_system.beam_profiles_list.size()))
+                ImGui::Text("%s", fem_system.beam_profiles_list[r.profile[i]].name.c_str());
+            else
+                ImGui::Text("%.4g", fem_system.areaToDisplay(r.area[i]));
+            ImGui::TableSetColumnIndex(2);
+            ImGui::Text("%.3f", r.stress_ratio[i]);
+        }
+        ImGui::EndTable();
+    }
+
+    if (ImGui::Button("Apply to Model"))
+        last_applied = fem_system.apply_sizing();
+    if (last_applied >= 0)
+    {
+        ImGui::SameLine();
+        ImGui::Text("%d members resized", last_applied);
+    }
+
+    ImGui::InputText("CSV Filename", sizing_name_buf, sizeof(sizing_name_buf));
+    ImGui::SameLine();
+    if (ImGui::Button("Export CSV"))
+    {
+        std::string fname(sizing_name_buf);
+        if (fname.size() < 4 || fname.substr(fname.size() - 4) != ".csv")
+            fname += ".csv";
+
+        std::ofstream ofs(fname);
+        if (!ofs)
+        {
+            error_msg = "Could not open CSV for writing.";
+            save_error = true;
+        }
+        else
+        {
+            ofs << "Beam,Profile,Area,Inertia,SectionModulus,StressRatio\n";
+            for (int i = 0; i < num_beams; ++i)
+            {
+                bool named = options.discrete && r.profile[i] >= 0 && r.profile[i] < static_cast<int>(fem_system.beam_profiles_list.size());
+                ofs << (i + 1) << "," << (named ? fem_system.beam_profiles_list[r.profile[i]].name : std::string()) << ","
+                    << fem_system.areaToDisplay(r.area[i]) << "," << fem_system.inertiaToDisplay(r.inertia[i]) << ","
+                    << fem_system.sectionModulusToDisplay(r.section_modulus[i]) << "," << r.stress_ratio[i] << "\n";
+            }
+            ofs << "\nIteration,Mass,MaxStressRatio,MaxDeflection,Changed,Refactored\n";
+            for (size_t k = 0; k < r.history.size(); ++k)
+            {
+                const SizingIteration &step = r.history[k];
+                ofs << k << "," << fem_system.massToDisplay(step.weight) << "," << step.max_stress_ratio << ","
+                    << fem_system.lengthToDisplay(step.max_deflection) << "," << step.changed << "," << (step.refactored ? 1 : 0) << "\n";
+            }
+            if (!ofs)
+            {
+                error_msg = "Error writing CSV file.";
+                save_error = true;
+            }
+        }
+    }
+    ImGui::PopID();
+}
+
+void GUIHandler::shapePanel()
+{
+    static int last_result = 0;
+    static int last_applied = -1;
+    static int variable_node = 1;
+    static int variable_dof = 1;
+    static float variable_range = 1.0f;
+    static char shape_name_buf[512] = "shape.csv";
+    ShapeOptions &options = fem_system.shape_options;
+    const ShapeResults &r = fem_system.shape_results;
+    const char *len_unit = (fem_system.unit_system == Metric) ? "m" : (fem_system.unit_system == ImperialInches ? "in" : "ft");
+    const char *stress_label = (fem_system.unit_system == Metric) ? "MPa" : "psi";
+    const char *mass_unit = (fem_system.unit_system == Metric) ? "kg" : "lb";
+    const char *dofs[] = {"x", "y"};
+    int num_nodes = static_cast<int>(fem_system.nodes.size());
+    int num_vars = static_cast<int>(options.variables.size());
+
+    ImGui::PushID("shape");
+    ImGui::TextWrapped("Moves chosen node coordinates within their bounds to make the structure lighter or its largest "
+                       "stress lower, keeping every member and section. Candidate designs are analysed in parallel.");
+
+    // design variables
+    ImGui::InputInt("Node", &variable_node);
+    ImGui::Combo("Direction", &variable_dof, dofs, IM_ARRAYSIZE(dofs));
+    ImGui::InputFloat((std::string("Range +/- (") + len_unit + ")").c_str(), &variable_range, 0.0f, 0.0f, "%.4g");
+    variable_range = std::max(variable_range, 0.0f);
+    if (ImGui::Button("Add Variable") && num_nodes > 0)
+    {
+        int n = std::min(std::max(variable_node, 1), num_nodes) - 1;
+        double x = fem_system.nodes[n].position[variable_dof];
+        double half = variable_range / fem_system.lengthToDisplay(1.0);
+        auto same = [&](const ShapeVariable &v)
+        { return v.node == n && v.dof == variable_dof; };
+        options.variables.erase(std::remove_if(options.variables.begin(), options.variables.end(), same), options.variables.end());
+        ShapeVariable v;
+        v.node = n;
+        v.dof = variable_dof;
+        v.lower = x - half;
+        v.upper = x + half;
+        options.variables.push_back(v);
+    }
+    ImGui::SameLine();
+    if (ImGui::Button("Add Free Nodes"))
+    {
+        // every unsupported node, both directions
+        double half = variable_range / fem_system.lengthToDisplay(1.0);
+        for (int n = 0; n < num_nodes; ++n)
+        {
+            if (fem_system.nodes[n].constraint_type != Free)
+                continue;
+            for (int dof = 0; dof < 2; ++dof)
+            {
+                bool listed = false;
+                for (const ShapeVariable &v : options.variables)
+                    listed = listed || (v.node == n && v.dof == dof);
+                if (listed)
+                    continue;
+                ShapeVariable v;
+                v.node = n;
+                v.dof = dof;
+                v.lower = fem_system.nodes[n].position[dof] - half;
+                v.upper = fem_system.nodes[n].position[dof] + half;
+                options.variables.push_back(v);
+            }
+        }
+    }
+    ImGui::SameLine();
+    if (ImGui::Button("Clear"))
+        options.variables.clear();
+    num_vars = static_cast<int>(options.variables.size());
+
+    if (num_vars > 0 && ImGui::BeginTable("shape_variables", 4, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg | ImGuiTableFlags_ScrollY,
+                                          ImVec2(0, std::min(num_vars + 1, 8) * ImGui::GetTextLineHeightWithSpacing() + 8)))
+    {
+        ImGui::TableSetupColumn("Node");
+        ImGui::TableSetupColumn((std::string("Bounds (") + len_unit + ")").c_str());
+        ImGui::TableSetupColumn("Result");
+        ImGui::TableSetupColumn("");
+        ImGui::TableHeadersRow();
+        int remove = -1;
+        for (int j = 0; j < num_vars; ++j)
+        {
+            ShapeVariable &v = options.variables[j];
+            ImGui::PushID(j);
+            ImGui::TableNextRow();
+            ImGui::TableSetColumnIndex(0);
+            ImGui::Text("%d %s", v.node + 1, dofs[std::min(std::max(v.dof, 0), 1)]);
+            ImGui::TableSetColumnIndex(1);
+            float bounds[2] = {static_cast<float>(fem_system.lengthToDisplay(v.lower)), static_cast<float>(fem_system.lengthToDisplay(v.upper))};
+            ImGui::SetNextItemWidth(-FLT_MIN);
+            if (ImGui::InputFloat2("##bounds", bounds, "%.4g"))
+            {
+                v.lower = bounds[0] / fem_system.lengthToDisplay(1.0);
+                v.upper = std::max(static_cast<double>(bounds[1]) / fem_system.lengthToDisplay(1.0), v.lower);
+            }
+            ImGui::TableSetColumnIndex(2);
+            if (static_cast<int>(r.coordinates.size()) == num_vars)
+                ImGui::Text("%.4g", fem_system.lengthToDisplay(r.coordinates[j]));
+            ImGui::TableSetColumnIndex(3);
+            if (ImGui::SmallButton("X"))
+                remove = j;
+            ImGui::PopID();
+        }
+        ImGui::EndTable();
+        if (remove >= 0)
+        {
+            options.variables.erase(options.variables.begin() + remove);
+            num_vars = static_cast<int>(options.variables.size());
+        }
+    }
+
+    const char *objectives[] = {"Weight (stress limited)", "Max Stress"};
+    int objective = static_cast<int>(options.objective);
+    if (ImGui::Combo("Objective", &objective, objectives, IM_ARRAYSIZE(objectives)))
+        options.objective = static_cast<ShapeOptions::Objective>(objective);
+    float stress_limit = static_cast<float>(fem_system.stressToDisplay(options.stress_limit));
+    if (ImGui::InputFloat((std::string("Stress Limit (") + stress_label + ")").c_str(), &stress_limit, 0.0f, 0.0f, "%.4g"))
+        options.stress_limit = std::max(stress_limit, 1e-6f) / fem_system.stressToDisplay(1.0);
+    float move = static_cast<float>(options.move_limit);
+    if (ImGui::SliderFloat("First Step (of range)", &move, 0.01f, 1.0f, "%.2f"))
+        options.move_limit = move;
+    ImGui::SliderInt("Line Search Points", &options.line_points, 1, 32);
+    ImGui::SliderInt("Starts", &options.starts, 1, 32);
+    if (ImGui::IsItemHovered())
+        ImGui::SetTooltip("The model's coordinates plus random points within the bounds, optimized concurrently.");
+    ImGui::SliderInt("Max Iterations", &options.max_iterations, 1, 500);
+
+    if (ImGui::Button("Optimize Shape"))
+    {
+        last_result = fem_system.solve_shape();
+        last_applied = -1;
+    }
+    if (last_result < 0)
+        ImGui::TextColored(ImVec4(1.f, 0.4f, 0.4f, 1.f), "Shape optimization failed: no variables, a missing node, or a mechanism.");
+
+    if (static_cast<int>(r.coordinates.size()) != num_vars || r.history.empty())
+    {
+        ImGui::PopID();
+        return;
+    }
+
+    ImGui::Separator();
+    if (options.objective == ShapeOptions::Weight && !r.feasible)
+        ImGui::TextColored(ImVec4(1.f, 0.8f, 0.2f, 1.f), "Stress limit not met");
+    if (!r.converged)
+        ImGui::TextColored(ImVec4(1.f, 0.8f, 0.2f, 1.f), "Iteration limit reached");
+    ImGui::Text("Mass: %.4g -> %.4g %s", fem_system.massToDisplay(r.initial_weight), fem_system.massToDisplay(r.weight), mass_unit);
+    ImGui::Text("Max stress: %.4g -> %.4g %s", fem_system.stressToDisplay(r.initial_max_stress), fem_system.stressToDisplay(r.max_stress), stress_label);
+    ImGui::Text("%d iterations, %d analyses, %.3f s", static_cast<int>(r.history.size()), r.evaluations, r.wall_seconds);
+    if (r.start_weight.size() > 1)
+        ImGui::Text("Best of %d starts: start %d", static_cast<int>(r.start_weight.size()), r.best_start + 1);
+
+    std::vector<float> values(r.history.size());
+    for (size_t k = 0; k < r.history.size(); ++k)
+        values[k] = static_cast<float>(options.objective == ShapeOptions::Weight ? fem_system.massToDisplay(r.history[k].weight)
+                                                                                : fem_system.stressToDisplay(r.history[k].max_stress));
+    ImGui::PlotLines(options.objective == ShapeOptions::Weight ? "Mass per Iteration" : "Max Stress per Iteration",
+                     values.data(), static_cast<int>(values.size()), 0, nullptr, 0.0f, FLT_MAX, ImVec2(0, 80));
+
+    if (ImGui::Button("Apply to Model"))
+        last_applied = fem_system.apply_shape();
+    if (last_applied >= 0)
+    {
+        ImGui::SameLine();
+        ImGui::Text("%d coordinates moved", last_applied);
+    }
+
+    ImGui::InputText("CSV Filename", shape_name_buf, sizeof(shape_name_buf));
+    ImGui::SameLine();
+    if (ImGui::Button("Export CSV"))
+    {
+        std::string fname(shape_name_buf);
+        if (fname.size() < 4 || fname.substr(fname.size() - 4) != ".csv")
+            fname += ".csv";
+
+        std::ofstream ofs(fname);
+        if (!ofs)
+        {
+            error_msg = "Could not open CSV for writing.";
+            save_error = true;
+        }
+        else
+        {
+            ofs << "Node,Direction,Lower,Upper,Initial,Optimized\n";
+            for (int j = 0; j < num_vars; ++j)
+            {
+                const ShapeVariable &v = options.variables[j];
+                double initial = (v.node >= 0 && v.node < num_nodes) ? fem_system.nodes[v.node].position[v.dof] : 0.0;
+                ofs << (v.node + 1) << "," << dofs[std::min(std::max(v.dof, 0), 1)] << "," << fem_system.lengthToDisplay(v.lower) << ","
+                    << fem_system.lengthToDisplay(v.upper) << "," << fem_system.lengthToDisplay(initial) << ","
+                    << fem_system.lengthToDisplay(r.coordinates[j]) << "\n";
+            }
+            ofs << "\nIteration,Mass,MaxStress,Step,Analyses\n";
+            for (size_t k = 0; k < r.history.size(); ++k)
+            {
+                const ShapeIteration &step = r.history[k];
+                ofs << (k + 1) << "," << fem_system.massToDisplay(step.weight) << "," << fem_system.stressToDisplay(step.max_stress)
+                    << "," << step.step << "," << step.evaluations << "\n";
+            }
+            if (!ofs)
+            {
+                error_msg = "Error writing CSV file.";
+                save_error = true;
+            }
+        }
+    }
+    ImGui::PopID();
+}
+
+void GUIHandler::sweepPanel()
+{
+    static int last_result = 0;
+    static int kind = 0;
+    static int index = 1;
+    static int profile = 0;
+    static int component = 1;
+    static float range[2] = {0.0f, 1.0f};
+    static int points = 11;
+    static int plot_x = 0;
+    static int plot_y = 0;
+    static std::vector<int> held; // grid index of the parameters not plotted against
+    static char sweep_name_buf[512] = "sweep.csv";
+    SweepOptions &options = fem_system.sweep_options;
+    const SweepResults &r = fem_system.sweep_results;
+    const SweepTable &table = r.table;
+    int num_nodes = static_cast<int>(fem_system.nodes.size());
+    int num_profiles = static_cast<int>(fem_system.beam_profiles_list.size());
+
+    // SI <-> display for every kind of column
+    auto toDisplay = [&](SweepQuantity q, double v)
+    {
+        switch (q)
+        {
+        case SweepQuantity::Force:
+            return fem_system.forceToDisplay(v);
+        case SweepQuantity::Moment:
+            return fem_system.momentToDisplay(v);
+        case SweepQuantity::Length:
+            return fem_system.lengthToDisplay(v);
+        case SweepQuantity::Area:
+            return fem_system.areaToDisplay(v);
+        case SweepQuantity::Inertia:
+            return fem_system.inertiaToDisplay(v);
+        case SweepQuantity::SectionModulus:
+            return fem_system.sectionModulusToDisplay(v);
+        case SweepQuantity::Stress:
+            return fem_system.stressToDisplay(v);
+        case SweepQuantity::Angle:
+            break;
+        }
+        return v;
+    };
+    auto quantityOf = [](const SweepParameter &a)
+    {
+        switch (a.kind)
+        {
+        case SweepParameter::Force:
+            return a.component == 2 ? SweepQuantity::Moment : SweepQuantity::Force;
+        case SweepParameter::Coordinate:
+            return SweepQuantity::Length;
+        case SweepParameter::Area:
+            return SweepQuantity::Area;
+        case SweepParameter::Inertia:
+            return SweepQuantity::Inertia;
+        case SweepParameter::SectionModulus:
+            return SweepQuantity::SectionModulus;
+        case SweepParameter::SliderAngle:
+            break;
+        }
+        return SweepQuantity::Angle;
+    };
+    auto unitOf = [&](SweepQuantity q)
+    {
+        bool metric = fem_system.unit_system == Metric;
+        bool inches = fem_system.unit_system == ImperialInches;
+        switch (q)
+        {
+        case SweepQuantity::Force:
+            return metric ? "N" : "lbf";
+        case SweepQuantity::Moment:
+            return metric ? "N m" : (inches ? "lbf in" : "lbf ft");
+        case SweepQuantity::Length:
+            return metric ? "m" : (inches ? "in" : "ft");
+        case SweepQuantity::Area:
+            return metric ? "m^2" : (inches ? "in^2" : "ft^2");
+        case SweepQuantity::Inertia:
+            return metric ? "m^4" : (inches ? "in^4" : "ft^4");
+        case SweepQuantity::SectionModulus:
+            return metric ? "m^3" : (inches ? "in^3" : "ft^3");
+        case SweepQuantity::Stress:
+            return metric ? "MPa" : "psi";
+        case SweepQuantity::Angle:
+            break;
+        }
+        return "deg";
+    };
+
+    ImGui::PushID("sweep");
+    ImGui::TextWrapped("Runs the model over a grid of input values, every combination in parallel, and tabulates the "
+                       "largest stress, displacement and the reactions at each point.");
+
+    // parameter definition
+    const char *kinds[] = {"Force", "Node Coordinate", "Profile Area", "Profile Inertia", "Profile Section Modulus", "Slider Angle"};
+    ImGui::Combo("Parameter", &kind, kinds, IM_ARRAYSIZE(kinds));
+    SweepParameter draft;
+    draft.kind = static_cast<SweepParameter::Kind>(kind);
+    bool on_profile = draft.kind == SweepParameter::Area || draft.kind == SweepParameter::Inertia ||
+                      draft.kind == SweepParameter::SectionModulus;
+    if (on_profile)
+    {
+        std::vector<const char *> profile_items;
+        for (auto &p : fem_system.beam_profiles_list)
+            profile_items.push_back(p.name.c_str());
+        profile = std::min(std::max(profile, 0), std::max(num_profiles - 1, 0));
+        if (num_profiles > 0)
+            ImGui::Combo("Profile", &profile, profile_items.data(), num_profiles);
+        draft.index = profile;
+    }
+    else
+    {
+        ImGui::InputInt("Node", &index);
+        draft.index = std::min(std::max(index, 1), std::max(num_nodes, 1)) - 1;
+    }
+    if (draft.kind == SweepParameter::Force)
+    {
+        const char *components[] = {"Fx", "Fy", "Moment"};
+        ImGui::Combo("Component", &component, components, IM_ARRAYSIZE(components));
+    }
+    else if (draft.kind == SweepParameter::Coordinate)
+    {
+        const char *components[] = {"x", "y"};
+        component = std::min(component, 1);
+        ImGui::Combo("Component", &component, components, IM_ARRAYSIZE(components));
+    }
+    draft.component = component;
+    SweepQuantity draft_quantity = quantityOf(draft);
+    ImGui::InputFloat2((std::string("From / To (") + unitOf(draft_quantity) + ")").c_str(), range, "%.4g");
+    ImGui::SliderInt("Points", &points, 1, 101);
+    if (ImGui::Button("Add Parameter"))
+    {
+        double to_display = toDisplay(draft_quantity, 1.0);
+        draft.from = range[0] / to_display;
+        draft.to = range[1] / to_display;
+        draft.points = points;
+        options.parameters.push_back(draft);
+    }
+    ImGui::SameLine();
+    if (ImGui::Button("Clear"))
+        options.parameters.clear();
+
+    long long total = 1;
+    int remove = -1;
+    for (int p = 0; p < static_cast<int>(options.parameters.size()); ++p)
+    {
+        const SweepParameter &a = options.parameters[p];
+        SweepQuantity q = quantityOf(a);
+        std::string what = a.kind < static_cast<int>(IM_ARRAYSIZE(kinds)) ? kinds[a.kind] : "";
+        if (a.kind == SweepParameter::Area || a.kind == SweepParameter::Inertia || a.kind == SweepParameter::SectionModulus)
+            what += " of " + (a.index < num_profiles ? fem_system.beam_profiles_list[a.index].name : std::string("?"));
+        else
+            what += " at node " + std::to_string(a.index + 1);
+        if (a.kind == SweepParameter::Force)
+            what += a.component == 0 ? " (Fx)" : (a.component == 1 ? " (Fy)" : " (M)");
+        else if (a.kind == SweepParameter::Coordinate)
+            what += a.component == 0 ? " (x)" : " (y)";
+        ImGui::PushID(p);
+        ImGui::BulletText("%s: %.4g .. %.4g %s, %d points", what.c_str(), toDisplay(q, a.from), toDisplay(q, a.to), unitOf(q), a.points);
+        ImGui::SameLine();
+        if (ImGui::SmallButton("X"))
+            remove = p;
+        ImGui::PopID();
+        total *= std::max(a.points, 1);
+    }
+    if (remove >= 0)
+        options.parameters.erase(options.parameters.begin() + remove);
+    if (!options.parameters.empty())
+        ImGui::Text("%lld points", total);
+
+    if (ImGui::Button("Run Sweep"))
+    {
+        last_result = fem_system.solve_sweep();
+        held.assign(options.parameters.size(), 0);
+    }
+    if (last_result < 0)
+        ImGui::TextColored(ImVec4(1.f, 0.4f, 0.4f, 1.f), "Sweep failed: a parameter repeats or names a missing node/profile, "
+                                                        "a slider angle is set on a node without a slider, or too many points.");
+
+    // results only while they still match the parameter list
+    int num_columns = static_cast<int>(table.names.size());
+    if (table.rows == 0 || num_columns == 0 || table.parameters != static_cast<int>(options.parameters.size()) ||
+        total != table.rows)
+    {
+        ImGui::PopID();
+        return;
+    }
+
+    ImGui::Separator();
+    ImGui::Text("%d points, %d failed, %d factorizations, %.3f s", table.rows, r.failed, r.factorizations, r.wall_seconds);
+
+    // one result against one parameter, the others held at a grid point
+    std::vector<const char *> parameter_names, result_names;
+    for (int c = 0; c < num_columns; ++c)
+        (c < table.parameters ? parameter_names : result_names).push_back(table.names[c].c_str());
+    plot_x = std::min(std::max(plot_x, 0), table.parameters - 1);
+    plot_y = std::min(std::max(plot_y, 0), static_cast<int>(result_names.size()) - 1);
+    ImGui::Combo("Plot Against", &plot_x, parameter_names.data(), static_cast<int>(parameter_names.size()));
+    ImGui::Combo("Result", &plot_y, result_names.data(), static_cast<int>(result_names.size()));
+    held.resize(table.parameters, 0);
+    std::vector<int> strides(table.parameters, 1);
+    for (int p = table.parameters - 2; p >= 0; --p)
+        strides[p] = strides[p + 1] * options.parameters[p + 1].points;
+    int base = 0;
+    for (int p = 0; p < table.parameters; ++p)
+    {
+        const SweepParameter &a = options.parameters[p];
+        if (p == plot_x || a.points < 2)
+            continue;
+        held[p] = std::min(std::max(held[p], 0), a.points - 1);
+        ImGui::PushID(p);
+        std::string label = std::string("Hold ") + table.names[p];
+        double value = table.columns[p][held[p] * strides[p]];
+        ImGui::SliderInt(label.c_str(), &held[p], 0, a.points - 1, "");
+        ImGui::SameLine();
+        ImGui::Text("%.4g %s", toDisplay(table.quantity[p], value), unitOf(table.quantity[p]));
+        ImGui::PopID();
+        base += held[p] * strides[p];
+    }
+    int y_column = table.parameters + plot_y;
+    const SweepParameter &x_param = options.parameters[plot_x];
+    std::vector<float> series(x_param.points);
+    for (int k = 0; k < x_param.points; ++k)
+        series[k] = static_cast<float>(toDisplay(table.quantity[y_column], table.columns[y_column][base + k * strides[plot_x]]));
+    std::string overlay = std::string(table.names[y_column]) + " (" + unitOf(table.quantity[y_column]) + ")";
+    ImGui::PlotLines("##sweep_plot", series.data(), static_cast<int>(series.size()), 0, overlay.c_str(), FLT_MAX, FLT_MAX, ImVec2(-1, 120));
+    ImGui::Text("%s from %.4g to %.4g %s", table.names[plot_x].c_str(), toDisplay(table.quantity[plot_x], x_param.from),
+                toDisplay(table.quantity[plot_x], x_param.to), unitOf(table.quantity[plot_x]));
+
+    // the table itself (first rows only; the CSV has them all)
+    const int shown_rows = std::min(table.rows, 200);
+    if (ImGui::BeginTable("sweep_table", num_columns, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg | ImGuiTableFlags_ScrollX | ImGuiTableFlags_ScrollY,
+                          ImVec2(0, 200)))
+    {
+        ImGui::TableSetupScrollFreeze(0, 1);
+        for (int c = 0; c < num_columns; ++c)
+            ImGui::TableSetupColumn((table.names[c] + " (" + unitOf(table.quantity[c]) + ")").c_str());
+        ImGui::TableHeadersRow();
+        for (int row = 0; row < shown_rows; ++row)
+        {
+            ImGui::TableNextRow();
+            for (int c = 0; c < num_columns; ++c)
+            {
+                ImGui::TableSetColumnIndex(c);
+                ImGui::Text("%.4g", toDisplay(table.quantity[c], table.columns[c][row]));
+            }
+        }
+        ImGui::EndTable();
+    }
+    if (shown_rows < table.rows)
+        ImGui::TextDisabled("Showing %d of %d rows", shown_rows, table.rows);
+
+    ImGui::InputText("CSV Filename", sweep_name_buf, sizeof(sweep_name_buf));
+    ImGui::SameLine();
+    if (ImGui::Button("Export CSV"))
+    {
+        std::string fname(sweep_name_buf);
+        if (fname.size() < 4 || fname.substr(fname.size() - 4) != ".csv")
+            fname += ".csv";
+
+        std::ofstream ofs(fname);
+        if (!ofs)
+        {
+            error_msg = "Could not open CSV for writing.";
+            save_error = true;
+        }
+        else
+        {
+            for (int c = 0; c < num_columns; ++c)
+                ofs << (c ? "," : "") << table.names[c] << " (" << unitOf(table.quantity[c]) << ")";
+            ofs << "\n";
+            for (int row = 0; row < table.rows; ++row)
+            {
+                for (int c = 0; c < num_columns; ++c)
+                    ofs << (c ? "," : "") << toDisplay(table.quantity[c], table.columns[c][row]);
+                ofs << "\n";
+            }
+            if (!ofs)
+            {
+                error_msg = "Error writing CSV file.";
+                save_error = true;
+            }
+        }
+    }
+    ImGui::PopID();
+}
+
+void GUIHandler::reliabilityPanel()
+{
+    static int last_result = 0;
+    static int kind = 2;
+    static int material = 0;
+    static int profile = 0;
+    static int index = 1;
+    static int component = 1;
+    static int distribution = 0;
+    static float moments[2] = {0.0f, 0.0f};
+    static int shown = 0; // 0: largest stress of each sample, else beam shown - 1
+    static char reliability_name_buf[512] = "reliability.csv";
+    ReliabilityOptions &options = fem_system.reliability_options;
+    const ReliabilityResults &r = fem_system.reliability_results;
+    const char *stress_label = (fem_system.unit_system == Metric) ? "MPa" : "psi";
+    int num_nodes = static_cast<int>(fem_system.nodes.size());
+    int num_materials = static_cast<int>(fem_system.materials_list.size());
+    int num_profiles = static_cast<int>(fem_system.beam_profiles_list.size());
+    int num_beams = static_cast<int>(fem_system.beams.size());
+
+    // SI <-> display and the unit of each kind of variable
+    auto toDisplay = [&](const RandomVariable &v, double x)
+    {
+        switch (v.kind)
+        {
+        case RandomVariable::Modulus:
+            return fem_system.modulusToDisplay(x);
+        case RandomVariable::Area:
+            return fem_system.areaToDisplay(x);
+        case RandomVariable::Force:
+            break;
+        }
+        return v.component == 2 ? fem_system.momentToDisplay(x) : fem_system.forceToDisplay(x);
+    };
+    auto unitOf = [&](const RandomVariable &v)
+    {
+        bool metric = fem_system.unit_system == Metric;
+        bool inches = fem_system.unit_system == ImperialInches;
+        switch (v.kind)
+        {
+        case RandomVariable::Modulus:
+            return metric ? "Pa" : "psi";
+        case RandomVariable::Area:
+            return metric ? "m^2" : (inches ? "in^2" : "ft^2");
+        case RandomVariable::Force:
+            break;
+        }
+        if (v.component == 2)
+            return metric ? "N m" : (inches ? "lbf in" : "lbf ft");
+        return metric ? "N" : "lbf";
+    };
+
+    ImGui::PushID("reliability");
+    ImGui::TextWrapped("Samples uncertain moduli, areas and loads and estimates the probability that some member's stress "
+                       "exceeds the limit, with the stress distribution of every member. Samples run in parallel and are "
+                       "the same for a given seed however many threads there are.");
+
+    // variable definition
+    const char *kinds[] = {"Young's Modulus", "Profile Area", "Force"};
+    const char *distributions[] = {"Normal", "Lognormal", "Uniform"};
+    ImGui::Combo("Variable", &kind, kinds, IM_ARRAYSIZE(kinds));
+    RandomVariable draft;
+    draft.kind = static_cast<RandomVariable::Kind>(kind);
+    if (draft.kind == RandomVariable::Modulus)
+    {
+        std::vector<const char *> items;
+        for (auto &m : fem_system.materials_list)
+            items.push_back(m.name.c_str());
+        material = std::min(std::max(material, 0), std::max(num_materials - 1, 0));
+        if (num_materials > 0)
+            ImGui::Combo("Material", &material, items.data(), num_materials);
+        draft.index = material;
+    }
+    else if (draft.kind == RandomVariable::Area)
+    {
+        std::vector<const char *> items;
+        for (auto &p : fem_system.beam_profiles_list)
+            items.push_back(p.name.c_str());
+        profile = std::min(std::max(profile, 0), std::max(num_profiles - 1, 0));
+        if (num_profiles > 0)
+            ImGui::Combo("Profile", &profile, items.data(), num_profiles);
+        draft.index = profile;
+    }
+    else
+    {
+        const char *components[] = {"Fx", "Fy", "Moment"};
+        ImGui::InputInt("Node", &index);
+        ImGui::Combo("Component", &component, components, IM_ARRAYSIZE(components));
+        draft.index = std::min(std::max(index, 1), std::max(num_nodes, 1)) - 1;
+        draft.component = component;
+    }
+    ImGui::Combo("Distribution", &distribution, distributions, IM_ARRAYSIZE(distributions));
+    draft.distribution = static_cast<RandomVariable::Distribution>(distribution);
+    ImGui::InputFloat2((std::string("Mean / Std. Deviation (") + unitOf(draft) + ")").c_str(), moments, "%.4g");
+    if (ImGui::Button("Use Model Value"))
+    {
+        // the model's current value, with a 10% coefficient of variation
+        double value = 0.0;
+        if (draft.kind == RandomVariable::Modulus && draft.index < num_materials)
+            value = fem_system.materials_list[draft.index].youngs_modulus;
+        else if (draft.kind == RandomVariable::Area && draft.index < num_profiles)
+            value = fem_system.beam_profiles_list[draft.index].area;
+        else if (draft.kind == RandomVariable::Force && draft.index * 3 + draft.component < fem_system.forces.size())
+            value = fem_system.forces(draft.index * 3 + draft.component);
+        moments[0] = static_cast<float>(toDisplay(draft, value));
+        moments[1] = std::abs(moments[0]) * 0.1f;
+    }
+    ImGui::SameLine();
+    if (ImGui::Button("Add Variable"))
+    {
+        double to_display = toDisplay(draft, 1.0);
+        draft.mean = moments[0] / to_display;
+        draft.deviation = std::abs(moments[1] / to_display);
+        options.variables.push_back(draft);
+    }
+    ImGui::SameLine();
+    if (ImGui::Button("Clear"))
+        options.variables.clear();
+
+    int remove = -1;
+    for (int v = 0; v < static_cast<int>(options.variables.size()); ++v)
+    {
+        const RandomVariable &a = options.variables[v];
+        std::string what = a.kind < static_cast<int>(IM_ARRAYSIZE(kinds)) ? kinds[a.kind] : "";
+        if (a.kind == RandomVariable::Modulus)
+            what += " of " + (a.index < num_materials ? fem_system.materials_list[a.index].name : std::string("?"));
+        else if (a.kind == RandomVariable::Area)
+            what += " of " + (a.index < num_profiles ? fem_system.beam_profiles_list[a.index].name : std::string("?"));
+        else
+            what += std::string(a.component == 0 ? " Fx" : (a.component == 1 ? " Fy" : " M")) + " at node " + std::to_string(a.index + 1);
+        ImGui::PushID(v);
+        ImGui::BulletText("%s: %s, mean %.4g, std. dev. %.4g %s", what.c_str(),
+                          a.distribution < static_cast<int>(IM_ARRAYSIZE(distributions)) ? distributions[a.distribution] : "",
+                          toDisplay(a, a.mean), toDisplay(a, a.deviation), unitOf(a));
+        ImGui::SameLine();
+        if (ImGui::SmallButton("X"))
+            remove = v;
+        ImGui::PopID();
+    }
+    if (remove >= 0)
+        options.variables.erase(options.variables.begin() + remove);
+
+    float stress_limit = static_cast<float>(fem_system.stressToDisplay(options.stress_limit));
+    if (ImGui::InputFloat((std::string("Stress Limit (") + stress_label + ")").c_str(), &stress_limit, 0.0f, 0.0f, "%.4g"))
+        options.stress_limit = std::max(stress_limit, 1e-6f) / fem_system.stressToDisplay(1.0);
+    ImGui::InputInt("Samples", &options.samples, 1000, 10000);
+    options.samples = std::min(std::max(options.samples, 1), 10000000);
+    int seed = static_cast<int>(options.seed);
+    if (ImGui::InputInt("Seed", &seed))
+        options.seed = static_cast<std::uint64_t>(std::max(seed, 0));
+    ImGui::SliderInt("Load Batch", &options.batch, 1, 256);
+    if (ImGui::IsItemHovered())
+        ImGui::SetTooltip("Samples that only vary loads are solved this many at a time against one factorization.");
+
+    if (ImGui::Button("Run Monte Carlo"))
+        last_result = fem_system.solve_reliability();
+    if (last_result < 0)
+        ImGui::TextColored(ImVec4(1.f, 0.4f, 0.4f, 1.f), "Monte Carlo failed: a variable repeats or names a missing material, "
+                                                        "profile or node, a lognormal mean is not positive, or the model is singular.");
+
+    if (r.samples == 0 || static_cast<int>(r.members.size()) != num_beams)
+    {
+        ImGui::PopID();
+        return;
+    }
+
+    ImGui::Separator();
+    ImGui::Text("Failure probability: %.4g (+- %.2g, %d of %d samples)", r.failure_probability, r.standard_error, r.failures, r.samples);
+    if (r.unsolvable > 0)
+        ImGui::TextColored(ImVec4(1.f, 0.8f, 0.2f, 1.f), "%d samples could not be solved (counted as failures)", r.unsolvable);
+    ImGui::Text("%d factorizations, %.3f s", r.factorizations, r.wall_seconds);
+
+    // one stress distribution at a time
+    shown = std::min(std::max(shown, 0), num_beams);
+    std::string shown_label = shown == 0 ? std::string("Largest stress") : "Beam " + std::to_string(shown);
+    if (ImGui::BeginCombo("Distribution of", shown_label.c_str()))
+    {
+        if (ImGui::Selectable("Largest stress", shown == 0))
+            shown = 0;
+        for (int i = 0; i < num_beams; ++i)
+        {
+            std::string label = "Beam " + std::to_string(i + 1);
+            if (ImGui::Selectable(label.c_str(), shown == i + 1))
+                shown = i + 1;
+        }
+        ImGui::EndCombo();
+    }
+    const StressStatistics &s = shown == 0 ? r.peak : r.members[shown - 1];
+    std::vector<float> bars(s.histogram.begin(), s.histogram.end());
+    ImGui::PlotHistogram("##reliability_histogram", bars.data(), static_cast<int>(bars.size()), 0, nullptr, 0.0f, FLT_MAX, ImVec2(-1, 80));
+    ImGui::Text("0 to %.4g %s; mean %.4g, std. dev. %.4g, max %.4g %s, P(> limit) %.4g", fem_system.stressToDisplay(r.histogram_max),
+                stress_label, fem_system.stressToDisplay(s.mean), fem_system.stressToDisplay(s.deviation),
+                fem_system.stressToDisplay(s.max), stress_label, s.exceedance);
+
+    // members most likely to exceed the limit
+    std::vector<int> order(num_beams);
+    for (int i = 0; i < num_beams; ++i)
+        order[i] = i;
+    std::sort(order.begin(), order.end(), [&](int a, int b)
+              { return r.members[a].exceedance != r.members[b].exceedance ? r.members[a].exceedance > r.members[b].exceedance
+                                                                          : r.members[a].mean > r.members[b].mean; });
+    const int shown_rows = std::min(num_beams, 50);
+    if (ImGui::BeginTable("reliability_table", 5, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg | ImGuiTableFlags_ScrollY, ImVec2(0, 200)))
+    {
+        ImGui::TableSetupScrollFreeze(0, 1);
+        ImGui::TableSetupColumn("Beam");
+        ImGui::TableSetupColumn((std::string("Mean (") + stress_label + ")").c_str());
+        ImGui::TableSetupColumn((std::string("Std. Dev. (") + stress_label + ")").c_str());
+        ImGui::TableSetupColumn((std::string("Max (") + stress_label + ")").c_str());
+        ImGui::TableSetupColumn("P(> limit)");
+        ImGui::TableHeadersRow();
+        for (int k = 0; k < shown_rows; ++k)
+        {
+            const StressStatistics &m = r.members[order[k]];
+            ImGui::TableNextRow();
+            ImGui::TableSetColumnIndex(0);
+            ImGui::Text("%d", order[k] + 1);
+            ImGui::TableSetColumnIndex(1);
+            ImGui::Text("%.4g", fem_system.stressToDisplay(m.mean));
+            ImGui::TableSetColumnIndex(2);
+            ImGui::Text("%.4g", fem_system.stressToDisplay(m.deviation));
+            ImGui::TableSetColumnIndex(3);
+            ImGui::Text("%.4g", fem_system.stressToDisplay(m.max));
+            ImGui::TableSetColumnIndex(4);
+            ImGui::Text("%.4g", m.exceedance);
+        }
+        ImGui::EndTable();
+    }
+    if (shown_rows < num_beams)
+        ImGui::TextDisabled("Showing the %d members most likely to exceed the limit of %d", shown_rows, num_beams);
+
+    ImGui::InputText("CSV Filename", reliability_name_buf, sizeof(reliability_name_buf));
+    ImGui::SameLine();
+    if (ImGui::Button("Export CSV"))
+    {
+        std::string fname(reliability_name_buf);
+        if (fname.size() < 4 || fname.substr(fname.size() - 4) != ".csv")
+            fname += ".csv";
+
+        std::ofstream ofs(fname);
+        if (!ofs)
+        {
+            error_msg = "Could not open CSV for writing.";
+            save_error = true;
+        }
+        else
+        {
+            ofs << "Samples,Failures,FailureProbability,StandardError\n";
+            ofs << r.samples << "," << r.failures << "," << r.failure_probability << "," << r.standard_error << "\n";
+            ofs << "\nBeam,Mean,StdDev,Min,Max,ExceedanceProbability\n";
+            for (int i = 0; i <= num_beams; ++i)
+            {
+                const StressStatistics &m = i < num_beams ? r.members[i] : r.peak;
+                ofs << (i < num_beams ? std::to_string(i + 1) : std::string("Largest")) << "," << fem_system.stressToDisplay(m.mean) << ","
+                    << fem_system.stressToDisplay(m.deviation) << "," << fem_system.stressToDisplay(m.min) << ","
+                    << fem_system.stressToDisplay(m.max) << "," << m.exceedance << "\n";
+            }
+            int bins = static_cast<int>(r.peak.histogram.size());
+            ofs << "\nBinUpper";
+            for (int i = 0; i <= num_beams; ++i)
+                ofs << "," << (i < num_beams ? "Beam " + std::to_string(i + 1) : std::string("Largest"));
+            ofs << "\n";
+            for (int b = 0; b < bins; ++b)
+            {
+                ofs << fem_system.stressToDisplay(r.histogram_max * (b + 1) / bins);
+                for (int i = 0; i <= num_beams; ++i)
+                    ofs << "," << (i < num_beams ? r.members[i] : r.peak).histogram[b];
+                ofs << "\n";
+            }
+            if (!ofs)
+            {
+                error_msg = "Error writing CSV file.";
+                save_error = true;
+            }
+        }
+    }
+    ImGui::PopID();
+}
+
+void GUIHandler::redundancyPanel()
+{
+    static int last_result = 0;
+    static char redundancy_name_buf[512] = "redundancy.csv";
+    RedundancyOptions &options = fem_system.redundancy_options;
+    const RedundancyResults &r = fem_system.redundancy_results;
+    const char *len_unit = (fem_system.unit_system == Metric) ? "m" : (fem_system.unit_system == ImperialInches ? "in" : "ft");
+    const char *stress_label = (fem_system.unit_system == Metric) ? "MPa" : "psi";
+    const char *outcomes[] = {"Redundant", "Overstress", "Mechanism"};
+
+    ImGui::PushID("redundancy");
+    ImGui::TextWrapped("Removes each member in turn and checks whether the rest still carries the loads, without "
+                       "refactoring the stiffness. Removals are ranked by severity: mechanisms first, then by the "
+                       "largest remaining stress.");
+
+    float stress_limit = static_cast<float>(fem_system.stressToDisplay(options.stress_limit));
+    if (ImGui::InputFloat((std::string("Stress Limit (") + stress_label + ")").c_str(), &stress_limit, 0.0f, 0.0f, "%.4g"))
+        options.stress_limit = std::max(stress_limit, 1e-6f) / fem_system.stressToDisplay(1.0);
+
+    if (ImGui::Button("Scan Member Removals"))
+        last_result = fem_system.solve_redundancy();
+    if (last_result < 0)
+        ImGui::TextColored(ImVec4(1.f, 0.4f, 0.4f, 1.f), "Scan failed: the intact structure is already a mechanism.");
+
+    if (r.removals.empty())
+    {
+        ImGui::PopID();
+        return;
+    }
+
+    ImGui::Separator();
+    int num_removals = static_cast<int>(r.removals.size());
+    ImGui::Text("%d removals: %d mechanisms, %d overstress, %d redundant", num_removals, r.mechanisms, r.overstressing,
+                num_removals - r.mechanisms - r.overstressing);
+    ImGui::Text("Intact max stress %.4g %s; %d solves, %.3f s", fem_system.stressToDisplay(r.intact_max_stress), stress_label,
+                r.solves, r.wall_seconds);
+
+    // ranked removals (first rows only; the CSV has them all)
+    const int shown_rows = std::min(num_removals, 200);
+    if (ImGui::BeginTable("redundancy_table", 7, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg | ImGuiTableFlags_ScrollY, ImVec2(0, 240)))
+    {
+        ImGui::TableSetupScrollFreeze(0, 1);
+        ImGui::TableSetupColumn("Rank");
+        ImGui::TableSetupColumn("Removed Beam");
+        ImGui::TableSetupColumn("Outcome");
+        ImGui::TableSetupColumn((std::string("Max Stress (") + stress_label + ")").c_str());
+        ImGui::TableSetupColumn("At Beam");
+        ImGui::TableSetupColumn("Overstressed");
+        ImGui::TableSetupColumn((std::string("Max Disp. (") + len_unit + ")").c_str());
+        ImGui::TableHeadersRow();
+        for (int k = 0; k < shown_rows; ++k)
+        {
+            const MemberRemoval &m = r.removals[k];
+            bool mechanism = m.outcome == MemberRemoval::Mechanism;
+            ImGui::TableNextRow();
+            ImGui::TableSetColumnIndex(0);
+            ImGui::Text("%d", k + 1);
+            ImGui::TableSetColumnIndex(1);
+            ImGui::Text("%d", m.member + 1);
+            ImGui::TableSetColumnIndex(2);
+            if (m.outcome == MemberRemoval::Redundant)
+                ImGui::Text("%s", outcomes[m.outcome]);
+            else
+                ImGui::TextColored(mechanism ? ImVec4(1.f, 0.4f, 0.4f, 1.f) : ImVec4(1.f, 0.8f, 0.2f, 1.f), "%s", outcomes[m.outcome]);
+            if (mechanism)
+                continue;
+            ImGui::TableSetColumnIndex(3);
+            ImGui::Text("%.4g (x%.2f)", fem_system.stressToDisplay(m.max_stress), m.stress_ratio);
+            ImGui::TableSetColumnIndex(4);
+            ImGui::Text("%d", m.critical_member + 1);
+            ImGui::TableSetColumnIndex(5);
+            ImGui::Text("%d", m.overstressed);
+            ImGui::TableSetColumnIndex(6);
+            ImGui::Text("%.4g", fem_system.lengthToDisplay(m.max_displacement));
+        }
+        ImGui::EndTable();
+    }
+    if (shown_rows < num_removals)
+        ImGui::TextDisabled("Showing %d of %d removals", shown_rows, num_removals);
+
+    ImGui::InputText("CSV Filename", redundancy_name_buf, sizeof(redundancy_name_buf));
+    ImGui::SameLine();
+    if (ImGui::Button("Export CSV"))
+    {
+        std::string fname(redundancy_name_buf);
+        if (fname.size() < 4 || fname.substr(fname.size() - 4) != ".csv")
+            fname += ".csv";
+
+        std::ofstream ofs(fname);
+        if (!ofs)
+        {
+            error_msg = "Could not open CSV for writing.";
+            save_error = true;
+        }
+        else
+        {
+            ofs << "Rank,RemovedBeam,Outcome,MaxStress,StressRatio,CriticalBeam,Overstressed,MaxDisplacement\n";
+            for (int k = 0; k < num_removals; ++k)
+            {
+                const MemberRemoval &m = r.removals[k];
+                ofs << (k + 1) << "," << (m.member + 1) << "," << outcomes[m.outcome];
+                if (m.outcome == MemberRemoval::Mechanism)
+                    ofs << ",,,,,\n";
+                else
+                    ofs << "," << fem_system.stressToDisplay(m.max_stress) << "," << m.stress_ratio << "," << (m.critical_member + 1)
+                        << "," << m.overstressed << "," << fem_system.lengthToDisplay(m.max_displacement) << "\n";
+            }
+            if (!ofs)
+            {
+                error_msg = "Error writing CSV file.";
+                save_error = true;
+            }
+        }
+    }
+    ImGui::PopID();
+}
+
+void GUIHandler::reducedModelPanel()
+{
+    static int last_result = 0;
+    static int kind = 2;
+    static int material = 0;
+    static int profile = 0;
+    static int index = 1;
+    static int component = 1;
+    static float range[2] = {0.0f, 1.0f};
+    static bool enrich = true;
+    static std::vector<float> values; // query point, display units
+    static RomQuery query;
+    static int query_result = -1;
+    RomOptions &options = fem_system.rom_options;
+    ReducedModel &model = fem_system.reduced_model;
+    const char *len_unit = (fem_system.unit_system == Metric) ? "m" : (fem_system.unit_system == ImperialInches ? "in" : "ft");
+    const char *stress_label = (fem_system.unit_system == Metric) ? "MPa" : "psi";
+    int num_nodes = static_cast<int>(fem_system.nodes.size());
+    int num_materials = static_cast<int>(fem_system.materials_list.size());
+    int num_profiles = static_cast<int>(fem_system.beam_profiles_list.size());
+
+    // SI <-> display and the unit of each kind of parameter
+    auto toDisplay = [&](const RomParameter &a, double x)
+    {
+        switch (a.kind)
+        {
+        case RomParameter::Modulus:
+            return fem_system.modulusToDisplay(x);
+        case RomParameter::Area:
+            return fem_system.areaToDisplay(x);
+        case RomParameter::Inertia:
+            return fem_system.inertiaToDisplay(x);
+        case RomParameter::Force:
+            break;
+        }
+        return a.component == 2 ? fem_system.momentToDisplay(x) : fem_system.forceToDisplay(x);
+    };
+    auto unitOf = [&](const RomParameter &a)
+    {
+        bool metric = fem_system.unit_system == Metric;
+        bool inches = fem_system.unit_system == ImperialInches;
+        switch (a.kind)
+        {
+        case RomParameter::Modulus:
+            return metric ? "Pa" : "psi";
+        case RomParameter::Area:
+            return metric ? "m^2" : (inches ? "in^2" : "ft^2");
+        case RomParameter::Inertia:
+            return metric ? "m^4" : (inches ? "in^4" : "ft^4");
+        case RomParameter::Force:
+            break;
+        }
+        if (a.component == 2)
+            return metric ? "N m" : (inches ? "lbf in" : "lbf ft");
+        return metric ? "N" : "lbf";
+    };
+    const char *kinds[] = {"Force", "Young's Modulus", "Profile Area", "Profile Inertia"};
+    auto describe = [&](const RomParameter &a)
+    {
+        std::string what = a.kind < static_cast<int>(IM_ARRAYSIZE(kinds)) ? kinds[a.kind] : "";
+        if (a.kind == RomParameter::Modulus)
+            what += " of " + (a.index < num_materials ? fem_system.materials_list[a.index].name : std::string("?"));
+        else if (a.kind == RomParameter::Area || a.kind == RomParameter::Inertia)
+            what += " of " + (a.index < num_profiles ? fem_system.beam_profiles_list[a.index].name : std::string("?"));
+        else
+            what += std::string(a.component == 0 ? " Fx" : (a.component == 1 ? " Fy" : " M")) + " at node " + std::to_string(a.index + 1);
+        return what;
+    };
+
+    ImGui::PushID("reduced_model");
+    ImGui::TextWrapped("Trains a small reduced-basis model from full solves over ranges of loads, moduli and section "
+                       "properties, then answers queries in microseconds. Queries whose error estimate is too large "
+                       "can add a full solve to the basis.");
+
+    // parameter definition
+    ImGui::Combo("Parameter", &kind, kinds, IM_ARRAYSIZE(kinds));
+    RomParameter draft;
+    draft.kind = static_cast<RomParameter::Kind>(kind);
+    if (draft.kind == RomParameter::Modulus)
+    {
+        std::vector<const char *> items;
+        for (auto &m : fem_system.materials_list)
+            items.push_back(m.name.c_str());
+        material = std::min(std::max(material, 0), std::max(num_materials - 1, 0));
+        if (num_materials > 0)
+            ImGui::Combo("Material", &material, items.data(), num_materials);
+        draft.index = material;
+    }
+    else if (draft.kind == RomParameter::Area || draft.kind == RomParameter::Inertia)
+    {
+        std::vector<const char *> items;
+        for (auto &p : fem_system.beam_profiles_list)
+            items.push_back(p.name.c_str());
+        profile = std::min(std::max(profile, 0), std::max(num_profiles - 1, 0));
+        if (num_profiles > 0)
+            ImGui::Combo("Profile", &profile, items.data(), num_profiles);
+        draft.index = profile;
+    }
+    else
+    {
+        const char *components[] = {"Fx", "Fy", "Moment"};
+        ImGui::InputInt("Node", &index);
+        ImGui::Combo("Component", &component, components, IM_ARRAYSIZE(components));
+        draft.index = std::min(std::max(index, 1), std::max(num_nodes, 1)) - 1;
+        draft.component = component;
+    }
+    ImGui::InputFloat2((std::string("Lower / Upper (") + unitOf(draft) + ")").c_str(), range, "%.4g");
+    if (ImGui::Button("Add Parameter"))
+    {
+        double to_display = toDisplay(draft, 1.0);
+        draft.lower = std::min(range[0], range[1]) / to_display;
+        draft.upper = std::max(range[0], range[1]) / to_display;
+        options.parameters.push_back(draft);
+    }
+    ImGui::SameLine();
+    if (ImGui::Button("Clear"))
+        options.parameters.clear();
+
+    int remove = -1;
+    for (int j = 0; j < static_cast<int>(options.parameters.size()); ++j)
+    {
+        const RomParameter &a = options.parameters[j];
+        ImGui::PushID(j);
+        ImGui::BulletText("%s: %.4g .. %.4g %s", describe(a).c_str(), toDisplay(a, a.lower), toDisplay(a, a.upper), unitOf(a));
+        ImGui::SameLine();
+        if (ImGui::SmallButton("X"))
+            remove = j;
+        ImGui::PopID();
+    }
+    if (remove >= 0)
+        options.parameters.erase(options.parameters.begin() + remove);
+
+    float tolerance = static_cast<float>(options.tolerance);
+    if (ImGui::InputFloat("Tolerance", &tolerance, 0.0f, 0.0f, "%.1e"))
+        options.tolerance = std::max(tolerance, 1e-9f);
+    if (ImGui::IsItemHovered())
+        ImGui::SetTooltip("Estimated relative residual |F - K u| / |F| the training drives every training point below.");
+    ImGui::SliderInt("Max Basis", &options.max_basis, 1, 200);
+    ImGui::SliderInt("Training Points", &options.training_points, 16, 4096);
+
+    if (ImGui::Button("Build Reduced Model"))
+    {
+        last_result = fem_system.build_reduced_model();
+        values.clear();
+        query_result = -1;
+    }
+    if (last_result < 0)
+        ImGui::TextColored(ImVec4(1.f, 0.4f, 0.4f, 1.f), "Build failed: a parameter repeats or names a missing material, profile "
+                                                        "or node, or a training point makes the structure singular.");
+
+    const std::vector<RomParameter> &params = model.get_parameters();
+    if (model.size() == 0)
+    {
+        ImGui::PopID();
+        return;
+    }
+
+    ImGui::Separator();
+    ImGui::Text("%d basis vectors for %d equations, %d full solves, %.3f s", model.size(), model.dofs(), model.snapshots,
+                model.build_seconds + model.train_seconds);
+    if (!model.training_error.empty())
+    {
+        std::vector<float> history(model.training_error.size());
+        for (size_t k = 0; k < history.size(); ++k)
+            history[k] = static_cast<float>(std::log10(std::max(model.training_error[k], 1e-16)));
+        ImGui::PlotLines("##rom_training", history.data(), static_cast<int>(history.size()), 0,
+                         "log10 largest training estimate", FLT_MAX, FLT_MAX, ImVec2(-1, 60));
+    }
+
+    // query point, starting from the model's own values
+    int num_params = static_cast<int>(params.size());
+    bool changed = false;
+    if (static_cast<int>(values.size()) != num_params)
+    {
+        values.resize(num_params);
+        for (int j = 0; j < num_params; ++j)
+            values[j] = static_cast<float>(toDisplay(params[j], model.nominal()[j]));
+        changed = true;
+    }
+    for (int j = 0; j < num_params; ++j)
+    {
+        const RomParameter &a = params[j];
+        ImGui::PushID(j);
+        float lo = static_cast<float>(toDisplay(a, a.lower));
+        float hi = static_cast<float>(toDisplay(a, a.upper));
+        std::string label = describe(a) + " (" + unitOf(a) + ")";
+        if (lo < hi)
+            changed |= ImGui::SliderFloat(label.c_str(), &values[j], lo, hi, "%.4g");
+        else
+            changed |= ImGui::InputFloat(label.c_str(), &values[j], 0.0f, 0.0f, "%.4g");
+        ImGui::PopID();
+    }
+    ImGui::Checkbox("Enrich When Above Tolerance", &enrich);
+
+    std::vector<double> mu(num_params);
+    for (int j = 0; j < num_params; ++j)
+        mu[j] = values[j] / toDisplay(params[j], 1.0);
+    if (changed)
+        query_result = enrich ? model.solve(mu, options.tolerance, options.max_basis, query) : model.query(mu, query);
+    if (query_result < 0)
+    {
+        ImGui::TextColored(ImVec4(1.f, 0.4f, 0.4f, 1.f), "Query failed: a modulus or area is not positive, or the structure is singular.");
+        ImGui::PopID();
+        return;
+    }
+
+    Eigen::VectorXd u;
+    model.displacements(query, u);
+    double max_displacement = 0.0;
+    for (int n = 0; n < static_cast<int>(u.size()) / 3; ++n)
+        max_displacement = std::max(max_displacement, std::hypot(u(n * 3), u(n * 3 + 1)));
+    if (query.estimate > options.tolerance)
+        ImGui::TextColored(ImVec4(1.f, 0.8f, 0.2f, 1.f), "Estimate %.2e above tolerance", query.estimate);
+    else
+        ImGui::Text("Estimate %.2e", query.estimate);
+    ImGui::SameLine();
+    ImGui::Text("(%.1f us%s)", query.seconds * 1e6, query.enriched ? ", basis enriched" : "");
+    ImGui::Text("Max displacement: %.4g %s", fem_system.lengthToDisplay(max_displacement), len_unit);
+    ImGui::Text("Max stress: %.4g %s", fem_system.stressToDisplay(model.max_stress(mu, u)), stress_label);
+    ImGui::PopID();
+}
+
+void GUIHandler::superelementPanel()
+{
+    static int last_result = 0;
+    static int first_member = 1;
+    static int last_member = 1;
+    static float offset[2] = {0.0f, 1.0f};
+    static int copies = 1;
+    static int placed = -1;
+    static std::vector<InstanceRecovery> recovered;
+    static std::vector<char> is_recovered;
+    static Eigen::VectorXd x; // reduced solution the recoveries fill in
+    SuperelementOptions &options = fem_system.superelement_options;
+    const SuperelementModel &model = fem_system.superelements;
+    const char *len_unit = (fem_system.unit_system == Metric) ? "m" : (fem_system.unit_system == ImperialInches ? "in" : "ft");
+    const char *stress_label = (fem_system.unit_system == Metric) ? "MPa" : "psi";
+    int num_beams = static_cast<int>(fem_system.beams.size());
+
+    ImGui::PushID("superelements");
+    ImGui::TextWrapped("Condenses the interior of repeated substructures onto their boundary nodes. Instances that "
+                       "match up to a translation share one cached condensation, only the boundary enters the "
+                       "global solve, and each instance's interior is recovered on demand.");
+
+    // a substructure is a range of members; copies of it are placed and become instances
+    ImGui::InputInt("First Member", &first_member);
+    ImGui::InputInt("Last Member", &last_member);
+    first_member = std::min(std::max(first_member, 1), std::max(num_beams, 1));
+    last_member = std::min(std::max(last_member, first_member), std::max(num_beams, 1));
+    std::vector<int> members;
+    for (int i = first_member; i <= last_member && i <= num_beams; ++i)
+        members.push_back(i - 1);
+    ImGui::InputFloat2((std::string("Copy Offset (") + len_unit + ")").c_str(), offset, "%.4g");
+    ImGui::InputInt("Copies", &copies);
+    copies = std::max(copies, 1);
+    if (ImGui::Button("Place Copies"))
+        placed = fem_system.place_substructure(members, fem_system.lengthFromDisplay(offset[0]),
+                                               fem_system.lengthFromDisplay(offset[1]), copies);
+    if (ImGui::IsItemHovered())
+        ImGui::SetTooltip("Copies of the members (and their nodes), each shifted by the offset from the one "
+                          "before; nodes already at a copy's position are shared.");
+    ImGui::SameLine();
+    if (ImGui::Button("Add as Instance") && !members.empty())
+        options.instances.push_back(members);
+    ImGui::SameLine();
+    if (ImGui::Button("Clear Instances"))
+        options.instances.clear();
+    if (placed >= 0)
+        ImGui::Text("Placed %d members", placed);
+    ImGui::Text("%d instances defined", static_cast<int>(options.instances.size()));
+
+    float tolerance = static_cast<float>(fem_system.lengthToDisplay(options.tolerance));
+    if (ImGui::InputFloat((std::string("Match Tolerance (") + len_unit + ")").c_str(), &tolerance, 0.0f, 0.0f, "%.2e"))
+        options.tolerance = std::max(fem_system.lengthFromDisplay(tolerance), 0.0);
+    if (ImGui::IsItemHovered())
+        ImGui::SetTooltip("How far node offsets of two instances may differ for them to share a condensation; "
+                          "also the distance within which placed nodes merge.");
+
+    if (ImGui::Button("Condense & Solve"))
+    {
+        last_result = fem_system.solve_superelements();
+        x = model.boundary_solution();
+        recovered.assign(model.instance_count(), InstanceRecovery());
+        is_recovered.assign(model.instance_count(), 0);
+    }
+    if (last_result < 0)
+        ImGui::TextColored(ImVec4(1.f, 0.4f, 0.4f, 1.f), "Solve failed: an instance is empty, shares a member with another, "
+                                                        "has an unrestrained interior, or the structure is a mechanism.");
+    if (last_result < 0 || model.boundary_solution().size() == 0 || x.size() != model.boundary_solution().size())
+    {
+        ImGui::PopID();
+        return;
+    }
+
+    ImGui::Separator();
+    ImGui::Text("%d instances of %d substructures: %d condensed, %d reused", model.instance_count(), model.definition_count(),
+                model.condensations, model.reuses);
+    ImGui::Text("%d boundary equations of %d (%d interior); condense %.3f s, solve %.3f s", model.boundary_dofs(),
+                model.boundary_dofs() + model.interior_dofs(), model.interior_dofs(), model.condense_seconds, model.solve_seconds);
+    if (ImGui::Button("Show Full Solution"))
+        fem_system.show_superelements();
+    if (ImGui::IsItemHovered())
+        ImGui::SetTooltip("Recovers every interior in parallel and shows the displacements and stresses.");
+
+    int num_instances = model.instance_count();
+    const int shown_rows = std::min(num_instances, 200);
+    if (ImGui::BeginTable("superelement_table", 5, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg | ImGuiTableFlags_ScrollY, ImVec2(0, 240)))
+    {
+        ImGui::TableSetupScrollFreeze(0, 1);
+        ImGui::TableSetupColumn("Instance");
+        ImGui::TableSetupColumn("Substructure");
+        ImGui::TableSetupColumn((std::string("Max Stress (") + stress_label + ")").c_str());
+        ImGui::TableSetupColumn("At Beam");
+        ImGui::TableSetupColumn((std::string("Max Disp. (") + len_unit + ")").c_str());
+        ImGui::TableHeadersRow();
+        for (int k = 0; k < shown_rows; ++k)
+        {
+            ImGui::PushID(k);
+            ImGui::TableNextRow();
+            ImGui::TableSetColumnIndex(0);
+            ImGui::Text("%d", k + 1);
+            ImGui::TableSetColumnIndex(1);
+            ImGui::Text("%d", model.definition_of(k) + 1);
+            ImGui::TableSetColumnIndex(2);
+            if (!is_recovered[k])
+            {
+                if (ImGui::SmallButton("Recover"))
+                    is_recovered[k] = model.recover(k, x, recovered[k]) == 0;
+                ImGui::PopID();
+                continue;
+            }
+            const InstanceRecovery &r = recovered[k];
+            ImGui::Text("%.4g", fem_system.stressToDisplay(r.max_stress));
+            ImGui::TableSetColumnIndex(3);
+            ImGui::Text("%d", r.critical_member + 1);
+            ImGui::TableSetColumnIndex(4);
+            ImGui::Text("%.4g", fem_system.lengthToDisplay(r.max_displacement));
+            ImGui::PopID();
+        }
+        ImGui::EndTable();
+    }
+    if (shown_rows < num_instances)
+        ImGui::TextDisabled("Showing %d of %d instances", shown_rows, num_instances);
+    ImGui::PopID();
+}
+
+void GUIHandler::topologyPanel()
+{
+    static int last_result = 0;
+    static int last_applied = -1;
+    static int material_idx = 0;
+    static char topology_name_buf[512] = "topology.csv";
+    TopologyOptions &options = fem_system.topology_options;
+    const TopologyResults &r = fem_system.topology_results;
+    const char *len_unit = (fem_system.unit_system == Metric) ? "m" : (fem_system.unit_system == ImperialInches ? "in" : "ft");
+    const char *area_unit = (fem_system.unit_system == Metric) ? "m^2" : (fem_system.unit_system == ImperialInches ? "in^2" : "ft^2");
+    const char *force_unit = (fem_system.unit_system == Metric) ? "N" : "lbf";
+    const char *stress_label = (fem_system.unit_system == Metric) ? "MPa" : "psi";
+    const char *mass_unit = (fem_system.unit_system == Metric) ? "kg" : "lb";
+    int num_materials = static_cast<int>(fem_system.materials_list.size());
+
+    ImGui::PushID("topology");
+    ImGui::TextWrapped("Finds the lightest pin-jointed truss that carries the current loads to the current supports, "
+                       "choosing members from every pair of nodes of a grid over the model. Node moments are ignored.");
+
+    int divisions[2] = {options.divisions_x, options.divisions_y};
+    if (ImGui::InputInt2("Grid Divisions (x, y)", divisions))
+    {
+        options.divisions_x = std::clamp(divisions[0], 1, 200);
+        options.divisions_y = std::clamp(divisions[1], 1, 200);
+    }
+    if (ImGui::IsItemHovered())
+        ImGui::SetTooltip("Cost grows quickly with the grid: 40 x 20 takes seconds, 80 x 40 minutes.");
+
+    float limits[2] = {static_cast<float>(fem_system.stressToDisplay(options.tension_limit)),
+                       static_cast<float>(fem_system.stressToDisplay(options.compression_limit))};
+    if (ImGui::InputFloat2((std::string("Tension / Compression Limit (") + stress_label + ")").c_str(), limits, "%.4g"))
+    {
+        options.tension_limit = std::max(limits[0], 1e-6f) / fem_system.stressToDisplay(1.0);
+        options.compression_limit = std::max(limits[1], 1e-6f) / fem_system.stressToDisplay(1.0);
+    }
+    float max_length = static_cast<float>(fem_system.lengthToDisplay(options.max_length));
+    if (ImGui::InputFloat((std::string("Max Member Length (") + len_unit + ", 0: none)").c_str(), &max_length, 0.0f, 0.0f, "%.4g"))
+        options.max_length = std::max(max_length, 0.0f) / fem_system.lengthToDisplay(1.0);
+    float add_fraction = static_cast<float>(options.add_fraction);
+    if (ImGui::SliderFloat("Members Added per Round", &add_fraction, 0.01f, 1.0f, "%.2f"))
+        options.add_fraction = add_fraction;
+    ImGui::SliderInt("Max Rounds", &options.max_rounds, 1, 200);
+    float cutoff = static_cast<float>(options.area_cutoff);
+    if (ImGui::InputFloat("Area Cutoff (of thickest)", &cutoff, 0.0f, 0.0f, "%.2g"))
+        options.area_cutoff = std::clamp(cutoff, 0.0f, 0.5f);
+
+    if (ImGui::Button("Generate Layout"))
+    {
+        last_result = fem_system.solve_topology();
+        last_applied = -1;
+    }
+    if (last_result == -1)
+        ImGui::TextColored(ImVec4(1.f, 0.4f, 0.4f, 1.f), "Needs loads, supports and nodes spanning both directions.");
+    else if (last_result == -2)
+        ImGui::TextColored(ImVec4(1.f, 0.4f, 0.4f, 1.f), "No layout on this grid can carry the loads.");
+
+    int num_members = static_cast<int>(r.member_area.size());
+    if (num_members == 0 || r.history.empty())
+    {
+        ImGui::PopID();
+        return;
+    }
+
+    ImGui::Separator();
+    if (!r.converged)
+        ImGui::TextColored(ImVec4(1.f, 0.8f, 0.2f, 1.f), "Round limit reached: the layout may not be optimal");
+    ImGui::Text("%d grid nodes, %lld potential members, %d rounds, %.3f s", r.grid_nodes, r.potential_members,
+                static_cast<int>(r.history.size()), r.wall_seconds);
+    ImGui::Text("Layout: %d members, %d nodes", num_members, static_cast<int>(r.nodes.size()));
+    double to_volume = std::pow(fem_system.lengthToDisplay(1.0), 3);
+    ImGui::Text("Volume %.4g %s^3", r.volume * to_volume, len_unit);
+    material_idx = std::clamp(material_idx, 0, std::max(num_materials - 1, 0));
+    if (num_materials > 0)
+    {
+        ImGui::SameLine();
+        ImGui::Text("(%.4g %s of %s)", fem_system.massToDisplay(r.volume * fem_system.materials_list[material_idx].density),
+                    mass_unit, fem_system.materials_list[material_idx].name.c_str());
+    }
+
+    std::vector<float> volumes(r.history.size());
+    for (size_t k = 0; k < r.history.size(); ++k)
+        volumes[k] = static_cast<float>(r.history[k].volume * to_volume);
+    ImGui::PlotLines("Volume per Round", volumes.data(), static_cast<int>(volumes.size()), 0, nullptr, 0.0f, FLT_MAX, ImVec2(0, 80));
+
+    if (num_materials > 0)
+    {
+        std::vector<const char *> material_items;
+        material_items.reserve(num_materials);
+        for (auto &mat : fem_system.materials_list)
+            material_items.push_back(mat.name.c_str());
+        ImGui::Combo("Material", &material_idx, material_items.data(), num_materials);
+        if (ImGui::Button("Apply (replaces model)"))
+            last_applied = fem_system.apply_topology(material_idx);
+        if (ImGui::IsItemHovered())
+            ImGui::SetTooltip("Replaces nodes, members and loads by the layout, with one new profile per member area.");
+        if (last_applied >= 0)
+        {
+            ImGui::SameLine();
+            ImGui::Text("%d members built", last_applied);
+        }
+    }
+
+    ImGui::InputText("CSV Filename", topology_name_buf, sizeof(topology_name_buf));
+    ImGui::SameLine();
+    if (ImGui::Button("Export CSV"))
+    {
+        std::string fname(topology_name_buf);
+        if (fname.size() < 4 || fname.substr(fname.size() - 4) != ".csv")
+            fname += ".csv";
+
+        std::ofstream ofs(fname);
+        if (!ofs)
+        {
+            error_msg = "Could not open CSV for writing.";
+            save_error = true;
+        }
+        else
+        {
+            ofs << "Member,NodeA,NodeB,XA,YA,XB,YB,Force (" << force_unit << "),Area (" << area_unit << ")\n";
+            for (int i = 0; i < num_members; ++i)
+            {
+                const Node &a = r.nodes[r.member_nodes[2 * i]];
+                const Node &b = r.nodes[r.member_nodes[2 * i + 1]];
+                ofs << (i + 1) << "," << (r.member_nodes[2 * i] + 1) << "," << (r.member_nodes[2 * i + 1] + 1) << ","
+                    << fem_system.lengthToDisplay(a.position[0]) << "," << fem_system.lengthToDisplay(a.position[1]) << ","
+                    << fem_system.lengthToDisplay(b.position[0]) << "," << fem_system.lengthToDisplay(b.position[1]) << ","
+                    << fem_system.forceToDisplay(r.member_force[i]) << "," << fem_system.areaToDisplay(r.member_area[i]) << "\n";
+            }
+            ofs << "\nRound,Volume,Members,Added,Iterations\n";
+            for (size_t k = 0; k < r.history.size(); ++k)
+            {
+                const TopologyRound &round = r.history[k];
+                ofs << k << "," << round.volume * to_volume << "," << round.members << "," << round.added << ","
+                    << round.iterations << "\n";
+            }
+            if (!ofs)
+            {
+                error_msg = "Error writing CSV file.";
+                save_error = true;
+            }
+        }
+    }
+    ImGui::PopID();
+}
+
+// New: Visualization GUI window
+void GUIHandler::visualizationEditor()
+{
+    if (!show_visualization_editor)
+        return;
+
+    ImGui::Begin("Visualization", &show_visualization_editor, ImGuiWindowFlags_AlwaysAutoResize);
+
+    ImGui::Text("Rendering / Visualization Settings");
+    ImGui::Separator();
+
+    // Show and control displacement scale (public member on renderer)
+    float ds = renderer.displacementScale;
+    if (ImGui::SliderFloat("Displacement Scale", &ds, 0.0f, 50.0f, "%.2f"))
+    {
+        renderer.displacementScale = ds;
+    }
+
+    ImGui::SameLine();
+    ImGui::TextDisabled("(?)");
+    if (ImGui::IsItemHovered())
+    {
+        ImGui::BeginTooltip();
+        ImGui::PushTextWrapPos(ImGui::GetFontSize() * 35.0f);
+        ImGui::TextUnformatted("Scale applied to computed displacements for visualization only (does not affect solver).");
+        ImGui::PopTextWrapPos();
+        ImGui::EndTooltip();
+    }
+
+    // Option: quick reset
+    if (ImGui::Button("Reset Scale"))
+    {
+        renderer.displacementScale = 1.0f;
+    }
+    ImGui::SameLine();
+    if (ImGui::Button("Auto Fit View"))
+    {
+        renderer.centerView();
+        renderer.autoZoomToFit();
+    }
+
+    // Visual scaling for force/reaction arrows
+
+    float fvs = renderer.forceScale;
+    if (ImGui::SliderFloat("Force Visual Scale (N->world)", &fvs, 1.0f, 40000.0f, "%.0f"))
+        renderer.forceScale = fvs;
+
+    ImGui::SameLine();
+    ImGui::TextDisabled("(larger = shorter arrows)");
+
+    float rvs = renderer.reactionScale;
+    if (ImGui::SliderFloat("Reaction Visual Scale (N->world)", &rvs, 1.0f, 40000.0f, "%.0f"))
+        renderer.reactionScale = rvs;
+
+    // Stress gradient along members from the station results
+    ImGui::Checkbox("Color Beams by Station", &renderer.colorByStation);
+    ImGui::SameLine();
+    int stations = fem_system.num_stations;
+    if (ImGui::SliderInt("Stations per Member", &stations, 2, 21))
+    {
+        fem_system.num_stations = stations; // get_stations() resamples on next use
+    }
+
+    // --- Load path / dynamic response playback ---
+    ImGui::Separator();
+    ImGui::Text("Animation");
+    ImGui::Spacing();
+
+    // plays back the converged increments of the nonlinear solve instead of rescaling a
+    // linear solution, so large rotations and stiffening show up as they really happen
+    if (ImGui::Button("Solve and Play Load Path"))
+    {
+        bool keep_all = fem_system.nonlinear_options.store_increments;
+        fem_system.nonlinear_options.store_increments = true;
+        fem_system.solve_nonlinear();
+        fem_system.nonlinear_options.store_increments = keep_all;
+        if (!fem_system.nonlinear_results.increments.empty())
+        {
+            selectShape(ShapeSource::Increment, 0);
+            shape_animate = true;
+        }
+    }
+    if (shape_source == ShapeSource::Increment)
+    {
+        ImGui::SameLine();
+        ImGui::Checkbox("Play", &shape_animate);
+        ImGui::SliderFloat("Increments per Second", &increments_per_second, 0.5f, 30.0f, "%.1f");
+    }
+    else if (!fem_system.nonlinear_results.increments.empty())
+    {
+        ImGui::SameLine();
+        if (ImGui::Button("Play Last Load Path"))
+        {
+            selectShape(ShapeSource::Increment, 0);
+            shape_animate = true;
+        }
+    }
+
+    // real dynamic response of the current loads times the load history
+    if (ImGui::Button("Solve and Play Transient"))
+    {
+        if (fem_system.solve_transient() == 0)
+        {
+            selectShape(ShapeSource::Transient, 0);
+            shape_animate = true;
+        }
+    }
+    if (shape_source == ShapeSource::Transient)
+    {
+        ImGui::SameLine();
+        ImGui::Checkbox("Play##transient", &shape_animate);
+        ImGui::SliderFloat("Playback Speed (sim s / s)", &playback_speed, 0.0001f, 10.0f, "%.4f", ImGuiSliderFlags_Logarithmic);
+    }
+    ImGui::TextWrapped("Solver settings, damping and load histories are under Analysis > Nonlinear Static and Transient Dynamics.");
+
+    // --- Recording controls ---
+    ImGui::Separator();
+    ImGui::Text("Recording / Export");
+    ImGui::Spacing();
+
+    // Persistent state across frames
+    static bool recording = false;
+    static float record_fps = 24.0;
+    static int recorded_frames = 0;
+    static double record_accum = 0.0;
+    // New: user-configurable recording length (seconds) and elapsed time accumulator
+    static float record_length_seconds = 5.0f;
+    static double record_time_accum = 0.0;
+    static std::string out_dir = "record_frames";
+    static std::string out_prefix = "frame";
+    static bool auto_build_gif = false;
+    static bool delete_frames_after = false;
+
+    // Input fields
+    char dir_buf[512];
     std::strncpy(dir_buf, out_dir.c_str(), sizeof(dir_buf));
     dir_buf[sizeof(dir_buf) - 1] = '\0';
     ImGui::InputText("Output Directory", dir_buf, sizeof(dir_buf));
@@ -2305,27 +5491,12 @@ void GUIHandler::visualizationEditor()
                        << std::setw(5) << std::setfill('0') << recorded_frames << ".png";
                     std::string fname = ns.str();
 
-                    // Start writer thread lazily
-                    if (!g_writer_started.load())
-                    {
-                        std::thread writer(writerThreadFunc);
-                        writer.detach(); // run in background
-                        g_writer_started = true;
-                    }
-
-                    // Enqueue the sf::Image (copy) for background saving
+                    // Hand the image to the scheduler for background saving; drop frames
+                    // rather than let the backlog grow without bound if encoding falls behind
+                    if (g_frames_in_flight.load() < max_frames_in_flight)
                     {
-                        std::lock_guard<std::mutex> lg(g_frame_mutex);
-                        if (g_frame_queue.size() > 500)
-                        {
-                            g_frame_queue.pop_front();
-                        }
-                        FrameTask task;
-                        task.filename = fname;
-                        task.image = std::move(image);
-                        g_frame_queue.emplace_back(std::move(task));
+                        enqueueFrameWrite(std::move(image), fname);
                     }
-                    g_frame_cv.notify_one();
 
                     ++recorded_frames;
                 }
@@ -2351,11 +5522,8 @@ void GUIHandler::visualizationEditor()
         int waited = 0;
         while (waited < max_wait_ms)
         {
-            {
-                std::lock_guard<std::mutex> lg(g_frame_mutex);
-                if (g_frame_queue.empty())
-                    break;
-            }
+            if (g_frames_in_flight.load() == 0)
+                break;
             std::this_thread::sleep_for(std::chrono::milliseconds(50));
             waited += 50;
         }
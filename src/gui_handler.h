@@ -40,6 +40,43 @@ private:
     void profileEditor();
     void visualizationEditor();
     void helpPage();
+    void taskProfiler();
+    void analysisWindow();
+    void modalPanel();
+    void bucklingPanel();
+    void nonlinearPanel();
+    void transientPanel();
+    void modalResponsePanel();
+    void frequencyResponsePanel();
+    void responseSpectrumPanel();
+    void pushoverPanel();
+    void movingLoadPanel();
+    void sensitivityPanel();
+    void sizingPanel();
+    void shapePanel();
+    void sweepPanel();
+    void reliabilityPanel();
+    void redundancyPanel();
+    void reducedModelPanel();
+    void superelementPanel();
+    void topologyPanel();
+    void shapeControls();
+
+    // which result is drawn as the deformed shape: the static solution, a mode of an analysis,
+    // an increment of the nonlinear load path, a frame of the transient response, the
+    // modal superposition preview or a hinge event of the pushover
+    enum class ShapeSource
+    {
+        Static,
+        Mode,
+        Buckling,
+        Increment,
+        Transient,
+        ModalResponse,
+        Pushover
+    };
+    void selectShape(ShapeSource source, int index);
+    void updateShape(); // pushes the selected shape into fem_system once per frame
     void outputEditor();
     void drawGridHUD();
 
@@ -51,6 +88,22 @@ private:
     bool request_load_popup = false;
     bool request_dpi_adjust = false;
     bool show_help_page = false;
+    bool show_task_profiler = false;
+    bool show_analysis = false;
+
+    // deformed-shape display of the analysis results
+    ShapeSource shape_source = ShapeSource::Static;
+    int shape_index = 0;
+    bool shape_animate = true;
+    float shape_amplitude = 0.25f; // largest nodal movement (display length units)
+    float shape_speed = 0.5f;      // Hz, visual only
+    float shape_time = 0.0f;
+    float increments_per_second = 4.0f; // load path playback rate
+    float playback_speed = 0.1f;        // transient and modal preview playback, simulated seconds per real second
+
+    // Worker Threads slider: follows the scheduler except while it is being dragged
+    int worker_threads = 0;
+    bool worker_threads_dragging = false;
 
     char filename_buf[512] = "system";
     bool trigger_save_write = false;
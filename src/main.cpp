@@ -61,8 +61,8 @@ int main()
     std::cout << "  Area: " << A_aluminum << " in^2" << std::endl;
     std::cout << "  Moment of Inertia: " << I_aluminum << " in^4" << std::endl;
 
-    MaterialProfile steel_material = {"Steel", E_steel};
-    MaterialProfile aluminum_material = {"Aluminum", E_aluminum};
+    MaterialProfile steel_material = {"Steel", E_steel, 7850.0};
+    MaterialProfile aluminum_material = {"Aluminum", E_aluminum, 2700.0};
     BeamProfile steel_beam = {"Steel Beam", A_steel, I_steel, S_steel};
     BeamProfile aluminum_beam = {"Aluminum Beam", A_aluminum, I_aluminum, S_aluminum};
     BeamProfile steel_truss = {"Steel Truss", A_steel / 2.0f, 0.0f, 0.0f};
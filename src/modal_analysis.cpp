@@ -0,0 +1,53 @@
+#include "modal_analysis.h"
+#include "eigen_solver.h"
+#include <cmath>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+int extract_modes(const DofMap &map, const SparseMatrix &K, const SparseMatrix &M, int count,
+                  ModalResults &out)
+{
+    out.count = 0;
+    out.omega.clear();
+    out.frequency.clear();
+    out.shapes.resize(map.total_dof, 0);
+    out.converged = false;
+    out.iterations = 0;
+
+    if (map.num_reduced == 0 || count <= 0)
+        return -1;
+
+    // a shift on the scale of the diagonal ratio keeps the factorization well away from singular
+    double k_diag = K.diagonal().cwiseAbs().mean();
+    double m_diag = M.diagonal().cwiseAbs().mean();
+    double ratio = (m_diag > 0.0) ? k_diag / m_diag : 1.0;
+
+    EigenResult eig;
+    int rc = -1;
+    double shift = -1e-6 * ratio;
+    for (int attempt = 0; attempt < 4 && rc == -1; ++attempt, shift *= 100.0)
+        rc = shift_invert_eigs(K, M, count, shift, eig);
+    if (rc == -1)
+        return -1;
+
+    int found = static_cast<int>(eig.values.size());
+    out.count = found;
+    out.omega.resize(found);
+    out.frequency.resize(found);
+    out.shapes.resize(map.total_dof, found);
+    for (int k = 0; k < found; ++k)
+    {
+        double lambda = std::max(eig.values(k), 0.0); // rigid-body modes can come out at -0
+        out.omega[k] = std::sqrt(lambda);
+        out.frequency[k] = out.omega[k] / (2.0 * M_PI);
+
+        Eigen::VectorXd global;
+        map.expand(eig.vectors.col(k), global);
+        out.shapes.col(k) = global;
+    }
+    out.converged = eig.converged;
+    out.iterations = eig.iterations;
+    return rc;
+}
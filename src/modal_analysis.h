@@ -0,0 +1,23 @@
+#pragma once
+#include <vector>
+#include <Eigen/Eigen>
+#include "dof_map.h"
+
+// Natural frequencies and mode shapes from the last FEMSystem::solve_modes()
+struct ModalResults
+{
+    int count = 0;
+    std::vector<double> omega;     // rad/s, ascending
+    std::vector<double> frequency; // Hz
+    Eigen::MatrixXd shapes;        // total_dof x count in global DOFs, mass-normalized
+    bool lumped = false;           // which mass matrix was used
+    bool converged = false;
+    int iterations = 0;
+};
+
+// Lowest `count` modes of K phi = omega^2 M phi on the reduced equations of `map`.
+// The shift starts just below zero so free-floating parts (zero-frequency modes) do not make
+// the shifted matrix singular; it is pushed further down if the factorization still fails.
+// Returns 0 on success, -1 if no usable shift was found, -2 if the solver did not converge.
+int extract_modes(const DofMap &map, const SparseMatrix &K, const SparseMatrix &M, int count,
+                  ModalResults &out);
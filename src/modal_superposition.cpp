@@ -0,0 +1,199 @@
+#include "modal_superposition.h"
+#include <algorithm>
+#include <cmath>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+namespace
+{
+    constexpr double min_omega = 1e-9; // rigid-body modes carry no static or dynamic response here
+
+    // Exact response of q'' + 2 zeta w q' + w^2 q = p(t) over one step of length h with p
+    // varying linearly from p0 to p1 (the Nigam-Jennings recurrence, unit modal mass)
+    void linear_load_step(double w, double zeta, double h, double p0, double p1, double &q, double &qdot)
+    {
+        double k = w * w;
+        double root = std::sqrt(1.0 - zeta * zeta);
+        double wd = w * root;
+        double e = std::exp(-zeta * w * h);
+        double s = std::sin(wd * h);
+        double c = std::cos(wd * h);
+        double zr = zeta / root;
+
+        double A = e * (zr * s + c);
+        double B = e * s / wd;
+        double C = (2.0 * zeta / (w * h) + e * (((1.0 - 2.0 * zeta * zeta) / (wd * h) - zr) * s - (1.0 + 2.0 * zeta / (w * h)) * c)) / k;
+        double D = (1.0 - 2.0 * zeta / (w * h) + e * ((2.0 * zeta * zeta - 1.0) / (wd * h) * s + 2.0 * zeta / (w * h) * c)) / k;
+        double Ad = -e * (w / root) * s;
+        double Bd = e * (c - zr * s);
+        double Cd = (-1.0 / h + e * ((w / root + zeta / (h * root)) * s + c / h)) / k;
+        double Dd = (1.0 - e * (zr * s + c)) / (k * h);
+
+        double q1 = A * q + B * qdot + C * p0 + D * p1;
+        double qdot1 = Ad * q + Bd * qdot + Cd * p0 + Dd * p1;
+        q = q1;
+        qdot = qdot1;
+    }
+} // namespace
+
+void ModalSuperposition::prepare(const ModalResults &modal, const Eigen::VectorXd &forces, const LoadHistory &history,
+                                 double damping_ratio, int max_modes)
+{
+    modes = std::min(std::max(max_modes, 0), modal.count);
+    if (modal.shapes.rows() != forces.size())
+        modes = 0;
+
+    omega.assign(modal.omega.begin(), modal.omega.begin() + modes);
+    zeta.assign(modes, std::min(std::max(damping_ratio, 0.0), 0.99)); // underdamped formulas only
+    modal_force.resize(modes);
+    for (int k = 0; k < modes; ++k)
+        modal_force[k] = modal.shapes.col(k).dot(forces);
+
+    load = history;
+    reset();
+}
+
+void ModalSuperposition::reset()
+{
+    time = 0.0;
+    q.assign(modes, 0.0);
+    qdot.assign(modes, 0.0);
+}
+
+void ModalSuperposition::advance_to(double t)
+{
+    if (t <= 0.0)
+    {
+        reset();
+        return;
+    }
+
+    if (load.type == LoadHistory::Step)
+    {
+        for (int k = 0; k < modes; ++k)
+        {
+            double w = omega[k];
+            if (w < min_omega)
+            {
+                q[k] = qdot[k] = 0.0;
+                continue;
+            }
+            double root = std::sqrt(1.0 - zeta[k] * zeta[k]);
+            double wd = w * root;
+            double e = std::exp(-zeta[k] * w * t);
+            double q_static = load.amplitude * modal_force[k] / (w * w);
+            q[k] = q_static * (1.0 - e * (std::cos(wd * t) + zeta[k] / root * std::sin(wd * t)));
+            qdot[k] = q_static * e * (w / root) * std::sin(wd * t);
+        }
+        time = t;
+        return;
+    }
+
+    if (load.type == LoadHistory::Harmonic)
+    {
+        double W = 2.0 * M_PI * load.frequency;
+        for (int k = 0; k < modes; ++k)
+        {
+            double w = omega[k];
+            if (w < min_omega)
+            {
+                q[k] = qdot[k] = 0.0;
+                continue;
+            }
+            double f = load.amplitude * modal_force[k];
+            double detune = w * w - W * W;
+            double cross = 2.0 * zeta[k] * w * W;
+            double D = detune * detune + cross * cross;
+
+            if (D < 1e-20 * w * w * w * w)
+            {
+                // undamped resonance: the amplitude grows linearly
+                q[k] = f / (2.0 * w * w) * (std::sin(w * t) - w * t * std::cos(w * t));
+                qdot[k] = 0.5 * f * t * std::sin(w * t);
+                continue;
+            }
+
+            // steady state plus the free vibration that starts it from rest
+            double qp = f * (detune * std::sin(W * t) - cross * std::cos(W * t)) / D;
+            double qp_dot = f * W * (detune * std::cos(W * t) + cross * std::sin(W * t)) / D;
+            double wd = w * std::sqrt(1.0 - zeta[k] * zeta[k]);
+            double C1 = f * cross / D;
+            double C2 = (zeta[k] * w * C1 - f * W * detune / D) / wd;
+            double e = std::exp(-zeta[k] * w * t);
+            double c = std::cos(wd * t);
+            double s = std::sin(wd * t);
+
+            q[k] = qp + e * (C1 * c + C2 * s);
+            qdot[k] = qp_dot + e * ((-zeta[k] * w * C1 + wd * C2) * c + (-zeta[k] * w * C2 - wd * C1) * s);
+        }
+        time = t;
+        return;
+    }
+
+    // piecewise-linear load: march, stepping exactly onto the load's breakpoints
+    if (t < time)
+        reset();
+
+    std::vector<double> breaks;
+    if (load.type == LoadHistory::Ramp)
+    {
+        breaks.push_back(load.duration);
+    }
+    else if (load.type == LoadHistory::Pulse)
+    {
+        const int pieces = 16; // the half sine is followed closely enough by 16 chords
+        for (int i = 1; i <= pieces; ++i)
+            breaks.push_back(load.duration * i / pieces);
+    }
+    else if (load.type == LoadHistory::Table)
+    {
+        for (const auto &point : load.table)
+            breaks.push_back(point(0));
+    }
+
+    while (time < t)
+    {
+        double next = t;
+        for (double b : breaks)
+        {
+            if (b > time + 1e-12 && b < next)
+                next = b;
+        }
+
+        double h = next - time;
+        if (h <= 1e-12)
+        {
+            time = next; // too short to matter, and the recurrence divides by h
+            continue;
+        }
+        double p0 = load.factor(time);
+        double p1 = load.factor(next);
+
+        for (int k = 0; k < modes; ++k)
+        {
+            if (omega[k] < min_omega)
+                continue;
+            linear_load_step(omega[k], zeta[k], h, p0 * modal_force[k], p1 * modal_force[k], q[k], qdot[k]);
+        }
+        time = next;
+    }
+}
+
+void ModalSuperposition::reconstruct(const Eigen::MatrixXd &shapes, const std::vector<int> &nodes,
+                                     Eigen::VectorXd &displacement) const
+{
+    if (modes == 0 || shapes.cols() < modes || shapes.rows() != displacement.size())
+        return;
+
+    Eigen::Map<const Eigen::VectorXd> qk(q.data(), modes);
+    for (int node : nodes)
+    {
+        for (int d = 0; d < 3; ++d)
+        {
+            int dof = node * 3 + d;
+            displacement(dof) = shapes.row(dof).head(modes).dot(qk);
+        }
+    }
+}
@@ -0,0 +1,35 @@
+#pragma once
+#include <vector>
+#include <Eigen/Eigen>
+#include "modal_analysis.h"
+#include "transient_analysis.h"
+
+// Dynamic response as a sum of the lowest modes: u(t) = sum_k phi_k q_k(t), each q_k an
+// independent damped oscillator q'' + 2 zeta w q' + w^2 q = phi_k^T F * load(t). Advancing
+// costs O(modes) per frame whatever the model size, and only the displacements of the nodes
+// that are actually drawn need to be rebuilt.
+struct ModalSuperposition
+{
+    int modes = 0;
+    std::vector<double> omega;      // rad/s
+    std::vector<double> zeta;       // damping ratio per mode
+    std::vector<double> modal_force; // phi_k^T F for the full applied load
+    LoadHistory load;
+
+    double time = 0.0;
+    std::vector<double> q;    // modal coordinates at `time`
+    std::vector<double> qdot; // and their rates
+
+    // take the first `max_modes` modes of `modal` (mass-normalized) and the load pattern
+    void prepare(const ModalResults &modal, const Eigen::VectorXd &forces, const LoadHistory &history,
+                 double damping_ratio, int max_modes);
+    void reset(); // back to rest at t = 0
+
+    // Step and Harmonic loads are evaluated in closed form at t, so any frame time (or
+    // seeking backwards) is exact. The other histories are marched from the current time with
+    // the exact recurrence for a piecewise-linear load, splitting at the load's own breakpoints.
+    void advance_to(double t);
+
+    // displacement entries of `nodes` only (3 DOFs each), from columns of `shapes`
+    void reconstruct(const Eigen::MatrixXd &shapes, const std::vector<int> &nodes, Eigen::VectorXd &displacement) const;
+};
@@ -0,0 +1,258 @@
+#include "moving_load.h"
+#include "task_scheduler.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
+
+namespace
+{
+    // a load at distance x along the deck as entries of column `col` of C, shared linearly
+    // between the two neighbouring deck nodes; loads off the deck do nothing
+    void distribute(const std::vector<double> &station, double x, double load, int col,
+                    std::vector<Eigen::Triplet<double>> &C)
+    {
+        int n = static_cast<int>(station.size());
+        if (x < station.front() || x > station.back())
+            return;
+        int j = static_cast<int>(std::upper_bound(station.begin(), station.end(), x) - station.begin()) - 1;
+        j = std::min(std::max(j, 0), n - 2);
+        double w = (x - station[j]) / (station[j + 1] - station[j]);
+        C.emplace_back(j, col, load * (1.0 - w));
+        C.emplace_back(j + 1, col, load * w);
+    }
+
+    // the fibre stress of larger magnitude for axial force P and beam-convention end moments
+    double combined_stress(const ElementCache &cache, int i, double P, double M1, double M2)
+    {
+        double axial = P * cache.inv_area[i];
+        double bending = std::max(std::abs(M1), std::abs(M2)) * cache.inv_section_modulus[i];
+        double tension = axial + bending;
+        double compression = axial - bending;
+        return std::abs(tension) > std::abs(compression) ? tension : compression;
+    }
+
+    // keep whichever of a and b has the larger magnitude
+    double larger(double a, double b)
+    {
+        return std::abs(b) > std::abs(a) ? b : a;
+    }
+} // namespace
+
+double LoadTrain::length() const
+{
+    double longest = 0.0;
+    for (double offset : offsets)
+        longest = std::max(longest, offset);
+    return longest;
+}
+
+int compute_influence_lines(const std::vector<Node> &nodes,
+                            const DofMap &map,
+                            const ElementCache &cache,
+                            const SparseSolver &solver,
+                            const std::vector<int> &deck_nodes,
+                            InfluenceLines &out)
+{
+    out = InfluenceLines();
+    int n = static_cast<int>(deck_nodes.size());
+    int num_nodes = static_cast<int>(nodes.size());
+    if (n < 2 || map.num_reduced == 0 || map.total_dof != num_nodes * 3)
+        return -1;
+    for (int node : deck_nodes)
+    {
+        if (node < 0 || node >= num_nodes)
+            return -1;
+    }
+
+    // distance along the path, panel by panel
+    out.station.assign(n, 0.0);
+    for (int j = 1; j < n; ++j)
+    {
+        const Node &a = nodes[deck_nodes[j - 1]];
+        const Node &b = nodes[deck_nodes[j]];
+        double dx = b.position[0] - a.position[0];
+        double dy = b.position[1] - a.position[1];
+        double panel = std::sqrt(dx * dx + dy * dy);
+        if (panel < 1e-9)
+            return -1;
+        out.station[j] = out.station[j - 1] + panel;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    out.deck_nodes = deck_nodes;
+    out.axial.resize(cache.count, n);
+    out.moment1.resize(cache.count, n);
+    out.moment2.resize(cache.count, n);
+
+    // one unit load case per deck node, all on the same factorization
+    TaskScheduler::instance().parallel_for(
+        0, n, 1, [&](int lo, int hi)
+        {
+            Eigen::VectorXd load(map.total_dof);
+            Eigen::VectorXd u;
+            for (int j = lo; j < hi; ++j)
+            {
+                load.setZero();
+                load(deck_nodes[j] * 3 + 1) = -1.0;
+                map.expand(solver.solve(map.restrict(load)), u);
+
+                double *P = out.axial.col(j).data();
+                double *M1 = out.moment1.col(j).data();
+                double *M2 = out.moment2.col(j).data();
+                for (int i = 0; i < cache.count; ++i)
+                {
+                    // same element arithmetic as recover_element_forces
+                    const double *d1 = u.data() + cache.n1[i] * 3;
+                    const double *d2 = u.data() + cache.n2[i] * 3;
+                    double c = cache.c[i];
+                    double s = cache.s[i];
+                    double L = cache.length[i];
+                    double inv_L = L > 1e-9 ? 1.0 / L : 0.0;
+                    double EI_L = cache.ei_over_l[i];
+                    double dw = (-s * d1[0] + c * d1[1]) - (-s * d2[0] + c * d2[1]);
+
+                    P[i] = cache.ea_over_l[i] * ((c * d2[0] + s * d2[1]) - (c * d1[0] + s * d1[1]));
+                    M1[i] = -(6.0 * EI_L * inv_L * dw + EI_L * (4.0 * d1[2] + 2.0 * d2[2]));
+                    M2[i] = 6.0 * EI_L * inv_L * dw + EI_L * (2.0 * d1[2] + 4.0 * d2[2]);
+                }
+            } },
+        TaskPriority::High, "influence_lines");
+
+    out.wall_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return 0;
+}
+
+int moving_load_envelope(const InfluenceLines &lines,
+                         const ElementCache &cache,
+                         const MovingLoadOptions &options,
+                         MovingLoadResults &out)
+{
+    out = MovingLoadResults();
+    const LoadTrain &train = options.train;
+    int n = static_cast<int>(lines.station.size());
+    if (n < 2 || lines.axial.rows() != cache.count || train.loads.empty() || train.loads.size() != train.offsets.size())
+        return -1;
+
+    auto start = std::chrono::steady_clock::now();
+
+    // front axle positions from the start of the deck until the last axle has left it
+    double deck = lines.deck_length();
+    double travel = deck + train.length();
+    double step = options.position_step > 0.0 ? options.position_step : deck / 200.0;
+    int per_direction = static_cast<int>(std::floor(travel / step + 1e-9)) + 1;
+    int directions = options.both_directions ? 2 : 1;
+    out.positions = per_direction * directions;
+
+    // deck node weights of every position: column k is the train with its front axle at
+    // k * step (first run) or coming the other way (second run). At most two entries per
+    // axle, so C is kept sparse and a position costs O(axles) per member, not O(deck nodes).
+    std::vector<Eigen::Triplet<double>> entries;
+    for (int d = 0; d < directions; ++d)
+    {
+        for (int k = 0; k < per_direction; ++k)
+        {
+            double front = k * step;
+            for (size_t a = 0; a < train.loads.size(); ++a)
+            {
+                double x = front - train.offsets[a];
+                distribute(lines.station, d == 0 ? x : deck - x, train.loads[a], d * per_direction + k, entries);
+            }
+        }
+    }
+    SparseMatrix C(n, out.positions);
+    C.setFromTriplets(entries.begin(), entries.end()); // duplicates (axles in one panel) are summed
+
+    int members = cache.count;
+    out.max_axial.assign(members, 0.0f);
+    out.min_axial.assign(members, 0.0f);
+    out.max_moment.assign(members, 0.0f);
+    out.min_moment.assign(members, 0.0f);
+    out.max_stress.assign(members, 0.0f);
+    out.min_stress.assign(members, 0.0f);
+    out.critical_position.assign(members, 0.0f);
+    out.critical_reversed.assign(members, 0);
+    ElementForces &env = out.envelope;
+    env.resize(members);
+
+    const int block = 64;
+    struct Range
+    {
+        float lo, hi;
+    };
+    Range range = TaskScheduler::instance().parallel_reduce(
+        0, members, block, Range{std::numeric_limits<float>::max(), std::numeric_limits<float>::lowest()},
+        [&](int lo, int hi)
+        {
+            Range r{std::numeric_limits<float>::max(), std::numeric_limits<float>::lowest()};
+            for (int first = lo; first < hi; first += block)
+            {
+                int count = std::min(block, hi - first);
+                // every position for a block of members at once
+                Eigen::MatrixXd P = lines.axial.middleRows(first, count) * C;
+                Eigen::MatrixXd M1 = lines.moment1.middleRows(first, count) * C;
+                Eigen::MatrixXd M2 = lines.moment2.middleRows(first, count) * C;
+
+                for (int b = 0; b < count; ++b)
+                {
+                    int i = first + b;
+                    double p_max = 0.0, p_min = 0.0, m_max = 0.0, m_min = 0.0, s_max = 0.0, s_min = 0.0;
+                    double p_ext = 0.0, m1_ext = 0.0, m2_ext = 0.0, s_ext = 0.0;
+                    int critical = 0;
+                    for (int k = 0; k < out.positions; ++k)
+                    {
+                        double p = P(b, k);
+                        double m1 = M1(b, k);
+                        double m2 = M2(b, k);
+                        double sigma = combined_stress(cache, i, p, m1, m2);
+
+                        p_max = std::max(p_max, p);
+                        p_min = std::min(p_min, p);
+                        m_max = std::max(m_max, std::max(m1, m2));
+                        m_min = std::min(m_min, std::min(m1, m2));
+                        s_max = std::max(s_max, sigma);
+                        s_min = std::min(s_min, sigma);
+                        p_ext = larger(p_ext, p);
+                        m1_ext = larger(m1_ext, m1);
+                        m2_ext = larger(m2_ext, m2);
+                        if (std::abs(sigma) > std::abs(s_ext))
+                        {
+                            s_ext = sigma;
+                            critical = k;
+                        }
+                    }
+
+                    out.max_axial[i] = static_cast<float>(p_max);
+                    out.min_axial[i] = static_cast<float>(p_min);
+                    out.max_moment[i] = static_cast<float>(m_max);
+                    out.min_moment[i] = static_cast<float>(m_min);
+                    out.max_stress[i] = static_cast<float>(s_max);
+                    out.min_stress[i] = static_cast<float>(s_min);
+                    bool reversed = critical >= per_direction;
+                    double front = (critical % per_direction) * step;
+                    out.critical_position[i] = static_cast<float>(reversed ? deck - front : front);
+                    out.critical_reversed[i] = reversed ? 1 : 0;
+
+                    // recovery sign convention, so the stress views read it like a static result
+                    env.p1[i] = -p_ext;
+                    env.p2[i] = p_ext;
+                    env.v1[i] = 0.0;
+                    env.v2[i] = 0.0;
+                    env.m1[i] = -m1_ext;
+                    env.m2[i] = m2_ext;
+                    env.stress[i] = static_cast<float>(s_ext);
+                    r.lo = std::min(r.lo, env.stress[i]);
+                    r.hi = std::max(r.hi, env.stress[i]);
+                }
+            }
+            return r;
+        },
+        [](const Range &a, const Range &b)
+        { return Range{std::min(a.lo, b.lo), std::max(a.hi, b.hi)}; },
+        TaskPriority::High, "moving_load_envelope");
+
+    out.envelope_min_stress = members > 0 ? range.lo : 0.0f;
+    out.envelope_max_stress = members > 0 ? range.hi : 0.0f;
+    out.wall_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return 0;
+}
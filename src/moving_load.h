@@ -0,0 +1,76 @@
+#pragma once
+#include <vector>
+#include <Eigen/Eigen>
+#include "dof_map.h"
+#include "element_cache.h"
+#include "sparse_solver.h"
+
+// Axle loads of a vehicle, located behind the front axle
+struct LoadTrain
+{
+    std::vector<double> offsets; // m behind the front axle (0 for the front axle itself)
+    std::vector<double> loads;   // N, acting downward
+
+    // a three-axle design truck: 35 kN, then 145 kN at 4.3 m and 145 kN at 8.6 m
+    LoadTrain() : offsets{0.0, 4.3, 8.6}, loads{35e3, 145e3, 145e3} {}
+    double length() const; // front to last axle
+};
+
+struct MovingLoadOptions
+{
+    std::vector<int> deck_nodes; // the path the loads travel along, in order
+    LoadTrain train;
+    double position_step = 0.0;  // front axle advance between positions (0: deck length / 200)
+    bool both_directions = true; // also run the train from the last deck node to the first
+};
+
+// Response of every member to a unit downward load at each deck node. A load between two
+// deck nodes is shared linearly between them (panel-point loading through stringers), so a
+// member's influence line is piecewise linear between the columns.
+struct InfluenceLines
+{
+    std::vector<int> deck_nodes;
+    std::vector<double> station; // distance along the deck path of each deck node, m
+    Eigen::MatrixXd axial;       // members x deck nodes: P (tension positive) per N
+    Eigen::MatrixXd moment1;     // end moments in the beam convention (-m1 and m2) per N
+    Eigen::MatrixXd moment2;
+    double wall_seconds = 0.0;
+
+    double deck_length() const { return station.empty() ? 0.0 : station.back(); }
+};
+
+struct MovingLoadResults
+{
+    int positions = 0; // train positions evaluated (both directions together)
+    std::vector<float> max_axial, min_axial;
+    std::vector<float> max_moment, min_moment; // over both ends
+    std::vector<float> max_stress, min_stress;
+    std::vector<float> critical_position;      // front axle station of the largest |stress|
+    std::vector<char> critical_reversed;       // ... reached on the run from the last deck node
+    // per member, the axial force, end moments and stress of larger magnitude, so the normal
+    // result views can show the envelope
+    ElementForces envelope;
+    float envelope_min_stress = 0.0f;
+    float envelope_max_stress = 0.0f;
+    double wall_seconds = 0.0;
+};
+
+// Unit-load responses for every deck node from one factorization: the load columns are
+// solved in parallel (SparseSolver::solve is const) and each member's P, M1, M2 recovered
+// per column. `solver` must hold K in `map`'s numbering.
+// Returns 0 on success, -1 if the deck has fewer than two nodes or a zero-length panel.
+int compute_influence_lines(const std::vector<Node> &nodes,
+                            const DofMap &map,
+                            const ElementCache &cache,
+                            const SparseSolver &solver,
+                            const std::vector<int> &deck_nodes,
+                            InfluenceLines &out);
+
+// Envelopes of the train alone (no other loads) crossing the deck, front axle from the start
+// of the deck until the last axle has left it. Each position is a sparse combination of the
+// influence columns, so a block of members is one dense x sparse product over all positions.
+// Returns 0 on success, -1 if the influence lines or the train are empty.
+int moving_load_envelope(const InfluenceLines &lines,
+                         const ElementCache &cache,
+                         const MovingLoadOptions &options,
+                         MovingLoadResults &out);
@@ -0,0 +1,300 @@
+#include "nonlinear_solver.h"
+#include "stress_recovery.h"
+#include "task_scheduler.h"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+namespace
+{
+    typedef Eigen::Matrix<double, 6, 1> Vector6d;
+
+    // element results at one displacement state
+    struct ElementState
+    {
+        std::vector<Vector6d> f; // global internal end forces
+        std::vector<Matrix6d> k; // global tangent stiffness (only when asked for)
+        ElementForces forces;
+        StressRange range = {0.0f, 0.0f};
+    };
+
+    // Corotational 2D frame element (Crisfield). The deformational displacements in the chord
+    // frame are the stretch Ln - L0 and the end rotations relative to the chord, and the local
+    // forces come from the same EA/L and EI/L terms as the linear element.
+    void corotational_element(const ElementCache &cache, int e, const double *u, bool tangent,
+                              Vector6d &f, Matrix6d *k, ElementForces &ef)
+    {
+        double L0 = cache.length[e];
+        f.setZero();
+        if (k != nullptr)
+            k->setZero();
+        if (L0 < 1e-9)
+        {
+            ef.p1[e] = ef.v1[e] = ef.m1[e] = 0.0;
+            ef.p2[e] = ef.v2[e] = ef.m2[e] = 0.0;
+            ef.stress[e] = 0.0f;
+            return;
+        }
+
+        const double *d1 = u + cache.n1[e] * 3;
+        const double *d2 = u + cache.n2[e] * 3;
+        double c0 = cache.c[e];
+        double s0 = cache.s[e];
+
+        // current chord
+        double du = d2[0] - d1[0];
+        double dv = d2[1] - d1[1];
+        double dx = L0 * c0 + du;
+        double dy = L0 * s0 + dv;
+        double Ln = std::max(std::sqrt(dx * dx + dy * dy), 1e-12 * L0);
+        double c = dx / Ln;
+        double s = dy / Ln;
+
+        // rigid rotation of the chord from its initial direction, then the local deformations.
+        // Ln - L0 is formed as (Ln^2 - L0^2) / (Ln + L0) so small stretches do not cancel.
+        double alpha = std::atan2(c0 * s - s0 * c, c0 * c + s0 * s);
+        double stretch = (2.0 * L0 * (c0 * du + s0 * dv) + du * du + dv * dv) / (Ln + L0);
+        double t1 = std::remainder(d1[2] - alpha, 2.0 * M_PI);
+        double t2 = std::remainder(d2[2] - alpha, 2.0 * M_PI);
+
+        double EA_L = cache.ea_over_l[e];
+        double EI_L = cache.ei_over_l[e];
+        double N = EA_L * stretch; // tension positive
+        double M1 = EI_L * (4.0 * t1 + 2.0 * t2);
+        double M2 = EI_L * (2.0 * t1 + 4.0 * t2);
+
+        // B = d{stretch, t1, t2} / d{u1, v1, theta1, u2, v2, theta2}
+        Vector6d r, z;
+        r << -c, -s, 0.0, c, s, 0.0;
+        z << s, -c, 0.0, -s, c, 0.0;
+        Eigen::Matrix<double, 3, 6> B;
+        B.row(0) = r.transpose();
+        B.row(1) = -z.transpose() / Ln;
+        B.row(2) = -z.transpose() / Ln;
+        B(1, 2) += 1.0;
+        B(2, 5) += 1.0;
+
+        f = B.transpose() * Eigen::Vector3d(N, M1, M2);
+
+        if (tangent && k != nullptr)
+        {
+            Eigen::Matrix3d D;
+            D << EA_L, 0.0, 0.0,
+                0.0, 4.0 * EI_L, 2.0 * EI_L,
+                0.0, 2.0 * EI_L, 4.0 * EI_L;
+            // material part plus the terms from the chord direction changing with u
+            *k = B.transpose() * D * B + (N / Ln) * (z * z.transpose()) +
+                 ((M1 + M2) / (Ln * Ln)) * (r * z.transpose() + z * r.transpose());
+        }
+
+        // end forces in the deformed chord frame, same sign convention as the linear recovery
+        double V = (M1 + M2) / Ln;
+        ef.p1[e] = -N;
+        ef.v1[e] = V;
+        ef.m1[e] = M1;
+        ef.p2[e] = N;
+        ef.v2[e] = -V;
+        ef.m2[e] = M2;
+
+        double axial = N * cache.inv_area[e];
+        double bending = std::max(std::abs(M1), std::abs(M2)) * cache.inv_section_modulus[e];
+        double tension = axial + bending;
+        double compression = axial - bending;
+        ef.stress[e] = static_cast<float>(std::abs(tension) > std::abs(compression) ? tension : compression);
+    }
+
+    void evaluate_elements(const ElementCache &cache, const Eigen::VectorXd &u, bool tangent, ElementState &state)
+    {
+        StressRange identity = {1e10f, -1e10f};
+        state.range = TaskScheduler::instance().parallel_reduce(
+            0, cache.count, 1024, identity,
+            [&](int lo, int hi)
+            {
+                StressRange range = {1e10f, -1e10f};
+                for (int e = lo; e < hi; ++e)
+                {
+                    corotational_element(cache, e, u.data(), tangent, state.f[e], tangent ? &state.k[e] : nullptr, state.forces);
+                    range.min_stress = std::min(range.min_stress, state.forces.stress[e]);
+                    range.max_stress = std::max(range.max_stress, state.forces.stress[e]);
+                }
+                return range;
+            },
+            [](const StressRange &a, const StressRange &b)
+            {
+                return StressRange{std::min(a.min_stress, b.min_stress), std::max(a.max_stress, b.max_stress)};
+            },
+            TaskPriority::High, "corotational_elements");
+    }
+
+    // sum the element end forces per node through the cache's node -> element-end adjacency,
+    // so every node is written by exactly one task
+    void gather_internal_forces(const ElementCache &cache, const ElementState &state, Eigen::VectorXd &f_int)
+    {
+        int num_nodes = static_cast<int>(cache.node_offsets.size()) - 1;
+        TaskScheduler::instance().parallel_for(
+            0, num_nodes, 4096, [&](int lo, int hi)
+            {
+                for (int node = lo; node < hi; ++node)
+                {
+                    Eigen::Vector3d sum = Eigen::Vector3d::Zero();
+                    for (int k = cache.node_offsets[node]; k < cache.node_offsets[node + 1]; ++k)
+                    {
+                        int e = cache.node_ends[k] >> 1;
+                        int end = cache.node_ends[k] & 1;
+                        sum += state.f[e].segment<3>(end * 3);
+                    }
+                    f_int.segment<3>(node * 3) = sum;
+                } },
+            TaskPriority::High, "internal_forces");
+    }
+} // namespace
+
+int solve_corotational(const DofMap &map,
+                       const std::vector<Beam> &beams,
+                       const ElementCache &cache,
+                       const Eigen::VectorXd &forces,
+                       const NonlinearOptions &options,
+                       SparseSolver &solver,
+                       NonlinearResults &out,
+                       bool debug)
+{
+    out = NonlinearResults();
+    int n = map.num_reduced;
+    if (n == 0 || cache.count == 0)
+    {
+        out.converged = true;
+        return 0;
+    }
+
+    int steps = std::max(options.load_steps, 1);
+    Eigen::VectorXd F_r = map.restrict(forces);
+    double load_norm = F_r.norm();
+
+    ElementState state;
+    state.f.resize(cache.count);
+    state.k.resize(cache.count);
+    state.forces.resize(cache.count);
+
+    Eigen::VectorXd a = Eigen::VectorXd::Zero(n); // reduced displacements
+    Eigen::VectorXd u;                            // global displacements of the last evaluation
+    Eigen::VectorXd f_int = Eigen::VectorXd::Zero(map.total_dof);
+
+    // residual lambda * F - f_int(a) in reduced DOFs; leaves `state` at `a_trial`
+    auto residual_at = [&](const Eigen::VectorXd &a_trial, double lambda, bool tangent, Eigen::VectorXd &R)
+    {
+        map.expand(a_trial, u);
+        evaluate_elements(cache, u, tangent, state);
+        gather_internal_forces(cache, state, f_int);
+        R = lambda * F_r - map.restrict(f_int);
+        return R.norm();
+    };
+
+    for (int step = 1; step <= steps; ++step)
+    {
+        double lambda = static_cast<double>(step) / steps;
+        double scale = load_norm > 0.0 ? lambda * load_norm : 1.0;
+
+        Eigen::VectorXd R;
+        double norm = residual_at(a, lambda, true, R);
+        bool converged = norm <= options.tolerance * scale;
+        double previous_norm = norm;
+        int it = 0;
+
+        while (!converged && it < options.max_iterations)
+        {
+            // full Newton refactors every iteration; modified Newton only at the start of the
+            // increment, or when the old factorization stops making progress
+            bool refactor = it == 0 || !options.modified_newton || norm > 0.5 * previous_norm;
+            if (refactor && options.modified_newton && it > 0)
+                norm = residual_at(a, lambda, true, R); // tangent at the current state
+            if (refactor)
+            {
+                SparseMatrix Kt = assemble_reduced(map, beams, state.k);
+                ++out.factorizations;
+                if (solver.factorize(Kt) != 0)
+                {
+                    if (debug)
+                        std::cout << "Tangent stiffness singular at load factor " << lambda
+                                  << " (limit point or mechanism)" << std::endl;
+                    out.increment_iterations.push_back(it);
+                    return -1;
+                }
+            }
+
+            Eigen::VectorXd da = solver.solve(R);
+            previous_norm = norm;
+
+            // energy line search: scale the step until the residual is nearly orthogonal to it
+            // (a plain residual-norm test would reject the first step of nearly every increment,
+            // where the axial terms briefly overshoot)
+            double eta = 1.0;
+            bool tangent = !options.modified_newton;
+            Eigen::VectorXd trial = a + da;
+            Eigen::VectorXd R_trial;
+            double trial_norm = residual_at(trial, lambda, tangent, R_trial);
+            double s0 = da.dot(R);
+            double s1 = da.dot(R_trial);
+            for (int ls = 0; options.line_search && ls < 4 && std::abs(s1) > 0.5 * std::abs(s0); ++ls)
+            {
+                double next = eta * s0 / (s0 - s1); // secant through (0, s0) and (eta, s1)
+                if (!std::isfinite(next))
+                    break;
+                eta = std::min(std::max(next, 0.1), 1.0);
+                trial = a + eta * da;
+                trial_norm = residual_at(trial, lambda, tangent, R_trial);
+                s1 = da.dot(R_trial);
+            }
+
+            a = trial;
+            R = R_trial;
+            norm = trial_norm;
+            ++it;
+            ++out.total_iterations;
+            out.residual_history.push_back(norm / scale);
+            converged = norm <= options.tolerance * scale;
+
+            if (debug)
+            {
+                std::cout << "  iteration " << it << ": residual " << norm / scale;
+                if (eta < 1.0)
+                    std::cout << " (line search eta=" << eta << ")";
+                std::cout << "\n";
+            }
+        }
+
+        out.increment_iterations.push_back(it);
+        if (!converged)
+        {
+            if (debug)
+                std::cout << "Increment " << step << " (load factor " << lambda << ") did not converge in "
+                          << options.max_iterations << " iterations" << std::endl;
+            return -2;
+        }
+
+        if (debug)
+            std::cout << "Increment " << step << ": load factor " << lambda << ", " << it
+                      << " iterations, residual " << norm / scale << std::endl;
+
+        if (!options.store_increments)
+            out.increments.clear();
+
+        NonlinearIncrement inc;
+        inc.load_factor = lambda;
+        inc.iterations = it;
+        inc.residual = norm / scale;
+        inc.displacement = u;
+        inc.internal_force = f_int;
+        inc.element_forces = state.forces;
+        inc.min_stress = state.range.min_stress;
+        inc.max_stress = state.range.max_stress;
+        out.increments.push_back(std::move(inc));
+        out.reached_load_factor = lambda;
+    }
+
+    out.converged = true;
+    return 0;
+}
@@ -0,0 +1,58 @@
+#pragma once
+#include <vector>
+#include <Eigen/Eigen>
+#include "dof_map.h"
+#include "element_cache.h"
+#include "sparse_solver.h"
+
+struct NonlinearOptions
+{
+    int load_steps = 10;          // equal increments up to the full applied load
+    int max_iterations = 25;      // equilibrium iterations allowed per increment
+    double tolerance = 1e-6;      // on |residual| / |applied load of the increment|
+    bool modified_newton = false; // keep the factorization across iterations (refreshed on stalls)
+    bool line_search = true;      // shorten steps that overshoot along their own direction
+    bool store_increments = true; // keep every converged increment for playback, else only the last
+};
+
+// One converged load increment
+struct NonlinearIncrement
+{
+    double load_factor = 0.0; // fraction of the applied forces
+    int iterations = 0;
+    double residual = 0.0;          // relative residual it converged to
+    Eigen::VectorXd displacement;   // global DOFs
+    Eigen::VectorXd internal_force; // global DOFs; minus the load gives the reactions at the supports
+    ElementForces element_forces;   // end forces in the deformed member axes
+    float min_stress = 0.0f;
+    float max_stress = 0.0f;
+};
+
+struct NonlinearResults
+{
+    std::vector<NonlinearIncrement> increments;
+    std::vector<double> residual_history; // relative residual after every iteration, all increments
+    std::vector<int> increment_iterations; // iterations used by every increment attempted
+    int total_iterations = 0;
+    int factorizations = 0;
+    double reached_load_factor = 0.0; // last converged load factor
+    bool converged = false;
+};
+
+// Geometrically nonlinear static solve with corotational frame/truss elements: each member
+// keeps its linear local stiffness in a frame that follows the chord, so large rotations with
+// small strains are exact. The load is applied in options.load_steps increments, each brought
+// to equilibrium by Newton-Raphson on the sparse tangent, or by modified Newton, which keeps
+// the factorization from the start of the increment until an iteration fails to halve the
+// residual. `solver` keeps its ordering between calls because the tangent has the same
+// pattern as the linear stiffness.
+// Returns 0 on success, -1 if the tangent became singular (limit point or mechanism), -2 if an
+// increment did not converge; `out` holds the increments that did converge in either case.
+int solve_corotational(const DofMap &map,
+                       const std::vector<Beam> &beams,
+                       const ElementCache &cache,
+                       const Eigen::VectorXd &forces,
+                       const NonlinearOptions &options,
+                       SparseSolver &solver,
+                       NonlinearResults &out,
+                       bool debug = false);
@@ -0,0 +1,420 @@
+#include "pushover.h"
+#include "task_scheduler.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <limits>
+
+namespace
+{
+    // local stiffness of member i in the order {u1, w1, t1, u2, w2, t2}, as Beam::compute_stiffness
+    Matrix6d local_stiffness(const ElementCache &cache, int i)
+    {
+        double L = cache.length[i];
+        double inv_L = L > 1e-9 ? 1.0 / L : 0.0;
+        double EA_L = cache.ea_over_l[i];
+        double EI_L = cache.ei_over_l[i];
+        double EI_L2 = EI_L * inv_L;
+        double EI_L3 = EI_L2 * inv_L;
+
+        Matrix6d k;
+        k << EA_L, 0.0, 0.0, -EA_L, 0.0, 0.0,
+            0.0, 12.0 * EI_L3, 6.0 * EI_L2, 0.0, -12.0 * EI_L3, 6.0 * EI_L2,
+            0.0, 6.0 * EI_L2, 4.0 * EI_L, 0.0, -6.0 * EI_L2, 2.0 * EI_L,
+            -EA_L, 0.0, 0.0, EA_L, 0.0, 0.0,
+            0.0, -12.0 * EI_L3, -6.0 * EI_L2, 0.0, 12.0 * EI_L3, -6.0 * EI_L2,
+            0.0, 6.0 * EI_L2, 2.0 * EI_L, 0.0, -6.0 * EI_L2, 4.0 * EI_L;
+        return k;
+    }
+
+    Matrix6d rotation(const ElementCache &cache, int i)
+    {
+        double c = cache.c[i];
+        double s = cache.s[i];
+        Matrix6d T = Matrix6d::Zero();
+        T(0, 0) = T(1, 1) = T(3, 3) = T(4, 4) = c;
+        T(0, 1) = T(3, 4) = s;
+        T(1, 0) = T(4, 3) = -s;
+        T(2, 2) = T(5, 5) = 1.0;
+        return T;
+    }
+
+    // global DOFs of member i gathered into {u1, v1, t1, u2, v2, t2}
+    Eigen::Matrix<double, 6, 1> element_dofs(const ElementCache &cache, int i, const Eigen::VectorXd &u)
+    {
+        Eigen::Matrix<double, 6, 1> d;
+        d.head<3>() = u.segment<3>(cache.n1[i] * 3);
+        d.tail<3>() = u.segment<3>(cache.n2[i] * 3);
+        return d;
+    }
+
+    // one column of the low-rank correction, nonzero on a few reduced rows
+    struct UpdateColumn
+    {
+        std::vector<int> rows;
+        std::vector<double> values;
+        double sign;
+        Eigen::VectorXd z; // K0^-1 w
+
+        double dot(const Eigen::VectorXd &v) const
+        {
+            double sum = 0.0;
+            for (size_t r = 0; r < rows.size(); ++r)
+                sum += values[r] * v(rows[r]);
+            return sum;
+        }
+    };
+
+    // Sherman-Morrison-Woodbury solves with K0 + W S W^T, grown one column per event
+    struct UpdatedSolver
+    {
+        const SparseSolver *base = nullptr;
+        double tolerance = 1e-9;
+        std::vector<UpdateColumn> columns;
+        Eigen::MatrixXd capacitance; // S + W^T Z
+
+        void add(UpdateColumn column)
+        {
+            Eigen::VectorXd w = Eigen::VectorXd::Zero(base->rows());
+            for (size_t r = 0; r < column.rows.size(); ++r)
+                w(column.rows[r]) += column.values[r];
+            column.z = base->solve(w);
+
+            int n = static_cast<int>(columns.size());
+            capacitance.conservativeResize(n + 1, n + 1);
+            for (int j = 0; j < n; ++j)
+            {
+                capacitance(n, j) = column.dot(columns[j].z);
+                capacitance(j, n) = columns[j].dot(column.z);
+            }
+            capacitance(n, n) = column.sign + column.dot(column.z);
+            columns.push_back(std::move(column));
+        }
+
+        // 0 and x = (K0 + W S W^T)^-1 b, or -1 if the update is singular
+        int solve(const Eigen::VectorXd &b, Eigen::VectorXd &x) const
+        {
+            x = base->solve(b);
+            if (columns.empty())
+                return 0;
+            // K0 + W S W^T is singular exactly when the capacitance is; its smallest singular
+            // value is measured against 1 since rcond() cannot see a small 1x1 or diagonal one.
+            // It is symmetric, so the singular values are the eigenvalue magnitudes
+            Eigen::SelfAdjointEigenSolver<Eigen::MatrixXd> eig(capacitance, Eigen::EigenvaluesOnly);
+            Eigen::VectorXd sigma = eig.eigenvalues().cwiseAbs();
+            if (!(sigma.minCoeff() > tolerance * std::max(1.0, sigma.maxCoeff())))
+                return -1;
+            Eigen::PartialPivLU<Eigen::MatrixXd> lu(capacitance);
+            Eigen::VectorXd wx(columns.size());
+            for (size_t j = 0; j < columns.size(); ++j)
+                wx(j) = columns[j].dot(x);
+            Eigen::VectorXd y = lu.solve(wx);
+            for (size_t j = 0; j < columns.size(); ++j)
+                x -= y(j) * columns[j].z;
+            return 0;
+        }
+    };
+
+    // scatter the global 6-vector of member i onto the reduced rows (sliders fold two DOFs)
+    UpdateColumn reduced_column(const DofMap &map, const ElementCache &cache, int i,
+                                const Eigen::Matrix<double, 6, 1> &global, double sign)
+    {
+        UpdateColumn column;
+        column.sign = sign;
+        for (int a = 0; a < 6; ++a)
+        {
+            int g = (a < 3 ? cache.n1[i] : cache.n2[i]) * 3 + a % 3;
+            int r = map.index[g];
+            if (r < 0)
+                continue;
+            auto it = std::find(column.rows.begin(), column.rows.end(), r);
+            if (it == column.rows.end())
+            {
+                column.rows.push_back(r);
+                column.values.push_back(map.scale[g] * global(a));
+            }
+            else
+            {
+                column.values[it - column.rows.begin()] += map.scale[g] * global(a);
+            }
+        }
+        return column;
+    }
+
+    void member_stress(const ElementCache &cache, ElementForces &ef, int i)
+    {
+        double axial = ef.p2[i] * cache.inv_area[i];
+        double bending = std::max(std::abs(ef.m1[i]), std::abs(ef.m2[i])) * cache.inv_section_modulus[i];
+        double tension = axial + bending;
+        double compression = axial - bending;
+        ef.stress[i] = static_cast<float>(std::abs(tension) > std::abs(compression) ? tension : compression);
+    }
+} // namespace
+
+int plastic_pushover(const DofMap &map,
+                     const std::vector<Beam> &beams,
+                     const ElementCache &cache,
+                     const std::vector<double> &plastic_moment,
+                     const Eigen::VectorXd &forces,
+                     const PushoverOptions &options,
+                     SparseSolver &solver,
+                     PushoverResults &out,
+                     bool debug)
+{
+    out = PushoverResults();
+    int num_beams = cache.count;
+    bool any_capacity = false;
+    for (int i = 0; i < num_beams; ++i)
+        any_capacity |= plastic_moment[i] > 0.0 && cache.ei_over_l[i] > 0.0;
+    if (!any_capacity || map.num_reduced == 0)
+        return -1;
+
+    auto start = std::chrono::steady_clock::now();
+    Eigen::VectorXd F_r = map.restrict(forces);
+
+    // current (hinge-condensed) local stiffness and open ends per member
+    std::vector<Matrix6d> k_local(num_beams);
+    std::vector<char> open(2 * num_beams, 0);
+    for (int i = 0; i < num_beams; ++i)
+        k_local[i] = local_stiffness(cache, i);
+
+    UpdatedSolver updated;
+    updated.base = &solver;
+    updated.tolerance = options.mechanism_tolerance;
+
+    // accumulated state
+    double lambda = 0.0;
+    Eigen::VectorXd u = Eigen::VectorXd::Zero(map.total_dof);
+    ElementForces total;
+    total.resize(num_beams);
+    for (int i = 0; i < num_beams; ++i)
+    {
+        total.p1[i] = total.v1[i] = total.m1[i] = 0.0;
+        total.p2[i] = total.v2[i] = total.m2[i] = 0.0;
+        total.stress[i] = 0.0f;
+    }
+
+    auto record = [&]()
+    {
+        PushoverStep step;
+        step.load_factor = lambda;
+        step.control_displacement = out.control_dof >= 0 ? u(out.control_dof) : 0.0;
+        step.hinges = static_cast<int>(out.hinge_sequence.size());
+        if (options.store_steps)
+        {
+            step.displacement = u;
+            step.element_forces = total;
+            if (num_beams > 0)
+            {
+                auto range = std::minmax_element(total.stress.begin(), total.stress.end());
+                step.min_stress = *range.first;
+                step.max_stress = *range.second;
+            }
+        }
+        out.steps.push_back(std::move(step));
+    };
+
+    ElementForces increment;
+    increment.resize(num_beams);
+    Eigen::VectorXd du_r, du;
+    double elastic_norm = 0.0;
+    double control_sign = 1.0;
+    int result = -2;
+
+    for (int event = 0; event <= options.max_events; ++event)
+    {
+        // response to one unit of load factor with the current hinges
+        if (updated.solve(F_r, du_r) != 0)
+        {
+            out.mechanism = true;
+            result = 0;
+            break;
+        }
+        map.expand(du_r, du);
+        double norm = du.lpNorm<Eigen::Infinity>();
+        if (event == 0)
+        {
+            elastic_norm = norm;
+            if (options.control_node >= 0 && options.control_node * 3 + 1 < map.total_dof)
+            {
+                int g = options.control_node * 3;
+                out.control_dof = std::abs(du(g + 1)) > std::abs(du(g)) ? g + 1 : g;
+            }
+            else
+            {
+                // the translation moving most in the elastic step
+                double largest = -1.0;
+                for (int g = 0; g < map.total_dof; ++g)
+                {
+                    if (g % 3 != 2 && std::abs(du(g)) > largest)
+                    {
+                        largest = std::abs(du(g));
+                        out.control_dof = g;
+                    }
+                }
+            }
+            control_sign = du(out.control_dof) < 0.0 ? -1.0 : 1.0;
+            record();
+        }
+        else if (!(norm <= 1e10 * elastic_norm))
+        {
+            out.mechanism = true; // not exactly singular in floating point, but unbounded
+            result = 0;
+            break;
+        }
+
+        // member end forces per unit load factor, and the smallest step to the next yield
+        typedef std::pair<double, int> Candidate;
+        const double no_event = std::numeric_limits<double>::infinity();
+        Candidate next = TaskScheduler::instance().parallel_reduce(
+            0, num_beams, 256, Candidate(no_event, -1),
+            [&](int lo, int hi)
+            {
+                Candidate best(no_event, -1);
+                for (int i = lo; i < hi; ++i)
+                {
+                    Eigen::Matrix<double, 6, 1> f = k_local[i] * (rotation(cache, i) * element_dofs(cache, i, du));
+                    increment.p1[i] = f(0);
+                    increment.v1[i] = f(1);
+                    increment.m1[i] = f(2);
+                    increment.p2[i] = f(3);
+                    increment.v2[i] = f(4);
+                    increment.m2[i] = f(5);
+
+                    double mp = plastic_moment[i];
+                    if (!(mp > 0.0) || cache.ei_over_l[i] <= 0.0)
+                        continue;
+                    for (int end = 0; end < 2; ++end)
+                    {
+                        if (open[2 * i + end])
+                            continue;
+                        double M = end == 0 ? total.m1[i] : total.m2[i];
+                        double dM = end == 0 ? f(2) : f(5);
+                        if (dM == 0.0)
+                            continue;
+                        double step = std::max(((dM > 0.0 ? mp : -mp) - M) / dM, 0.0);
+                        if (step < best.first)
+                            best = Candidate(step, 2 * i + end);
+                    }
+                }
+                return best;
+            },
+            [](const Candidate &a, const Candidate &b)
+            { return b.first < a.first ? b : a; },
+            TaskPriority::High, "pushover_events");
+
+        // advance to the event (or to the load factor limit)
+        double step = next.first;
+        bool limit = next.second < 0 || lambda + step >= options.max_load_factor;
+        if (limit)
+            step = options.max_load_factor - lambda;
+        lambda += step;
+        u += step * du;
+        for (int i = 0; i < num_beams; ++i)
+        {
+            total.p1[i] += step * increment.p1[i];
+            total.v1[i] += step * increment.v1[i];
+            total.m1[i] += step * increment.m1[i];
+            total.p2[i] += step * increment.p2[i];
+            total.v2[i] += step * increment.v2[i];
+            total.m2[i] += step * increment.m2[i];
+            member_stress(cache, total, i);
+        }
+        if (limit)
+        {
+            record();
+            result = 0;
+            break;
+        }
+        if (event == options.max_events)
+        {
+            record();
+            break;
+        }
+
+        // open the hinge: release end rotation q of member e, k -= k_q k_q^T / k_qq
+        int e = next.second >> 1;
+        int end = next.second & 1;
+        int q = end == 0 ? 2 : 5;
+        open[next.second] = 1;
+        out.hinge_sequence.push_back(next.second);
+        record();
+
+        double kqq = k_local[e](q, q);
+        if (kqq > 0.0)
+        {
+            Eigen::Matrix<double, 6, 1> w_local = k_local[e].col(q) / std::sqrt(kqq);
+            k_local[e] -= w_local * w_local.transpose();
+            k_local[e](q, q) = 0.0; // exactly, not by cancellation
+            Eigen::Matrix<double, 6, 1> w = rotation(cache, e).transpose() * w_local;
+            updated.add(reduced_column(map, cache, e, w, -1.0));
+        }
+
+        // a joint whose every bending member is now hinged has nothing left holding its rotation
+        int node = end == 0 ? cache.n1[e] : cache.n2[e];
+        int r = map.index[node * 3 + 2];
+        bool held = false;
+        for (int k = cache.node_offsets[node]; k < cache.node_offsets[node + 1]; ++k)
+        {
+            int m = cache.node_ends[k] >> 1;
+            held |= cache.ei_over_l[m] > 0.0 && !open[cache.node_ends[k]];
+        }
+        if (r >= 0 && !held && kqq > 0.0)
+        {
+            UpdateColumn spring;
+            spring.rows.push_back(r);
+            spring.values.push_back(std::sqrt(kqq));
+            spring.sign = 1.0;
+            updated.add(spring);
+        }
+
+        if (static_cast<int>(updated.columns.size()) > options.max_update_rank)
+        {
+            // rebase: refactor with the condensed members and the joint springs in place
+            std::vector<Matrix6d> element(num_beams);
+            for (int i = 0; i < num_beams; ++i)
+            {
+                Matrix6d T = rotation(cache, i);
+                element[i] = T.transpose() * k_local[i] * T;
+            }
+            SparseMatrix K = assemble_reduced(map, beams, element);
+            for (const UpdateColumn &column : updated.columns)
+            {
+                if (column.sign > 0.0)
+                    K.coeffRef(column.rows[0], column.rows[0]) += column.values[0] * column.values[0];
+            }
+            ++out.refactorizations;
+            updated.columns.clear();
+            updated.capacitance.resize(0, 0);
+            if (solver.factorize(K) != 0)
+            {
+                out.mechanism = true;
+                result = 0;
+                break;
+            }
+        }
+    }
+
+    for (PushoverStep &step : out.steps)
+        step.control_displacement *= control_sign;
+    if (!options.store_steps && !out.steps.empty())
+    {
+        // the final state is always kept, so it can be shown
+        PushoverStep &last = out.steps.back();
+        last.displacement = u;
+        last.element_forces = total;
+        auto range = std::minmax_element(total.stress.begin(), total.stress.end());
+        last.min_stress = *range.first;
+        last.max_stress = *range.second;
+    }
+    out.collapse_load_factor = lambda;
+    out.update_rank = static_cast<int>(updated.columns.size());
+    out.wall_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    if (debug)
+        std::cout << "Pushover: " << out.hinge_sequence.size() << " hinges, load factor " << lambda
+                  << (out.mechanism ? " (mechanism)" : "") << ", " << out.refactorizations << " refactorizations, "
+                  << out.wall_seconds << " s" << std::endl;
+    return result;
+}
@@ -0,0 +1,63 @@
+#pragma once
+#include <vector>
+#include <Eigen/Eigen>
+#include "dof_map.h"
+#include "element_cache.h"
+#include "sparse_solver.h"
+
+struct PushoverOptions
+{
+    double max_load_factor = 100.0; // stop here if no mechanism forms first
+    int max_events = 500;           // hinges inserted before giving up
+    int control_node = -1;          // node whose displacement is plotted (-1: the one moving most)
+    int max_update_rank = 100;      // refactor once the low-rank correction grows past this
+    double mechanism_tolerance = 1e-9; // smallest singular value of the update's capacitance
+                                       // (relative to 1) below which the hinged K is singular
+    bool store_steps = true;        // keep displacement and member forces of every event, not just the last
+};
+
+// state just after one event (step 0 is the unloaded structure)
+struct PushoverStep
+{
+    double load_factor = 0.0;
+    double control_displacement = 0.0; // along the control DOF, positive in the elastic direction
+    int hinges = 0;                    // the first `hinges` entries of hinge_sequence are open
+    Eigen::VectorXd displacement;      // empty unless options.store_steps (or the last step)
+    ElementForces element_forces;
+    float min_stress = 0.0f;
+    float max_stress = 0.0f;
+};
+
+struct PushoverResults
+{
+    std::vector<PushoverStep> steps;
+    std::vector<int> hinge_sequence; // 2 * member + end, in the order the hinges formed
+    int control_dof = -1;
+    bool mechanism = false;          // the last hinge turned the structure into a mechanism
+    double collapse_load_factor = 0.0; // load factor of the last step
+    int refactorizations = 0;
+    int update_rank = 0;             // rank of the low-rank correction at the end
+    double wall_seconds = 0.0;
+};
+
+// First-order event-to-event pushover of forces * lambda with elastic-perfectly-plastic
+// hinges at the member ends. Between events the response is linear, so each event solves
+// for the increment of one unit of load factor, scales it to the smallest step that brings
+// another end moment up to its plastic_moment (per beam, 0: never yields) and opens a hinge
+// there. A hinge releases the end rotation of a single member: its element matrix loses the
+// rank-1 term k_j k_j^T / k_jj, which is applied as a Sherman-Morrison-Woodbury correction of
+// the factorization in `solver` (K of the elastic structure on entry) rather than a
+// refactor. A joint left without any rotational stiffness gets a rotational spring of the
+// released member's end stiffness k_jj back, so K stays nonsingular and equally scaled (the
+// joint carries no moment either way). Stops when the correction turns singular (a collapse mechanism) or
+// at options.max_load_factor. Hinges are not checked for unloading.
+// Returns 0 on success, -1 if no member has a plastic moment, -2 if max_events ran out.
+int plastic_pushover(const DofMap &map,
+                     const std::vector<Beam> &beams,
+                     const ElementCache &cache,
+                     const std::vector<double> &plastic_moment,
+                     const Eigen::VectorXd &forces,
+                     const PushoverOptions &options,
+                     SparseSolver &solver,
+                     PushoverResults &out,
+                     bool debug = false);
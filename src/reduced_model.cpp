@@ -0,0 +1,460 @@
+#include "reduced_model.h"
+#include "task_scheduler.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
+#include <random>
+
+int ReducedModel::build(const std::vector<Node> &nodes,
+                        const std::vector<Beam> &beams,
+                        const std::vector<MaterialProfile> &materials,
+                        const std::vector<BeamProfile> &shapes,
+                        const DofMap &map,
+                        const Eigen::VectorXd &forces,
+                        const std::vector<char> &active,
+                        const std::vector<RomParameter> &parameters,
+                        const SparseSolver &solver)
+{
+    *this = ReducedModel();
+    int num_nodes = static_cast<int>(nodes.size());
+    int num_beams = static_cast<int>(beams.size());
+    int num_materials = static_cast<int>(materials.size());
+    int num_shapes = static_cast<int>(shapes.size());
+    int num_params = static_cast<int>(parameters.size());
+    if (map.num_reduced == 0 || forces.size() != num_nodes * 3)
+        return -1;
+
+    // which parameter (if any) drives each material's modulus and each profile's area and inertia
+    std::vector<int> modulus_of(num_materials, -1), area_of(num_shapes, -1), inertia_of(num_shapes, -1);
+    for (int j = 0; j < num_params; ++j)
+    {
+        const RomParameter &a = parameters[j];
+        if (a.lower > a.upper)
+            return -1;
+        int *slot = nullptr;
+        switch (a.kind)
+        {
+        case RomParameter::Force:
+            if (a.index < 0 || a.index >= num_nodes || a.component < 0 || a.component > 2)
+                return -1;
+            for (int q = 0; q < j; ++q)
+            {
+                if (parameters[q].kind == RomParameter::Force && parameters[q].index == a.index && parameters[q].component == a.component)
+                    return -1;
+            }
+            break;
+        case RomParameter::Modulus:
+            if (a.index < 0 || a.index >= num_materials)
+                return -1;
+            slot = &modulus_of[a.index];
+            break;
+        case RomParameter::Area:
+        case RomParameter::Inertia:
+            if (a.index < 0 || a.index >= num_shapes)
+                return -1;
+            slot = a.kind == RomParameter::Area ? &area_of[a.index] : &inertia_of[a.index];
+            break;
+        }
+        if (slot && *slot >= 0)
+            return -1;
+        if (slot)
+            *slot = j;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    this->map = map;
+    this->beams = beams;
+    this->materials = materials;
+    this->shapes = shapes;
+    this->parameters = parameters;
+    full_solver = solver;
+
+    nominal_values.resize(num_params);
+    Eigen::VectorXd fixed_forces = forces;
+    for (int j = 0; j < num_params; ++j)
+    {
+        const RomParameter &a = parameters[j];
+        switch (a.kind)
+        {
+        case RomParameter::Force:
+            nominal_values[j] = forces(a.index * 3 + a.component);
+            fixed_forces(a.index * 3 + a.component) = 0.0;
+            break;
+        case RomParameter::Modulus:
+            nominal_values[j] = materials[a.index].youngs_modulus;
+            break;
+        case RomParameter::Area:
+            nominal_values[j] = shapes[a.index].area;
+            break;
+        case RomParameter::Inertia:
+            nominal_values[j] = shapes[a.index].moment_of_inertia;
+            break;
+        }
+    }
+    F.push_back(map.restrict(fixed_forces));
+    for (const RomParameter &a : parameters)
+    {
+        if (a.kind != RomParameter::Force)
+            continue;
+        Eigen::VectorXd unit = Eigen::VectorXd::Zero(num_nodes * 3);
+        unit(a.index * 3 + a.component) = 1.0;
+        F.push_back(map.restrict(unit));
+    }
+
+    // split every member's stiffness into the constant term and one term per (material,
+    // profile) pair and part (axial, bending) whose factor varies
+    forms.resize(num_beams);
+    carries.resize(num_beams);
+    std::vector<Matrix6d> constant(num_beams);
+    std::vector<std::vector<int>> term_members;
+    term_material.push_back(-1);
+    term_profile.push_back(-1);
+    term_bending.push_back(0);
+    term_members.emplace_back();
+    auto term_of = [&](int material, int profile, bool bending)
+    {
+        for (size_t t = 1; t < term_material.size(); ++t)
+        {
+            if (term_material[t] == material && term_profile[t] == profile && term_bending[t] == bending)
+                return static_cast<int>(t);
+        }
+        term_material.push_back(material);
+        term_profile.push_back(profile);
+        term_bending.push_back(bending);
+        term_members.emplace_back();
+        return static_cast<int>(term_material.size()) - 1;
+    };
+    for (int i = 0; i < num_beams; ++i)
+    {
+        const Beam &beam = beams[i];
+        double dx = nodes[beam.nodes[1]].position[0] - nodes[beam.nodes[0]].position[0];
+        double dy = nodes[beam.nodes[1]].position[1] - nodes[beam.nodes[0]].position[1];
+        carries[i] = member_form(dx, dy, forms[i]) && (active.empty() || active[i]);
+        constant[i].setZero(); // kept as structural zeros
+        if (!carries[i])
+            continue;
+        int m = beam.material_idx, p = beam.shape_idx;
+        double E = materials[m].youngs_modulus;
+        if (modulus_of[m] >= 0 || area_of[p] >= 0)
+            term_members[term_of(m, p, false)].push_back(i);
+        else
+            constant[i] += E * shapes[p].area * forms[i].axial;
+        if (beam.is_truss)
+            continue;
+        if (modulus_of[m] >= 0 || inertia_of[p] >= 0)
+            term_members[term_of(m, p, true)].push_back(i);
+        else
+            constant[i] += E * shapes[p].moment_of_inertia * forms[i].bending;
+    }
+
+    // term 0 carries the full pattern, so every K(mu) has the one `solver` was ordered for
+    K.push_back(assemble_reduced(map, beams, constant));
+    for (size_t t = 1; t < term_members.size(); ++t)
+    {
+        std::vector<Matrix6d> unit(num_beams, Matrix6d::Zero());
+        for (int i : term_members[t])
+            unit[i] = term_bending[t] ? forms[i].bending : forms[i].axial;
+        SparseMatrix k = assemble_reduced(map, beams, unit);
+        k.prune([](const int &, const int &, const double &value) { return value != 0.0; });
+        K.push_back(k);
+    }
+
+    int num_terms = static_cast<int>(K.size());
+    V.resize(map.num_reduced, 0);
+    KV.assign(num_terms, Eigen::MatrixXd(0, 0));
+    FV.resize(0, F.size());
+    gram.resize(F.size(), F.size());
+    for (size_t i = 0; i < F.size(); ++i)
+    {
+        for (size_t k = 0; k <= i; ++k)
+            gram(i, k) = gram(k, i) = F[i].dot(F[k]);
+    }
+    build_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return 0;
+}
+
+void ReducedModel::stiffness_weights(const std::vector<double> &mu, Eigen::VectorXd &theta) const
+{
+    // current moduli and sections, the parameters overriding the model's values
+    std::vector<double> E(materials.size()), A(shapes.size()), I(shapes.size());
+    for (size_t m = 0; m < materials.size(); ++m)
+        E[m] = materials[m].youngs_modulus;
+    for (size_t p = 0; p < shapes.size(); ++p)
+    {
+        A[p] = shapes[p].area;
+        I[p] = shapes[p].moment_of_inertia;
+    }
+    for (size_t j = 0; j < parameters.size(); ++j)
+    {
+        const RomParameter &a = parameters[j];
+        if (a.kind == RomParameter::Modulus)
+            E[a.index] = mu[j];
+        else if (a.kind == RomParameter::Area)
+            A[a.index] = mu[j];
+        else if (a.kind == RomParameter::Inertia)
+            I[a.index] = mu[j];
+    }
+
+    theta.resize(K.size());
+    theta(0) = 1.0;
+    for (size_t t = 1; t < K.size(); ++t)
+        theta(t) = E[term_material[t]] * (term_bending[t] ? I[term_profile[t]] : A[term_profile[t]]);
+}
+
+void ReducedModel::force_weights(const std::vector<double> &mu, Eigen::VectorXd &phi) const
+{
+    phi.resize(F.size());
+    phi(0) = 1.0;
+    int k = 1;
+    for (size_t j = 0; j < parameters.size(); ++j)
+    {
+        if (parameters[j].kind == RomParameter::Force)
+            phi(k++) = mu[j];
+    }
+}
+
+bool ReducedModel::valid(const std::vector<double> &mu) const
+{
+    if (mu.size() != parameters.size() || K.empty())
+        return false;
+    for (size_t j = 0; j < parameters.size(); ++j)
+    {
+        if (!std::isfinite(mu[j]))
+            return false;
+        if ((parameters[j].kind == RomParameter::Modulus || parameters[j].kind == RomParameter::Area) && mu[j] <= 0.0)
+            return false;
+        if (parameters[j].kind == RomParameter::Inertia && mu[j] < 0.0)
+            return false;
+    }
+    return true;
+}
+
+int ReducedModel::add_snapshot(const std::vector<double> &mu)
+{
+    if (!valid(mu))
+        return -1;
+
+    Eigen::VectorXd theta, phi;
+    stiffness_weights(mu, theta);
+    force_weights(mu, phi);
+    SparseMatrix A = K[0];
+    for (size_t t = 1; t < K.size(); ++t)
+        A += theta(t) * K[t];
+    if (full_solver.factorize(A) != 0)
+        return -1;
+    ++snapshots;
+    Eigen::VectorXd b = Eigen::VectorXd::Zero(map.num_reduced);
+    for (size_t i = 0; i < F.size(); ++i)
+        b += phi(i) * F[i];
+    Eigen::VectorXd x = full_solver.solve(b);
+
+    // Gram-Schmidt, twice for orthogonality to round-off
+    double norm = x.norm();
+    Eigen::VectorXd v = x;
+    for (int pass = 0; pass < 2 && V.cols() > 0; ++pass)
+        v -= V * (V.transpose() * v);
+    if (!(v.norm() > 1e-10 * norm))
+        return 1;
+    v /= v.norm();
+
+    int r = static_cast<int>(V.cols());
+    int num_terms = static_cast<int>(K.size());
+    int num_forces = static_cast<int>(F.size());
+    V.conservativeResize(Eigen::NoChange, r + 1);
+    V.col(r) = v;
+
+    // projections, one new row and column each
+    std::vector<Eigen::VectorXd> w(num_terms);
+    for (int t = 0; t < num_terms; ++t)
+    {
+        w[t] = K[t] * v;
+        Eigen::VectorXd column = V.transpose() * w[t];
+        KV[t].conservativeResize(r + 1, r + 1);
+        KV[t].col(r) = column;
+        KV[t].row(r) = column.transpose();
+    }
+    FV.conservativeResize(r + 1, Eigen::NoChange);
+    for (int i = 0; i < num_forces; ++i)
+        FV(r, i) = v.dot(F[i]);
+
+    // Gram matrix of the residual's terms: K_t v for every term is appended after the
+    // existing ones (ordered basis vector by basis vector)
+    int old_size = static_cast<int>(gram.rows());
+    gram.conservativeResize(old_size + num_terms, old_size + num_terms);
+    for (int t = 0; t < num_terms; ++t)
+    {
+        for (int i = 0; i < num_forces; ++i)
+            gram(old_size + t, i) = gram(i, old_size + t) = w[t].dot(F[i]);
+        for (int s = 0; s <= t; ++s)
+            gram(old_size + t, old_size + s) = gram(old_size + s, old_size + t) = w[t].dot(w[s]);
+    }
+    if (r > 0)
+    {
+        // against the earlier K_s v_j, recomputed per term rather than stored (n x r each)
+        TaskScheduler::instance().parallel_for(
+            0, num_terms, 1, [&](int lo, int hi)
+            {
+                for (int s = lo; s < hi; ++s)
+                {
+                    Eigen::MatrixXd KsV = K[s] * V.leftCols(r);
+                    for (int t = 0; t < num_terms; ++t)
+                    {
+                        Eigen::VectorXd products = KsV.transpose() * w[t];
+                        for (int j = 0; j < r; ++j)
+                        {
+                            int old = num_forces + j * num_terms + s;
+                            gram(old_size + t, old) = gram(old, old_size + t) = products(j);
+                        }
+                    }
+                } },
+            TaskPriority::High, "rom_gram");
+    }
+    return 0;
+}
+
+int ReducedModel::query(const std::vector<double> &mu, RomQuery &out) const
+{
+    auto start = std::chrono::steady_clock::now();
+    out = RomQuery();
+    int r = size();
+    if (r == 0 || !valid(mu))
+        return -1;
+
+    Eigen::VectorXd theta, phi;
+    stiffness_weights(mu, theta);
+    force_weights(mu, phi);
+    Eigen::MatrixXd Kr = KV[0];
+    for (size_t t = 1; t < KV.size(); ++t)
+        Kr += theta(t) * KV[t];
+    Eigen::LDLT<Eigen::MatrixXd> ldlt(Kr);
+    if (ldlt.info() != Eigen::Success || !ldlt.isPositive())
+        return -1;
+    out.coefficients = ldlt.solve(FV * phi);
+
+    // |F - K V a|^2 = c^T G c, c = (phi, -theta_t a_j)
+    int num_terms = static_cast<int>(KV.size());
+    int num_forces = static_cast<int>(F.size());
+    Eigen::VectorXd c(gram.rows());
+    c.head(num_forces) = phi;
+    for (int j = 0; j < r; ++j)
+        c.segment(num_forces + j * num_terms, num_terms) = -out.coefficients(j) * theta;
+    double residual = c.dot(gram * c);
+    double load = phi.dot(gram.topLeftCorner(num_forces, num_forces) * phi);
+    out.estimate = load > 0.0 ? std::sqrt(std::max(residual, 0.0) / load) : 0.0;
+    out.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return 0;
+}
+
+int ReducedModel::solve(const std::vector<double> &mu, double tolerance, int max_basis, RomQuery &out)
+{
+    int result = query(mu, out);
+    if (result == 0 && (out.estimate <= tolerance || size() >= max_basis))
+        return 0;
+    if (!valid(mu) || add_snapshot(mu) < 0)
+        return -1;
+    if (query(mu, out) != 0)
+        return -1;
+    out.enriched = true;
+    return 1;
+}
+
+int ReducedModel::train(const RomOptions &options)
+{
+    auto start = std::chrono::steady_clock::now();
+    int num_params = parameter_count();
+    if (K.empty())
+        return -1;
+
+    // training points spread uniformly over the box
+    int count = std::max(options.training_points, 1);
+    std::mt19937 rng(options.seed);
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+    std::vector<std::vector<double>> points(count, std::vector<double>(num_params));
+    for (int k = 0; k < count; ++k)
+    {
+        for (int j = 0; j < num_params; ++j)
+            points[k][j] = parameters[j].lower + (parameters[j].upper - parameters[j].lower) * uniform(rng);
+    }
+
+    int added = 0;
+    if (size() == 0)
+    {
+        // the middle of the box first
+        std::vector<double> middle(num_params);
+        for (int j = 0; j < num_params; ++j)
+            middle[j] = 0.5 * (parameters[j].lower + parameters[j].upper);
+        if (add_snapshot(middle) < 0)
+            return -1;
+        ++added;
+    }
+
+    std::vector<double> estimate(count);
+    while (size() < options.max_basis)
+    {
+        TaskScheduler::instance().parallel_for(
+            0, count, 16, [&](int lo, int hi)
+            {
+                RomQuery q;
+                for (int k = lo; k < hi; ++k)
+                    estimate[k] = query(points[k], q) == 0 ? q.estimate : std::numeric_limits<double>::infinity();
+            },
+            TaskPriority::High, "rom_training");
+        int worst = static_cast<int>(std::max_element(estimate.begin(), estimate.end()) - estimate.begin());
+        training_error.push_back(estimate[worst]);
+        if (estimate[worst] <= options.tolerance)
+            break;
+        int result = add_snapshot(points[worst]);
+        if (result < 0)
+            return -1;
+        if (result == 1)
+            break; // already in the span: the estimate is round-off
+        ++added;
+    }
+    train_seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return added;
+}
+
+void ReducedModel::displacements(const RomQuery &q, Eigen::VectorXd &u) const
+{
+    if (q.coefficients.size() != size())
+    {
+        u = Eigen::VectorXd::Zero(map.total_dof);
+        return;
+    }
+    map.expand(V * q.coefficients, u);
+}
+
+double ReducedModel::max_stress(const std::vector<double> &mu, const Eigen::VectorXd &u) const
+{
+    if (!valid(mu) || u.size() != map.total_dof)
+        return 0.0;
+    std::vector<double> E(materials.size()), I(shapes.size());
+    for (size_t m = 0; m < materials.size(); ++m)
+        E[m] = materials[m].youngs_modulus;
+    for (size_t p = 0; p < shapes.size(); ++p)
+        I[p] = shapes[p].moment_of_inertia;
+    for (size_t j = 0; j < parameters.size(); ++j)
+    {
+        if (parameters[j].kind == RomParameter::Modulus)
+            E[parameters[j].index] = mu[j];
+        else if (parameters[j].kind == RomParameter::Inertia)
+            I[parameters[j].index] = mu[j];
+    }
+
+    double largest = 0.0;
+    Vector6d d;
+    for (size_t i = 0; i < beams.size(); ++i)
+    {
+        if (!carries[i])
+            continue;
+        const Beam &beam = beams[i];
+        const MemberForm &f = forms[i];
+        double e = E[beam.material_idx];
+        double ei = beam.is_truss ? 0.0 : e * I[beam.shape_idx];
+        double inv_z = inverse_section_modulus(shapes[beam.shape_idx].section_modulus);
+        d << u.segment<3>(beam.nodes[0] * 3), u.segment<3>(beam.nodes[1] * 3);
+        largest = std::max(largest, member_combined_stress(f, e, ei, inv_z, d));
+    }
+    return largest;
+}
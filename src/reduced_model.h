@@ -0,0 +1,130 @@
+#pragma once
+#include <vector>
+#include <Eigen/Eigen>
+#include "node.h"
+#include "beam.h"
+#include "beam_props.h"
+#include "dof_map.h"
+#include "sparse_solver.h"
+#include "sensitivity.h"
+
+// One input the reduced model answers queries for. K and F are affine in these (K is a sum of
+// E*A and E*I times fixed matrices, F a sum of force components), which is what lets a query
+// skip the full model; coordinates and slider angles are not, so they are not offered.
+struct RomParameter
+{
+    enum Kind
+    {
+        Force,   // forces(index * 3 + component): N, or N m for component 2
+        Modulus, // youngs_modulus of material `index`, Pa
+        Area,    // of profile `index`, m^2
+        Inertia  // of profile `index`, m^4
+    };
+
+    Kind kind = Force;
+    int index = 0;
+    int component = 1;
+    double lower = 0.0; // training range
+    double upper = 1.0;
+};
+
+struct RomOptions
+{
+    std::vector<RomParameter> parameters;
+    double tolerance = 1e-4;   // on the estimated relative residual |F - K V a| / |F|
+    int max_basis = 60;
+    int training_points = 256; // random points of the parameter box the greedy training checks
+    unsigned seed = 1;
+};
+
+// Answer to one query: the reduced coordinates and how far they can be trusted
+struct RomQuery
+{
+    Eigen::VectorXd coefficients; // u_reduced ~ V * coefficients
+    double estimate = 0.0;        // relative residual, without forming it
+    bool enriched = false;        // a full solve was added to the basis for this query
+    double seconds = 0.0;
+};
+
+// Reduced-basis (POD/greedy) model of the static solve. V holds orthonormalized snapshot
+// solutions of the full sparse system; a query projects K(mu) = K0 + sum theta_q(mu) K_q and
+// F(mu) onto V from matrices precomputed once per basis vector and solves an r x r dense system.
+// The residual norm comes from a precomputed Gram matrix of the residual's affine terms, so
+// neither the estimate nor the solve touches anything of the full model's size.
+class ReducedModel
+{
+public:
+    // affine terms for `parameters` around the model's current values; `solver` (K in `map`'s
+    // numbering) lends its ordering to the snapshot solves. Members with `active` 0 stay slack.
+    // Returns 0 on success, -1 if a parameter names something that does not exist, repeats
+    // another one or has lower > upper.
+    int build(const std::vector<Node> &nodes,
+              const std::vector<Beam> &beams,
+              const std::vector<MaterialProfile> &materials,
+              const std::vector<BeamProfile> &shapes,
+              const DofMap &map,
+              const Eigen::VectorXd &forces,
+              const std::vector<char> &active,
+              const std::vector<RomParameter> &parameters,
+              const SparseSolver &solver);
+
+    // greedy training: enrich at the training point with the largest estimate until every one
+    // is below options.tolerance or the basis is full. Returns the number of snapshots added,
+    // -1 if a snapshot solve failed (singular K).
+    int train(const RomOptions &options);
+
+    // reduced solve at `mu` (one value per parameter); -1 if the basis is empty or mu is invalid
+    int query(const std::vector<double> &mu, RomQuery &out) const;
+
+    // query, then a full solve and enrichment if the estimate exceeds `tolerance` (and the
+    // basis has room). Returns 1 if it enriched, 0 if not, -1 on failure.
+    int solve(const std::vector<double> &mu, double tolerance, int max_basis, RomQuery &out);
+
+    // full snapshot solve at mu added to the basis; 0 on success, 1 if it already lay in the
+    // span, -1 if K(mu) is singular
+    int add_snapshot(const std::vector<double> &mu);
+
+    // global displacements and the largest |combined stress| of a query at its mu
+    void displacements(const RomQuery &q, Eigen::VectorXd &u) const;
+    double max_stress(const std::vector<double> &mu, const Eigen::VectorXd &u) const;
+
+    int size() const { return static_cast<int>(V.cols()); }
+    int dofs() const { return static_cast<int>(V.rows()); }
+    int parameter_count() const { return static_cast<int>(parameters.size()); }
+    const std::vector<RomParameter> &get_parameters() const { return parameters; }
+    const std::vector<double> &nominal() const { return nominal_values; } // the model's own values
+
+    int snapshots = 0;                  // full solves so far
+    std::vector<double> training_error; // largest training estimate before each enrichment
+    double build_seconds = 0.0;         // affine terms
+    double train_seconds = 0.0;         // snapshots, projections and training queries
+
+private:
+    // theta_q(mu) of every stiffness term (term 0 is the constant part, theta = 1)
+    void stiffness_weights(const std::vector<double> &mu, Eigen::VectorXd &theta) const;
+    // F(mu) = F0 + sum mu_j e_j over the force parameters: weights (1, mu_j...)
+    void force_weights(const std::vector<double> &mu, Eigen::VectorXd &phi) const;
+    bool valid(const std::vector<double> &mu) const;
+
+    DofMap map;
+    std::vector<Beam> beams;
+    std::vector<MaterialProfile> materials;
+    std::vector<BeamProfile> shapes;
+    std::vector<MemberForm> forms;
+    std::vector<char> carries;
+    std::vector<RomParameter> parameters;
+    std::vector<double> nominal_values;
+
+    // stiffness terms: K(mu) = sum theta_q K_q, K_q of the members of one (material, profile)
+    // pair's axial or bending part; term_material / term_profile say what theta_q multiplies
+    std::vector<SparseMatrix> K;
+    std::vector<int> term_material, term_profile;
+    std::vector<char> term_bending;
+    std::vector<Eigen::VectorXd> F; // F0, then one unit vector per force parameter (reduced)
+
+    Eigen::MatrixXd V;                  // orthonormal basis, reduced DOFs x r
+    std::vector<Eigen::MatrixXd> KV;    // V^T K_q V
+    Eigen::MatrixXd FV;                 // V^T F_i, r x force terms
+    Eigen::MatrixXd gram;               // inner products of F_i and K_q v_j, in that order
+    SparseSolver full_solver;
+};
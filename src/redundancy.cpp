@@ -0,0 +1,228 @@
+#include "redundancy.h"
+#include "sensitivity.h"
+#include "task_scheduler.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+
+int scan_redundancy(const std::vector<Node> &nodes,
+                    const std::vector<Beam> &beams,
+                    const std::vector<MaterialProfile> &materials,
+                    const std::vector<BeamProfile> &shapes,
+                    const DofMap &map,
+                    const ElementCache &cache,
+                    const Eigen::VectorXd &forces,
+                    const std::vector<char> &active,
+                    const RedundancyOptions &options,
+                    const SparseSolver &solver,
+                    RedundancyResults &out)
+{
+    out = RedundancyResults();
+    int num_nodes = static_cast<int>(nodes.size());
+    int num_beams = static_cast<int>(beams.size());
+    if (map.num_reduced == 0 || !solver.factored() || solver.rows() != map.num_reduced || cache.count != num_beams ||
+        forces.size() != num_nodes * 3)
+        return -1;
+
+    auto start = std::chrono::steady_clock::now();
+
+    // each member's stiffness and stress recovery at the model's sections
+    std::vector<MemberForm> forms(num_beams);
+    std::vector<Matrix6d> element(num_beams);
+    std::vector<double> E(num_beams), EI(num_beams), inv_z(num_beams);
+    std::vector<char> carries(num_beams);
+    for (int i = 0; i < num_beams; ++i)
+    {
+        const Beam &beam = beams[i];
+        double dx = nodes[beam.nodes[1]].position[0] - nodes[beam.nodes[0]].position[0];
+        double dy = nodes[beam.nodes[1]].position[1] - nodes[beam.nodes[0]].position[1];
+        carries[i] = member_form(dx, dy, forms[i]) && (active.empty() || active[i]);
+        const BeamProfile &shape = shapes[beam.shape_idx];
+        E[i] = materials[beam.material_idx].youngs_modulus;
+        EI[i] = beam.is_truss ? 0.0 : E[i] * shape.moment_of_inertia;
+        inv_z[i] = inverse_section_modulus(shape.section_modulus);
+        if (carries[i])
+            element[i] = E[i] * shape.area * forms[i].axial + EI[i] * forms[i].bending;
+    }
+    auto stress = [&](const Eigen::VectorXd &u, int i)
+    {
+        Vector6d d;
+        d << u.segment<3>(beams[i].nodes[0] * 3), u.segment<3>(beams[i].nodes[1] * 3);
+        return member_combined_stress(forms[i], E[i], EI[i], inv_z[i], d);
+    };
+
+    Eigen::VectorXd f = map.restrict(forces);
+    Eigen::VectorXd x0 = solver.solve(f);
+    Eigen::VectorXd u0;
+    map.expand(x0, u0);
+    std::vector<int> candidates;
+    for (int i = 0; i < num_beams; ++i)
+    {
+        if (!carries[i])
+            continue;
+        candidates.push_back(i);
+        out.intact_max_stress = std::max(out.intact_max_stress, stress(u0, i));
+    }
+
+    int num_candidates = static_cast<int>(candidates.size());
+    std::vector<MemberRemoval> removals(num_candidates);
+    std::atomic<int> solves{1};
+    TaskScheduler::instance().parallel_for(
+        0, num_candidates, 1, [&](int lo, int hi)
+        {
+            Eigen::VectorXd column(map.num_reduced), x, u;
+            for (int c = lo; c < hi; ++c)
+            {
+                int i = candidates[c];
+                const Beam &beam = beams[i];
+                MemberRemoval &r = removals[c];
+                r.member = i;
+
+                // the member's element matrix on its reduced rows (sliders fold two DOFs onto one)
+                std::vector<int> rows;
+                Eigen::Matrix<double, 6, Eigen::Dynamic> P = Eigen::Matrix<double, 6, Eigen::Dynamic>::Zero(6, 6);
+                for (int a = 0; a < 6; ++a)
+                {
+                    int g = beam.nodes[a / 3] * 3 + a % 3;
+                    if (map.index[g] < 0)
+                        continue;
+                    int local = static_cast<int>(std::find(rows.begin(), rows.end(), map.index[g]) - rows.begin());
+                    if (local == static_cast<int>(rows.size()))
+                        rows.push_back(map.index[g]);
+                    P(a, local) += map.scale[g];
+                }
+                int R = static_cast<int>(rows.size());
+                Eigen::MatrixXd k = P.leftCols(R).transpose() * element[i] * P.leftCols(R);
+                Eigen::MatrixXd delta = -k;
+
+                // an end the member leaves without a carrying member, or with truss members only,
+                // keeps its diagonal stiffness on the DOFs nothing else restrains
+                bool hanging_load = false;
+                for (int end = 0; end < 2; ++end)
+                {
+                    int n = beam.nodes[end];
+                    int others = 0, frames = 0;
+                    for (int e = cache.node_offsets[n]; e < cache.node_offsets[n + 1]; ++e)
+                    {
+                        int j = cache.node_ends[e] >> 1;
+                        if (j == i || !carries[j])
+                            continue;
+                        ++others;
+                        frames += !beams[j].is_truss;
+                    }
+                    for (int dof = 0; dof < 3; ++dof)
+                    {
+                        int row = map.index[n * 3 + dof];
+                        if (row < 0 || !(others == 0 || (dof == 2 && frames == 0)))
+                            continue;
+                        int local = static_cast<int>(std::find(rows.begin(), rows.end(), row) - rows.begin());
+                        if (local == R || k(local, local) <= 0.0)
+                            continue;
+                        delta(local, local) += k(local, local);
+                        hanging_load = hanging_load || f(row) != 0.0;
+                    }
+                }
+                if (hanging_load)
+                {
+                    r.outcome = MemberRemoval::Mechanism;
+                    continue;
+                }
+
+                // K - k = K + U L U^T with the nonzero eigenpairs of the update
+                x = x0;
+                if (R > 0)
+                {
+                    Eigen::SelfAdjointEigenSolver<Eigen::MatrixXd> eig(delta);
+                    double largest = eig.eigenvalues().cwiseAbs().maxCoeff();
+                    std::vector<int> keep;
+                    for (int m = 0; m < R; ++m)
+                    {
+                        if (std::abs(eig.eigenvalues()(m)) > 1e-12 * largest)
+                            keep.push_back(m);
+                    }
+                    int rank = static_cast<int>(keep.size());
+                    Eigen::MatrixXd U(R, rank), Z(map.num_reduced, rank), z_rows(R, rank);
+                    Eigen::VectorXd L(rank);
+                    for (int m = 0; m < rank; ++m)
+                    {
+                        U.col(m) = eig.eigenvectors().col(keep[m]);
+                        L(m) = eig.eigenvalues()(keep[m]);
+                        column.setZero();
+                        for (int a = 0; a < R; ++a)
+                            column(rows[a]) = U(a, m);
+                        Z.col(m) = solver.solve(column);
+                    }
+                    solves += rank;
+
+                    // (K + U L U^T)^-1 f = x0 - Z (I + L U^T Z)^-1 L U^T x0
+                    Eigen::VectorXd x_rows(R);
+                    for (int a = 0; a < R; ++a)
+                    {
+                        z_rows.row(a) = Z.row(rows[a]);
+                        x_rows(a) = x0(rows[a]);
+                    }
+                    if (rank > 0)
+                    {
+                        Eigen::MatrixXd capacitance = Eigen::MatrixXd::Identity(rank, rank) + L.asDiagonal() * (U.transpose() * z_rows);
+
+                        // K - k is singular exactly when the capacitance is (det(K + U L U^T) =
+                        // det(K) det(I + L U^T Z)); unlike rcond(), the smallest singular value
+                        // is measured against the identity, so a 1x1 capacitance still counts
+                        Eigen::JacobiSVD<Eigen::MatrixXd> svd(capacitance);
+                        double smallest = svd.singularValues()(rank - 1);
+                        if (!(smallest > options.mechanism_tolerance * std::max(1.0, svd.singularValues()(0))))
+                        {
+                            r.outcome = MemberRemoval::Mechanism;
+                            continue;
+                        }
+                        Eigen::PartialPivLU<Eigen::MatrixXd> lu(capacitance);
+                        x -= Z * lu.solve(L.cwiseProduct(U.transpose() * x_rows));
+                    }
+                }
+                if (!x.allFinite())
+                {
+                    r.outcome = MemberRemoval::Mechanism;
+                    continue;
+                }
+
+                map.expand(x, u);
+                for (int j : candidates)
+                {
+                    if (j == i)
+                        continue;
+                    double s = stress(u, j);
+                    if (s > r.max_stress)
+                    {
+                        r.max_stress = s;
+                        r.critical_member = j;
+                    }
+                    r.overstressed += s > options.stress_limit;
+                }
+                for (int n = 0; n < num_nodes; ++n)
+                    r.max_displacement = std::max(r.max_displacement, std::hypot(u(n * 3), u(n * 3 + 1)));
+                r.stress_ratio = out.intact_max_stress > 0.0 ? r.max_stress / out.intact_max_stress : 0.0;
+                r.outcome = r.overstressed > 0 ? MemberRemoval::Overstress : MemberRemoval::Redundant;
+            } },
+        TaskPriority::High, "redundancy_scan");
+
+    // mechanisms first, then by the largest remaining stress
+    std::sort(removals.begin(), removals.end(), [](const MemberRemoval &a, const MemberRemoval &b)
+              {
+                  bool a_mechanism = a.outcome == MemberRemoval::Mechanism;
+                  bool b_mechanism = b.outcome == MemberRemoval::Mechanism;
+                  if (a_mechanism != b_mechanism)
+                      return a_mechanism;
+                  if (a.max_stress != b.max_stress)
+                      return a.max_stress > b.max_stress;
+                  return a.member < b.member; });
+    for (const MemberRemoval &r : removals)
+    {
+        out.mechanisms += r.outcome == MemberRemoval::Mechanism;
+        out.overstressing += r.outcome == MemberRemoval::Overstress;
+    }
+    out.removals = std::move(removals);
+    out.solves = solves;
+    out.wall_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return 0;
+}
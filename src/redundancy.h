@@ -0,0 +1,67 @@
+#pragma once
+#include <vector>
+#include <Eigen/Eigen>
+#include "node.h"
+#include "beam.h"
+#include "beam_props.h"
+#include "dof_map.h"
+#include "element_cache.h"
+#include "sparse_solver.h"
+
+struct RedundancyOptions
+{
+    double stress_limit = 165e6;       // Pa, on |combined stress| of the remaining members
+    double mechanism_tolerance = 1e-9; // smallest singular value of the downdate's capacitance
+                                       // (relative to 1) below which the remaining K is singular
+};
+
+// The structure's response with one member removed
+struct MemberRemoval
+{
+    enum Outcome
+    {
+        Redundant,  // the rest carries the loads within the stress limit
+        Overstress, // the rest carries the loads, some member above the limit
+        Mechanism   // the rest cannot carry the loads (K singular, or a loaded node left hanging)
+    };
+
+    int member = -1;
+    Outcome outcome = Redundant;
+    double max_stress = 0.0;       // Pa, largest |combined stress| of the remaining members
+    int critical_member = -1;      // where it occurs
+    double stress_ratio = 0.0;     // max_stress / the intact structure's largest stress
+    int overstressed = 0;          // remaining members above the limit
+    double max_displacement = 0.0; // m, largest node translation
+};
+
+struct RedundancyResults
+{
+    std::vector<MemberRemoval> removals; // every carrying member, most severe first
+    double intact_max_stress = 0.0;      // Pa
+    int mechanisms = 0;
+    int overstressing = 0;
+    int solves = 0; // back-substitutions on the intact factorization
+    double wall_seconds = 0.0;
+};
+
+// Removes each carrying member in turn and reanalyses the rest for the loads `forces`, without
+// refactoring: the member's reduced element matrix has rank 1 (truss) or 3 (frame), so K minus
+// it is a low-rank downdate of `solver`'s factorization of K (in `map`'s numbering), solved with
+// the Woodbury identity from a few back-substitutions. A node the member leaves hanging (or a
+// rotation only it restrained) keeps the member's diagonal stiffness so it does not make K
+// singular; the removal is a mechanism if that node is loaded. Removals run in parallel and are
+// ranked mechanisms first, then by largest remaining stress. Members with `active` 0 (slack
+// one-way members) carry nothing and are not removed; the active set is held fixed, so a slack
+// member stays slack after a removal even if it would then be loaded.
+// Returns 0 on success, -1 if `solver` holds no factorization of the model.
+int scan_redundancy(const std::vector<Node> &nodes,
+                    const std::vector<Beam> &beams,
+                    const std::vector<MaterialProfile> &materials,
+                    const std::vector<BeamProfile> &shapes,
+                    const DofMap &map,
+                    const ElementCache &cache,
+                    const Eigen::VectorXd &forces,
+                    const std::vector<char> &active,
+                    const RedundancyOptions &options,
+                    const SparseSolver &solver,
+                    RedundancyResults &out);
@@ -0,0 +1,375 @@
+#include "reliability.h"
+#include "sensitivity.h"
+#include "task_scheduler.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <limits>
+#include <memory>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+namespace
+{
+    // SplitMix64's finalizer: a bijection that scrambles every input bit into every output bit
+    std::uint64_t mix(std::uint64_t z)
+    {
+        z += 0x9e3779b97f4a7c15ULL;
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+        return z ^ (z >> 31);
+    }
+
+    // uniform in (0, 1), a pure function of its counters
+    double uniform(std::uint64_t seed, std::uint64_t sample, std::uint64_t stream)
+    {
+        std::uint64_t bits = mix(mix(mix(seed) ^ sample) ^ stream);
+        return (static_cast<double>(bits >> 11) + 0.5) * (1.0 / 9007199254740992.0);
+    }
+
+    double draw(const RandomVariable &v, std::uint64_t seed, std::uint64_t sample, int variable)
+    {
+        double u1 = uniform(seed, sample, 2 * static_cast<std::uint64_t>(variable));
+        double u2 = uniform(seed, sample, 2 * static_cast<std::uint64_t>(variable) + 1);
+        double z = std::sqrt(-2.0 * std::log(u1)) * std::cos(2.0 * M_PI * u2); // Box-Muller
+        switch (v.distribution)
+        {
+        case RandomVariable::Normal:
+            break;
+        case RandomVariable::Lognormal:
+        {
+            double cov = v.deviation / v.mean;
+            double sigma2 = std::log(1.0 + cov * cov);
+            return std::exp(std::log(v.mean) - 0.5 * sigma2 + std::sqrt(sigma2) * z);
+        }
+        case RandomVariable::Uniform:
+            return v.mean + std::sqrt(3.0) * v.deviation * (2.0 * u1 - 1.0);
+        }
+        return v.mean + v.deviation * z;
+    }
+
+    // running mean and sum of squared deviations (Welford) of one chunk of samples
+    struct Moments
+    {
+        int count = 0;
+        std::vector<double> mean;
+        std::vector<double> m2;
+    };
+
+    // One copy of the varied model plus the order-independent counts of the samples it ran
+    struct Worker
+    {
+        std::vector<MaterialProfile> materials;
+        std::vector<BeamProfile> shapes;
+        Eigen::VectorXd forces;
+        std::vector<Matrix6d> element;
+        SparseSolver solver;
+        Eigen::VectorXd u;
+        std::vector<double> stress; // per member, then the largest
+        std::vector<double> min, max;
+        std::vector<int> exceeded;
+        std::vector<int> histogram; // bins per member, member-major
+        int failures = 0;
+        int unsolvable = 0;
+    };
+} // namespace
+
+int run_reliability(const std::vector<Node> &nodes,
+                    const std::vector<Beam> &beams,
+                    const std::vector<MaterialProfile> &materials,
+                    const std::vector<BeamProfile> &shapes,
+                    const DofMap &map,
+                    const ElementCache &cache,
+                    const Eigen::VectorXd &forces,
+                    const std::vector<char> &active,
+                    const ReliabilityOptions &options,
+                    const SparseSolver &solver,
+                    ReliabilityResults &out)
+{
+    out = ReliabilityResults();
+    int num_nodes = static_cast<int>(nodes.size());
+    int num_beams = static_cast<int>(beams.size());
+    int num_vars = static_cast<int>(options.variables.size());
+    if (map.num_reduced == 0 || cache.count != num_beams || forces.size() != num_nodes * 3 ||
+        options.samples < 1 || options.batch < 1 || options.bins < 1 || options.stress_limit <= 0.0)
+        return -1;
+
+    for (int v = 0; v < num_vars; ++v)
+    {
+        const RandomVariable &a = options.variables[v];
+        int count = a.kind == RandomVariable::Modulus ? static_cast<int>(materials.size())
+                                                      : (a.kind == RandomVariable::Area ? static_cast<int>(shapes.size()) : num_nodes);
+        if (a.index < 0 || a.index >= count || a.deviation < 0.0)
+            return -1;
+        if (a.kind == RandomVariable::Force && (a.component < 0 || a.component > 2))
+            return -1;
+        if (a.distribution == RandomVariable::Lognormal && a.mean <= 0.0)
+            return -1;
+        for (int q = 0; q < v; ++q)
+        {
+            const RandomVariable &b = options.variables[q];
+            if (a.kind == b.kind && a.index == b.index && (a.kind != RandomVariable::Force || a.component == b.component))
+                return -1;
+        }
+    }
+
+    auto start = std::chrono::steady_clock::now();
+
+    // the geometry never changes, so neither do the member forms
+    std::vector<MemberForm> forms(num_beams);
+    std::vector<char> has_length(num_beams);
+    std::vector<char> carries(num_beams);
+    for (int i = 0; i < num_beams; ++i)
+    {
+        const Beam &beam = beams[i];
+        double dx = nodes[beam.nodes[1]].position[0] - nodes[beam.nodes[0]].position[0];
+        double dy = nodes[beam.nodes[1]].position[1] - nodes[beam.nodes[0]].position[1];
+        has_length[i] = member_form(dx, dy, forms[i]);
+        carries[i] = active.empty() || active[i];
+    }
+
+    // members whose stiffness a sample changes
+    std::vector<char> touched(num_beams, 0);
+    bool varies_k = false;
+    for (const RandomVariable &a : options.variables)
+    {
+        if (a.kind == RandomVariable::Force)
+            continue;
+        varies_k = true;
+        for (int i = 0; i < num_beams; ++i)
+        {
+            int idx = a.kind == RandomVariable::Modulus ? beams[i].material_idx : beams[i].shape_idx;
+            touched[i] = touched[i] || idx == a.index;
+        }
+    }
+    std::vector<int> changing;
+    for (int i = 0; i < num_beams; ++i)
+    {
+        if (touched[i])
+            changing.push_back(i);
+    }
+
+    auto update_member = [&](Worker &w, int i)
+    {
+        const Beam &beam = beams[i];
+        const BeamProfile &shape = w.shapes[beam.shape_idx];
+        double E = w.materials[beam.material_idx].youngs_modulus;
+        double I = beam.is_truss ? 0.0 : shape.moment_of_inertia;
+        if (carries[i] && has_length[i])
+            w.element[i] = E * shape.area * forms[i].axial + E * I * forms[i].bending;
+        else
+            w.element[i].setZero(); // kept as structural zeros
+    };
+
+    int bins = options.bins;
+    int num_stats = num_beams + 1; // the members, then the largest
+    double histogram_max = options.histogram_max > 0.0 ? options.histogram_max : 2.0 * options.stress_limit;
+    out.histogram_max = histogram_max;
+
+    // workers are handed out per range of chunks, as a thread waiting inside a worker's
+    // assembly may pick up another range
+    ScratchPool<Worker> pool;
+    auto make_worker = [&]()
+    {
+        std::unique_ptr<Worker> w(new Worker());
+        w->materials = materials;
+        w->shapes = shapes;
+        w->forces = forces;
+        w->element.resize(num_beams);
+        for (int i = 0; i < num_beams; ++i)
+            update_member(*w, i);
+        if (varies_k)
+            w->solver = solver;
+        w->stress.assign(num_stats, 0.0);
+        w->min.assign(num_stats, std::numeric_limits<double>::infinity());
+        w->max.assign(num_stats, 0.0);
+        w->exceeded.assign(num_stats, 0);
+        w->histogram.assign(static_cast<size_t>(num_stats) * bins, 0);
+        return w;
+    };
+
+    // sets the worker's inputs to sample `s` (false: a modulus or area came out non-positive)
+    auto set_sample = [&](Worker &w, int s) -> bool
+    {
+        bool valid = true;
+        for (int v = 0; v < num_vars; ++v)
+        {
+            const RandomVariable &a = options.variables[v];
+            double value = draw(a, options.seed, static_cast<std::uint64_t>(s), v);
+            switch (a.kind)
+            {
+            case RandomVariable::Modulus:
+                w.materials[a.index].youngs_modulus = value;
+                valid = valid && value > 0.0;
+                break;
+            case RandomVariable::Area:
+                w.shapes[a.index].area = value;
+                valid = valid && value > 0.0;
+                break;
+            case RandomVariable::Force:
+                w.forces(a.index * 3 + a.component) = value;
+                break;
+            }
+        }
+        return valid;
+    };
+
+    // member stresses of the worker's u into its statistics and the chunk's moments
+    auto record = [&](Worker &w, Moments &m)
+    {
+        Vector6d d;
+        double largest = 0.0;
+        for (int i = 0; i < num_beams; ++i)
+        {
+            double stress = 0.0;
+            if (carries[i] && has_length[i])
+            {
+                const BeamProfile &shape = w.shapes[beams[i].shape_idx];
+                const MemberForm &f = forms[i];
+                double E = w.materials[beams[i].material_idx].youngs_modulus;
+                double I = beams[i].is_truss ? 0.0 : shape.moment_of_inertia;
+                d << w.u.segment<3>(beams[i].nodes[0] * 3), w.u.segment<3>(beams[i].nodes[1] * 3);
+                stress = member_combined_stress(f, E, E * I, inverse_section_modulus(shape.section_modulus), d);
+            }
+            w.stress[i] = stress;
+            largest = std::max(largest, stress);
+        }
+        w.stress[num_beams] = largest;
+
+        ++m.count;
+        for (int k = 0; k < num_stats; ++k)
+        {
+            double x = w.stress[k];
+            double delta = x - m.mean[k];
+            m.mean[k] += delta / m.count;
+            m.m2[k] += delta * (x - m.mean[k]);
+            w.min[k] = std::min(w.min[k], x);
+            w.max[k] = std::max(w.max[k], x);
+            w.exceeded[k] += x > options.stress_limit;
+            int bin = std::min(static_cast<int>(x / histogram_max * bins), bins - 1);
+            ++w.histogram[static_cast<size_t>(k) * bins + bin];
+        }
+        w.failures += largest > options.stress_limit;
+    };
+
+    // fixed chunks of consecutive samples, so the moments merge in the same order every run
+    int num_chunks = std::min(options.samples, 128);
+    std::vector<Moments> chunks(num_chunks);
+    std::atomic<int> factorizations{0};
+    TaskScheduler::instance().parallel_for(
+        0, num_chunks, 1, [&](int lo, int hi)
+        {
+            Worker *w = pool.acquire(make_worker);
+            Eigen::MatrixXd rhs;
+            for (int c = lo; c < hi; ++c)
+            {
+                Moments &m = chunks[c];
+                m.mean.assign(num_stats, 0.0);
+                m.m2.assign(num_stats, 0.0);
+                int first = static_cast<int>(static_cast<long long>(options.samples) * c / num_chunks);
+                int last = static_cast<int>(static_cast<long long>(options.samples) * (c + 1) / num_chunks);
+
+                if (!varies_k)
+                {
+                    // K is the model's: back-substitute a block of samples at a time
+                    for (int s0 = first; s0 < last; s0 += options.batch)
+                    {
+                        int count = std::min(options.batch, last - s0);
+                        rhs.resize(map.num_reduced, count);
+                        for (int j = 0; j < count; ++j)
+                        {
+                            set_sample(*w, s0 + j);
+                            rhs.col(j) = map.restrict(w->forces);
+                        }
+                        Eigen::MatrixXd x = solver.solve_many(rhs);
+                        for (int j = 0; j < count; ++j)
+                        {
+                            map.expand(x.col(j), w->u);
+                            record(*w, m);
+                        }
+                    }
+                    continue;
+                }
+
+                for (int s = first; s < last; ++s)
+                {
+                    bool ok = set_sample(*w, s);
+                    if (ok)
+                    {
+                        for (int i : changing)
+                            update_member(*w, i);
+                        ok = w->solver.factorize(assemble_reduced(map, beams, w->element)) == 0;
+                        ++factorizations;
+                    }
+                    if (!ok)
+                    {
+                        ++w->unsolvable;
+                        ++w->failures;
+                        continue;
+                    }
+                    map.expand(w->solver.solve(map.restrict(w->forces)), w->u);
+                    record(*w, m);
+                }
+            }
+            pool.release(w); },
+        TaskPriority::High, "reliability_samples");
+
+    // moments in chunk order (Chan et al.'s pairwise update), the counts in any order
+    Moments total;
+    total.mean.assign(num_stats, 0.0);
+    total.m2.assign(num_stats, 0.0);
+    for (const Moments &m : chunks)
+    {
+        if (m.count == 0)
+            continue;
+        int n = total.count + m.count;
+        for (int k = 0; k < num_stats; ++k)
+        {
+            double delta = m.mean[k] - total.mean[k];
+            total.mean[k] += delta * m.count / n;
+            total.m2[k] += m.m2[k] + delta * delta * static_cast<double>(total.count) * m.count / n;
+        }
+        total.count = n;
+    }
+
+    std::vector<StressStatistics> stats(num_stats);
+    for (int k = 0; k < num_stats; ++k)
+    {
+        stats[k].mean = total.mean[k];
+        stats[k].deviation = total.count > 1 ? std::sqrt(total.m2[k] / (total.count - 1)) : 0.0;
+        stats[k].min = std::numeric_limits<double>::infinity();
+        stats[k].histogram.assign(bins, 0);
+    }
+    for (const auto &w : pool.all())
+    {
+        out.failures += w->failures;
+        out.unsolvable += w->unsolvable;
+        for (int k = 0; k < num_stats; ++k)
+        {
+            stats[k].min = std::min(stats[k].min, w->min[k]);
+            stats[k].max = std::max(stats[k].max, w->max[k]);
+            stats[k].exceedance += w->exceeded[k];
+            for (int b = 0; b < bins; ++b)
+                stats[k].histogram[b] += w->histogram[static_cast<size_t>(k) * bins + b];
+        }
+    }
+    for (StressStatistics &s : stats)
+    {
+        s.exceedance /= options.samples;
+        if (total.count == 0)
+            s.min = 0.0;
+    }
+
+    out.samples = options.samples;
+    out.peak = stats[num_beams];
+    stats.pop_back();
+    out.members = std::move(stats);
+    out.failure_probability = static_cast<double>(out.failures) / options.samples;
+    out.standard_error = std::sqrt(out.failure_probability * (1.0 - out.failure_probability) / options.samples);
+    out.factorizations = factorizations;
+    out.wall_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return 0;
+}
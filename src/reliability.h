@@ -0,0 +1,95 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <Eigen/Eigen>
+#include "node.h"
+#include "beam.h"
+#include "beam_props.h"
+#include "dof_map.h"
+#include "element_cache.h"
+#include "sparse_solver.h"
+
+// One uncertain model input, described by its mean and standard deviation
+struct RandomVariable
+{
+    enum Kind
+    {
+        Modulus, // youngs_modulus of material `index`, Pa
+        Area,    // of profile `index`, m^2
+        Force    // forces(index * 3 + component): N, or N m for component 2
+    };
+
+    enum Distribution
+    {
+        Normal,
+        Lognormal, // never negative; the usual choice for moduli and areas
+        Uniform    // mean +- sqrt(3) deviations
+    };
+
+    Kind kind = Force;
+    int index = 0;
+    int component = 1;
+    Distribution distribution = Normal;
+    double mean = 0.0;
+    double deviation = 0.0;
+};
+
+struct ReliabilityOptions
+{
+    std::vector<RandomVariable> variables;
+    int samples = 10000;
+    std::uint64_t seed = 1;      // the same seed gives the same samples on any number of threads
+    double stress_limit = 165e6; // Pa, a sample fails once any member's |combined stress| exceeds it
+    int batch = 64;              // load-only samples solved together as one multi-RHS block
+    int bins = 50;               // stress histogram bins over [0, histogram_max]
+    double histogram_max = 0.0;  // Pa, 0: twice stress_limit (larger stresses go in the last bin)
+};
+
+// Distribution of one member's |combined stress| (or the largest one) over the samples
+struct StressStatistics
+{
+    double mean = 0.0;
+    double deviation = 0.0;
+    double min = 0.0;
+    double max = 0.0;
+    double exceedance = 0.0;    // fraction of the samples above stress_limit
+    std::vector<int> histogram; // sample counts per bin
+};
+
+struct ReliabilityResults
+{
+    int samples = 0;
+    int failures = 0;       // including samples that could not be solved
+    int unsolvable = 0;     // a non-positive modulus or area, or a singular K
+    double failure_probability = 0.0;
+    double standard_error = 0.0; // of failure_probability
+    std::vector<StressStatistics> members;
+    StressStatistics peak;       // of the largest member stress in each sample
+    double histogram_max = 0.0;  // Pa, upper end of the histograms
+    int factorizations = 0;      // 0 when only forces vary
+    double wall_seconds = 0.0;
+};
+
+// Monte Carlo estimate of the probability that some member's stress exceeds options'
+// stress_limit when the variables are drawn independently from their distributions, along with
+// each member's stress distribution. Every random number is a hash of (seed, sample, variable)
+// rather than the next draw of a stream, so the samples are the same however they are split
+// over the task scheduler's threads. The statistics are accumulated per fixed chunk of samples
+// and merged in chunk order, so the results are too, and memory stays independent of the sample
+// count. When only forces vary, K is `solver`'s (K in `map`'s numbering) for every sample and
+// each chunk back-substitutes its samples in blocks of options.batch right-hand sides; otherwise
+// every sample refactors on a worker's copy of `solver`, reusing its ordering and symbolic
+// analysis. Members with `active` 0 stay slack.
+// Returns 0 on success, -1 if a variable names something that does not exist, repeats another
+// one or has a negative deviation, or there are no samples.
+int run_reliability(const std::vector<Node> &nodes,
+                    const std::vector<Beam> &beams,
+                    const std::vector<MaterialProfile> &materials,
+                    const std::vector<BeamProfile> &shapes,
+                    const DofMap &map,
+                    const ElementCache &cache,
+                    const Eigen::VectorXd &forces,
+                    const std::vector<char> &active,
+                    const ReliabilityOptions &options,
+                    const SparseSolver &solver,
+                    ReliabilityResults &out);
@@ -0,0 +1,254 @@
+#include "response_spectrum.h"
+#include "task_scheduler.h"
+#include <algorithm>
+#include <cmath>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+namespace
+{
+    constexpr double min_omega = 1e-9; // rigid-body modes have no spectral response
+    constexpr int quantities = 8;      // P, V, Ma, Mb and the four end fibre stresses
+
+    // Der Kiureghian correlation of two modes with equal damping
+    Eigen::MatrixXd cqc_correlation(const std::vector<double> &omega, int m, double zeta)
+    {
+        Eigen::MatrixXd rho = Eigen::MatrixXd::Identity(m, m);
+        for (int i = 0; i < m; ++i)
+        {
+            for (int j = i + 1; j < m; ++j)
+            {
+                if (omega[i] < min_omega || omega[j] < min_omega)
+                {
+                    rho(i, j) = rho(j, i) = 0.0;
+                    continue;
+                }
+                double r = omega[j] / omega[i];
+                double denom = (1.0 - r * r) * (1.0 - r * r) + 4.0 * zeta * zeta * r * (1.0 + r) * (1.0 + r);
+                double value = denom > 0.0 ? 8.0 * zeta * zeta * (1.0 + r) * r * std::sqrt(r) / denom : 1.0;
+                rho(i, j) = rho(j, i) = value;
+            }
+        }
+        return rho;
+    }
+
+    // modal values of the local end forces of member i, one entry per mode, from the modal
+    // peak displacements Y (modes x total_dof)
+    void member_modal_forces(const ElementCache &cache, const Eigen::MatrixXd &Y, int i,
+                             Eigen::VectorXd &P, Eigen::VectorXd &V, Eigen::VectorXd &Ma, Eigen::VectorXd &Mb)
+    {
+        int a = cache.n1[i] * 3;
+        int b = cache.n2[i] * 3;
+        double c = cache.c[i];
+        double s = cache.s[i];
+
+        double L = cache.length[i];
+        double inv_L = L > 1e-9 ? 1.0 / L : 0.0;
+        double EI_L = cache.ei_over_l[i];
+        double EI_L2 = EI_L * inv_L;
+        double EI_L3 = EI_L2 * inv_L;
+
+        // same element arithmetic as recover_element_forces, across modes
+        Eigen::VectorXd dw = (-s * Y.col(a) + c * Y.col(a + 1)) - (-s * Y.col(b) + c * Y.col(b + 1));
+        P = cache.ea_over_l[i] * ((c * Y.col(b) + s * Y.col(b + 1)) - (c * Y.col(a) + s * Y.col(a + 1)));
+        V = (12.0 * EI_L3) * dw + (6.0 * EI_L2) * (Y.col(a + 2) + Y.col(b + 2));
+        Ma = (6.0 * EI_L2) * dw + EI_L * (4.0 * Y.col(a + 2) + 2.0 * Y.col(b + 2));
+        Mb = (6.0 * EI_L2) * dw + EI_L * (2.0 * Y.col(a + 2) + 4.0 * Y.col(b + 2));
+    }
+
+    // combined magnitude of every column of R (modal values down the rows)
+    Eigen::RowVectorXd combine(const Eigen::MatrixXd &R, const Eigen::MatrixXd *rho)
+    {
+        Eigen::RowVectorXd squared;
+        if (rho)
+            squared = R.cwiseProduct(*rho * R).colwise().sum();
+        else
+            squared = R.colwise().squaredNorm();
+        return squared.cwiseMax(0.0).cwiseSqrt();
+    }
+} // namespace
+
+double ResponseSpectrum::acceleration(double period) const
+{
+    if (table.empty())
+        return 0.0;
+    if (period <= table.front()(0))
+        return scale * table.front()(1);
+    for (size_t i = 1; i < table.size(); ++i)
+    {
+        if (period <= table[i](0))
+        {
+            double span = table[i](0) - table[i - 1](0);
+            double w = span > 0.0 ? (period - table[i - 1](0)) / span : 1.0;
+            return scale * ((1.0 - w) * table[i - 1](1) + w * table[i](1));
+        }
+    }
+    return scale * table.back()(1);
+}
+
+void ResponseSpectrum::set_design_shape(double pga, double plateau, double tb, double tc)
+{
+    table.clear();
+    table.push_back(Eigen::Vector2d(0.0, pga));
+    table.push_back(Eigen::Vector2d(tb, plateau * pga));
+    table.push_back(Eigen::Vector2d(tc, plateau * pga));
+
+    // the descending branch as chords, denser where it curves most
+    const int points = 12;
+    for (int k = 1; k <= points; ++k)
+    {
+        double T = tc * std::pow(4.0 / tc, static_cast<double>(k) / points);
+        table.push_back(Eigen::Vector2d(T, plateau * pga * tc / T));
+    }
+}
+
+int response_spectrum(const DofMap &map,
+                      const SparseMatrix &M,
+                      const ModalResults &modal,
+                      const ElementCache &cache,
+                      const std::vector<int> &supported_nodes,
+                      const ResponseSpectrumOptions &options,
+                      ResponseSpectrumResults &out)
+{
+    out = ResponseSpectrumResults();
+    int m = std::min(options.modes, modal.count);
+    if (m <= 0 || map.num_reduced == 0 || modal.shapes.rows() != map.total_dof)
+        return -1;
+
+    // influence vector of a unit ground displacement along the direction
+    double angle = options.direction * M_PI / 180.0;
+    Eigen::VectorXd r_global = Eigen::VectorXd::Zero(map.total_dof);
+    for (int i = 0; i < map.total_dof / 3; ++i)
+    {
+        r_global(i * 3) = std::cos(angle);
+        r_global(i * 3 + 1) = std::sin(angle);
+    }
+    Eigen::VectorXd r = map.restrict(r_global);
+    Eigen::VectorXd Mr = M * r;
+    out.total_mass = r.dot(Mr);
+
+    // modal peak displacements d_k phi_k with d_k = gamma_k Sa(T_k) / w_k^2
+    out.modes = m;
+    out.period.resize(m);
+    out.spectral_acceleration.resize(m);
+    out.participation.resize(m);
+    out.mass_ratio.resize(m);
+    Eigen::VectorXd d = Eigen::VectorXd::Zero(m);
+    for (int k = 0; k < m; ++k)
+    {
+        double w = modal.omega[k];
+        double gamma = map.restrict(modal.shapes.col(k)).dot(Mr);
+        out.participation[k] = gamma;
+        out.mass_ratio[k] = out.total_mass > 0.0 ? gamma * gamma / out.total_mass : 0.0;
+        out.captured_mass += out.mass_ratio[k];
+        if (w < min_omega)
+        {
+            out.period[k] = 0.0;
+            out.spectral_acceleration[k] = 0.0;
+            continue;
+        }
+        out.period[k] = 2.0 * M_PI / w;
+        out.spectral_acceleration[k] = options.spectrum.acceleration(out.period[k]);
+        d(k) = gamma * out.spectral_acceleration[k] / (w * w);
+    }
+
+    // modes down the rows, so the DOFs of a node are contiguous columns of length m
+    Eigen::MatrixXd Y = (modal.shapes.leftCols(m) * d.asDiagonal()).transpose();
+
+    Eigen::MatrixXd rho;
+    if (options.combination == ResponseSpectrumOptions::CQC)
+        rho = cqc_correlation(modal.omega, m, std::max(options.damping_ratio, 0.0));
+    const Eigen::MatrixXd *correlation = rho.size() > 0 ? &rho : nullptr;
+
+    ElementForces &env = out.envelope;
+    env.resize(cache.count);
+    const int block = 64;
+    float max_stress = TaskScheduler::instance().parallel_reduce(
+        0, cache.count, block, 0.0f,
+        [&](int lo, int hi)
+        {
+            float block_max = 0.0f;
+            Eigen::MatrixXd R(m, quantities * block);
+            Eigen::VectorXd P, V, Ma, Mb;
+            for (int first = lo; first < hi; first += block)
+            {
+                int n = std::min(block, hi - first);
+                for (int j = 0; j < n; ++j)
+                {
+                    int i = first + j;
+                    member_modal_forces(cache, Y, i, P, V, Ma, Mb);
+                    double inv_a = cache.inv_area[i];
+                    double inv_z = cache.inv_section_modulus[i];
+                    double *col = R.data() + static_cast<size_t>(quantities) * j * m;
+                    Eigen::Map<Eigen::MatrixXd> q(col, m, quantities);
+                    q.col(0) = P;
+                    q.col(1) = V;
+                    q.col(2) = Ma;
+                    q.col(3) = Mb;
+                    q.col(4) = inv_a * P + inv_z * Ma;
+                    q.col(5) = inv_a * P - inv_z * Ma;
+                    q.col(6) = inv_a * P + inv_z * Mb;
+                    q.col(7) = inv_a * P - inv_z * Mb;
+                }
+
+                Eigen::RowVectorXd peak = combine(R.leftCols(quantities * n), correlation);
+                for (int j = 0; j < n; ++j)
+                {
+                    int i = first + j;
+                    const double *v = peak.data() + quantities * j;
+                    env.p2[i] = v[0];
+                    env.p1[i] = -v[0];
+                    env.v1[i] = v[1];
+                    env.v2[i] = -v[1];
+                    env.m1[i] = v[2];
+                    env.m2[i] = v[3];
+                    float stress = static_cast<float>(std::max(std::max(v[4], v[5]), std::max(v[6], v[7])));
+                    env.stress[i] = stress;
+                    block_max = std::max(block_max, stress);
+                }
+            }
+            return block_max;
+        },
+        [](float a, float b)
+        { return std::max(a, b); },
+        TaskPriority::High, "spectrum_members");
+    out.max_stress = max_stress;
+
+    // support reactions per mode from the incident members, then combined like the forces
+    out.reactions = Eigen::VectorXd::Zero(map.total_dof);
+    Eigen::MatrixXd modal_reactions = Eigen::MatrixXd::Zero(m, 3 * supported_nodes.size());
+    Eigen::MatrixXd base(m, 3);
+    base.setZero();
+    Eigen::VectorXd P, V, Ma, Mb;
+    for (size_t s = 0; s < supported_nodes.size(); ++s)
+    {
+        int node = supported_nodes[s];
+        for (int k = cache.node_offsets[node]; k < cache.node_offsets[node + 1]; ++k)
+        {
+            int e = cache.node_ends[k] >> 1;
+            bool second = (cache.node_ends[k] & 1) != 0;
+            member_modal_forces(cache, Y, e, P, V, Ma, Mb);
+
+            // end forces in the recovery's sign convention, rotated back to global
+            double c = cache.c[e];
+            double sn = cache.s[e];
+            Eigen::VectorXd p = second ? P : Eigen::VectorXd(-P);
+            Eigen::VectorXd v = second ? Eigen::VectorXd(-V) : V;
+            modal_reactions.col(3 * s) += c * p - sn * v;
+            modal_reactions.col(3 * s + 1) += sn * p + c * v;
+            modal_reactions.col(3 * s + 2) += second ? Mb : Ma;
+        }
+        base += modal_reactions.middleCols(3 * s, 3);
+    }
+
+    Eigen::RowVectorXd reaction_peaks = combine(modal_reactions, correlation);
+    for (size_t s = 0; s < supported_nodes.size(); ++s)
+        out.reactions.segment<3>(supported_nodes[s] * 3) = reaction_peaks.segment<3>(3 * s).transpose();
+    Eigen::RowVectorXd base_peaks = combine(base, correlation);
+    for (int dir = 0; dir < 3; ++dir)
+        out.base_shear[dir] = base_peaks(dir);
+
+    return 0;
+}
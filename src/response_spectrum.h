@@ -0,0 +1,71 @@
+#pragma once
+#include <vector>
+#include <Eigen/Eigen>
+#include "dof_map.h"
+#include "element_cache.h"
+#include "modal_analysis.h"
+
+// Design spectrum: spectral (pseudo-)acceleration against period, linear between the points
+// and held flat beyond the first and last
+struct ResponseSpectrum
+{
+    std::vector<Eigen::Vector2d> table; // (period s, Sa) points in increasing period
+    double scale = 9.80665;             // Sa units -> m/s^2 (9.80665 for spectra in g)
+
+    ResponseSpectrum() { set_design_shape(0.3, 2.5, 0.15, 0.5); }
+    double acceleration(double period) const; // m/s^2
+
+    // the usual code shape: pga at T = 0, rising to plateau * pga at tb, flat to tc, then
+    // falling as 1/T up to 4 s
+    void set_design_shape(double pga, double plateau, double tb, double tc);
+};
+
+struct ResponseSpectrumOptions
+{
+    enum Combination
+    {
+        SRSS, // square root of the sum of squares (well separated modes)
+        CQC   // complete quadratic combination (Der Kiureghian correlation, closely spaced modes)
+    };
+
+    ResponseSpectrum spectrum;
+    Combination combination = CQC;
+    int modes = 20;
+    double damping_ratio = 0.05; // of every mode, for the CQC correlation
+    double direction = 0.0;      // ground motion direction, degrees from +x
+    bool lumped_mass = false;
+};
+
+struct ResponseSpectrumResults
+{
+    int modes = 0;
+    std::vector<double> period;                // s
+    std::vector<double> spectral_acceleration; // m/s^2
+    std::vector<double> participation;         // phi_k^T M r (mass-normalized modes)
+    std::vector<double> mass_ratio;            // effective modal mass / total mass in the direction
+    double total_mass = 0.0;                   // r^T M r of the free DOFs
+    double captured_mass = 0.0;                // sum of mass_ratio
+
+    // Peak member forces as non-negative magnitudes, each combined separately: p2 = |P|,
+    // v1 = |V|, m1/m2 = |M| at each end, stress = largest |fibre stress| at the ends
+    // (p1 and v2 hold the negatives, as a static recovery would store them)
+    ElementForces envelope;
+    float max_stress = 0.0f;
+
+    Eigen::VectorXd reactions; // combined magnitudes at the supports (total_dof, others zero)
+    double base_shear[3] = {0.0, 0.0, 0.0}; // combined total reaction {Fx, Fy, Mz}
+};
+
+// Peak response to ground acceleration along options.direction from the spectrum, by modal
+// combination over the first options.modes modes of `modal` (mass-normalized, from the same
+// M). Member quantities are combined in blocks: the modal values of a block form an
+// m x quantities matrix R, and CQC becomes sum(R .* (rho R)), one product per block, with
+// the blocks spread across the scheduler.
+// Returns 0 on success, -1 if there are no usable modes.
+int response_spectrum(const DofMap &map,
+                      const SparseMatrix &M,
+                      const ModalResults &modal,
+                      const ElementCache &cache,
+                      const std::vector<int> &supported_nodes,
+                      const ResponseSpectrumOptions &options,
+                      ResponseSpectrumResults &out);
@@ -0,0 +1,147 @@
+#include "result_queries.h"
+#include "task_scheduler.h"
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    // keep only the k entries of idx with the largest |values|, in no particular order
+    void keep_largest(std::vector<int> &idx, const std::vector<float> &values, int k)
+    {
+        if (static_cast<int>(idx.size()) <= k)
+            return;
+
+        auto larger = [&values](int a, int b)
+        {
+            float va = std::abs(values[a]);
+            float vb = std::abs(values[b]);
+            return va > vb || (va == vb && a < b);
+        };
+        std::nth_element(idx.begin(), idx.begin() + k, idx.end(), larger);
+        idx.resize(k);
+    }
+} // namespace
+
+std::vector<int> top_k_by_magnitude(const std::vector<float> &values, int k)
+{
+    int n = static_cast<int>(values.size());
+    k = std::min(k, n);
+    if (k <= 0)
+        return {};
+
+    std::vector<int> best = TaskScheduler::instance().parallel_reduce(
+        0, n, 4096, std::vector<int>(),
+        [&](int lo, int hi)
+        {
+            std::vector<int> idx(hi - lo);
+            for (int i = lo; i < hi; ++i)
+                idx[i - lo] = i;
+            keep_largest(idx, values, k);
+            return idx;
+        },
+        [&](std::vector<int> a, const std::vector<int> &b)
+        {
+            a.insert(a.end(), b.begin(), b.end());
+            keep_largest(a, values, k);
+            return a;
+        },
+        TaskPriority::High, "top_k");
+
+    std::sort(best.begin(), best.end(), [&values](int a, int b)
+              {
+                  float va = std::abs(values[a]);
+                  float vb = std::abs(values[b]);
+                  return va > vb || (va == vb && a < b); });
+    return best;
+}
+
+void percentile_range(const std::vector<float> &values, float percentile, float &lo, float &hi)
+{
+    lo = 0.0f;
+    hi = 0.0f;
+    if (values.empty())
+        return;
+
+    if (percentile >= 100.0f)
+    {
+        auto mm = std::minmax_element(values.begin(), values.end());
+        lo = *mm.first;
+        hi = *mm.second;
+        return;
+    }
+
+    percentile = std::max(percentile, 50.0f);
+    std::vector<float> scratch(values);
+    size_t last = scratch.size() - 1;
+    size_t hi_pos = static_cast<size_t>(std::floor(percentile / 100.0f * last));
+    size_t lo_pos = last - hi_pos;
+
+    // the second selection only has to look below the first one
+    std::nth_element(scratch.begin(), scratch.begin() + hi_pos, scratch.end());
+    hi = scratch[hi_pos];
+    std::nth_element(scratch.begin(), scratch.begin() + lo_pos, scratch.begin() + hi_pos + 1);
+    lo = scratch[lo_pos];
+}
+
+StressHistogram stress_histogram(const std::vector<float> &values, float lo, float hi, int bins)
+{
+    StressHistogram h;
+    h.lo = lo;
+    h.hi = hi;
+    if (bins < 1)
+        return h;
+
+    float width = (hi - lo) / bins;
+    float inv_width = width > 0.0f ? 1.0f / width : 0.0f;
+
+    h.counts = TaskScheduler::instance().parallel_reduce(
+        0, static_cast<int>(values.size()), 8192, std::vector<int>(bins, 0),
+        [&](int first, int last)
+        {
+            std::vector<int> counts(bins, 0);
+            for (int i = first; i < last; ++i)
+            {
+                int b = static_cast<int>((values[i] - lo) * inv_width);
+                counts[std::min(std::max(b, 0), bins - 1)]++;
+            }
+            return counts;
+        },
+        [](std::vector<int> a, const std::vector<int> &b)
+        {
+            for (size_t i = 0; i < a.size(); ++i)
+                a[i] += b[i];
+            return a;
+        },
+        TaskPriority::High, "stress_histogram");
+    return h;
+}
+
+void summarize_stresses(const std::vector<float> &stress,
+                        float min_stress,
+                        float max_stress,
+                        int top_k,
+                        float percentile,
+                        int bins,
+                        StressSummary &out)
+{
+    out.top_k = top_k;
+    out.percentile = percentile;
+    out.bins = bins;
+
+    if (stress.empty())
+    {
+        out.critical.clear();
+        out.color_min = out.color_max = 0.0f;
+        out.histogram = StressHistogram();
+        return;
+    }
+
+    TaskGroup group;
+    group.run([&]
+              { percentile_range(stress, percentile, out.color_min, out.color_max); },
+              TaskPriority::High, "stress_percentile");
+
+    out.critical = top_k_by_magnitude(stress, top_k);
+    out.histogram = stress_histogram(stress, min_stress, max_stress, bins);
+    group.wait();
+}
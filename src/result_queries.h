@@ -0,0 +1,46 @@
+#pragma once
+#include <vector>
+
+// Equal-width bins of the per-beam stress between lo and hi (values outside are clamped
+// into the end bins).
+struct StressHistogram
+{
+    float lo = 0.0f;
+    float hi = 0.0f;
+    std::vector<int> counts;
+};
+
+// Everything the stress panel and the colormap need, computed together once per solve so
+// nothing has to walk every beam per frame.
+struct StressSummary
+{
+    std::vector<int> critical; // top-K members by |stress|, most stressed first
+    float color_min = 0.0f;    // signed stress at the lower/upper color percentile
+    float color_max = 0.0f;
+    StressHistogram histogram;
+
+    // settings the summary was computed with
+    int top_k = 0;
+    float percentile = 0.0f;
+    int bins = 0;
+};
+
+// Indices of the k largest |values|, largest first (ties broken by index). Each chunk keeps
+// its own k best with nth_element and the chunks are merged, so it never sorts all values.
+std::vector<int> top_k_by_magnitude(const std::vector<float> &values, int k);
+
+// Signed values at the (100 - percentile) and percentile positions, found with
+// nth_element on a copy. percentile >= 100 gives the plain min and max.
+void percentile_range(const std::vector<float> &values, float percentile, float &lo, float &hi);
+
+StressHistogram stress_histogram(const std::vector<float> &values, float lo, float hi, int bins);
+
+// Fill `out` from the recovered stresses. The percentile selection runs as a task next to
+// the top-K and histogram passes, which are themselves split across the scheduler.
+void summarize_stresses(const std::vector<float> &stress,
+                        float min_stress,
+                        float max_stress,
+                        int top_k,
+                        float percentile,
+                        int bins,
+                        StressSummary &out);
@@ -0,0 +1,291 @@
+#include "sensitivity.h"
+#include "task_scheduler.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+namespace
+{
+    // combined stress as recover_element_forces computes it, and optionally its gradient in u
+    // and its derivative in I at fixed u (the governing fibre and end are held)
+    double member_stress(const MemberForm &f, double E, double A, double I, double inv_z,
+                         const Vector6d &u, Vector6d *gradient = nullptr, double *d_inertia = nullptr)
+    {
+        double P = E * A * f.p.dot(u);
+        double Ma = E * I * f.ma.dot(u);
+        double Mb = E * I * f.mb.dot(u);
+        bool end_a = std::abs(Ma) >= std::abs(Mb);
+        double M = end_a ? Ma : Mb;
+
+        double axial = P / A;
+        double bending = std::abs(M) * inv_z;
+        double t = std::abs(axial + bending) > std::abs(axial - bending) ? 1.0 : -1.0;
+        double sign = M < 0.0 ? -1.0 : 1.0;
+
+        if (gradient)
+            *gradient = E * f.p + t * sign * inv_z * E * I * (end_a ? f.ma : f.mb);
+        if (d_inertia)
+            *d_inertia = t * sign * inv_z * E * (end_a ? f.ma : f.mb).dot(u);
+        return axial + t * bending;
+    }
+
+    Vector6d gather(const Eigen::VectorXd &global, int n1, int n2)
+    {
+        Vector6d v;
+        v << global.segment<3>(n1 * 3), global.segment<3>(n2 * 3);
+        return v;
+    }
+} // namespace
+
+bool member_form(double dx, double dy, MemberForm &f)
+{
+    double L = std::sqrt(dx * dx + dy * dy);
+    if (L < 1e-9)
+        return false;
+    double c = dx / L;
+    double s = dy / L;
+
+    f.p << -c / L, -s / L, 0.0, c / L, s / L, 0.0;
+    f.axial = L * f.p * f.p.transpose();
+
+    // w1 - w2 (transverse displacement difference) and the two end rotations
+    Vector6d dw, t1, t2;
+    dw << -s, c, 0.0, s, -c, 0.0;
+    t1 << 0.0, 0.0, 1.0, 0.0, 0.0, 0.0;
+    t2 << 0.0, 0.0, 0.0, 0.0, 0.0, 1.0;
+    Vector6d v = 12.0 / (L * L * L) * dw + 6.0 / (L * L) * (t1 + t2);
+    f.ma = 6.0 / (L * L) * dw + (4.0 * t1 + 2.0 * t2) / L;
+    f.mb = 6.0 / (L * L) * dw + (2.0 * t1 + 4.0 * t2) / L;
+
+    // shear V acts along dw, the end moments on the rotations
+    f.bending = dw * v.transpose() + t1 * f.ma.transpose() + t2 * f.mb.transpose();
+    return true;
+}
+
+double member_combined_stress(const MemberForm &f, double E, double EI, double inv_z, const Vector6d &d,
+                              double *axial)
+{
+    double P = std::abs(E * f.p.dot(d));
+    if (axial)
+        *axial = P;
+    return P + EI * std::max(std::abs(f.ma.dot(d)), std::abs(f.mb.dot(d))) * inv_z;
+}
+
+double inverse_section_modulus(double z)
+{
+    return std::abs(z) < 1e-12 ? 0.0 : 1.0 / std::abs(z);
+}
+
+int compute_sensitivities(const std::vector<Node> &nodes,
+                          const std::vector<Beam> &beams,
+                          const std::vector<MaterialProfile> &materials,
+                          const std::vector<BeamProfile> &shapes,
+                          const DofMap &map,
+                          const ElementCache &cache,
+                          const SparseSolver &solver,
+                          const Eigen::VectorXd &forces,
+                          const Eigen::VectorXd &displacement,
+                          const std::vector<char> &active,
+                          const std::vector<SensitivityResponse> &responses,
+                          SensitivityResults &out)
+{
+    out = SensitivityResults();
+    int num_nodes = static_cast<int>(nodes.size());
+    int num_beams = static_cast<int>(beams.size());
+    int num_responses = static_cast<int>(responses.size());
+    for (const SensitivityResponse &r : responses)
+    {
+        if (r.type == SensitivityResponse::Displacement && (r.node < 0 || r.node >= num_nodes || r.dof < 0 || r.dof > 2))
+            return -1;
+        if (r.type == SensitivityResponse::Stress && (r.member < 0 || r.member >= num_beams))
+            return -1;
+        if (r.type == SensitivityResponse::MaxStress && !(r.aggregation > 0.0))
+            return -1;
+    }
+    if (displacement.size() != num_nodes * 3 || cache.count != num_beams)
+        return -1;
+
+    auto start = std::chrono::steady_clock::now();
+    auto carries = [&](int i)
+    { return beams[i].k_matrix.rows() == 6 && (active.empty() || active[i]); };
+    auto section = [&](int i, double &E, double &A, double &I)
+    {
+        E = materials[beams[i].material_idx].youngs_modulus;
+        A = shapes[beams[i].shape_idx].area;
+        I = beams[i].is_truss ? 0.0 : shapes[beams[i].shape_idx].moment_of_inertia;
+    };
+    auto geometry = [&](int i, double &dx, double &dy)
+    {
+        dx = nodes[beams[i].nodes[1]].position[0] - nodes[beams[i].nodes[0]].position[0];
+        dy = nodes[beams[i].nodes[1]].position[1] - nodes[beams[i].nodes[0]].position[1];
+    };
+
+    // stress of a carrying member at the static solution, optionally with its gradient in u
+    auto stress_of = [&](int i, MemberForm &f, Vector6d *gradient) -> double
+    {
+        double E, A, I, dx, dy;
+        section(i, E, A, I);
+        geometry(i, dx, dy);
+        if (!carries(i) || !member_form(dx, dy, f))
+            return 0.0;
+        return member_stress(f, E, A, I, cache.inv_section_modulus[i],
+                             gather(displacement, beams[i].nodes[0], beams[i].nodes[1]), gradient);
+    };
+
+    // adjoint load dg/du and one back-substitution per response (compliance is self-adjoint).
+    // Stress responses also keep dg/d(stress) per member for the explicit terms below
+    out.responses.resize(num_responses);
+    std::vector<Eigen::VectorXd> adjoint(num_responses);
+    std::vector<std::vector<double>> stress_weight(num_responses);
+    TaskScheduler::instance().parallel_for(
+        0, num_responses, 1, [&](int lo, int hi)
+        {
+            MemberForm f;
+            Vector6d gradient;
+            for (int k = lo; k < hi; ++k)
+            {
+                const SensitivityResponse &r = responses[k];
+                ResponseSensitivity &result = out.responses[k];
+                result.response = r;
+                if (r.type == SensitivityResponse::Compliance)
+                {
+                    result.value = forces.dot(displacement);
+                    adjoint[k] = displacement;
+                    continue;
+                }
+
+                Eigen::VectorXd load = Eigen::VectorXd::Zero(num_nodes * 3);
+                if (r.type == SensitivityResponse::Displacement)
+                {
+                    result.value = displacement(r.node * 3 + r.dof);
+                    load(r.node * 3 + r.dof) = 1.0;
+                }
+                else
+                {
+                    std::vector<double> &weight = stress_weight[k];
+                    weight.assign(num_beams, 0.0);
+                    if (r.type == SensitivityResponse::Stress)
+                    {
+                        result.value = stress_of(r.member, f, nullptr);
+                        weight[r.member] = carries(r.member) ? 1.0 : 0.0;
+                    }
+                    else
+                    {
+                        // KS = ref (m + ln sum exp(rho (|s_i| / ref - m)) / rho), m = max |s_i| / ref
+                        std::vector<double> stress(num_beams);
+                        double largest = 0.0;
+                        for (int i = 0; i < num_beams; ++i)
+                        {
+                            stress[i] = stress_of(i, f, nullptr);
+                            largest = std::max(largest, std::abs(stress[i]));
+                        }
+                        double ref = r.reference > 0.0 ? r.reference : largest;
+                        if (ref > 0.0)
+                        {
+                            double m = largest / ref;
+                            double sum = 0.0;
+                            for (int i = 0; i < num_beams; ++i)
+                            {
+                                weight[i] = carries(i) ? std::exp(r.aggregation * (std::abs(stress[i]) / ref - m)) : 0.0;
+                                sum += weight[i];
+                            }
+                            result.value = ref * (m + std::log(sum) / r.aggregation);
+                            for (int i = 0; i < num_beams; ++i)
+                                weight[i] *= (stress[i] < 0.0 ? -1.0 : 1.0) / sum;
+                        }
+                    }
+                    for (int i = 0; i < num_beams; ++i)
+                    {
+                        if (weight[i] == 0.0)
+                            continue;
+                        stress_of(i, f, &gradient);
+                        load.segment<3>(beams[i].nodes[0] * 3) += weight[i] * gradient.head<3>();
+                        load.segment<3>(beams[i].nodes[1] * 3) += weight[i] * gradient.tail<3>();
+                    }
+                }
+                map.expand(solver.solve(map.restrict(load)), adjoint[k]);
+            } },
+        TaskPriority::High, "sensitivity_adjoint");
+
+    // dg/dp = dg/dp|explicit - lambda^T dk/dp u, member by member
+    std::vector<double> d_dx(num_beams), d_dy(num_beams);
+    for (int k = 0; k < num_responses; ++k)
+    {
+        ResponseSensitivity &result = out.responses[k];
+        result.area.assign(num_beams, 0.0);
+        result.inertia.assign(num_beams, 0.0);
+        result.modulus.assign(num_beams, 0.0);
+        const Eigen::VectorXd &lambda = adjoint[k];
+        const std::vector<double> &weight = stress_weight[k];
+
+        TaskScheduler::instance().parallel_for(
+            0, num_beams, 256, [&](int lo, int hi)
+            {
+                MemberForm f, g;
+                for (int i = lo; i < hi; ++i)
+                {
+                    d_dx[i] = 0.0;
+                    d_dy[i] = 0.0;
+                    double E, A, I, dx, dy;
+                    section(i, E, A, I);
+                    geometry(i, dx, dy);
+                    if (!carries(i) || !member_form(dx, dy, f))
+                        continue;
+
+                    int n1 = beams[i].nodes[0];
+                    int n2 = beams[i].nodes[1];
+                    Vector6d u = gather(displacement, n1, n2);
+                    Vector6d l = gather(lambda, n1, n2);
+                    double la = l.dot(f.axial * u);
+                    double lb = l.dot(f.bending * u);
+                    result.area[i] = -E * la;
+                    result.inertia[i] = beams[i].is_truss ? 0.0 : -E * lb;
+                    result.modulus[i] = -(A * la + I * lb);
+
+                    // dg/d(stress) of this member's own stress, if the response depends on it
+                    double w = weight.empty() ? 0.0 : weight[i];
+                    double inv_z = cache.inv_section_modulus[i];
+                    if (w != 0.0)
+                    {
+                        // sigma = E * strain, so only I (through M) and E appear explicitly
+                        double d_inertia = 0.0;
+                        double sigma = member_stress(f, E, A, I, inv_z, u, nullptr, &d_inertia);
+                        if (!beams[i].is_truss)
+                            result.inertia[i] += w * d_inertia;
+                        result.modulus[i] += w * sigma / E;
+                    }
+
+                    // coordinates: central differences of the element terms in dx and dy
+                    double h = 1e-6 * std::sqrt(dx * dx + dy * dy);
+                    auto term = [&](double ex, double ey)
+                    {
+                        if (!member_form(ex, ey, g))
+                            return 0.0;
+                        double value = -E * (A * l.dot(g.axial * u) + I * l.dot(g.bending * u));
+                        if (w != 0.0)
+                            value += w * member_stress(g, E, A, I, inv_z, u);
+                        return value;
+                    };
+                    d_dx[i] = (term(dx + h, dy) - term(dx - h, dy)) / (2.0 * h);
+                    d_dy[i] = (term(dx, dy + h) - term(dx, dy - h)) / (2.0 * h);
+                } },
+            TaskPriority::High, "sensitivity_members");
+
+        // dx = x2 - x1: each node collects +d from the members it ends and -d from those it starts
+        result.node_x.assign(num_nodes, 0.0);
+        result.node_y.assign(num_nodes, 0.0);
+        for (int n = 0; n < num_nodes && n + 1 < static_cast<int>(cache.node_offsets.size()); ++n)
+        {
+            for (int e = cache.node_offsets[n]; e < cache.node_offsets[n + 1]; ++e)
+            {
+                int i = cache.node_ends[e] >> 1;
+                double sign = (cache.node_ends[e] & 1) ? 1.0 : -1.0;
+                result.node_x[n] += sign * d_dx[i];
+                result.node_y[n] += sign * d_dy[i];
+            }
+        }
+    }
+
+    out.wall_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return 0;
+}
@@ -0,0 +1,86 @@
+#pragma once
+#include <vector>
+#include <Eigen/Eigen>
+#include "node.h"
+#include "beam.h"
+#include "beam_props.h"
+#include "dof_map.h"
+#include "element_cache.h"
+#include "sparse_solver.h"
+
+typedef Eigen::Matrix<double, 6, 1> Vector6d;
+
+// One member at geometry (dx, dy) in global coordinates, per unit EA and EI, so analyses that
+// change sections (sensitivities, sizing) never rebuild T
+struct MemberForm
+{
+    Matrix6d axial; // k_matrix = EA * axial + EI * bending
+    Matrix6d bending;
+    Vector6d p;      // P = EA * p.u (tension positive)
+    Vector6d ma, mb; // end moments of recover_element_forces: Ma = EI * ma.u, Mb = EI * mb.u
+};
+bool member_form(double dx, double dy, MemberForm &f); // false for a zero-length member
+
+// |E p.d| + EI max(|ma.d|, |mb.d|) inv_z for end displacements d: the combined stress the
+// optimizers and scans rank members by. `axial`, if given, receives the |E p.d| part.
+double member_combined_stress(const MemberForm &f, double E, double EI, double inv_z, const Vector6d &d,
+                              double *axial = nullptr);
+double inverse_section_modulus(double z); // 1 / |z|, 0 for a section without one
+
+// A scalar result of the static solve to differentiate
+struct SensitivityResponse
+{
+    enum Type
+    {
+        Compliance,   // F^T u (self-adjoint, no extra solve)
+        Displacement, // u of `node` along `dof` (0: x, 1: y, 2: rotation)
+        Stress,       // combined stress of `member`, at its governing fibre and end
+        MaxStress     // smooth (Kreisselmeier-Steinhauser) upper bound of every member's |stress|
+    };
+
+    Type type = Compliance;
+    int node = -1;
+    int dof = 1;
+    int member = -1;
+    double aggregation = 100.0; // MaxStress: sharpness, on stresses relative to `reference`
+    double reference = 0.0;     // MaxStress: Pa (0: the current largest |stress|)
+};
+
+// d(response) / d(parameter), each member's parameters varied on their own (members sharing a
+// profile or material add up to the profile's sensitivity)
+struct ResponseSensitivity
+{
+    SensitivityResponse response;
+    double value = 0.0;
+    std::vector<double> area;    // per member, per m^2
+    std::vector<double> inertia; // per member, per m^4 (0 for truss members)
+    std::vector<double> modulus; // per member, per Pa
+    std::vector<double> node_x;  // per node, per m of the node's x coordinate
+    std::vector<double> node_y;
+};
+
+struct SensitivityResults
+{
+    std::vector<ResponseSensitivity> responses;
+    double wall_seconds = 0.0;
+};
+
+// Adjoint sensitivities of each response about the static solution `displacement`: one
+// back-substitution on `solver` (K in `map`'s numbering) per displacement or stress response,
+// solved in parallel, then dg/dp = dg/dp|explicit - lambda^T dK/dp u element by element.
+// Area, inertia and modulus terms are exact; coordinate terms differentiate each element's
+// matrix by central differences (no extra solves). Members with `active` 0 carry nothing.
+// Returns 0 on success, -1 if a response names a node, DOF or member that does not exist (or
+// aggregates without a positive sharpness).
+int compute_sensitivities(const std::vector<Node> &nodes,
+                          const std::vector<Beam> &beams,
+                          const std::vector<MaterialProfile> &materials,
+                          const std::vector<BeamProfile> &shapes,
+                          const DofMap &map,
+                          const ElementCache &cache,
+                          const SparseSolver &solver,
+                          const Eigen::VectorXd &forces,
+                          const Eigen::VectorXd &displacement,
+                          const std::vector<char> &active,
+                          const std::vector<SensitivityResponse> &responses,
+                          SensitivityResults &out);
@@ -4,7 +4,7 @@
 
 // File magic (4 bytes) followed by a format version number (uint32_t)
 constexpr std::uint32_t FILE_MAGIC = 0x53595356; // "SYSV" magic number
-constexpr std::uint32_t FILE_FORMAT_VERSION = 2; // bumped format for unit metadata
+constexpr std::uint32_t FILE_FORMAT_VERSION = 5; // 2 added unit metadata, 3 material density, 4 one-way members, 5 plastic moment
 
 void writeString(std::ofstream &ofs, const std::string &str);
 std::string readString(std::ifstream &ifs);
@@ -0,0 +1,375 @@
+#include "shape.h"
+#include "sensitivity.h"
+#include "task_scheduler.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
+#include <random>
+
+namespace
+{
+    // one analysed design, its variables scaled to [0, 1] over their bounds
+    struct Trial
+    {
+        std::vector<double> x;
+        double weight = 0.0;
+        double max_stress = 0.0;
+        double merit = std::numeric_limits<double>::infinity();
+        bool ok = false;
+    };
+
+    // what one concurrent analysis owns: the moved nodes, the element matrices of K and a copy
+    // of the solver (it shares the ordering and refactors only the numbers)
+    struct Analysis
+    {
+        std::vector<Node> nodes;
+        std::vector<Matrix6d> element;
+        SparseSolver solver;
+        Eigen::VectorXd u;
+    };
+
+    // a single optimization run (one start)
+    struct Run
+    {
+        Trial best;
+        std::vector<ShapeIteration> history;
+        bool converged = false;
+        int evaluations = 0;
+    };
+} // namespace
+
+int optimize_shape(const std::vector<Node> &nodes,
+                   const std::vector<Beam> &beams,
+                   const std::vector<MaterialProfile> &materials,
+                   const std::vector<BeamProfile> &shapes,
+                   const DofMap &map,
+                   const ElementCache &cache,
+                   const Eigen::VectorXd &forces,
+                   const std::vector<char> &active,
+                   const ShapeOptions &options,
+                   const SparseSolver &solver,
+                   ShapeResults &out)
+{
+    out = ShapeResults();
+    int num_beams = static_cast<int>(beams.size());
+    int num_nodes = static_cast<int>(nodes.size());
+    int num_vars = static_cast<int>(options.variables.size());
+    if (map.num_reduced == 0 || cache.count != num_beams || num_vars == 0 || !(options.stress_limit > 0.0) ||
+        !(options.aggregation > 0.0))
+        return -1;
+    std::vector<char> moved(num_nodes * 2, 0);
+    for (const ShapeVariable &v : options.variables)
+    {
+        if (v.node < 0 || v.node >= num_nodes || v.dof < 0 || v.dof > 1 || !(v.upper >= v.lower) ||
+            moved[v.node * 2 + v.dof])
+            return -1;
+        moved[v.node * 2 + v.dof] = 1;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    int line_points = std::max(options.line_points, 1);
+    int starts = std::max(options.starts, 1);
+    std::vector<double> range(num_vars);
+    for (int j = 0; j < num_vars; ++j)
+        range[j] = options.variables[j].upper - options.variables[j].lower;
+
+    std::vector<double> E(num_beams), A(num_beams), I(num_beams), mass_per_length(num_beams);
+    std::vector<char> carries(num_beams);
+    for (int i = 0; i < num_beams; ++i)
+    {
+        const BeamProfile &shape = shapes[beams[i].shape_idx];
+        E[i] = materials[beams[i].material_idx].youngs_modulus;
+        A[i] = shape.area;
+        I[i] = beams[i].is_truss ? 0.0 : shape.moment_of_inertia;
+        mass_per_length[i] = materials[beams[i].material_idx].density * shape.area;
+        carries[i] = active.empty() || active[i];
+    }
+    Eigen::VectorXd F_r = map.restrict(forces);
+
+    // the stress the merit and the smooth maximum are measured against
+    double reference = options.stress_limit;
+    auto merit = [&](const Trial &t)
+    {
+        if (options.objective == ShapeOptions::MaxStress)
+            return t.max_stress / reference;
+        return t.weight / out.initial_weight + 100.0 * std::max(t.max_stress / options.stress_limit - 1.0, 0.0);
+    };
+
+    // static analysis of the design x on `a`
+    auto evaluate = [&](Analysis &a, Trial &t)
+    {
+        t.ok = false;
+        t.merit = std::numeric_limits<double>::infinity();
+        for (int j = 0; j < num_vars; ++j)
+        {
+            const ShapeVariable &v = options.variables[j];
+            a.nodes[v.node].position[v.dof] = static_cast<float>(v.lower + t.x[j] * range[j]);
+        }
+
+        std::vector<MemberForm> forms(num_beams);
+        t.weight = 0.0;
+        for (int i = 0; i < num_beams; ++i)
+        {
+            double dx = a.nodes[beams[i].nodes[1]].position[0] - a.nodes[beams[i].nodes[0]].position[0];
+            double dy = a.nodes[beams[i].nodes[1]].position[1] - a.nodes[beams[i].nodes[0]].position[1];
+            if (!member_form(dx, dy, forms[i]))
+                return; // two nodes moved onto each other
+            t.weight += mass_per_length[i] * std::sqrt(dx * dx + dy * dy);
+            if (carries[i])
+                a.element[i] = E[i] * A[i] * forms[i].axial + E[i] * I[i] * forms[i].bending;
+            else
+                a.element[i].setZero();
+        }
+        if (a.solver.factorize(assemble_reduced(map, beams, a.element)) != 0)
+            return;
+        map.expand(a.solver.solve(F_r), a.u);
+
+        t.max_stress = 0.0;
+        Vector6d d;
+        for (int i = 0; i < num_beams; ++i)
+        {
+            if (!carries[i])
+                continue;
+            d << a.u.segment<3>(beams[i].nodes[0] * 3), a.u.segment<3>(beams[i].nodes[1] * 3);
+            t.max_stress = std::max(t.max_stress, member_combined_stress(forms[i], E[i], E[i] * I[i],
+                                                                         cache.inv_section_modulus[i], d));
+        }
+        t.ok = true;
+        if (out.initial_weight > 0.0)
+            t.merit = merit(t);
+    };
+
+    // d(weight)/dx and d(smooth max stress)/dx in scaled variables, about the design on `a`
+    auto gradient = [&](const Analysis &a, std::vector<double> &d_weight, std::vector<double> &d_stress)
+    {
+        SensitivityResponse response;
+        response.type = SensitivityResponse::MaxStress;
+        response.aggregation = options.aggregation;
+        response.reference = reference;
+        SensitivityResults sensitivity;
+        compute_sensitivities(a.nodes, beams, materials, shapes, map, cache, a.solver, forces, a.u, active,
+                              {response}, sensitivity);
+        const ResponseSensitivity &s = sensitivity.responses[0];
+
+        // member length dL/d(x2 - x1) = (x2 - x1) / L
+        std::vector<double> node_weight(num_nodes * 2, 0.0);
+        for (int i = 0; i < num_beams; ++i)
+        {
+            const Node &n1 = a.nodes[beams[i].nodes[0]];
+            const Node &n2 = a.nodes[beams[i].nodes[1]];
+            double dx = n2.position[0] - n1.position[0];
+            double dy = n2.position[1] - n1.position[1];
+            double L = std::sqrt(dx * dx + dy * dy);
+            for (int k = 0; k < 2; ++k)
+            {
+                double g = mass_per_length[i] * (k == 0 ? dx : dy) / L;
+                node_weight[beams[i].nodes[1] * 2 + k] += g;
+                node_weight[beams[i].nodes[0] * 2 + k] -= g;
+            }
+        }
+        for (int j = 0; j < num_vars; ++j)
+        {
+            const ShapeVariable &v = options.variables[j];
+            d_weight[j] = node_weight[v.node * 2 + v.dof] * range[j];
+            d_stress[j] = (v.dof == 0 ? s.node_x[v.node] : s.node_y[v.node]) * range[j];
+        }
+    };
+
+    // starting points: the model's coordinates, then random points in the bounds
+    std::vector<std::vector<double>> initial(starts, std::vector<double>(num_vars, 0.0));
+    for (int j = 0; j < num_vars; ++j)
+    {
+        const ShapeVariable &v = options.variables[j];
+        double x = nodes[v.node].position[v.dof];
+        initial[0][j] = range[j] > 0.0 ? std::min(std::max((x - v.lower) / range[j], 0.0), 1.0) : 0.0;
+    }
+    for (int s = 1; s < starts; ++s)
+    {
+        std::mt19937 rng(static_cast<unsigned>(s));
+        std::uniform_real_distribution<double> uniform(0.0, 1.0);
+        for (int j = 0; j < num_vars; ++j)
+            initial[s][j] = uniform(rng);
+    }
+
+    // the model itself sets the weight scale (and the stress scale of MaxStress)
+    {
+        Analysis a;
+        a.nodes = nodes;
+        a.element.resize(num_beams);
+        a.solver = solver;
+        Trial t;
+        t.x = initial[0];
+        evaluate(a, t);
+        if (!t.ok || !(t.weight > 0.0))
+            return -1;
+        out.initial_weight = t.weight;
+        out.initial_max_stress = t.max_stress;
+        if (options.objective == ShapeOptions::MaxStress && t.max_stress > 0.0)
+            reference = t.max_stress;
+    }
+
+    std::vector<Run> runs(starts);
+    TaskScheduler::instance().parallel_for(
+        0, starts, 1, [&](int lo, int hi)
+        {
+            // one more slot than line points: the current design's analysis stays intact
+            std::vector<Analysis> slots(line_points + 1);
+            for (Analysis &a : slots)
+            {
+                a.nodes = nodes;
+                a.element.resize(num_beams);
+                a.solver = solver;
+            }
+            std::vector<Trial> trials(line_points);
+            std::vector<double> d_weight(num_vars), d_stress(num_vars), step(num_vars);
+
+            for (int s = lo; s < hi; ++s)
+            {
+                Run &run = runs[s];
+                run.best.x = initial[s];
+                evaluate(slots[0], run.best);
+                ++run.evaluations;
+                if (!run.best.ok)
+                    continue;
+                int current = 0; // slot holding run.best's analysis
+                double move = options.move_limit;
+
+                for (int iteration = 0; iteration < options.max_iterations; ++iteration)
+                {
+                    gradient(slots[current], d_weight, d_stress);
+
+                    // search direction within the move limit and the bounds
+                    auto direction = [&](double mu)
+                    {
+                        double wn = 0.0, sn = 0.0;
+                        for (int j = 0; j < num_vars; ++j)
+                        {
+                            wn = std::max(wn, std::abs(d_weight[j]));
+                            sn = std::max(sn, std::abs(d_stress[j]));
+                        }
+                        for (int j = 0; j < num_vars; ++j)
+                        {
+                            double g = options.objective == ShapeOptions::MaxStress
+                                           ? (sn > 0.0 ? d_stress[j] / sn : 0.0)
+                                           : (wn > 0.0 ? d_weight[j] / wn : 0.0) + (sn > 0.0 ? mu * d_stress[j] / sn : 0.0);
+                            double x = run.best.x[j];
+                            step[j] = range[j] > 0.0 ? std::min(std::max(-move * g, -x), 1.0 - x) : 0.0;
+                        }
+                    };
+                    direction(0.0);
+                    if (options.objective == ShapeOptions::Weight)
+                    {
+                        // lighter while the linearized stress stays within the limit: the stress
+                        // gradient's weight mu by bisection, as a restoration step if none fits
+                        auto predicted = [&]()
+                        {
+                            double g = run.best.max_stress / options.stress_limit - 1.0;
+                            for (int j = 0; j < num_vars; ++j)
+                                g += d_stress[j] / options.stress_limit * step[j];
+                            return g;
+                        };
+                        if (predicted() > 0.0)
+                        {
+                            double mu_lo = -6.0, mu_hi = 6.0; // log10
+                            for (int k = 0; k < 40; ++k)
+                            {
+                                double mid = 0.5 * (mu_lo + mu_hi);
+                                direction(std::pow(10.0, mid));
+                                if (predicted() > 0.0)
+                                    mu_lo = mid;
+                                else
+                                    mu_hi = mid;
+                            }
+                            direction(std::pow(10.0, mu_hi));
+                        }
+                    }
+                    double length = 0.0;
+                    for (int j = 0; j < num_vars; ++j)
+                        length = std::max(length, std::abs(step[j]));
+                    if (length < options.tolerance)
+                    {
+                        run.converged = true;
+                        break;
+                    }
+
+                    // step lengths 1, 1/2, 1/4, ... of the direction, all analysed at once
+                    auto slot_of = [&](int k)
+                    { return k < current ? k : k + 1; };
+                    TaskScheduler::instance().parallel_for(
+                        0, line_points, 1, [&](int first, int last)
+                        {
+                            for (int k = first; k < last; ++k)
+                            {
+                                double alpha = std::ldexp(1.0, -k);
+                                Trial &t = trials[k];
+                                t.x = run.best.x;
+                                for (int j = 0; j < num_vars; ++j)
+                                    t.x[j] = std::min(std::max(t.x[j] + alpha * step[j], 0.0), 1.0);
+                                evaluate(slots[slot_of(k)], t);
+                            }
+                        },
+                        TaskPriority::High, "shape_line_search");
+                    run.evaluations += line_points;
+
+                    int chosen = -1;
+                    for (int k = 0; k < line_points; ++k)
+                    {
+                        if (trials[k].ok && trials[k].merit < run.best.merit - 1e-12 * std::abs(run.best.merit) &&
+                            (chosen < 0 || trials[k].merit < trials[chosen].merit))
+                            chosen = k;
+                    }
+
+                    ShapeIteration it;
+                    it.evaluations = line_points;
+                    if (chosen < 0)
+                    {
+                        // nothing better along this direction: shorter steps next time
+                        move *= std::ldexp(1.0, -line_points);
+                        it.weight = run.best.weight;
+                        it.max_stress = run.best.max_stress;
+                        run.history.push_back(it);
+                        if (move < options.tolerance)
+                        {
+                            run.converged = true;
+                            break;
+                        }
+                        continue;
+                    }
+                    double alpha = std::ldexp(1.0, -chosen);
+                    run.best = trials[chosen];
+                    current = slot_of(chosen);
+                    move = std::min(chosen == 0 ? 1.5 * move : alpha * move, 1.0);
+                    it.weight = run.best.weight;
+                    it.max_stress = run.best.max_stress;
+                    it.step = alpha * length;
+                    run.history.push_back(it);
+                }
+            } },
+        TaskPriority::High, "shape_starts");
+
+    int best = -1;
+    for (int s = 0; s < starts; ++s)
+    {
+        out.evaluations += runs[s].evaluations;
+        out.start_weight.push_back(runs[s].best.ok ? runs[s].best.weight : 0.0);
+        out.start_max_stress.push_back(runs[s].best.ok ? runs[s].best.max_stress : 0.0);
+        if (runs[s].best.ok && (best < 0 || runs[s].best.merit < runs[best].best.merit))
+            best = s;
+    }
+    if (best < 0)
+        return -1;
+
+    const Run &run = runs[best];
+    out.best_start = best;
+    out.history = run.history;
+    out.coordinates.resize(num_vars);
+    for (int j = 0; j < num_vars; ++j)
+        out.coordinates[j] = options.variables[j].lower + run.best.x[j] * range[j];
+    out.weight = run.best.weight;
+    out.max_stress = run.best.max_stress;
+    out.feasible = out.max_stress <= options.stress_limit * (1.0 + 1e-3);
+    out.converged = run.converged;
+    out.wall_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return options.objective == ShapeOptions::Weight && !out.feasible ? 1 : 0;
+}
@@ -0,0 +1,83 @@
+#pragma once
+#include <vector>
+#include <Eigen/Eigen>
+#include "node.h"
+#include "beam.h"
+#include "beam_props.h"
+#include "dof_map.h"
+#include "element_cache.h"
+#include "sparse_solver.h"
+
+// One node coordinate the optimizer may move
+struct ShapeVariable
+{
+    int node = -1;
+    int dof = 1;         // 0: x, 1: y
+    double lower = 0.0;  // m, bounds of the coordinate
+    double upper = 0.0;
+};
+
+struct ShapeOptions
+{
+    enum Objective
+    {
+        Weight,   // lightest structure whose stresses stay within stress_limit
+        MaxStress // lowest largest member stress
+    };
+
+    Objective objective = Weight;
+    std::vector<ShapeVariable> variables;
+    double stress_limit = 165e6; // Pa, on |combined stress| (Weight)
+    double move_limit = 0.1;     // first step, as a fraction of each variable's range
+    int line_points = 8;         // step lengths tried concurrently along each search direction
+    int starts = 1;              // the model's coordinates plus starts - 1 random points in the bounds
+    int max_iterations = 50;
+    double tolerance = 1e-4;     // stop once the step is below this fraction of the ranges
+    double aggregation = 100.0;  // sharpness of the smooth maximum the stress gradients come from
+};
+
+struct ShapeIteration
+{
+    double weight = 0.0;     // kg
+    double max_stress = 0.0; // Pa, largest |combined stress|
+    double step = 0.0;       // largest coordinate change taken, as a fraction of its range
+    int evaluations = 0;     // analyses of the line search
+};
+
+struct ShapeResults
+{
+    std::vector<double> coordinates;     // m, final value of each variable
+    std::vector<ShapeIteration> history; // of the best start
+    std::vector<double> start_weight;    // kg, final design of every start
+    std::vector<double> start_max_stress;
+    int best_start = 0;
+    double initial_weight = 0.0;
+    double initial_max_stress = 0.0;
+    double weight = 0.0;
+    double max_stress = 0.0;
+    bool feasible = false;  // max_stress within stress_limit (Weight)
+    bool converged = false; // the best start stopped on tolerance, not max_iterations
+    int evaluations = 0;    // static analyses over all starts
+    double wall_seconds = 0.0;
+};
+
+// Moves the variables' node coordinates within their bounds to minimize options' objective for
+// the loads `forces`, with the members, sections and supports held. Search directions come from
+// adjoint coordinate sensitivities (weight analytically, stress through a smooth maximum) and a
+// line search along each tries options.line_points step lengths at once, every candidate on its
+// own copy of the node array and of `solver` (K in `map`'s numbering): the connectivity never
+// changes, so the copies refactor on the ordering and symbolic analysis `solver` already holds.
+// Multi-starts run concurrently too. Members with `active` 0 (slack one-way members) stay slack.
+// Returns 0 on success, 1 if the stress limit could not be met (Weight), -1 if a variable names
+// a missing node or repeats one, or the structure is singular at the start.
+int optimize_shape(const std::vector<Node> &nodes,
+                   const std::vector<Beam> &beams,
+                   const std::vector<MaterialProfile> &materials,
+                   const std::vector<BeamProfile> &shapes,
+                   const DofMap &map,
+                   const ElementCache &cache,
+                   const Eigen::VectorXd &forces,
+                   const std::vector<char> &active,
+                   const ShapeOptions &options,
+                   const SparseSolver &solver,
+                   ShapeResults &out);
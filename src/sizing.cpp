@@ -0,0 +1,650 @@
+#include "sizing.h"
+#include "sensitivity.h"
+#include "task_scheduler.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+namespace
+{
+    // K for the current member stiffnesses, as the last factorization plus a low-rank correction.
+    // A member's stiffness change is EA' - EA times its axial matrix plus EI' - EI times its
+    // bending matrix, so with U = [sqrt(L) p, bending eigenvectors] fixed by the geometry the
+    // change is U D U^T, D = diag(dEA, dEI, dEI), and K0^-1 U is reused for as long as the
+    // factorization is.
+    class Reanalysis
+    {
+    public:
+        Reanalysis(const DofMap &map, const std::vector<Beam> &beams, const std::vector<MemberForm> &forms,
+                   const std::vector<char> &carries, SparseSolver &solver)
+            : map(map), beams(beams), forms(forms), carries(carries), solver(solver), members(forms.size())
+        {
+        }
+
+        int refactorizations = 0;
+
+        // 0 when K for (ea, ei) is ready to solve with, -1 if it is singular
+        int set(const std::vector<double> &ea, const std::vector<double> &ei, int max_rank, bool &refactored)
+        {
+            refactored = false;
+            changed.clear();
+            int rank = 0;
+            if (!base_ea.empty())
+            {
+                for (size_t i = 0; i < members.size(); ++i)
+                {
+                    if (!carries[i] || (ea[i] == base_ea[i] && ei[i] == base_ei[i]))
+                        continue;
+                    build_columns(static_cast<int>(i));
+                    changed.push_back(static_cast<int>(i));
+                    rank += static_cast<int>(members[i].u.cols());
+                }
+            }
+
+            if (base_ea.empty() || rank > max_rank)
+            {
+                refactored = true;
+                return factor(ea, ei);
+            }
+            if (changed.empty())
+                return 0;
+
+            // K0^-1 U for members changed for the first time since the factorization
+            TaskScheduler::instance().parallel_for(
+                0, static_cast<int>(changed.size()), 1, [&](int lo, int hi)
+                {
+                    Eigen::VectorXd column(map.num_reduced);
+                    for (int c = lo; c < hi; ++c)
+                    {
+                        Member &m = members[changed[c]];
+                        if (m.z.cols() == m.u.cols())
+                            continue;
+                        m.z.resize(map.num_reduced, m.u.cols());
+                        for (int k = 0; k < m.u.cols(); ++k)
+                        {
+                            column.setZero();
+                            for (size_t r = 0; r < m.rows.size(); ++r)
+                                column(m.rows[r]) = m.u(r, k);
+                            m.z.col(k) = solver.solve(column);
+                        }
+                    } },
+                TaskPriority::High, "sizing_update");
+
+            // (K0 + U D U^T)^-1 b = x0 - Z (I + D U^T Z)^-1 D U^T x0
+            Z.resize(map.num_reduced, rank);
+            D.resize(rank);
+            int offset = 0;
+            for (int i : changed)
+            {
+                const Member &m = members[i];
+                int r = static_cast<int>(m.u.cols());
+                Z.middleCols(offset, r) = m.z;
+                D(offset) = ea[i] - base_ea[i];
+                for (int k = 1; k < r; ++k)
+                    D(offset + k) = ei[i] - base_ei[i];
+                offset += r;
+            }
+            Eigen::MatrixXd capacitance = Eigen::MatrixXd::Identity(rank, rank);
+            offset = 0;
+            for (int i : changed)
+            {
+                const Member &m = members[i];
+                int r = static_cast<int>(m.u.cols());
+                Eigen::MatrixXd z_rows(m.rows.size(), rank);
+                for (size_t row = 0; row < m.rows.size(); ++row)
+                    z_rows.row(row) = Z.row(m.rows[row]);
+                capacitance.middleRows(offset, r) += D.segment(offset, r).asDiagonal() * (m.u.transpose() * z_rows);
+                offset += r;
+            }
+            lu.compute(capacitance);
+            if (!(lu.rcond() > 1e-12))
+            {
+                refactored = true;
+                return factor(ea, ei);
+            }
+            return 0;
+        }
+
+        void solve(const Eigen::VectorXd &b, Eigen::VectorXd &x) const
+        {
+            x = solver.solve(b);
+            if (changed.empty())
+                return;
+            Eigen::VectorXd y(D.size());
+            int offset = 0;
+            for (int i : changed)
+            {
+                const Member &m = members[i];
+                Eigen::VectorXd x_rows(m.rows.size());
+                for (size_t row = 0; row < m.rows.size(); ++row)
+                    x_rows(row) = x(m.rows[row]);
+                y.segment(offset, m.u.cols()) = m.u.transpose() * x_rows;
+                offset += static_cast<int>(m.u.cols());
+            }
+            x -= Z * lu.solve(D.cwiseProduct(y));
+        }
+
+    private:
+        struct Member
+        {
+            std::vector<int> rows; // reduced rows of the member's DOFs
+            Eigen::MatrixXd u;     // rows.size() x (1 or 3) unit update columns
+            Eigen::MatrixXd z;     // K0^-1 U over all reduced DOFs
+        };
+
+        int factor(const std::vector<double> &ea, const std::vector<double> &ei)
+        {
+            std::vector<Matrix6d> element(members.size());
+            for (size_t i = 0; i < members.size(); ++i)
+            {
+                if (carries[i])
+                    element[i] = ea[i] * forms[i].axial + ei[i] * forms[i].bending;
+                else
+                    element[i].setZero(); // kept as structural zeros
+            }
+            ++refactorizations;
+            changed.clear();
+            for (Member &m : members)
+                m.z.resize(0, 0);
+            base_ea = ea;
+            base_ei = ei;
+            return solver.factorize(assemble_reduced(map, beams, element));
+        }
+
+        void build_columns(int i)
+        {
+            Member &m = members[i];
+            if (m.u.cols() > 0)
+                return;
+
+            int columns = beams[i].is_truss ? 1 : 3;
+            Eigen::Matrix<double, 6, 3> global = Eigen::Matrix<double, 6, 3>::Zero();
+            double L = 1.0 / forms[i].p.head<2>().norm(); // p = [-c, -s, 0, c, s, 0] / L
+            global.col(0) = std::sqrt(L) * forms[i].p;    // axial = L p p^T
+            if (columns == 3)
+            {
+                // bending is positive semidefinite of rank 2: its two nonzero eigenpairs
+                Eigen::SelfAdjointEigenSolver<Matrix6d> eig(forms[i].bending);
+                for (int k = 0; k < 2; ++k)
+                    global.col(1 + k) = std::sqrt(std::max(eig.eigenvalues()(5 - k), 0.0)) * eig.eigenvectors().col(5 - k);
+            }
+
+            // scatter onto the reduced rows (sliders fold two DOFs onto one)
+            m.u = Eigen::MatrixXd::Zero(6, columns);
+            for (int a = 0; a < 6; ++a)
+            {
+                int g = beams[i].nodes[a / 3] * 3 + a % 3;
+                int r = map.index[g];
+                if (r < 0)
+                    continue;
+                auto it = std::find(m.rows.begin(), m.rows.end(), r);
+                int local = static_cast<int>(it - m.rows.begin());
+                if (it == m.rows.end())
+                    m.rows.push_back(r);
+                m.u.row(local) += map.scale[g] * global.row(a).head(columns);
+            }
+            m.u.conservativeResize(m.rows.size(), columns);
+        }
+
+        const DofMap &map;
+        const std::vector<Beam> &beams;
+        const std::vector<MemberForm> &forms;
+        const std::vector<char> &carries;
+        SparseSolver &solver;
+
+        std::vector<Member> members;
+        std::vector<double> base_ea, base_ei; // what the factorization holds
+        std::vector<int> changed;
+        Eigen::MatrixXd Z;
+        Eigen::VectorXd D;
+        Eigen::PartialPivLU<Eigen::MatrixXd> lu;
+    };
+} // namespace
+
+int optimize_sizing(const std::vector<Node> &nodes,
+                    const std::vector<Beam> &beams,
+                    const std::vector<MaterialProfile> &materials,
+                    const std::vector<BeamProfile> &shapes,
+                    const DofMap &map,
+                    const ElementCache &cache,
+                    const Eigen::VectorXd &forces,
+                    const std::vector<char> &active,
+                    const SizingOptions &options,
+                    SparseSolver &solver,
+                    SizingResults &out)
+{
+    out = SizingResults();
+    int num_beams = static_cast<int>(beams.size());
+    int num_nodes = static_cast<int>(nodes.size());
+    if (map.num_reduced == 0 || cache.count != num_beams || !(options.stress_limit > 0.0))
+        return -1;
+
+    // library profiles lightest first (same material, so lighter = smaller area)
+    std::vector<int> library;
+    for (int k = 0; k < static_cast<int>(shapes.size()); ++k)
+    {
+        if (shapes[k].area > 0.0)
+            library.push_back(k);
+    }
+    std::sort(library.begin(), library.end(), [&](int a, int b)
+              { return shapes[a].area < shapes[b].area; });
+    if (library.empty())
+        return -1;
+
+    auto start = std::chrono::steady_clock::now();
+
+    // fixed member data and the starting sections
+    std::vector<MemberForm> forms(num_beams);
+    std::vector<char> carries(num_beams, 0);
+    std::vector<double> E(num_beams), mass_per_area(num_beams);
+    std::vector<double> A(num_beams), I(num_beams), Z(num_beams);
+    std::vector<double> A0(num_beams), I0(num_beams), Z0(num_beams);
+    out.profile.resize(num_beams);
+    for (int i = 0; i < num_beams; ++i)
+    {
+        const Beam &beam = beams[i];
+        const BeamProfile &shape = shapes[beam.shape_idx];
+        double dx = nodes[beam.nodes[1]].position[0] - nodes[beam.nodes[0]].position[0];
+        double dy = nodes[beam.nodes[1]].position[1] - nodes[beam.nodes[0]].position[1];
+        carries[i] = member_form(dx, dy, forms[i]) && (active.empty() || active[i]);
+        if (carries[i] && !(shape.area > 0.0))
+            return -1;
+        E[i] = materials[beam.material_idx].youngs_modulus;
+        mass_per_area[i] = materials[beam.material_idx].density * cache.length[i];
+        out.profile[i] = beam.shape_idx;
+        A[i] = A0[i] = shape.area;
+        I[i] = I0[i] = beam.is_truss ? 0.0 : shape.moment_of_inertia;
+        Z[i] = Z0[i] = shape.section_modulus;
+    }
+    auto weight = [&]()
+    {
+        double w = 0.0;
+        for (int i = 0; i < num_beams; ++i)
+            w += mass_per_area[i] * A[i];
+        return w;
+    };
+    auto use_profile = [&](int i, int k)
+    {
+        out.profile[i] = k;
+        A[i] = shapes[k].area;
+        I[i] = beams[i].is_truss ? 0.0 : shapes[k].moment_of_inertia;
+        Z[i] = shapes[k].section_modulus;
+    };
+    auto use_area = [&](int i, double area)
+    {
+        double ratio = area / A0[i];
+        A[i] = area;
+        I[i] = I0[i] * ratio * ratio;
+        Z[i] = Z0[i] * std::pow(ratio, 1.5);
+    };
+    out.initial_weight = weight();
+
+    Reanalysis reanalysis(map, beams, forms, carries, solver);
+    Eigen::VectorXd F_r = map.restrict(forces);
+    Eigen::VectorXd u_r, u, lambda_r, lambda;
+    std::vector<double> ea(num_beams), ei(num_beams);
+    std::vector<double> axial(num_beams), bending(num_beams); // |P|/A and max |M|/Z
+    out.stress_ratio.assign(num_beams, 0.0f);
+    int worst_node = -1;
+    double deflection = 0.0;
+
+    // static response at the current sizes: stress ratios and the largest node translation
+    auto analyze = [&]() -> int
+    {
+        for (int i = 0; i < num_beams; ++i)
+        {
+            ea[i] = E[i] * A[i];
+            ei[i] = E[i] * I[i];
+        }
+        SizingIteration step;
+        if (reanalysis.set(ea, ei, options.max_update_rank, step.refactored) != 0)
+            return -1;
+        reanalysis.solve(F_r, u_r);
+        map.expand(u_r, u);
+        ++out.analyses;
+
+        TaskScheduler::instance().parallel_for(
+            0, num_beams, 256, [&](int lo, int hi)
+            {
+                Eigen::Matrix<double, 6, 1> d;
+                for (int i = lo; i < hi; ++i)
+                {
+                    axial[i] = bending[i] = 0.0;
+                    out.stress_ratio[i] = 0.0f;
+                    if (!carries[i])
+                        continue;
+                    d << u.segment<3>(beams[i].nodes[0] * 3), u.segment<3>(beams[i].nodes[1] * 3);
+                    double stress = member_combined_stress(forms[i], E[i], E[i] * I[i], inverse_section_modulus(Z[i]), d,
+                                                           &axial[i]);
+                    bending[i] = stress - axial[i];
+                    out.stress_ratio[i] = static_cast<float>(stress / options.stress_limit);
+                } },
+            TaskPriority::High, "sizing_members");
+
+        deflection = 0.0;
+        worst_node = -1;
+        for (int n = 0; n < num_nodes; ++n)
+        {
+            double d = std::hypot(u(n * 3), u(n * 3 + 1));
+            if (d > deflection)
+            {
+                deflection = d;
+                worst_node = n;
+            }
+        }
+        step.weight = weight();
+        step.max_stress_ratio = out.stress_ratio.empty() ? 0.0 : *std::max_element(out.stress_ratio.begin(), out.stress_ratio.end());
+        step.max_deflection = deflection;
+        out.history.push_back(step);
+        return 0;
+    };
+    auto deflection_ok = [&]()
+    { return options.deflection_limit <= 0.0 || deflection <= options.deflection_limit * (1.0 + 1e-3); };
+    auto feasible = [&]()
+    { return out.history.back().max_stress_ratio <= 1.0 + 1e-3 && deflection_ok(); };
+
+    // d(deflection)/d(EA) and d/d(EI) per member by one adjoint solve of the worst node
+    std::vector<double> d_ea(num_beams), d_ei(num_beams);
+    auto deflection_gradient = [&]()
+    {
+        Eigen::VectorXd load = Eigen::VectorXd::Zero(map.total_dof);
+        load(worst_node * 3) = u(worst_node * 3) / deflection;
+        load(worst_node * 3 + 1) = u(worst_node * 3 + 1) / deflection;
+        reanalysis.solve(map.restrict(load), lambda_r);
+        map.expand(lambda_r, lambda);
+        TaskScheduler::instance().parallel_for(
+            0, num_beams, 256, [&](int lo, int hi)
+            {
+                Eigen::Matrix<double, 6, 1> d, l;
+                for (int i = lo; i < hi; ++i)
+                {
+                    d_ea[i] = d_ei[i] = 0.0;
+                    if (!carries[i])
+                        continue;
+                    d << u.segment<3>(beams[i].nodes[0] * 3), u.segment<3>(beams[i].nodes[1] * 3);
+                    l << lambda.segment<3>(beams[i].nodes[0] * 3), lambda.segment<3>(beams[i].nodes[1] * 3);
+                    d_ea[i] = -l.dot(forms[i].axial * d);
+                    d_ei[i] = -l.dot(forms[i].bending * d);
+                } },
+            TaskPriority::High, "sizing_gradient");
+    };
+    // d(deflection)/d(area) with I and Z following the area
+    auto area_gradient = [&](int i)
+    { return E[i] * d_ea[i] + (A[i] > 0.0 ? E[i] * 2.0 * I[i] / A[i] * d_ei[i] : 0.0); };
+
+    // area at the stress limit with the member's forces held: stress ~ A^-1 axially and
+    // A^-1.5 in bending. In a redundant frame a member can be stressed mostly by compatibility
+    // (a stiffer member attracts the force), so one whose stress hardly fell after it grew is
+    // held at its size instead of grown further
+    std::vector<double> previous_area(num_beams, 0.0), previous_stress(num_beams, 0.0);
+    auto stressed_area = [&](int i)
+    {
+        double stress = axial[i] + bending[i];
+        double grown = previous_area[i] > 0.0 ? std::log(A[i] / previous_area[i]) : 0.0;
+        bool held = grown > 1e-3 && previous_stress[i] > 0.0 && stress > options.stress_limit &&
+                    std::log(previous_stress[i] / stress) < 0.25 * grown;
+        previous_area[i] = A[i];
+        previous_stress[i] = stress;
+        if (stress <= 0.0)
+            return options.min_area;
+        if (held)
+            return A[i];
+        double exponent = (axial[i] + 1.5 * bending[i]) / stress;
+        return A[i] * std::pow(stress / options.stress_limit, 1.0 / exponent);
+    };
+
+    int result = 0;
+
+    // continuous phase: fully stressed or optimality criteria
+    if (!options.discrete || options.method == SizingOptions::Gradient)
+    {
+        for (int i = 0; i < num_beams; ++i)
+        {
+            if (carries[i])
+                use_area(i, std::min(std::max(A[i], options.min_area), options.max_area));
+        }
+        std::vector<double> next(num_beams), lo(num_beams), hi(num_beams), c(num_beams);
+        // each member's move limit halves whenever its resizing reverses direction
+        std::vector<double> move(num_beams, options.move_limit);
+        std::vector<signed char> direction(num_beams, 0);
+        for (int iteration = 0; iteration < options.max_iterations; ++iteration)
+        {
+            if (analyze() != 0)
+                return -1;
+            bool check_deflection = options.deflection_limit > 0.0 && worst_node >= 0;
+            if (check_deflection)
+                deflection_gradient();
+
+            bool gradient = options.method == SizingOptions::Gradient;
+            for (int i = 0; i < num_beams; ++i)
+            {
+                next[i] = A[i];
+                if (!carries[i])
+                    continue;
+                lo[i] = std::max(options.min_area, A[i] * std::max(1.0 - move[i], 0.0));
+                hi[i] = std::min(options.max_area, A[i] * (1.0 + move[i]));
+                next[i] = std::min(std::max(stressed_area(i), lo[i]), hi[i]);
+                lo[i] = next[i]; // the stress limit is a lower bound for the deflection step
+                // reciprocal linearization: deflection ~ const + sum c_i / A_i
+                c[i] = check_deflection ? std::max(-area_gradient(i) * A[i] * A[i], 0.0) : 0.0;
+            }
+
+            if (check_deflection)
+            {
+                double base = deflection;
+                for (int i = 0; i < num_beams; ++i)
+                    base -= carries[i] ? c[i] / A[i] : 0.0;
+                auto predicted = [&](const std::vector<double> &a)
+                {
+                    double d = base;
+                    for (int i = 0; i < num_beams; ++i)
+                        d += carries[i] ? c[i] / a[i] : 0.0;
+                    return d;
+                };
+
+                if (predicted(next) > options.deflection_limit)
+                {
+                    if (!gradient)
+                    {
+                        // fully stressed: scale the stress sizes uniformly until the deflection fits
+                        double fixed = 0.0, scaled = 0.0;
+                        for (int i = 0; i < num_beams; ++i)
+                            scaled += carries[i] ? c[i] / next[i] : 0.0;
+                        fixed = options.deflection_limit - base;
+                        double factor = fixed > 0.0 ? scaled / fixed : 10.0;
+                        for (int i = 0; i < num_beams; ++i)
+                        {
+                            if (carries[i])
+                                next[i] = std::min(next[i] * std::max(factor, 1.0), options.max_area);
+                        }
+                    }
+                    else
+                    {
+                        // optimality criteria: a_i = sqrt(mu c_i / w_i), mu by bisection (log scale)
+                        auto sizes = [&](double mu)
+                        {
+                            for (int i = 0; i < num_beams; ++i)
+                            {
+                                if (!carries[i])
+                                    continue;
+                                double a = c[i] > 0.0 ? std::sqrt(mu * c[i] / mass_per_area[i]) : lo[i];
+                                next[i] = std::min(std::max(a, lo[i]), hi[i]);
+                            }
+                        };
+                        double mu_lo = -80.0, mu_hi = 80.0; // log10
+                        for (int k = 0; k < 100; ++k)
+                        {
+                            double mid = 0.5 * (mu_lo + mu_hi);
+                            sizes(std::pow(10.0, mid));
+                            if (predicted(next) > options.deflection_limit)
+                                mu_lo = mid;
+                            else
+                                mu_hi = mid;
+                        }
+                        sizes(std::pow(10.0, mu_hi));
+                    }
+                }
+            }
+
+            double largest_change = 0.0;
+            int changed = 0;
+            for (int i = 0; i < num_beams; ++i)
+            {
+                if (!carries[i])
+                    continue;
+                double change = std::abs(next[i] - A[i]) / A[i];
+                largest_change = std::max(largest_change, change);
+                if (change <= options.tolerance)
+                    continue;
+                ++changed;
+                signed char sign = next[i] > A[i] ? 1 : -1;
+                if (sign == -direction[i])
+                    move[i] *= 0.5;
+                else
+                    move[i] = std::min(move[i] * 1.2, options.move_limit);
+                direction[i] = sign;
+            }
+            out.history.back().changed = changed;
+            // settled, whether or not every limit could be met
+            if (largest_change <= options.tolerance)
+            {
+                out.converged = true;
+                break;
+            }
+            for (int i = 0; i < num_beams; ++i)
+            {
+                if (carries[i])
+                    use_area(i, next[i]);
+            }
+        }
+
+        if (!out.converged && analyze() != 0)
+            return -1;
+        result = feasible() ? 0 : 1;
+
+        // discrete: lightest library profile at least as large in every section property
+        if (options.discrete)
+        {
+            for (int i = 0; i < num_beams; ++i)
+            {
+                if (!carries[i])
+                    continue;
+                int pick = library.back();
+                for (int k : library)
+                {
+                    if (shapes[k].area >= A[i] * (1.0 - 1e-9) &&
+                        (beams[i].is_truss || (shapes[k].moment_of_inertia >= I[i] * (1.0 - 1e-9) &&
+                                               shapes[k].section_modulus >= Z[i] * (1.0 - 1e-9))))
+                    {
+                        pick = k;
+                        break;
+                    }
+                }
+                use_profile(i, pick);
+            }
+        }
+    }
+
+    // discrete phase: lightest profile that passes the stress check with the current member
+    // forces; deflection raises floors on the members that stiffen it most per kg
+    if (options.discrete)
+    {
+        std::vector<int> rank(num_beams, 0), floor_rank(num_beams, 0);
+        for (int i = 0; i < num_beams; ++i)
+            rank[i] = static_cast<int>(std::find(library.begin(), library.end(), out.profile[i]) - library.begin());
+
+        out.converged = false;
+        for (int iteration = 0; iteration < options.max_iterations; ++iteration)
+        {
+            if (analyze() != 0)
+                return -1;
+
+            std::vector<int> next = rank;
+            for (int i = 0; i < num_beams; ++i)
+            {
+                if (!carries[i])
+                    continue;
+                // forces P and M are held while the profile changes
+                double P = axial[i] * A[i];
+                double M = bending[i] * std::abs(Z[i]);
+                next[i] = static_cast<int>(library.size()) - 1;
+                for (int k = floor_rank[i]; k < static_cast<int>(library.size()); ++k)
+                {
+                    const BeamProfile &shape = shapes[library[k]];
+                    double z = std::abs(shape.section_modulus) > 1e-12 ? std::abs(shape.section_modulus) : 0.0;
+                    double stress = P / shape.area + (z > 0.0 && !beams[i].is_truss ? M / z : 0.0);
+                    if (stress <= options.stress_limit)
+                    {
+                        next[i] = k;
+                        break;
+                    }
+                }
+            }
+
+            if (!deflection_ok() && worst_node >= 0)
+            {
+                // next size up of each member ranked by deflection change per kg
+                deflection_gradient();
+                std::vector<std::pair<double, int>> candidates;
+                for (int i = 0; i < num_beams; ++i)
+                {
+                    int k = std::max(next[i], rank[i]) + 1;
+                    if (!carries[i] || k >= static_cast<int>(library.size()))
+                        continue;
+                    const BeamProfile &shape = shapes[library[k]];
+                    double dEA = E[i] * (shape.area - A[i]);
+                    double dEI = beams[i].is_truss ? 0.0 : E[i] * (shape.moment_of_inertia - I[i]);
+                    double gain = d_ea[i] * dEA + d_ei[i] * dEI;
+                    double cost = mass_per_area[i] * (shape.area - A[i]);
+                    if (gain < 0.0 && cost > 0.0)
+                        candidates.push_back({gain / cost, i});
+                }
+                std::sort(candidates.begin(), candidates.end());
+                double needed = deflection - options.deflection_limit;
+                for (const auto &candidate : candidates)
+                {
+                    int i = candidate.second;
+                    int k = std::max(next[i], rank[i]) + 1;
+                    const BeamProfile &shape = shapes[library[k]];
+                    needed += d_ea[i] * E[i] * (shape.area - A[i]) +
+                              (beams[i].is_truss ? 0.0 : d_ei[i] * E[i] * (shape.moment_of_inertia - I[i]));
+                    next[i] = k;
+                    floor_rank[i] = k;
+                    if (needed <= 0.0)
+                        break;
+                }
+            }
+
+            int changed = 0;
+            for (int i = 0; i < num_beams; ++i)
+            {
+                if (next[i] != rank[i])
+                {
+                    ++changed;
+                    rank[i] = next[i];
+                    use_profile(i, library[rank[i]]);
+                }
+            }
+            out.history.back().changed = changed;
+            if (changed == 0)
+            {
+                out.converged = true;
+                break;
+            }
+        }
+        if (!out.converged && analyze() != 0)
+            return -1;
+        result = feasible() ? 0 : 1;
+    }
+
+    out.area = A;
+    out.inertia = I;
+    out.section_modulus = Z;
+    out.weight = weight();
+    out.max_stress_ratio = out.history.back().max_stress_ratio;
+    out.max_deflection = deflection;
+    out.feasible = result == 0;
+    out.refactorizations = reanalysis.refactorizations;
+    out.wall_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return result;
+}
@@ -0,0 +1,77 @@
+#pragma once
+#include <vector>
+#include <Eigen/Eigen>
+#include "node.h"
+#include "beam.h"
+#include "beam_props.h"
+#include "dof_map.h"
+#include "element_cache.h"
+#include "sparse_solver.h"
+
+struct SizingOptions
+{
+    enum Method
+    {
+        FullyStressed, // resize every member to its stress limit, deflection by uniform scaling
+        Gradient       // optimality criteria on adjoint deflection sensitivities, stress as minimum sizes
+    };
+
+    Method method = FullyStressed;
+    bool discrete = true;          // pick each member's profile from the library, else a continuous area
+    double stress_limit = 165e6;   // Pa, on |combined stress|
+    double deflection_limit = 0.0; // m, on the largest node translation (0: no limit)
+    double min_area = 1e-5;        // m^2, continuous bounds
+    double max_area = 0.5;
+    double move_limit = 0.5;       // largest relative area change per iteration (continuous)
+    int max_iterations = 50;
+    double tolerance = 1e-3;       // stop once no area changes by more than this (relative)
+    int max_update_rank = 90;      // low-rank correction columns before refactoring (3 per member)
+};
+
+struct SizingIteration
+{
+    double weight = 0.0;           // kg
+    double max_stress_ratio = 0.0; // |stress| / limit of the worst member
+    double max_deflection = 0.0;   // m
+    int changed = 0;               // members resized for the next iteration
+    bool refactored = false;       // this analysis factored K instead of updating it
+};
+
+// Continuous sizes keep each member's profile shape: I scales with area^2 and the section
+// modulus with area^1.5 (geometrically similar sections).
+struct SizingResults
+{
+    std::vector<int> profile;        // chosen library profile per member (discrete)
+    std::vector<double> area;        // final sections per member
+    std::vector<double> inertia;
+    std::vector<double> section_modulus;
+    std::vector<float> stress_ratio; // at the final sizes
+    std::vector<SizingIteration> history;
+    double initial_weight = 0.0;
+    double weight = 0.0;
+    double max_stress_ratio = 0.0;
+    double max_deflection = 0.0;
+    bool feasible = false;
+    bool converged = false;
+    int analyses = 0;
+    int refactorizations = 0;
+    double wall_seconds = 0.0;
+};
+
+// Minimum-weight member sizes for the loads `forces` under options' stress and deflection
+// limits. Every reanalysis reuses `solver`: a few resized members are a low-rank (Woodbury)
+// update of the last factorization, many a numeric refactor on the kept symbolic analysis.
+// Members with `active` 0 (slack one-way members) keep their size and carry nothing.
+// Returns 0 when the final design is feasible, 1 when the limits could not be met, -1 if the
+// model has no usable profile or the structure is singular.
+int optimize_sizing(const std::vector<Node> &nodes,
+                    const std::vector<Beam> &beams,
+                    const std::vector<MaterialProfile> &materials,
+                    const std::vector<BeamProfile> &shapes,
+                    const DofMap &map,
+                    const ElementCache &cache,
+                    const Eigen::VectorXd &forces,
+                    const std::vector<char> &active,
+                    const SizingOptions &options,
+                    SparseSolver &solver,
+                    SizingResults &out);
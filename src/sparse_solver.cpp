@@ -0,0 +1,97 @@
+#include "sparse_solver.h"
+#include <algorithm>
+
+SparseSolver::SparseSolver(const SparseSolver &other)
+{
+    *this = other;
+}
+
+SparseSolver &SparseSolver::operator=(const SparseSolver &other)
+{
+    if (this == &other)
+        return *this;
+
+    perm = other.perm;
+    perm_inv = other.perm_inv;
+    outer = other.outer;
+    inner = other.inner;
+    has_ordering = other.has_ordering;
+    num_rows = other.num_rows;
+    analyses = other.analyses;
+    reuses = other.reuses;
+
+    // Eigen's factorization objects cannot be copied; the next factorize() redoes the cheap
+    // part of the symbolic analysis on the shared ordering
+    permuted = SparseMatrix();
+    ldlt_analyzed = false;
+    is_factored = false;
+    return *this;
+}
+
+bool SparseSolver::same_pattern(const SparseMatrix &A) const
+{
+    if (!has_ordering || !A.isCompressed() || A.rows() != num_rows)
+        return false;
+    if (static_cast<size_t>(A.outerSize() + 1) != outer.size() || static_cast<size_t>(A.nonZeros()) != inner.size())
+        return false;
+    return std::equal(outer.begin(), outer.end(), A.outerIndexPtr()) &&
+           std::equal(inner.begin(), inner.end(), A.innerIndexPtr());
+}
+
+int SparseSolver::factorize(const SparseMatrix &A)
+{
+    is_factored = false;
+
+    if (same_pattern(A))
+    {
+        ++reuses;
+    }
+    else
+    {
+        // A holds both triangles, which is what the AMD ordering expects
+        Eigen::AMDOrdering<int> amd;
+        amd(A, perm_inv);
+        perm = perm_inv.inverse();
+
+        num_rows = static_cast<int>(A.rows());
+        outer.assign(A.outerIndexPtr(), A.outerIndexPtr() + A.outerSize() + 1);
+        inner.assign(A.innerIndexPtr(), A.innerIndexPtr() + A.nonZeros());
+        has_ordering = true;
+        ldlt_analyzed = false;
+        ++analyses;
+    }
+
+    permuted.resize(A.rows(), A.cols());
+    permuted.selfadjointView<Eigen::Lower>() = A.selfadjointView<Eigen::Lower>().twistedBy(perm);
+
+    if (!ldlt_analyzed)
+    {
+        ldlt.analyzePattern(permuted);
+        ldlt_analyzed = true;
+    }
+
+    ldlt.factorize(permuted);
+    if (ldlt.info() != Eigen::Success)
+        return -1;
+
+    // positive definite means every pivot is clearly positive; a near-zero or negative one
+    // is round-off on a singular matrix
+    const Eigen::VectorXd &D = ldlt.vectorD();
+    if (D.size() > 0 && D.minCoeff() <= 1e-13 * D.cwiseAbs().maxCoeff())
+        return -1;
+
+    is_factored = true;
+    return 0;
+}
+
+Eigen::VectorXd SparseSolver::solve(const Eigen::VectorXd &b) const
+{
+    Eigen::VectorXd pb = perm * b;
+    return perm_inv * ldlt.solve(pb);
+}
+
+Eigen::MatrixXd SparseSolver::solve_many(const Eigen::MatrixXd &B) const
+{
+    Eigen::MatrixXd PB = perm * B;
+    return perm_inv * ldlt.solve(PB);
+}
@@ -0,0 +1,47 @@
+#pragma once
+#include <vector>
+#include <Eigen/Eigen>
+#include <Eigen/Sparse>
+#include "dof_map.h"
+
+// Sparse LDL^T factorization of a symmetric positive definite matrix (the reduced stiffness).
+// The fill-reducing (AMD) ordering and elimination tree are kept and reused for as long as
+// the sparsity pattern stays the same, so re-solving after a load, section or material change
+// only redoes the numeric factorization. Copies share the ordering but not the numeric
+// factors: a copy has to be factorize()d before it can solve.
+class SparseSolver
+{
+public:
+    SparseSolver() = default;
+    SparseSolver(const SparseSolver &other);
+    SparseSolver &operator=(const SparseSolver &other);
+
+    // 0 on success, -1 if the matrix is singular or not positive definite
+    int factorize(const SparseMatrix &A);
+    Eigen::VectorXd solve(const Eigen::VectorXd &b) const;
+    Eigen::MatrixXd solve_many(const Eigen::MatrixXd &B) const; // one right-hand side per column
+
+    bool factored() const { return is_factored; }
+    int rows() const { return num_rows; }
+
+    // how often the symbolic analysis was computed vs. reused (for the profiler / debug output)
+    int analyses = 0;
+    int reuses = 0;
+
+private:
+    typedef Eigen::PermutationMatrix<Eigen::Dynamic, Eigen::Dynamic, int> Permutation;
+
+    bool same_pattern(const SparseMatrix &A) const;
+
+    // the ordering is applied here rather than inside Eigen so it can be copied
+    Eigen::SimplicialLDLT<SparseMatrix, Eigen::Lower, Eigen::NaturalOrdering<int>> ldlt;
+    Permutation perm;      // P, factor P A P^T
+    Permutation perm_inv;  // P^T
+    SparseMatrix permuted; // lower triangle of P A P^T
+    std::vector<int> outer; // pattern the ordering was computed for
+    std::vector<int> inner;
+    bool has_ordering = false;
+    bool ldlt_analyzed = false;
+    bool is_factored = false;
+    int num_rows = 0;
+};
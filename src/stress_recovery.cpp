@@ -0,0 +1,326 @@
+#include "stress_recovery.h"
+#include "task_scheduler.h"
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    constexpr int block_size = 256;
+
+    // k' * (T * u_e) for one block of elements already rotated into their local frames,
+    // written out for the 2D frame element so no 6x6 matrices are formed. Branch-free so it
+    // vectorizes across elements.
+    struct BlockOut
+    {
+        double *p1, *v1, *m1, *p2, *v2, *m2;
+        float *stress;
+    };
+
+    void compute_block(int n, const double *u1, const double *w1, const double *t1, const double *u2,
+                       const double *w2, const double *t2, const double *ea_l, const double *ei_l,
+                       const double *len, const double *inv_a, const double *inv_z, BlockOut out)
+    {
+        for (int k = 0; k < n; ++k)
+        {
+            double L = len[k];
+            double inv_L = L > 1e-9 ? 1.0 / L : 0.0;
+            double EI_L = ei_l[k];
+            double EI_L2 = EI_L * inv_L;
+            double EI_L3 = EI_L2 * inv_L;
+
+            double dw = w1[k] - w2[k];
+            double P = ea_l[k] * (u2[k] - u1[k]); // tension positive
+            double V = 12.0 * EI_L3 * dw + 6.0 * EI_L2 * (t1[k] + t2[k]);
+            double Ma = 6.0 * EI_L2 * dw + EI_L * (4.0 * t1[k] + 2.0 * t2[k]);
+            double Mb = 6.0 * EI_L2 * dw + EI_L * (2.0 * t1[k] + 4.0 * t2[k]);
+
+            out.p1[k] = -P;
+            out.v1[k] = V;
+            out.m1[k] = Ma;
+            out.p2[k] = P;
+            out.v2[k] = -V;
+            out.m2[k] = Mb;
+
+            // combined stress P/A +/- M/Z, keeping whichever fibre has the larger magnitude
+            double axial = P * inv_a[k];
+            double bending = std::max(std::abs(Ma), std::abs(Mb)) * inv_z[k];
+            double tension = axial + bending;
+            double compression = axial - bending;
+            out.stress[k] = static_cast<float>(std::abs(tension) > std::abs(compression) ? tension : compression);
+        }
+    }
+
+    // Local end forces for one block of elements: elements first .. first + n - 1, or
+    // elements[first] .. elements[first + n - 1] when an index list is given. Contiguous
+    // blocks read the cache and write `out` in place; listed ones gather and scatter.
+    void recover_block(const ElementCache &cache, const double *u, const int *elements, int first, int n,
+                       ElementForces &out)
+    {
+        double u1[block_size], w1[block_size], t1[block_size];
+        double u2[block_size], w2[block_size], t2[block_size];
+
+        // gather: global displacements rotated into the local frame
+        for (int k = 0; k < n; ++k)
+        {
+            int i = elements ? elements[first + k] : first + k;
+            const double *d1 = u + cache.n1[i] * 3;
+            const double *d2 = u + cache.n2[i] * 3;
+            double c = cache.c[i];
+            double s = cache.s[i];
+
+            u1[k] = c * d1[0] + s * d1[1];
+            w1[k] = -s * d1[0] + c * d1[1];
+            t1[k] = d1[2];
+            u2[k] = c * d2[0] + s * d2[1];
+            w2[k] = -s * d2[0] + c * d2[1];
+            t2[k] = d2[2];
+        }
+
+        if (!elements)
+        {
+            BlockOut dst = {out.p1.data() + first, out.v1.data() + first, out.m1.data() + first,
+                            out.p2.data() + first, out.v2.data() + first, out.m2.data() + first,
+                            out.stress.data() + first};
+            compute_block(n, u1, w1, t1, u2, w2, t2, cache.ea_over_l.data() + first, cache.ei_over_l.data() + first,
+                          cache.length.data() + first, cache.inv_area.data() + first,
+                          cache.inv_section_modulus.data() + first, dst);
+            return;
+        }
+
+        double ea_l[block_size], ei_l[block_size], len[block_size], inv_a[block_size], inv_z[block_size];
+        for (int k = 0; k < n; ++k)
+        {
+            int i = elements[first + k];
+            ea_l[k] = cache.ea_over_l[i];
+            ei_l[k] = cache.ei_over_l[i];
+            len[k] = cache.length[i];
+            inv_a[k] = cache.inv_area[i];
+            inv_z[k] = cache.inv_section_modulus[i];
+        }
+
+        double p1[block_size], v1[block_size], m1[block_size];
+        double p2[block_size], v2[block_size], m2[block_size];
+        float stress[block_size];
+        compute_block(n, u1, w1, t1, u2, w2, t2, ea_l, ei_l, len, inv_a, inv_z, {p1, v1, m1, p2, v2, m2, stress});
+
+        // scatter
+        for (int k = 0; k < n; ++k)
+        {
+            int i = elements[first + k];
+            out.p1[i] = p1[k];
+            out.v1[i] = v1[k];
+            out.m1[i] = m1[k];
+            out.p2[i] = p2[k];
+            out.v2[i] = v2[k];
+            out.m2[i] = m2[k];
+            out.stress[i] = stress[k];
+        }
+    }
+
+    StressRange recover_range(const ElementCache &cache, const Eigen::VectorXd &displacement,
+                              const int *elements, int count, ElementForces &out)
+    {
+        const double *u = displacement.data();
+        StressRange identity = {1e10f, -1e10f};
+
+        return TaskScheduler::instance().parallel_reduce(
+            0, count, 4 * block_size, identity,
+            [&](int lo, int hi)
+            {
+                StressRange range = {1e10f, -1e10f};
+                for (int first = lo; first < hi; first += block_size)
+                {
+                    int n = std::min(block_size, hi - first);
+                    recover_block(cache, u, elements, first, n, out);
+
+                    for (int k = 0; k < n; ++k)
+                    {
+                        float stress = out.stress[elements ? elements[first + k] : first + k];
+                        range.min_stress = std::min(range.min_stress, stress);
+                        range.max_stress = std::max(range.max_stress, stress);
+                    }
+                }
+                return range;
+            },
+            [](const StressRange &a, const StressRange &b)
+            {
+                return StressRange{std::min(a.min_stress, b.min_stress), std::max(a.max_stress, b.max_stress)};
+            },
+            TaskPriority::High, "stress_recovery");
+    }
+} // namespace
+
+StressRange recover_element_forces(const ElementCache &cache,
+                                   const Eigen::VectorXd &displacement,
+                                   ElementForces &out)
+{
+    out.resize(cache.count);
+    return recover_range(cache, displacement, nullptr, cache.count, out);
+}
+
+StressRange recover_element_forces_at(const ElementCache &cache,
+                                      const Eigen::VectorXd &displacement,
+                                      const std::vector<int> &elements,
+                                      ElementForces &out)
+{
+    if (static_cast<int>(out.stress.size()) != cache.count)
+        out.resize(cache.count);
+    return recover_range(cache, displacement, elements.data(), static_cast<int>(elements.size()), out);
+}
+
+void recover_reactions_at(const ElementCache &cache,
+                          const ElementForces &element_forces,
+                          const std::vector<int> &supported_nodes,
+                          const Eigen::VectorXd &forces,
+                          Eigen::VectorXd &reactions,
+                          EquilibriumTotals &totals)
+{
+    for (int d = 0; d < 3; ++d)
+        totals.reaction[d] = 0.0;
+
+    for (int node : supported_nodes)
+    {
+        double rx = -forces(node * 3);
+        double ry = -forces(node * 3 + 1);
+        double rm = -forces(node * 3 + 2);
+
+        for (int k = cache.node_offsets[node]; k < cache.node_offsets[node + 1]; ++k)
+        {
+            int e = cache.node_ends[k] >> 1;
+            bool second = (cache.node_ends[k] & 1) != 0;
+
+            double P = second ? element_forces.p2[e] : element_forces.p1[e];
+            double V = second ? element_forces.v2[e] : element_forces.v1[e];
+            double M = second ? element_forces.m2[e] : element_forces.m1[e];
+
+            // local end force rotated back to global: T^T * {P, V, M}
+            double c = cache.c[e];
+            double s = cache.s[e];
+            rx += c * P - s * V;
+            ry += s * P + c * V;
+            rm += M;
+        }
+
+        reactions(node * 3) = rx;
+        reactions(node * 3 + 1) = ry;
+        reactions(node * 3 + 2) = rm;
+
+        totals.reaction[0] += rx;
+        totals.reaction[1] += ry;
+        totals.reaction[2] += rm;
+    }
+
+    // applied totals: one strided, vectorized pass over the load vector
+    int num_nodes = static_cast<int>(forces.size() / 3);
+    Eigen::Map<const Eigen::Matrix<double, 3, Eigen::Dynamic>> f(forces.data(), 3, num_nodes);
+    Eigen::Vector3d applied = f.rowwise().sum();
+    for (int d = 0; d < 3; ++d)
+        totals.applied[d] = applied(d);
+}
+
+void StationResults::resize(int count, int stations_per_beam)
+{
+    stations = stations_per_beam;
+    size_t n = static_cast<size_t>(count) * static_cast<size_t>(stations_per_beam);
+    axial.resize(n);
+    shear.resize(n);
+    moment.resize(n);
+    stress.resize(n);
+    critical_position.resize(count);
+    critical_stress.resize(count);
+}
+
+void evaluate_stations(const ElementCache &cache,
+                       const ElementForces &element_forces,
+                       int stations,
+                       StationResults &out)
+{
+    if (stations < 2)
+        stations = 2;
+    out.resize(cache.count, stations);
+
+    TaskScheduler::instance().parallel_for(
+        0, cache.count, 4 * block_size, [&](int lo, int hi)
+        {
+            std::vector<double> moment_k(block_size);
+            std::vector<double> stress_k(block_size);
+
+            for (int first = lo; first < hi; first += block_size)
+            {
+                int n = std::min(block_size, hi - first);
+
+                const double *P = element_forces.p2.data() + first;
+                const double *V = element_forces.v1.data() + first;
+                const double *M1 = element_forces.m1.data() + first;
+                const double *M2 = element_forces.m2.data() + first;
+                const double *len = cache.length.data() + first;
+                const double *inv_a = cache.inv_area.data() + first;
+                const double *inv_z = cache.inv_section_modulus.data() + first;
+
+                for (int k = 0; k < stations; ++k)
+                {
+                    double xi = static_cast<double>(k) / (stations - 1);
+
+                    // one station across the whole block, branch-free
+                    for (int b = 0; b < n; ++b)
+                    {
+                        double M = -M1[b] + V[b] * xi * len[b]; // linear between -M1 and M2
+                        double axial = P[b] * inv_a[b];
+                        double bending = std::abs(M) * inv_z[b];
+                        double tension = axial + bending;
+                        double compression = axial - bending;
+                        moment_k[b] = M;
+                        stress_k[b] = std::abs(tension) > std::abs(compression) ? tension : compression;
+                    }
+
+                    for (int b = 0; b < n; ++b)
+                    {
+                        size_t idx = static_cast<size_t>(first + b) * stations + k;
+                        out.axial[idx] = static_cast<float>(P[b]);
+                        out.shear[idx] = static_cast<float>(V[b]);
+                        out.moment[idx] = static_cast<float>(moment_k[b]);
+                        out.stress[idx] = static_cast<float>(stress_k[b]);
+                    }
+                }
+
+                // exact extremum: the end with the larger |M|
+                for (int b = 0; b < n; ++b)
+                {
+                    double m_start = std::abs(M1[b]);
+                    double m_end = std::abs(M2[b]);
+                    bool at_end = m_end > m_start;
+                    double axial = P[b] * inv_a[b];
+                    double bending = (at_end ? m_end : m_start) * inv_z[b];
+                    double tension = axial + bending;
+                    double compression = axial - bending;
+                    out.critical_position[first + b] = at_end ? 1.0f : 0.0f;
+                    out.critical_stress[first + b] = static_cast<float>(std::abs(tension) > std::abs(compression) ? tension : compression);
+                }
+            } },
+        TaskPriority::High, "station_recovery");
+}
+
+void envelope_stations(const ElementCache &cache,
+                       const ElementForces &envelope,
+                       StationResults &out)
+{
+    out.resize(cache.count, 2);
+    for (int i = 0; i < cache.count; ++i)
+    {
+        double P[2] = {envelope.p1[i], envelope.p2[i]};
+        double V[2] = {envelope.v1[i], envelope.v2[i]};
+        double M[2] = {envelope.m1[i], envelope.m2[i]};
+        double end_stress[2];
+        for (int end = 0; end < 2; ++end)
+        {
+            size_t idx = static_cast<size_t>(i) * 2 + end;
+            end_stress[end] = std::abs(P[end]) * cache.inv_area[i] + std::abs(M[end]) * cache.inv_section_modulus[i];
+            out.axial[idx] = static_cast<float>(P[end]);
+            out.shear[idx] = static_cast<float>(V[end]);
+            out.moment[idx] = static_cast<float>(M[end]);
+            out.stress[idx] = static_cast<float>(end_stress[end]);
+        }
+        out.critical_position[i] = end_stress[1] > end_stress[0] ? 1.0f : 0.0f;
+        out.critical_stress[i] = envelope.stress[i];
+    }
+}
@@ -0,0 +1,80 @@
+#pragma once
+#include <vector>
+#include <Eigen/Eigen>
+#include "element_cache.h"
+
+struct StressRange
+{
+    float min_stress;
+    float max_stress;
+};
+
+// Recover local end forces and combined stress for every element from a global
+// displacement vector. Only reads the cached element data, so it can be re-run for a
+// new load case without recomputing any stiffness. Runs in parallel blocks on the
+// task scheduler; each block gathers its displacements into SoA scratch so the force
+// and stress arithmetic is straight-line code the compiler can vectorize.
+StressRange recover_element_forces(const ElementCache &cache,
+                                   const Eigen::VectorXd &displacement,
+                                   ElementForces &out);
+
+// The same recovery for the listed elements only, so a frame that draws a few members does
+// not pay for the rest. Entries of other elements in `out` are left as they were; the range
+// covers the listed elements.
+StressRange recover_element_forces_at(const ElementCache &cache,
+                                      const Eigen::VectorXd &displacement,
+                                      const std::vector<int> &elements,
+                                      ElementForces &out);
+
+// applied and reaction totals per direction {Fx, Fy, Mz}
+struct EquilibriumTotals
+{
+    double applied[3] = {0.0, 0.0, 0.0};
+    double reaction[3] = {0.0, 0.0, 0.0};
+};
+
+// Reactions at the supported nodes only, as the sum of the global end forces of the
+// incident elements minus the applied load (R = K*u - F evaluated locally). Uses the
+// cache's node adjacency, so the cost is proportional to the supports and their
+// incident members. Entries of other nodes in `reactions` are left untouched.
+void recover_reactions_at(const ElementCache &cache,
+                          const ElementForces &element_forces,
+                          const std::vector<int> &supported_nodes,
+                          const Eigen::VectorXd &forces,
+                          Eigen::VectorXd &reactions,
+                          EquilibriumTotals &totals);
+
+// Internal forces sampled at evenly spaced stations along each member (x = 0 .. L).
+// Values are stored per beam, beam-major: value[beam * stations + k]. Floats keep the
+// array compact enough to hold several stations for very large models.
+struct StationResults
+{
+    int stations = 0;
+    std::vector<float> axial;  // N(x), tension positive
+    std::vector<float> shear;  // V(x)
+    std::vector<float> moment; // M(x), running linearly from -M1 at x = 0 to M2 at x = L
+    std::vector<float> stress; // combined fibre stress N/A +/- |M|/Z (larger magnitude kept)
+
+    // exact location (fraction of L) and value of the extreme combined stress per beam
+    std::vector<float> critical_position;
+    std::vector<float> critical_stress;
+
+    void resize(int count, int stations_per_beam);
+};
+
+// Evaluate N, V, M and combined stress at `stations` points (>= 2) along every member from
+// the recovered end forces. Works on blocks of beams with station-major scratch so each
+// station is one vectorizable pass across beams, then scatters into the per-beam layout.
+// The extremum search is exact rather than sampled: without member loads M(x) is linear,
+// so the peak |M| (and therefore the peak fibre stress) is at one of the ends.
+void evaluate_stations(const ElementCache &cache,
+                       const ElementForces &element_forces,
+                       int stations,
+                       StationResults &out);
+
+// Stations of an envelope (peak end forces from different load positions or modes, so there
+// is no M(x) between the ends): two stations per member holding the end values as they are,
+// their combined stress |N|/A + |M|/Z, and the envelope's own stress at the worse end.
+void envelope_stations(const ElementCache &cache,
+                       const ElementForces &envelope,
+                       StationResults &out);
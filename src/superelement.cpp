@@ -0,0 +1,471 @@
+#include "superelement.h"
+#include "task_scheduler.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+namespace
+{
+    bool same_signature(const std::vector<int> &topology_a, const std::vector<double> &offsets_a,
+                        const std::vector<double> &properties_a, const std::vector<int> &topology_b,
+                        const std::vector<double> &offsets_b, const std::vector<double> &properties_b, double tolerance)
+    {
+        if (topology_a != topology_b || offsets_a.size() != offsets_b.size() || properties_a != properties_b)
+            return false;
+        // five values per node: two coordinates (within tolerance) and three DOF scales
+        for (size_t k = 0; k < offsets_a.size(); ++k)
+        {
+            double allowed = k % 5 < 2 ? tolerance : 1e-9;
+            if (std::abs(offsets_a[k] - offsets_b[k]) > allowed)
+                return false;
+        }
+        return true;
+    }
+}
+
+int SuperelementModel::condense(const std::vector<Node> &nodes,
+                                const std::vector<Beam> &beams,
+                                const std::vector<MaterialProfile> &materials,
+                                const std::vector<BeamProfile> &shapes,
+                                const DofMap &map,
+                                const Eigen::VectorXd &forces,
+                                const SuperelementOptions &options)
+{
+    auto start = std::chrono::steady_clock::now();
+    int num_nodes = static_cast<int>(nodes.size());
+    int num_beams = static_cast<int>(beams.size());
+    int num_instances = static_cast<int>(options.instances.size());
+    instances.clear();
+    solution.resize(0);
+    condensations = 0;
+    reuses = 0;
+    num_boundary = 0;
+    num_interior = 0;
+    if (map.num_reduced == 0 || map.total_dof != num_nodes * 3 || forces.size() != num_nodes * 3)
+        return -1;
+
+    // which instance owns each member, and each node all of whose members it owns
+    owner.assign(num_beams, -1);
+    for (int k = 0; k < num_instances; ++k)
+    {
+        if (options.instances[k].empty())
+            return -1;
+        for (int i : options.instances[k])
+        {
+            if (i < 0 || i >= num_beams || owner[i] >= 0)
+                return -1;
+            owner[i] = k;
+        }
+    }
+    std::vector<int> node_owner(num_nodes, -2); // -2: no member yet, -1: more than one owner
+    for (int i = 0; i < num_beams; ++i)
+    {
+        for (int end = 0; end < 2; ++end)
+        {
+            int &o = node_owner[beams[i].nodes[end]];
+            o = (o == -2 || o == owner[i]) ? owner[i] : -1;
+        }
+    }
+
+    this->map = map;
+    ends.resize(num_beams * 2);
+    forms.assign(num_beams, MemberForm());
+    E.assign(num_beams, 0.0);
+    EI.assign(num_beams, 0.0);
+    inv_z.assign(num_beams, 0.0);
+    for (int i = 0; i < num_beams; ++i)
+    {
+        const Beam &beam = beams[i];
+        ends[i * 2] = beam.nodes[0];
+        ends[i * 2 + 1] = beam.nodes[1];
+        double dx = nodes[beam.nodes[1]].position[0] - nodes[beam.nodes[0]].position[0];
+        double dy = nodes[beam.nodes[1]].position[1] - nodes[beam.nodes[0]].position[1];
+        member_form(dx, dy, forms[i]);
+        const BeamProfile &shape = shapes[beam.shape_idx];
+        E[i] = materials[beam.material_idx].youngs_modulus;
+        EI[i] = beam.is_truss ? 0.0 : E[i] * shape.moment_of_inertia;
+        inv_z[i] = inverse_section_modulus(shape.section_modulus);
+    }
+
+    // step 1 - canonical node order and signature of every instance (independent, so in parallel)
+    instances.resize(num_instances);
+    double tolerance = options.tolerance;
+    TaskScheduler::instance().parallel_for(
+        0, num_instances, 1, [&](int lo, int hi)
+        {
+            for (int k = lo; k < hi; ++k)
+            {
+                Instance &inst = instances[k];
+                inst.members = options.instances[k];
+                for (int i : inst.members)
+                {
+                    inst.nodes.push_back(beams[i].nodes[0]);
+                    inst.nodes.push_back(beams[i].nodes[1]);
+                }
+                std::sort(inst.nodes.begin(), inst.nodes.end());
+                inst.nodes.erase(std::unique(inst.nodes.begin(), inst.nodes.end()), inst.nodes.end());
+
+                // positions relative to the lower left corner, ordered by x then y snapped to a
+                // tolerance grid (integer keys, so the order is a strict weak ordering)
+                double x0 = nodes[inst.nodes[0]].position[0], y0 = nodes[inst.nodes[0]].position[1];
+                for (int n : inst.nodes)
+                {
+                    x0 = std::min(x0, static_cast<double>(nodes[n].position[0]));
+                    y0 = std::min(y0, static_cast<double>(nodes[n].position[1]));
+                }
+                double grid = tolerance > 0.0 ? 1.0 / tolerance : 1e9;
+                struct GridNode
+                {
+                    long gx, gy;
+                    int node;
+                    bool operator<(const GridNode &o) const
+                    {
+                        if (gx != o.gx)
+                            return gx < o.gx;
+                        if (gy != o.gy)
+                            return gy < o.gy;
+                        return node < o.node;
+                    }
+                };
+                std::vector<GridNode> snapped;
+                snapped.reserve(inst.nodes.size());
+                for (int n : inst.nodes)
+                    snapped.push_back({std::lround((nodes[n].position[0] - x0) * grid),
+                                       std::lround((nodes[n].position[1] - y0) * grid), n});
+                std::sort(snapped.begin(), snapped.end());
+                for (size_t local = 0; local < snapped.size(); ++local)
+                    inst.nodes[local] = snapped[local].node;
+
+                Definition &sig = inst.signature;
+                int count = static_cast<int>(inst.nodes.size());
+                for (int local = 0; local < count; ++local)
+                {
+                    int n = inst.nodes[local];
+                    bool interior = node_owner[n] == k;
+                    sig.topology.push_back(interior ? 0 : 1);
+                    sig.offsets.push_back(nodes[n].position[0] - x0);
+                    sig.offsets.push_back(nodes[n].position[1] - y0);
+                    for (int dof = 0; dof < 3; ++dof)
+                    {
+                        int g = n * 3 + dof;
+                        sig.offsets.push_back(map.index[g] < 0 ? 0.0 : map.scale[g]);
+                        // a slider folds both translations onto one row
+                        int row = map.index[g];
+                        std::vector<int> &rows = interior ? inst.interior_rows : inst.boundary_rows;
+                        if (row >= 0 && std::find(rows.begin(), rows.end(), row) == rows.end())
+                            rows.push_back(row);
+                    }
+                }
+
+                // members by their local nodes, so the order does not depend on the model's numbering
+                struct Key
+                {
+                    int a, b, truss;
+                    double e, area, inertia;
+                    bool operator<(const Key &o) const
+                    {
+                        if (a != o.a)
+                            return a < o.a;
+                        if (b != o.b)
+                            return b < o.b;
+                        if (truss != o.truss)
+                            return truss < o.truss;
+                        if (e != o.e)
+                            return e < o.e;
+                        if (area != o.area)
+                            return area < o.area;
+                        return inertia < o.inertia;
+                    }
+                };
+                std::vector<Key> keys;
+                for (int i : inst.members)
+                {
+                    int a = static_cast<int>(std::find(inst.nodes.begin(), inst.nodes.end(), beams[i].nodes[0]) - inst.nodes.begin());
+                    int b = static_cast<int>(std::find(inst.nodes.begin(), inst.nodes.end(), beams[i].nodes[1]) - inst.nodes.begin());
+                    const BeamProfile &shape = shapes[beams[i].shape_idx];
+                    keys.push_back({std::min(a, b), std::max(a, b), beams[i].is_truss ? 1 : 0, E[i], shape.area,
+                                    beams[i].is_truss ? 0.0 : shape.moment_of_inertia});
+                }
+                std::sort(keys.begin(), keys.end());
+                for (const Key &key : keys)
+                {
+                    sig.topology.insert(sig.topology.end(), {key.a, key.b, key.truss});
+                    sig.properties.insert(sig.properties.end(), {key.e, key.area, key.inertia});
+                }
+            } },
+        TaskPriority::High, "superelement_signatures");
+
+    // step 2 - match against the cached condensations; unmatched instances start new ones
+    std::vector<Definition> previous;
+    previous.swap(library);
+    std::vector<int> representative; // instance a new definition is condensed from (-1: cached)
+    for (int k = 0; k < num_instances; ++k)
+    {
+        Instance &inst = instances[k];
+        const Definition &sig = inst.signature;
+        for (int d = 0; d < static_cast<int>(library.size()) && inst.definition < 0; ++d)
+        {
+            if (same_signature(sig.topology, sig.offsets, sig.properties, library[d].topology, library[d].offsets,
+                               library[d].properties, tolerance))
+                inst.definition = d;
+        }
+        if (inst.definition >= 0)
+        {
+            ++reuses;
+            continue;
+        }
+        for (Definition &old : previous)
+        {
+            if (old.topology.empty() ||
+                !same_signature(sig.topology, sig.offsets, sig.properties, old.topology, old.offsets, old.properties, tolerance))
+                continue;
+            library.push_back(std::move(old));
+            old.topology.clear(); // taken
+            representative.push_back(-1);
+            inst.definition = static_cast<int>(library.size()) - 1;
+            ++reuses;
+            break;
+        }
+        if (inst.definition >= 0)
+            continue;
+        library.push_back(sig);
+        representative.push_back(k);
+        inst.definition = static_cast<int>(library.size()) - 1;
+        ++condensations;
+    }
+
+    // step 3 - condense each new definition from its representative: S = K_bb - K_bi K_ii^-1 K_ib
+    int num_definitions = static_cast<int>(library.size());
+    std::vector<char> failed(num_definitions, 0);
+    TaskScheduler::instance().parallel_for(
+        0, num_definitions, 1, [&](int lo, int hi)
+        {
+            for (int d = lo; d < hi; ++d)
+            {
+                if (representative[d] < 0)
+                    continue;
+                const Instance &inst = instances[representative[d]];
+                int nb = static_cast<int>(inst.boundary_rows.size());
+                int ni = static_cast<int>(inst.interior_rows.size());
+                std::vector<int> rows = inst.boundary_rows;
+                rows.insert(rows.end(), inst.interior_rows.begin(), inst.interior_rows.end());
+                Eigen::MatrixXd local = Eigen::MatrixXd::Zero(nb + ni, nb + ni);
+                for (int i : inst.members)
+                {
+                    const Beam &beam = beams[i];
+                    int at[6];
+                    double s[6];
+                    for (int a = 0; a < 6; ++a)
+                    {
+                        int g = beam.nodes[a / 3] * 3 + a % 3;
+                        at[a] = map.index[g] < 0 ? -1 : static_cast<int>(std::find(rows.begin(), rows.end(), map.index[g]) - rows.begin());
+                        s[a] = map.scale[g];
+                    }
+                    for (int a = 0; a < 6; ++a)
+                    {
+                        if (at[a] < 0)
+                            continue;
+                        for (int b = 0; b < 6; ++b)
+                        {
+                            if (at[b] >= 0)
+                                local(at[a], at[b]) += s[a] * s[b] * beam.k_matrix(a, b);
+                        }
+                    }
+                }
+
+                Definition &def = library[d];
+                def.interior.compute(local.bottomRightCorner(ni, ni));
+                if (ni > 0)
+                {
+                    // same test as the sparse solver: every pivot clearly positive
+                    Eigen::VectorXd pivots = def.interior.matrixLLT().diagonal().cwiseAbs2();
+                    if (def.interior.info() != Eigen::Success || !(pivots.minCoeff() > 1e-13 * pivots.maxCoeff()))
+                    {
+                        failed[d] = 1;
+                        continue;
+                    }
+                }
+                def.coupling = def.interior.solve(local.bottomLeftCorner(ni, nb));
+                def.condensed = local.topLeftCorner(nb, nb) - local.bottomLeftCorner(ni, nb).transpose() * def.coupling;
+                def.condensed = 0.5 * (def.condensed + def.condensed.transpose()).eval();
+            } },
+        TaskPriority::High, "superelement_condense");
+    if (std::count(failed.begin(), failed.end(), 1) > 0)
+    {
+        library.clear();
+        instances.clear();
+        return -1;
+    }
+
+    // step 4 - boundary equations: every reduced row no instance keeps inside
+    Eigen::VectorXd f = map.restrict(forces);
+    compact.assign(map.num_reduced, 0);
+    for (const Instance &inst : instances)
+    {
+        for (int row : inst.interior_rows)
+            compact[row] = -1;
+        num_interior += static_cast<int>(inst.interior_rows.size());
+    }
+    for (int &c : compact)
+    {
+        if (c == 0)
+            c = num_boundary++;
+    }
+
+    // interior loads K_ii^-1 F_i, condensed onto the boundary as F_b - K_bi K_ii^-1 F_i
+    std::vector<Eigen::VectorXd> corrections(num_instances);
+    TaskScheduler::instance().parallel_for(
+        0, num_instances, 16, [&](int lo, int hi)
+        {
+            for (int k = lo; k < hi; ++k)
+            {
+                Instance &inst = instances[k];
+                const Definition &def = library[inst.definition];
+                Eigen::VectorXd fi(inst.interior_rows.size());
+                for (int a = 0; a < static_cast<int>(fi.size()); ++a)
+                    fi(a) = f(inst.interior_rows[a]);
+                inst.interior_load = def.interior.solve(fi);
+                // K_bi K_ii^-1 F_i = W^T F_i (K_ii is symmetric)
+                corrections[k] = def.coupling.transpose() * fi;
+                inst.signature = Definition(); // only needed for matching
+            } },
+        TaskPriority::High, "superelement_loads");
+
+    F = Eigen::VectorXd::Zero(num_boundary);
+    for (int row = 0; row < map.num_reduced; ++row)
+    {
+        if (compact[row] >= 0)
+            F(compact[row]) += f(row);
+    }
+    std::vector<Eigen::Triplet<double>> triplets;
+    for (int k = 0; k < num_instances; ++k)
+    {
+        const Instance &inst = instances[k];
+        const Eigen::MatrixXd &S = library[inst.definition].condensed;
+        int nb = static_cast<int>(inst.boundary_rows.size());
+        for (int a = 0; a < nb; ++a)
+        {
+            F(compact[inst.boundary_rows[a]]) -= corrections[k](a);
+            for (int b = 0; b < nb; ++b)
+                triplets.emplace_back(compact[inst.boundary_rows[a]], compact[inst.boundary_rows[b]], S(a, b));
+        }
+    }
+    // members outside every instance assemble as usual (both their ends are boundary nodes)
+    for (int i = 0; i < num_beams; ++i)
+    {
+        if (owner[i] >= 0)
+            continue;
+        const Beam &beam = beams[i];
+        for (int a = 0; a < 6; ++a)
+        {
+            int ga = beam.nodes[a / 3] * 3 + a % 3;
+            if (map.index[ga] < 0)
+                continue;
+            for (int b = 0; b < 6; ++b)
+            {
+                int gb = beam.nodes[b / 3] * 3 + b % 3;
+                if (map.index[gb] >= 0)
+                    triplets.emplace_back(compact[map.index[ga]], compact[map.index[gb]],
+                                          map.scale[ga] * map.scale[gb] * beam.k_matrix(a, b));
+            }
+        }
+    }
+    K.resize(num_boundary, num_boundary);
+    K.setFromTriplets(triplets.begin(), triplets.end());
+
+    condense_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return 0;
+}
+
+int SuperelementModel::solve()
+{
+    auto start = std::chrono::steady_clock::now();
+    solution.resize(0);
+    if (compact.empty() || K.rows() != num_boundary)
+        return -1;
+    Eigen::VectorXd xb = Eigen::VectorXd::Zero(num_boundary);
+    if (num_boundary > 0)
+    {
+        if (solver.factorize(K) != 0)
+            return -1;
+        xb = solver.solve(F);
+    }
+    solution = Eigen::VectorXd::Zero(map.num_reduced);
+    for (int row = 0; row < map.num_reduced; ++row)
+    {
+        if (compact[row] >= 0)
+            solution(row) = xb(compact[row]);
+    }
+    solve_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return 0;
+}
+
+double SuperelementModel::member_stress(int member, const Eigen::VectorXd &x) const
+{
+    Vector6d d;
+    for (int a = 0; a < 6; ++a)
+    {
+        int g = ends[member * 2 + a / 3] * 3 + a % 3;
+        d(a) = map.index[g] < 0 ? 0.0 : map.scale[g] * x(map.index[g]);
+    }
+    return member_combined_stress(forms[member], E[member], EI[member], inv_z[member], d);
+}
+
+void SuperelementModel::fill_interior(int instance, Eigen::VectorXd &x) const
+{
+    const Instance &inst = instances[instance];
+    const Definition &def = library[inst.definition];
+
+    // u_i = K_ii^-1 (F_i - K_ib u_b) = K_ii^-1 F_i - W u_b
+    int nb = static_cast<int>(inst.boundary_rows.size());
+    Eigen::VectorXd xb(nb);
+    for (int a = 0; a < nb; ++a)
+        xb(a) = x(inst.boundary_rows[a]);
+    Eigen::VectorXd xi = inst.interior_load - def.coupling * xb;
+    for (int a = 0; a < static_cast<int>(xi.size()); ++a)
+        x(inst.interior_rows[a]) = xi(a);
+}
+
+int SuperelementModel::recover(int instance, Eigen::VectorXd &x, InstanceRecovery &out) const
+{
+    out = InstanceRecovery();
+    if (instance < 0 || instance >= instance_count() || x.size() != map.num_reduced)
+        return -1;
+    fill_interior(instance, x);
+
+    const Instance &inst = instances[instance];
+    for (int i : inst.members)
+    {
+        double s = member_stress(i, x);
+        if (s > out.max_stress)
+        {
+            out.max_stress = s;
+            out.critical_member = i;
+        }
+    }
+    for (int n : inst.nodes)
+    {
+        double u[2];
+        for (int dof = 0; dof < 2; ++dof)
+        {
+            int g = n * 3 + dof;
+            u[dof] = map.index[g] < 0 ? 0.0 : map.scale[g] * x(map.index[g]);
+        }
+        out.max_displacement = std::max(out.max_displacement, std::hypot(u[0], u[1]));
+    }
+    return 0;
+}
+
+void SuperelementModel::recover_all(Eigen::VectorXd &x) const
+{
+    x = solution;
+    if (x.size() != map.num_reduced)
+        return;
+    // instances write disjoint interior rows and only read boundary ones
+    TaskScheduler::instance().parallel_for(
+        0, instance_count(), 16, [&](int lo, int hi)
+        {
+            for (int k = lo; k < hi; ++k)
+                fill_interior(k, x); },
+        TaskPriority::High, "superelement_recover");
+}
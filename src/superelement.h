@@ -0,0 +1,115 @@
+#pragma once
+#include <vector>
+#include <Eigen/Eigen>
+#include "node.h"
+#include "beam.h"
+#include "beam_props.h"
+#include "dof_map.h"
+#include "sensitivity.h"
+#include "sparse_solver.h"
+
+struct SuperelementOptions
+{
+    std::vector<std::vector<int>> instances; // members of each placed substructure instance
+    double tolerance = 1e-4;                 // m, how far the node offsets of two instances may
+                                             // differ and still share one condensation (the
+                                             // first one's geometry is used for all of them)
+};
+
+// What recovering one instance's interior found
+struct InstanceRecovery
+{
+    double max_stress = 0.0; // Pa, largest |combined stress| of its members
+    int critical_member = -1;
+    double max_displacement = 0.0; // m, largest translation of its nodes
+};
+
+// Static condensation of repeated substructures. A node of an instance is interior when all of
+// its members belong to that instance; its equations are eliminated with the Schur complement
+// S = K_bb - K_bi K_ii^-1 K_ib, so only boundary equations enter the global sparse solve.
+// Instances whose nodes, supports and sections match up to a translation share one
+// condensation (the K_ii factorization, K_ii^-1 K_ib and S), which is also kept across calls
+// while it still matches, so editing loads or the rest of the model does not recondense.
+// Interiors are recovered per instance from the boundary solution, on demand.
+// Members are taken as linear: tension- and compression-only members are always active.
+class SuperelementModel
+{
+public:
+    // condense `options.instances` for the element matrices in `beams` (compute_stiffness done)
+    // and the loads `forces`. Returns 0 on success, -1 if an instance is empty, names a member
+    // that does not exist or belongs to another instance, or its interior is not restrained
+    // by its own members (K_ii singular).
+    int condense(const std::vector<Node> &nodes,
+                 const std::vector<Beam> &beams,
+                 const std::vector<MaterialProfile> &materials,
+                 const std::vector<BeamProfile> &shapes,
+                 const DofMap &map,
+                 const Eigen::VectorXd &forces,
+                 const SuperelementOptions &options);
+
+    // boundary solve of the condensed system; 0 on success, -1 if it is singular
+    int solve();
+
+    // `x` (reduced numbering) starts as boundary_solution(); recovery writes the instance's
+    // interior rows into it and measures its members. -1 if `instance` does not exist.
+    int recover(int instance, Eigen::VectorXd &x, InstanceRecovery &out) const;
+    // every interior, in parallel: the full reduced solution
+    void recover_all(Eigen::VectorXd &x) const;
+
+    const Eigen::VectorXd &boundary_solution() const { return solution; } // interior rows 0
+    int instance_count() const { return static_cast<int>(instances.size()); }
+    int definition_count() const { return static_cast<int>(library.size()); }
+    int definition_of(int instance) const { return instances[instance].definition; }
+    int boundary_dofs() const { return num_boundary; }
+    int interior_dofs() const { return num_interior; }
+
+    int condensations = 0; // definitions condensed by the last condense(), the rest were reused
+    int reuses = 0;        // instances that reused a condensation
+    double condense_seconds = 0.0;
+    double solve_seconds = 0.0;
+
+private:
+    // one condensation, shared by every instance that matches its signature
+    struct Definition
+    {
+        std::vector<int> topology;      // per local node: boundary flag; per member: its two
+                                        // local nodes and truss flag
+        std::vector<double> offsets;    // per local node: position relative to the instance's
+                                        // corner, then the three DOF scales (0: eliminated)
+        std::vector<double> properties; // per member: E, A, I
+        Eigen::LLT<Eigen::MatrixXd> interior; // K_ii
+        Eigen::MatrixXd coupling;             // W = K_ii^-1 K_ib
+        Eigen::MatrixXd condensed;            // S = K_bb - K_bi W
+    };
+
+    struct Instance
+    {
+        int definition = -1;
+        std::vector<int> members;
+        std::vector<int> nodes;         // canonical order
+        std::vector<int> boundary_rows; // reduced rows, in the definition's order
+        std::vector<int> interior_rows;
+        Eigen::VectorXd interior_load;  // K_ii^-1 F_i
+        Definition signature;           // before matching (no matrices)
+    };
+
+    void fill_interior(int instance, Eigen::VectorXd &x) const; // from the boundary rows of x
+    double member_stress(int member, const Eigen::VectorXd &x) const;
+
+    std::vector<Definition> library;
+    std::vector<Instance> instances;
+    std::vector<int> owner; // member -> instance, -1 if assembled directly
+
+    // the boundary system, in reduced rows with the interior ones skipped
+    DofMap map;
+    std::vector<int> ends; // two nodes per member
+    std::vector<MemberForm> forms;
+    std::vector<double> E, EI, inv_z;
+    std::vector<int> compact; // reduced row -> boundary equation, -1 if interior
+    SparseMatrix K;
+    Eigen::VectorXd F;        // condensed loads
+    SparseSolver solver;
+    Eigen::VectorXd solution; // reduced numbering
+    int num_boundary = 0;
+    int num_interior = 0;
+};
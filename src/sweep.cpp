@@ -0,0 +1,338 @@
+#include "sweep.h"
+#include "sensitivity.h"
+#include "task_scheduler.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <limits>
+#include <memory>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+int SweepTable::column(const std::string &name) const
+{
+    auto it = std::find(names.begin(), names.end(), name);
+    return it == names.end() ? -1 : static_cast<int>(it - names.begin());
+}
+
+namespace
+{
+    // One copy of the varied model. A worker serves one range of rows at a time; rows only ever
+    // change the same inputs, so whatever a row sets is overwritten by the next one.
+    struct Worker
+    {
+        std::vector<Node> nodes;
+        std::vector<BeamProfile> shapes;
+        DofMap map;
+        Eigen::VectorXd forces;
+        std::vector<MemberForm> forms;
+        std::vector<Matrix6d> element;
+        SparseSolver solver;
+        std::vector<double> factored; // values of the K parameters solver holds (empty: none)
+        Eigen::VectorXd u;
+    };
+} // namespace
+
+int run_sweep(const std::vector<Node> &nodes,
+              const std::vector<Beam> &beams,
+              const std::vector<MaterialProfile> &materials,
+              const std::vector<BeamProfile> &shapes,
+              const DofMap &map,
+              const ElementCache &cache,
+              const Eigen::VectorXd &forces,
+              const std::vector<char> &active,
+              const SweepOptions &options,
+              const SparseSolver &solver,
+              SweepResults &out)
+{
+    out = SweepResults();
+    int num_nodes = static_cast<int>(nodes.size());
+    int num_beams = static_cast<int>(beams.size());
+    int num_shapes = static_cast<int>(shapes.size());
+    int num_params = static_cast<int>(options.parameters.size());
+    if (map.num_reduced == 0 || cache.count != num_beams || num_params == 0 || forces.size() != num_nodes * 3)
+        return -1;
+
+    // validate, and count the rows
+    long long rows = 1;
+    for (int p = 0; p < num_params; ++p)
+    {
+        const SweepParameter &a = options.parameters[p];
+        bool on_node = a.kind == SweepParameter::Force || a.kind == SweepParameter::Coordinate ||
+                       a.kind == SweepParameter::SliderAngle;
+        if (a.points < 1 || a.index < 0 || a.index >= (on_node ? num_nodes : num_shapes))
+            return -1;
+        if ((a.kind == SweepParameter::Force && (a.component < 0 || a.component > 2)) ||
+            (a.kind == SweepParameter::Coordinate && (a.component < 0 || a.component > 1)))
+            return -1;
+        if (a.kind == SweepParameter::SliderAngle &&
+            (nodes[a.index].constraint_type != Slider || map.index[a.index * 3] < 0))
+            return -1;
+        for (int q = 0; q < p; ++q)
+        {
+            const SweepParameter &b = options.parameters[q];
+            bool by_component = a.kind == SweepParameter::Force || a.kind == SweepParameter::Coordinate;
+            if (a.kind == b.kind && a.index == b.index && (!by_component || a.component == b.component))
+                return -1;
+        }
+        rows *= a.points;
+        if (rows > options.max_points)
+            return -1;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+
+    // members whose stiffness a row changes, and whether K changes at all
+    auto changes_k = [](const SweepParameter &a)
+    { return a.kind != SweepParameter::Force && a.kind != SweepParameter::SectionModulus; };
+    std::vector<char> touched(num_beams, 0);
+    bool varies_k = false;
+    for (const SweepParameter &a : options.parameters)
+    {
+        if (a.kind == SweepParameter::Coordinate)
+        {
+            for (int e = cache.node_offsets[a.index]; e < cache.node_offsets[a.index + 1]; ++e)
+                touched[cache.node_ends[e] >> 1] = 1;
+        }
+        else if (a.kind == SweepParameter::Area || a.kind == SweepParameter::Inertia)
+        {
+            for (int i = 0; i < num_beams; ++i)
+                touched[i] = touched[i] || beams[i].shape_idx == a.index;
+        }
+        varies_k = varies_k || changes_k(a);
+    }
+    std::vector<int> changing;
+    for (int i = 0; i < num_beams; ++i)
+    {
+        if (touched[i])
+            changing.push_back(i);
+    }
+    std::vector<char> carries(num_beams);
+    for (int i = 0; i < num_beams; ++i)
+        carries[i] = active.empty() || active[i];
+
+    // element matrix of member i for the worker's geometry and sections (false: zero length)
+    auto update_member = [&](Worker &w, int i) -> bool
+    {
+        const Beam &beam = beams[i];
+        double dx = w.nodes[beam.nodes[1]].position[0] - w.nodes[beam.nodes[0]].position[0];
+        double dy = w.nodes[beam.nodes[1]].position[1] - w.nodes[beam.nodes[0]].position[1];
+        if (!member_form(dx, dy, w.forms[i]))
+            return false;
+        const BeamProfile &shape = w.shapes[beam.shape_idx];
+        double E = materials[beam.material_idx].youngs_modulus;
+        double I = beam.is_truss ? 0.0 : shape.moment_of_inertia;
+        if (carries[i])
+            w.element[i] = E * shape.area * w.forms[i].axial + E * I * w.forms[i].bending;
+        else
+            w.element[i].setZero(); // kept as structural zeros
+        return true;
+    };
+
+    // workers are handed out per range of rows: a thread waiting inside a worker's assembly
+    // may pick up another range, so they cannot be tied to thread indices
+    ScratchPool<Worker> pool;
+    auto make_worker = [&]()
+    {
+        std::unique_ptr<Worker> w(new Worker());
+        w->nodes = nodes;
+        w->shapes = shapes;
+        w->map = map;
+        w->forces = forces;
+        w->forms.resize(num_beams);
+        w->element.resize(num_beams);
+        for (int i = 0; i < num_beams; ++i)
+        {
+            if (!update_member(*w, i))
+                w->element[i].setZero();
+        }
+        if (varies_k)
+            w->solver = solver;
+        return w;
+    };
+
+    // columns: parameters, then the results
+    SweepTable &table = out.table;
+    table.rows = static_cast<int>(rows);
+    table.parameters = num_params;
+    auto add_column = [&](const std::string &name, SweepQuantity quantity)
+    {
+        table.names.push_back(name);
+        table.quantity.push_back(quantity);
+        table.columns.emplace_back(table.rows, std::numeric_limits<double>::quiet_NaN());
+    };
+    for (const SweepParameter &a : options.parameters)
+    {
+        std::string node = "Node " + std::to_string(a.index + 1);
+        std::string shape = a.index < num_shapes ? shapes[a.index].name : std::string();
+        switch (a.kind)
+        {
+        case SweepParameter::Force:
+            add_column(node + (a.component == 0 ? " Fx" : (a.component == 1 ? " Fy" : " M")),
+                       a.component == 2 ? SweepQuantity::Moment : SweepQuantity::Force);
+            break;
+        case SweepParameter::Coordinate:
+            add_column(node + (a.component == 0 ? " x" : " y"), SweepQuantity::Length);
+            break;
+        case SweepParameter::Area:
+            add_column(shape + " A", SweepQuantity::Area);
+            break;
+        case SweepParameter::Inertia:
+            add_column(shape + " I", SweepQuantity::Inertia);
+            break;
+        case SweepParameter::SectionModulus:
+            add_column(shape + " Z", SweepQuantity::SectionModulus);
+            break;
+        case SweepParameter::SliderAngle:
+            add_column(node + " angle", SweepQuantity::Angle);
+            break;
+        }
+    }
+    int stress_column = static_cast<int>(table.names.size());
+    add_column("Max stress", SweepQuantity::Stress);
+    add_column("Max displacement", SweepQuantity::Length);
+    std::vector<int> reaction_dofs; // global DOF per reaction column
+    for (int n = 0; n < num_nodes; ++n)
+    {
+        ConstraintType type = nodes[n].constraint_type;
+        if (type == Free || cache.node_offsets[n] == cache.node_offsets[n + 1])
+            continue;
+        std::string name = "R" + std::to_string(n + 1);
+        add_column(name + " x", SweepQuantity::Force);
+        reaction_dofs.push_back(n * 3);
+        add_column(name + " y", SweepQuantity::Force);
+        reaction_dofs.push_back(n * 3 + 1);
+        if (type == Fixed)
+        {
+            add_column(name + " M", SweepQuantity::Moment);
+            reaction_dofs.push_back(n * 3 + 2);
+        }
+    }
+
+    // parameter values of every row, the last parameter varying fastest
+    for (int row = 0; row < table.rows; ++row)
+    {
+        int rest = row;
+        for (int p = num_params - 1; p >= 0; --p)
+        {
+            const SweepParameter &a = options.parameters[p];
+            int k = rest % a.points;
+            rest /= a.points;
+            table.columns[p][row] = a.points > 1 ? a.from + (a.to - a.from) * k / (a.points - 1) : a.from;
+        }
+    }
+
+    std::atomic<int> failed{0}, factorizations{0};
+    TaskScheduler::instance().parallel_for(
+        0, table.rows, 1, [&](int lo, int hi)
+        {
+            Worker *w = pool.acquire(make_worker);
+            Vector6d d;
+            std::vector<double> k_values;
+            for (int row = lo; row < hi; ++row)
+            {
+                for (int p = 0; p < num_params; ++p)
+                {
+                    const SweepParameter &a = options.parameters[p];
+                    double v = table.columns[p][row];
+                    switch (a.kind)
+                    {
+                    case SweepParameter::Force:
+                        w->forces(a.index * 3 + a.component) = v;
+                        break;
+                    case SweepParameter::Coordinate:
+                        w->nodes[a.index].position[a.component] = static_cast<float>(v);
+                        break;
+                    case SweepParameter::Area:
+                        w->shapes[a.index].area = v;
+                        break;
+                    case SweepParameter::Inertia:
+                        w->shapes[a.index].moment_of_inertia = v;
+                        break;
+                    case SweepParameter::SectionModulus:
+                        w->shapes[a.index].section_modulus = v;
+                        break;
+                    case SweepParameter::SliderAngle:
+                        w->map.scale[a.index * 3] = std::cos(v * M_PI / 180.0);
+                        w->map.scale[a.index * 3 + 1] = std::sin(v * M_PI / 180.0);
+                        break;
+                    }
+                }
+
+                // rows that only differ in forces or section moduli share K (with the last
+                // parameter varying fastest, neighbouring rows often do)
+                bool ok = true;
+                const SparseSolver *factored = &solver;
+                if (varies_k)
+                {
+                    factored = &w->solver;
+                    k_values.clear();
+                    for (int p = 0; p < num_params; ++p)
+                    {
+                        if (changes_k(options.parameters[p]))
+                            k_values.push_back(table.columns[p][row]);
+                    }
+                    if (k_values != w->factored)
+                    {
+                        w->factored.clear();
+                        for (int i : changing)
+                            ok = update_member(*w, i) && ok;
+                        ok = ok && w->solver.factorize(assemble_reduced(w->map, beams, w->element)) == 0;
+                        ++factorizations;
+                        if (ok)
+                            w->factored = k_values;
+                    }
+                }
+                if (!ok)
+                {
+                    ++failed;
+                    continue;
+                }
+                w->map.expand(factored->solve(w->map.restrict(w->forces)), w->u);
+
+                double max_stress = 0.0;
+                for (int i = 0; i < num_beams; ++i)
+                {
+                    if (!carries[i])
+                        continue;
+                    const BeamProfile &shape = w->shapes[beams[i].shape_idx];
+                    const MemberForm &f = w->forms[i];
+                    double E = materials[beams[i].material_idx].youngs_modulus;
+                    double I = beams[i].is_truss ? 0.0 : shape.moment_of_inertia;
+                    d << w->u.segment<3>(beams[i].nodes[0] * 3), w->u.segment<3>(beams[i].nodes[1] * 3);
+                    max_stress = std::max(max_stress, member_combined_stress(f, E, E * I,
+                                                                             inverse_section_modulus(shape.section_modulus), d));
+                }
+                double max_displacement = 0.0;
+                for (int n = 0; n < num_nodes; ++n)
+                    max_displacement = std::max(max_displacement, std::hypot(w->u(n * 3), w->u(n * 3 + 1)));
+                table.columns[stress_column][row] = max_stress;
+                table.columns[stress_column + 1][row] = max_displacement;
+
+                // R = K u - F at the supports, from the members that end there
+                for (size_t r = 0; r < reaction_dofs.size(); ++r)
+                {
+                    int dof = reaction_dofs[r];
+                    int n = dof / 3;
+                    double reaction = -w->forces(dof);
+                    for (int e = cache.node_offsets[n]; e < cache.node_offsets[n + 1]; ++e)
+                    {
+                        int i = cache.node_ends[e] >> 1;
+                        int end = cache.node_ends[e] & 1;
+                        d << w->u.segment<3>(beams[i].nodes[0] * 3), w->u.segment<3>(beams[i].nodes[1] * 3);
+                        reaction += w->element[i].row(end * 3 + dof % 3).dot(d);
+                    }
+                    table.columns[stress_column + 2 + r][row] = reaction;
+                }
+            }
+            pool.release(w); },
+        TaskPriority::High, "sweep_rows");
+
+    out.failed = failed;
+    out.factorizations = factorizations;
+    out.wall_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return 0;
+}
@@ -0,0 +1,92 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <Eigen/Eigen>
+#include "node.h"
+#include "beam.h"
+#include "beam_props.h"
+#include "dof_map.h"
+#include "element_cache.h"
+#include "sparse_solver.h"
+
+// One model input varied over `points` evenly spaced values from `from` to `to`
+struct SweepParameter
+{
+    enum Kind
+    {
+        Force,          // forces(index * 3 + component): N, or N m for component 2
+        Coordinate,     // node `index`'s x (component 0) or y (1), m
+        Area,           // of profile `index`, m^2
+        Inertia,        // of profile `index`, m^4
+        SectionModulus, // of profile `index`, m^3 (stresses only)
+        SliderAngle     // track of slider node `index`, degrees
+    };
+
+    Kind kind = Force;
+    int index = 0;
+    int component = 1;
+    double from = 0.0;
+    double to = 1.0;
+    int points = 11;
+};
+
+struct SweepOptions
+{
+    std::vector<SweepParameter> parameters; // every combination is run, the last varying fastest
+    int max_points = 100000;
+};
+
+// what a column holds, so it can be shown in display units
+enum class SweepQuantity
+{
+    Force,
+    Moment,
+    Length,
+    Area,
+    Inertia,
+    SectionModulus,
+    Angle,
+    Stress
+};
+
+// Results stored column by column: the parameter values first, then max |stress|, the largest
+// node translation and the restrained reaction components of every support. Rows whose model
+// could not be solved (a mechanism, a zero-length member) hold NaN outside the parameters.
+struct SweepTable
+{
+    std::vector<std::string> names;
+    std::vector<SweepQuantity> quantity;
+    std::vector<std::vector<double>> columns; // columns[c][row]
+    int rows = 0;
+    int parameters = 0; // leading columns that are inputs
+
+    int column(const std::string &name) const; // -1 if there is none
+};
+
+struct SweepResults
+{
+    SweepTable table;
+    int failed = 0;         // rows without a solution
+    int factorizations = 0; // numeric refactorizations (0 when only forces or section moduli vary)
+    double wall_seconds = 0.0;
+};
+
+// Runs the model at every combination of options' parameter values, the rows spread over the
+// task scheduler's threads (work stealing evens out rows that cost more). The members and
+// supports never change, so K keeps its pattern: every worker refactors on a copy of `solver`
+// (K in `map`'s numbering), reusing its ordering and symbolic analysis; neighbouring rows with
+// the same stiffness inputs share one factorization, and sweeps of forces alone only
+// back-substitute on `solver` itself. Members with `active` 0 stay slack.
+// Returns 0 on success, -1 if a parameter names something that does not exist (or a slider
+// angle a node that is no slider), repeats another one, or the grid exceeds max_points.
+int run_sweep(const std::vector<Node> &nodes,
+              const std::vector<Beam> &beams,
+              const std::vector<MaterialProfile> &materials,
+              const std::vector<BeamProfile> &shapes,
+              const DofMap &map,
+              const ElementCache &cache,
+              const Eigen::VectorXd &forces,
+              const std::vector<char> &active,
+              const SweepOptions &options,
+              const SparseSolver &solver,
+              SweepResults &out);
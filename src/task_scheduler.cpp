@@ -0,0 +1,345 @@
+#include "task_scheduler.h"
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <iterator>
+
+namespace
+{
+    // 0 for any thread the scheduler did not start, 1..n for its workers
+    thread_local int tls_thread_index = 0;
+} // namespace
+
+TaskGroup::TaskGroup(TaskScheduler &scheduler) : scheduler(scheduler)
+{
+}
+
+TaskGroup::TaskGroup() : scheduler(TaskScheduler::instance())
+{
+}
+
+TaskGroup::~TaskGroup()
+{
+    // tasks may still reference the caller's frame; an exception nobody waited for is dropped
+    drain();
+}
+
+void TaskGroup::run(std::function<void()> fn, TaskPriority priority, const char *name)
+{
+    pending.fetch_add(1, std::memory_order_relaxed);
+
+    TaskScheduler::Task task;
+    task.fn = std::move(fn);
+    task.group = this;
+    task.name = name;
+
+    if (scheduler.workers.empty() || scheduler.compute_threads == 1)
+    {
+        // no workers to hand the task to (the background one is for submit()), run it right here
+        scheduler.execute(task);
+        return;
+    }
+    scheduler.push(std::move(task), priority);
+}
+
+void TaskGroup::wait()
+{
+    drain();
+
+    std::exception_ptr first;
+    {
+        std::lock_guard<std::mutex> lock(error_mutex);
+        std::swap(first, error);
+    }
+    if (first)
+        std::rethrow_exception(first);
+}
+
+void TaskGroup::drain()
+{
+    // help with queued work (ours or anyone's) until all of our tasks have finished
+    while (pending.load(std::memory_order_acquire) > 0)
+    {
+        if (!scheduler.try_run_one())
+            std::this_thread::yield();
+    }
+}
+
+TaskScheduler &TaskScheduler::instance()
+{
+    static TaskScheduler scheduler(default_thread_count());
+    return scheduler;
+}
+
+int TaskScheduler::default_thread_count()
+{
+    const char *env = std::getenv("FASTFEM_THREADS");
+    if (env && *env)
+    {
+        int n = std::atoi(env);
+        if (n > 0)
+            return n;
+    }
+
+    // keep at least one worker so background tasks (frame encoding) never block the GUI
+    unsigned int hw = std::thread::hardware_concurrency();
+    return hw > 1 ? static_cast<int>(hw) : 2;
+}
+
+TaskScheduler::TaskScheduler(int threads)
+{
+    start_workers(threads);
+}
+
+TaskScheduler::~TaskScheduler()
+{
+    stop_workers(true);
+}
+
+void TaskScheduler::set_thread_count(int threads)
+{
+    if (threads < 1)
+        threads = 1;
+    if (threads == thread_count())
+        return;
+
+    stop_workers(false);
+    start_workers(threads);
+}
+
+int TaskScheduler::current_thread_index()
+{
+    return tls_thread_index;
+}
+
+void TaskScheduler::start_workers(int threads)
+{
+    if (threads < 1)
+        threads = 1;
+
+    stopping = false;
+    compute_threads = threads;
+
+    // at least one worker, so fire-and-forget work (frame encoding) never runs on the caller
+    int slots = std::max(threads, 2);
+
+    // keep queue 0 across restarts so tasks submitted from outside are never lost
+    if (queues.empty())
+        queues.emplace_back(new WorkerQueue());
+    while (static_cast<int>(queues.size()) < slots)
+        queues.emplace_back(new WorkerQueue());
+
+    workers.reserve(slots - 1);
+    for (int i = 1; i < slots; ++i)
+        workers.emplace_back(&TaskScheduler::worker_loop, this, i);
+
+    // tasks handed over by the previous set are already queued; wake the new workers for them
+    if (queued.load() > 0)
+        sleep_cv.notify_all();
+}
+
+void TaskScheduler::stop_workers(bool finish_queued)
+{
+    {
+        std::lock_guard<std::mutex> lock(sleep_mutex);
+        this->finish_queued = finish_queued;
+        stopping = true;
+    }
+    sleep_cv.notify_all();
+
+    for (auto &t : workers)
+        t.join();
+    workers.clear();
+
+    // whatever the workers left queued moves to queue 0, oldest first, for the next set
+    if (!queues.empty())
+    {
+        WorkerQueue &shared = *queues[0];
+        std::lock_guard<std::mutex> lock(shared.mutex);
+        for (size_t k = 1; k < queues.size(); ++k)
+        {
+            for (int p = 0; p < num_priorities; ++p)
+            {
+                std::deque<Task> &from = queues[k]->tasks[p];
+                shared.tasks[p].insert(shared.tasks[p].end(), std::make_move_iterator(from.begin()),
+                                       std::make_move_iterator(from.end()));
+                from.clear();
+            }
+        }
+    }
+    if (queues.size() > 1)
+        queues.resize(1);
+}
+
+void TaskScheduler::worker_loop(int index)
+{
+    tls_thread_index = index;
+
+    while (true)
+    {
+        // a restart only waits for the task each worker is running, not for the queues
+        if (stopping && !finish_queued)
+            break;
+        if (try_run_one())
+            continue;
+
+        std::unique_lock<std::mutex> lock(sleep_mutex);
+        sleep_cv.wait(lock, [this]
+                      { return queued.load() > 0 || stopping.load(); });
+        if (stopping && (queued.load() == 0 || !finish_queued))
+            break;
+    }
+}
+
+void TaskScheduler::submit(std::function<void()> fn, TaskPriority priority, const char *name)
+{
+    Task task;
+    task.fn = std::move(fn);
+    task.name = name;
+
+    if (workers.empty())
+    {
+        execute(task);
+        return;
+    }
+    push(std::move(task), priority);
+}
+
+void TaskScheduler::push(Task task, TaskPriority priority)
+{
+    int self = tls_thread_index;
+    if (self >= static_cast<int>(queues.size()))
+        self = 0;
+
+    {
+        WorkerQueue &q = *queues[self];
+        std::lock_guard<std::mutex> lock(q.mutex);
+        q.tasks[static_cast<int>(priority)].push_back(std::move(task));
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(sleep_mutex);
+        queued.fetch_add(1);
+    }
+    sleep_cv.notify_one();
+}
+
+bool TaskScheduler::try_pop(int self, Task &out)
+{
+    const int n = static_cast<int>(queues.size());
+
+    for (int p = 0; p < num_priorities; ++p)
+    {
+        // newest task from our own deque first (it is most likely still in cache)
+        {
+            WorkerQueue &q = *queues[self];
+            std::lock_guard<std::mutex> lock(q.mutex);
+            if (!q.tasks[p].empty())
+            {
+                out = std::move(q.tasks[p].back());
+                q.tasks[p].pop_back();
+                queued.fetch_sub(1);
+                return true;
+            }
+        }
+
+        // then steal the oldest task from somebody else
+        for (int k = 1; k < n; ++k)
+        {
+            WorkerQueue &q = *queues[(self + k) % n];
+            std::lock_guard<std::mutex> lock(q.mutex);
+            if (!q.tasks[p].empty())
+            {
+                out = std::move(q.tasks[p].front());
+                q.tasks[p].pop_front();
+                queued.fetch_sub(1);
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+bool TaskScheduler::try_run_one()
+{
+    if (queued.load(std::memory_order_relaxed) <= 0)
+        return false;
+
+    int self = tls_thread_index;
+    if (self >= static_cast<int>(queues.size()))
+        self = 0;
+
+    Task task;
+    if (!try_pop(self, task))
+        return false;
+
+    execute(task);
+    return true;
+}
+
+void TaskScheduler::execute(Task &task)
+{
+    try
+    {
+        run_timed(task.name, task.fn);
+    }
+    catch (...)
+    {
+        if (task.group)
+        {
+            // handed to whoever waits on the group
+            std::lock_guard<std::mutex> lock(task.group->error_mutex);
+            if (!task.group->error)
+                task.group->error = std::current_exception();
+        }
+        else
+        {
+            // submit()ted tasks have nobody waiting on them
+            try
+            {
+                throw;
+            }
+            catch (const std::exception &e)
+            {
+                std::cerr << "Task " << (task.name ? task.name : "(unnamed)") << " threw: " << e.what() << "\n";
+            }
+            catch (...)
+            {
+                std::cerr << "Task " << (task.name ? task.name : "(unnamed)") << " threw\n";
+            }
+        }
+    }
+
+    if (task.group)
+        task.group->pending.fetch_sub(1, std::memory_order_release);
+}
+
+void TaskScheduler::record_timing(const char *name, double ms)
+{
+    std::lock_guard<std::mutex> lock(timing_mutex);
+    TaskTiming &t = timings[name];
+    if (t.name.empty())
+        t.name = name;
+    t.count++;
+    t.total_ms += ms;
+    if (ms > t.max_ms)
+        t.max_ms = ms;
+}
+
+std::vector<TaskTiming> TaskScheduler::timing_snapshot() const
+{
+    std::lock_guard<std::mutex> lock(timing_mutex);
+    std::vector<TaskTiming> out;
+    out.reserve(timings.size());
+    for (const auto &kv : timings)
+        out.push_back(kv.second);
+    std::sort(out.begin(), out.end(), [](const TaskTiming &a, const TaskTiming &b)
+              { return a.total_ms > b.total_ms; });
+    return out;
+}
+
+void TaskScheduler::reset_timing()
+{
+    std::lock_guard<std::mutex> lock(timing_mutex);
+    timings.clear();
+}
@@ -0,0 +1,297 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// Process-wide work-stealing task scheduler shared by the solver, renderer and recorder.
+// Every worker owns a deque per priority level; it pops its own work LIFO and steals
+// from the other workers FIFO. Threads that are not workers (the GUI thread) push into
+// slot 0 and help out with queued work while they wait on a TaskGroup.
+
+enum class TaskPriority
+{
+    High = 0,
+    Normal = 1,
+    Low = 2
+};
+
+// accumulated wall-clock time of every task submitted under the same name
+struct TaskTiming
+{
+    std::string name;
+    std::uint64_t count = 0;
+    double total_ms = 0.0;
+    double max_ms = 0.0;
+};
+
+class TaskScheduler;
+
+// A set of tasks that can be waited on together. The waiting thread runs queued
+// tasks itself, so nested groups (a parallel_for inside a task) never deadlock.
+class TaskGroup
+{
+public:
+    explicit TaskGroup(TaskScheduler &scheduler);
+    TaskGroup();
+    ~TaskGroup();
+
+    TaskGroup(const TaskGroup &) = delete;
+    TaskGroup &operator=(const TaskGroup &) = delete;
+
+    void run(std::function<void()> fn, TaskPriority priority = TaskPriority::Normal, const char *name = nullptr);
+    // rethrows the first exception any of the group's tasks threw (the rest still ran)
+    void wait();
+
+private:
+    friend class TaskScheduler;
+    void drain();
+
+    TaskScheduler &scheduler;
+    std::atomic<int> pending{0};
+    std::mutex error_mutex;
+    std::exception_ptr error; // first exception of a task, until wait() rethrows it
+};
+
+class TaskScheduler
+{
+public:
+    // the shared instance; created on first use with default_thread_count() threads
+    static TaskScheduler &instance();
+
+    // FASTFEM_THREADS environment variable if set, otherwise the hardware concurrency
+    static int default_thread_count();
+
+    explicit TaskScheduler(int threads);
+    ~TaskScheduler();
+
+    TaskScheduler(const TaskScheduler &) = delete;
+    TaskScheduler &operator=(const TaskScheduler &) = delete;
+
+    // total number of threads doing parallel work, including the calling thread (minimum 1).
+    // At 1, parallel work runs on the calling thread but one worker is kept for submit()ted
+    // tasks. Restarting lets the workers finish their current task and hands their queued ones
+    // to the new set, so it never waits for the queues to drain; call it while no parallel
+    // work is in flight.
+    void set_thread_count(int threads);
+    int thread_count() const { return compute_threads; }
+
+    // index of the calling thread, 0 for any non-worker thread. Inside parallel_for bodies it
+    // is in [0, thread_count()), useful for picking per-thread scratch data.
+    static int current_thread_index();
+
+    // fire-and-forget task (e.g. frame encoding). Runs inline if there are no workers.
+    void submit(std::function<void()> fn, TaskPriority priority = TaskPriority::Normal, const char *name = nullptr);
+
+    // body(lo, hi) is called over disjoint sub-ranges covering [begin, end); an exception
+    // from any sub-range is rethrown here once all of them have finished
+    template <typename Body>
+    void parallel_for(int begin, int end, int grain, Body &&body,
+                      TaskPriority priority = TaskPriority::Normal, const char *name = nullptr);
+
+    // body(lo, hi) returns the partial result for a sub-range, combine(a, b) merges two of them.
+    // Partials are merged in range order so the result does not depend on scheduling.
+    template <typename T, typename Body, typename Combine>
+    T parallel_reduce(int begin, int end, int grain, T identity, Body &&body, Combine &&combine,
+                      TaskPriority priority = TaskPriority::Normal, const char *name = nullptr);
+
+    // per-task timing for profiling (only named tasks are recorded, and only while enabled)
+    std::atomic<bool> profiling_enabled{false};
+    std::vector<TaskTiming> timing_snapshot() const;
+    void reset_timing();
+
+private:
+    friend class TaskGroup;
+
+    struct Task
+    {
+        std::function<void()> fn;
+        TaskGroup *group = nullptr;
+        const char *name = nullptr;
+    };
+
+    static constexpr int num_priorities = 3;
+
+    struct WorkerQueue
+    {
+        std::mutex mutex;
+        std::deque<Task> tasks[num_priorities];
+    };
+
+    void start_workers(int threads);
+    void stop_workers(bool finish_queued); // false: queued tasks move to queue 0 instead
+    void worker_loop(int index);
+
+    void push(Task task, TaskPriority priority);
+    bool try_pop(int self, Task &out);
+    bool try_run_one();
+    void execute(Task &task);
+    void record_timing(const char *name, double ms);
+
+    template <typename Fn>
+    void run_timed(const char *name, Fn &&fn);
+
+    // slot 0 is shared by all non-worker threads, slots 1..n belong to the workers
+    std::vector<std::unique_ptr<WorkerQueue>> queues;
+    std::vector<std::thread> workers;
+
+    std::mutex sleep_mutex;
+    std::condition_variable sleep_cv;
+    std::atomic<int> queued{0};
+    std::atomic<bool> stopping{false};
+    std::atomic<bool> finish_queued{true}; // while stopping: run the queues empty first
+    int compute_threads = 1;
+
+    mutable std::mutex timing_mutex;
+    std::unordered_map<std::string, TaskTiming> timings;
+};
+
+// Scratch objects for parallel_for bodies, handed out per range instead of per thread index:
+// a thread waiting inside one range may pick up another, so ranges sharing a thread must not
+// share scratch. acquire(make) reuses an idle object or keeps the one make() returns.
+template <typename T>
+class ScratchPool
+{
+public:
+    template <typename Make>
+    T *acquire(Make &&make)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!idle.empty())
+            {
+                T *item = idle.back();
+                idle.pop_back();
+                return item;
+            }
+        }
+        std::unique_ptr<T> item = make(); // outside the lock, setting one up may be costly
+        std::lock_guard<std::mutex> lock(mutex);
+        items.push_back(std::move(item));
+        return items.back().get();
+    }
+
+    T *acquire()
+    {
+        return acquire([]
+                       { return std::unique_ptr<T>(new T()); });
+    }
+
+    void release(T *item)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        idle.push_back(item);
+    }
+
+    // every object made so far, for merging per-object results once the loop is done
+    const std::vector<std::unique_ptr<T>> &all() const { return items; }
+
+private:
+    std::mutex mutex;
+    std::vector<std::unique_ptr<T>> items;
+    std::vector<T *> idle;
+};
+
+template <typename Fn>
+void TaskScheduler::run_timed(const char *name, Fn &&fn)
+{
+    if (name == nullptr || !profiling_enabled.load(std::memory_order_relaxed))
+    {
+        fn();
+        return;
+    }
+    auto start = std::chrono::steady_clock::now();
+    fn();
+    auto stop = std::chrono::steady_clock::now();
+    record_timing(name, std::chrono::duration<double, std::milli>(stop - start).count());
+}
+
+template <typename Body>
+void TaskScheduler::parallel_for(int begin, int end, int grain, Body &&body,
+                                 TaskPriority priority, const char *name)
+{
+    if (end <= begin)
+        return;
+
+    int count = end - begin;
+    if (grain < 1)
+        grain = 1;
+
+    // keep a few chunks per thread so idle workers have something to steal,
+    // without flooding the queues when the caller picks a tiny grain
+    int max_chunks = thread_count() * 8;
+    int chunks = (count + grain - 1) / grain;
+    if (chunks > max_chunks)
+    {
+        grain = (count + max_chunks - 1) / max_chunks;
+        chunks = (count + grain - 1) / grain;
+    }
+
+    if (chunks == 1 || workers.empty() || compute_threads == 1)
+    {
+        run_timed(name, [&]
+                  { body(begin, end); });
+        return;
+    }
+
+    TaskGroup group(*this);
+    for (int c = 1; c < chunks; ++c)
+    {
+        int lo = begin + c * grain;
+        int hi = std::min(end, lo + grain);
+        group.run([&body, lo, hi]
+                  { body(lo, hi); },
+                  priority, name);
+    }
+
+    // the caller works on the first chunk instead of just waiting
+    run_timed(name, [&]
+              { body(begin, std::min(end, begin + grain)); });
+    group.wait();
+}
+
+template <typename T, typename Body, typename Combine>
+T TaskScheduler::parallel_reduce(int begin, int end, int grain, T identity, Body &&body, Combine &&combine,
+                                 TaskPriority priority, const char *name)
+{
+    if (end <= begin)
+        return identity;
+
+    if (grain < 1)
+        grain = 1;
+    int max_chunks = thread_count() * 8;
+    int count = end - begin;
+    int chunks = (count + grain - 1) / grain;
+    if (chunks > max_chunks)
+    {
+        grain = (count + max_chunks - 1) / max_chunks;
+        chunks = (count + grain - 1) / grain;
+    }
+
+    std::vector<T> partials(chunks, identity);
+    parallel_for(
+        0, chunks, 1, [&](int lo, int hi)
+        {
+            for (int c = lo; c < hi; ++c)
+            {
+                int first = begin + c * grain;
+                int last = std::min(end, first + grain);
+                partials[c] = body(first, last);
+            } },
+        priority, name);
+
+    T result = identity;
+    for (const T &p : partials)
+        result = combine(result, p);
+    return result;
+}
@@ -0,0 +1,697 @@
+#include "topology.h"
+#include "sparse_solver.h"
+#include "task_scheduler.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <numeric>
+#include <unordered_set>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+namespace
+{
+    // one member's column of B on the equilibrium rows: -e at its first node, +e at its second
+    struct Column
+    {
+        int a, b; // grid nodes, a < b
+        double length;
+        int rows[4]; // -1 where the component is supported
+        double coef[4];
+    };
+
+    struct Candidate
+    {
+        double violation; // largest virtual strain over its limit
+        long long key;    // a * grid nodes + b
+    };
+
+    // min c^T x, A x = b, x >= 0 with A = [B, -B] by Mehrotra's predictor-corrector method.
+    // The normal matrix B diag(d+ + d-) B^T keeps its pattern for a member set, so every
+    // iteration after the first reuses the solver's symbolic analysis.
+    class InteriorPoint
+    {
+    public:
+        InteriorPoint(int num_rows, const std::vector<Column> &columns, const Eigen::VectorXd &b,
+                      const Eigen::VectorXd &c, SparseSolver &solver)
+            : m(num_rows), n(static_cast<int>(columns.size())), columns(columns), b(b), c(c), solver(solver)
+        {
+            typedef Eigen::Triplet<double> Triplet;
+            std::vector<Triplet> triplets;
+            triplets.reserve(static_cast<size_t>(n) * 16 + m);
+            for (int r = 0; r < m; ++r)
+                triplets.emplace_back(r, r, 0.0);
+            for (const Column &col : columns)
+            {
+                for (int i = 0; i < 4; ++i)
+                {
+                    for (int j = 0; j < 4; ++j)
+                    {
+                        if (col.rows[i] >= 0 && col.rows[j] >= 0)
+                            triplets.emplace_back(col.rows[i], col.rows[j], 0.0);
+                    }
+                }
+            }
+            normal.resize(m, m);
+            normal.setFromTriplets(triplets.begin(), triplets.end());
+            normal.makeCompressed();
+
+            // where each column's outer product lands in the value array
+            auto position = [&](int row, int col)
+            {
+                const int *begin = normal.innerIndexPtr() + normal.outerIndexPtr()[col];
+                const int *end = normal.innerIndexPtr() + normal.outerIndexPtr()[col + 1];
+                return static_cast<int>(std::lower_bound(begin, end, row) - normal.innerIndexPtr());
+            };
+            diagonal.resize(m);
+            for (int r = 0; r < m; ++r)
+                diagonal[r] = position(r, r);
+            positions.assign(static_cast<size_t>(n) * 16, -1);
+            TaskScheduler::instance().parallel_for(
+                0, n, 1024, [&](int lo, int hi)
+                {
+                    for (int k = lo; k < hi; ++k)
+                    {
+                        const Column &col = columns[k];
+                        for (int i = 0; i < 4; ++i)
+                        {
+                            for (int j = 0; j < 4; ++j)
+                            {
+                                if (col.rows[i] >= 0 && col.rows[j] >= 0)
+                                    positions[static_cast<size_t>(k) * 16 + i * 4 + j] = position(col.rows[i], col.rows[j]);
+                            }
+                        }
+                    } },
+                TaskPriority::High, "topology_pattern");
+        }
+
+        Eigen::VectorXd x, y, s;
+        int iterations = 0;
+
+        // 0 once the relative primal and dual residuals and gap are below `tolerance` (or the
+        // best iterate is below 1e-5 when progress stalls), -1 if the LP is infeasible or
+        // unbounded (the iterates blow up)
+        int solve(double tolerance, int max_iterations)
+        {
+            Eigen::VectorXd rp, rd, rc, dx, dy, ds, d, dx_aff, ds_aff;
+
+            // Mehrotra's starting point: least-norm x and least-squares (y, s), shifted positive
+            d = Eigen::VectorXd::Ones(2 * n);
+            if (factor(d) != 0)
+                return -1;
+            x = apply_transpose(solver.solve(b));
+            y = solver.solve(apply(c));
+            s = c - apply_transpose(y);
+            double shift_x = std::max(-1.5 * x.minCoeff(), 0.0);
+            double shift_s = std::max(-1.5 * s.minCoeff(), 0.0);
+            x.array() += shift_x;
+            s.array() += shift_s;
+            double xs = x.dot(s);
+            x.array() += 0.5 * xs / std::max(s.sum(), 1e-300);
+            s.array() += 0.5 * xs / std::max(x.sum(), 1e-300);
+            double b_norm = b.norm(), c_norm = c.norm();
+
+            // the normal equations lose accuracy close to the optimum, so the best iterate is
+            // kept and accepted at a looser tolerance once progress stalls
+            Eigen::VectorXd best_x, best_y, best_s;
+            double best = HUGE_VAL;
+            int stalled = 0;
+            auto finish = [&]()
+            {
+                x = best_x;
+                y = best_y;
+                s = best_s;
+                return best <= std::max(tolerance, 1e-5) ? 0 : -1;
+            };
+            for (iterations = 0; iterations < max_iterations; ++iterations)
+            {
+                rp = b - apply(x);
+                rd = c - apply_transpose(y) - s;
+                double mu = x.dot(s) / (2.0 * n);
+                double primal = c.dot(x);
+                double error = std::max({rp.norm() / (1.0 + b_norm), rd.norm() / (1.0 + c_norm),
+                                         std::abs(primal - b.dot(y)) / (1.0 + std::abs(primal))});
+                if (error < best)
+                {
+                    best = error;
+                    best_x = x;
+                    best_y = y;
+                    best_s = s;
+                    stalled = 0;
+                }
+                else if (++stalled >= 5)
+                {
+                    return finish();
+                }
+                if (error <= tolerance)
+                    return 0;
+                if (!(x.lpNorm<Eigen::Infinity>() < 1e12 && y.lpNorm<Eigen::Infinity>() < 1e12))
+                    return finish();
+
+                d = x.cwiseQuotient(s);
+                if (factor(d) != 0)
+                    return finish();
+
+                // predictor (affine scaling), then the centred corrector
+                rc = -x.cwiseProduct(s);
+                direction(d, rp, rd, rc, dx_aff, dy, ds_aff);
+                double alpha_p = step(x, dx_aff), alpha_d = step(s, ds_aff);
+                double mu_aff = (x + alpha_p * dx_aff).dot(s + alpha_d * ds_aff) / (2.0 * n);
+                double sigma = std::pow(mu_aff / mu, 3.0);
+
+                rc = Eigen::VectorXd::Constant(2 * n, sigma * mu) - x.cwiseProduct(s) - dx_aff.cwiseProduct(ds_aff);
+                direction(d, rp, rd, rc, dx, dy, ds);
+                alpha_p = std::min(1.0, 0.995 * step(x, dx));
+                alpha_d = std::min(1.0, 0.995 * step(s, ds));
+                x += alpha_p * dx;
+                y += alpha_d * dy;
+                s += alpha_d * ds;
+            }
+            return finish();
+        }
+
+    private:
+        // B^T v per column (elongation of each member under nodal displacements v)
+        Eigen::VectorXd elongation(const Eigen::VectorXd &v) const
+        {
+            Eigen::VectorXd e(n);
+            TaskScheduler::instance().parallel_for(
+                0, n, 4096, [&](int lo, int hi)
+                {
+                    for (int k = lo; k < hi; ++k)
+                    {
+                        const Column &col = columns[k];
+                        double sum = 0.0;
+                        for (int i = 0; i < 4; ++i)
+                            sum += col.rows[i] >= 0 ? col.coef[i] * v(col.rows[i]) : 0.0;
+                        e(k) = sum;
+                    } },
+                TaskPriority::High, "topology_products");
+            return e;
+        }
+
+        Eigen::VectorXd apply(const Eigen::VectorXd &z) const
+        {
+            Eigen::VectorXd out = Eigen::VectorXd::Zero(m);
+            for (int k = 0; k < n; ++k)
+            {
+                const Column &col = columns[k];
+                double w = z(k) - z(n + k);
+                for (int i = 0; i < 4; ++i)
+                {
+                    if (col.rows[i] >= 0)
+                        out(col.rows[i]) += col.coef[i] * w;
+                }
+            }
+            return out;
+        }
+
+        Eigen::VectorXd apply_transpose(const Eigen::VectorXd &v) const
+        {
+            Eigen::VectorXd e = elongation(v);
+            Eigen::VectorXd out(2 * n);
+            out << e, -e;
+            return out;
+        }
+
+        // A D A^T with a small diagonal shift; the shift grows if the factorization fails
+        int factor(const Eigen::VectorXd &d)
+        {
+            double *values = normal.valuePtr();
+            std::fill(values, values + normal.nonZeros(), 0.0);
+            for (int k = 0; k < n; ++k)
+            {
+                const Column &col = columns[k];
+                double w = d(k) + d(n + k);
+                for (int i = 0; i < 4; ++i)
+                {
+                    for (int j = 0; j < 4; ++j)
+                    {
+                        int p = positions[static_cast<size_t>(k) * 16 + i * 4 + j];
+                        if (p >= 0)
+                            values[p] += w * col.coef[i] * col.coef[j];
+                    }
+                }
+            }
+            double largest = 0.0;
+            for (int r = 0; r < m; ++r)
+                largest = std::max(largest, values[diagonal[r]]);
+            double shift = 1e-14 * std::max(largest, 1e-30);
+            for (int attempt = 0; attempt < 6; ++attempt)
+            {
+                for (int r = 0; r < m; ++r)
+                    values[diagonal[r]] += shift;
+                if (solver.factorize(normal) == 0)
+                    return 0;
+                shift *= 100.0;
+            }
+            return -1;
+        }
+
+        void direction(const Eigen::VectorXd &d, const Eigen::VectorXd &rp, const Eigen::VectorXd &rd,
+                       const Eigen::VectorXd &rc, Eigen::VectorXd &dx, Eigen::VectorXd &dy, Eigen::VectorXd &ds) const
+        {
+            // the factor carries a diagonal shift and loses accuracy as x and s separate, so two
+            // steps of iterative refinement against the exact A D A^T
+            Eigen::VectorXd rhs = rp + apply(d.cwiseProduct(rd) - rc.cwiseQuotient(s));
+            dy = solver.solve(rhs);
+            for (int refine = 0; refine < 2; ++refine)
+                dy += solver.solve(rhs - apply(d.cwiseProduct(apply_transpose(dy))));
+            ds = rd - apply_transpose(dy);
+            dx = rc.cwiseQuotient(s) - d.cwiseProduct(ds);
+        }
+
+        // largest step keeping v + alpha dv >= 0
+        static double step(const Eigen::VectorXd &v, const Eigen::VectorXd &dv)
+        {
+            double alpha = 1.0;
+            for (int i = 0; i < v.size(); ++i)
+            {
+                if (dv(i) < 0.0)
+                    alpha = std::min(alpha, -v(i) / dv(i));
+            }
+            return alpha;
+        }
+
+        int m, n;
+        const std::vector<Column> &columns;
+        const Eigen::VectorXd &b;
+        const Eigen::VectorXd &c;
+        SparseSolver &solver;
+        SparseMatrix normal;
+        std::vector<int> diagonal;
+        std::vector<int> positions; // 16 per column
+    };
+
+    int gcd(int a, int b)
+    {
+        while (b != 0)
+        {
+            int t = a % b;
+            a = b;
+            b = t;
+        }
+        return a;
+    }
+
+    // how much of a support a constraint is, to merge several onto one grid node
+    int restraint(ConstraintType type)
+    {
+        switch (type)
+        {
+        case Fixed:
+            return 3;
+        case FixedPin:
+            return 2;
+        case Slider:
+            return 1;
+        case Free:
+            break;
+        }
+        return 0;
+    }
+} // namespace
+
+int optimize_topology(const std::vector<Node> &nodes,
+                      const Eigen::VectorXd &forces,
+                      const TopologyOptions &options,
+                      TopologyResults &out)
+{
+    out = TopologyResults();
+    int num_nodes = static_cast<int>(nodes.size());
+    if (num_nodes == 0 || forces.size() < num_nodes * 3 || options.divisions_x < 1 || options.divisions_y < 1 || options.max_rounds < 1 ||
+        !(options.tension_limit > 0.0) || !(options.compression_limit > 0.0))
+        return -1;
+
+    auto start = std::chrono::steady_clock::now();
+
+    // the design grid over the model's bounding box
+    double x_min = nodes[0].position[0], x_max = x_min, y_min = nodes[0].position[1], y_max = y_min;
+    for (const Node &node : nodes)
+    {
+        x_min = std::min(x_min, static_cast<double>(node.position[0]));
+        x_max = std::max(x_max, static_cast<double>(node.position[0]));
+        y_min = std::min(y_min, static_cast<double>(node.position[1]));
+        y_max = std::max(y_max, static_cast<double>(node.position[1]));
+    }
+    double width = x_max - x_min, height = y_max - y_min;
+    if (!(width > 1e-9) || !(height > 1e-9))
+        return -1;
+    int nx = options.divisions_x, ny = options.divisions_y;
+    int grid = (nx + 1) * (ny + 1);
+    double hx = width / nx, hy = height / ny;
+    out.grid_nodes = grid;
+    auto column_of = [&](int g)
+    { return g % (nx + 1); };
+    auto row_of = [&](int g)
+    { return g / (nx + 1); };
+
+    // supports and loads snapped to their nearest grid node
+    std::vector<ConstraintType> support(grid, Free);
+    std::vector<float> support_angle(grid, 0.0f);
+    std::vector<double> load(grid * 2, 0.0);
+    double largest_load = 0.0;
+    bool supported = false;
+    for (int i = 0; i < num_nodes; ++i)
+    {
+        int gi = std::min(std::max(static_cast<int>(std::lround((nodes[i].position[0] - x_min) / hx)), 0), nx);
+        int gj = std::min(std::max(static_cast<int>(std::lround((nodes[i].position[1] - y_min) / hy)), 0), ny);
+        int g = gj * (nx + 1) + gi;
+        if (restraint(nodes[i].constraint_type) > restraint(support[g]))
+        {
+            support[g] = nodes[i].constraint_type;
+            support_angle[g] = nodes[i].constraint_angle;
+        }
+        supported |= nodes[i].constraint_type != Free;
+        load[g * 2] += forces(i * 3);
+        load[g * 2 + 1] += forces(i * 3 + 1);
+    }
+    for (double f : load)
+        largest_load = std::max(largest_load, std::abs(f));
+    if (!supported || !(largest_load > 0.0))
+        return -1;
+
+    // equilibrium rows: two per free node, one along a slider's track, none at a fixed node
+    std::vector<int> row(grid * 2, -1);
+    std::vector<double> row_scale(grid * 2, 0.0);
+    int num_rows = 0;
+    for (int g = 0; g < grid; ++g)
+    {
+        if (support[g] == Free)
+        {
+            row[g * 2] = num_rows++;
+            row[g * 2 + 1] = num_rows++;
+            row_scale[g * 2] = row_scale[g * 2 + 1] = 1.0;
+        }
+        else if (support[g] == Slider)
+        {
+            double theta = support_angle[g] * M_PI / 180.0;
+            row[g * 2] = row[g * 2 + 1] = num_rows++;
+            row_scale[g * 2] = std::cos(theta);
+            row_scale[g * 2 + 1] = std::sin(theta);
+        }
+    }
+
+    // scaled so loads, lengths and costs are all of order one
+    double reference_length = std::max(width, height);
+    double compression_cost = options.tension_limit / options.compression_limit;
+    Eigen::VectorXd b = Eigen::VectorXd::Zero(num_rows);
+    for (int k = 0; k < grid * 2; ++k)
+    {
+        if (row[k] >= 0)
+            b(row[k]) += row_scale[k] * load[k] / largest_load;
+    }
+
+    auto make_column = [&](int a, int c, Column &col)
+    {
+        double dx = (column_of(c) - column_of(a)) * hx;
+        double dy = (row_of(c) - row_of(a)) * hy;
+        col.a = a;
+        col.b = c;
+        col.length = std::sqrt(dx * dx + dy * dy);
+        double e[4] = {-dx / col.length, -dy / col.length, dx / col.length, dy / col.length};
+        int comps[4] = {a * 2, a * 2 + 1, c * 2, c * 2 + 1};
+        for (int i = 0; i < 4; ++i)
+        {
+            col.rows[i] = row[comps[i]];
+            col.coef[i] = col.rows[i] >= 0 ? row_scale[comps[i]] * e[i] : 0.0;
+        }
+    };
+    // a candidate overlapping a shorter one (through another grid node) is never needed
+    auto admissible = [&](int a, int c)
+    {
+        int di = std::abs(column_of(c) - column_of(a));
+        int dj = std::abs(row_of(c) - row_of(a));
+        if (gcd(di, dj) != 1)
+            return false;
+        if (options.max_length > 0.0 && std::hypot(di * hx, dj * hy) > options.max_length * (1.0 + 1e-9))
+            return di + dj == 1; // neighbours stay so the grid is always connected
+        return true;
+    };
+
+    // start from the nearest-neighbour ground structure
+    std::vector<Column> columns;
+    std::unordered_set<long long> in_lp;
+    auto add = [&](int a, int c)
+    {
+        long long key = static_cast<long long>(a) * grid + c;
+        if (!in_lp.insert(key).second)
+            return;
+        Column col;
+        make_column(a, c, col);
+        if (col.rows[0] < 0 && col.rows[1] < 0 && col.rows[2] < 0 && col.rows[3] < 0)
+            return; // between two fixed nodes
+        columns.push_back(col);
+    };
+    for (int g = 0; g < grid; ++g)
+    {
+        int i = column_of(g), j = row_of(g);
+        if (i < nx)
+            add(g, g + 1);
+        if (j < ny)
+            add(g, g + nx + 1);
+        if (i < nx && j < ny && admissible(g, g + nx + 2))
+            add(g, g + nx + 2);
+        if (i > 0 && j < ny && admissible(g + nx, g))
+            add(g, g + nx);
+    }
+
+    auto costs = [&](const std::vector<Column> &set)
+    {
+        int n = static_cast<int>(set.size());
+        Eigen::VectorXd c(2 * n);
+        for (int k = 0; k < n; ++k)
+        {
+            c(k) = set[k].length / reference_length;
+            c(n + k) = c(k) * compression_cost;
+        }
+        return c;
+    };
+
+    // early rounds only need rough duals to pick members; the member set is confirmed with
+    // a tight solve before it is accepted
+    SparseSolver solver;
+    Eigen::VectorXd c, x;
+    int result = 1;
+    bool precise = false;
+    for (int round = 0; round < options.max_rounds; ++round)
+    {
+        int n = static_cast<int>(columns.size());
+        c = costs(columns);
+        InteriorPoint lp(num_rows, columns, b, c, solver);
+        if (lp.solve(precise ? 1e-8 : 1e-3, 200) != 0)
+            return -2;
+        x = lp.x;
+
+        TopologyRound step;
+        step.volume = c.dot(x) * reference_length * largest_load / options.tension_limit;
+        step.members = n;
+        step.iterations = lp.iterations;
+        out.history.push_back(step);
+
+        // the duals are virtual displacements: check every member of the full ground structure
+        // against its virtual strain limit, generated on the fly a row of start nodes at a time
+        const Eigen::VectorXd &u = lp.y;
+        size_t cap = std::max<size_t>(static_cast<size_t>(options.add_fraction * n), 64);
+        struct Partial
+        {
+            std::vector<Candidate> list;
+            long long potential = 0;
+        };
+        auto keep_worst = [cap](std::vector<Candidate> &list)
+        {
+            if (list.size() <= cap)
+                return;
+            std::nth_element(list.begin(), list.begin() + cap, list.end(), [](const Candidate &p, const Candidate &q)
+                             { return p.violation > q.violation || (p.violation == q.violation && p.key < q.key); });
+            list.resize(cap);
+        };
+        Partial scan = TaskScheduler::instance().parallel_reduce(
+            0, grid, 1, Partial(),
+            [&](int lo, int hi)
+            {
+                Partial part;
+                Column col;
+                for (int a = lo; a < hi; ++a)
+                {
+                    for (int other = a + 1; other < grid; ++other)
+                    {
+                        if (!admissible(a, other))
+                            continue;
+                        ++part.potential;
+                        make_column(a, other, col);
+                        double elongation = 0.0;
+                        for (int i = 0; i < 4; ++i)
+                            elongation += col.rows[i] >= 0 ? col.coef[i] * u(col.rows[i]) : 0.0;
+                        double limit = col.length / reference_length;
+                        double violation = std::max(elongation / limit, -elongation / (limit * compression_cost));
+                        if (violation > 1.0 + options.tolerance)
+                            part.list.push_back({violation, static_cast<long long>(a) * grid + other});
+                    }
+                    keep_worst(part.list);
+                }
+                return part;
+            },
+            [&](Partial p, Partial q)
+            {
+                p.list.insert(p.list.end(), q.list.begin(), q.list.end());
+                p.potential += q.potential;
+                keep_worst(p.list);
+                return p;
+            },
+            TaskPriority::High, "topology_candidates");
+        out.potential_members = scan.potential;
+
+        std::sort(scan.list.begin(), scan.list.end(), [](const Candidate &p, const Candidate &q)
+                  { return p.violation > q.violation || (p.violation == q.violation && p.key < q.key); });
+        size_t before = columns.size();
+        for (const Candidate &candidate : scan.list)
+            add(static_cast<int>(candidate.key / grid), static_cast<int>(candidate.key % grid));
+        out.history.back().added = static_cast<int>(columns.size() - before);
+        if (columns.size() == before)
+        {
+            if (precise)
+            {
+                result = 0;
+                break;
+            }
+            precise = true;
+        }
+    }
+    out.converged = result == 0;
+
+    // members of the last LP, thin ones dropped
+    int n = static_cast<int>(out.history.back().members);
+    struct Bar
+    {
+        int a, b;
+        double force, area;
+        bool alive;
+    };
+    std::vector<Bar> bars;
+    double thickest = 0.0;
+    for (int k = 0; k < n; ++k)
+    {
+        double tension = x(k) * largest_load, compression = x(n + k) * largest_load;
+        double area = tension / options.tension_limit + compression / options.compression_limit;
+        bars.push_back({columns[k].a, columns[k].b, tension - compression, area, true});
+        thickest = std::max(thickest, area);
+    }
+    for (Bar &bar : bars)
+        bar.alive = bar.area >= options.area_cutoff * thickest;
+
+    // the interior point optimum spreads a little force over members that do not belong to the
+    // layout, so the kept members are re-solved on their own to balance the loads exactly
+    std::vector<Column> kept;
+    std::vector<int> kept_bar;
+    for (int k = 0; k < n; ++k)
+    {
+        if (!bars[k].alive)
+            continue;
+        kept.push_back(columns[k]);
+        kept_bar.push_back(k);
+    }
+    Eigen::VectorXd kept_cost = costs(kept);
+    InteriorPoint cleanup(num_rows, kept, b, kept_cost, solver);
+    if (!kept.empty() && cleanup.solve(1e-8, 200) == 0)
+    {
+        int m = static_cast<int>(kept.size());
+        thickest = 0.0;
+        for (int j = 0; j < m; ++j)
+        {
+            Bar &bar = bars[kept_bar[j]];
+            double tension = cleanup.x(j) * largest_load, compression = cleanup.x(m + j) * largest_load;
+            bar.force = tension - compression;
+            bar.area = tension / options.tension_limit + compression / options.compression_limit;
+            thickest = std::max(thickest, bar.area);
+        }
+        for (int k : kept_bar)
+            bars[k].alive = bars[k].area >= options.area_cutoff * thickest;
+    }
+
+    // merge collinear chains through unloaded, unsupported nodes, drop dangling members there
+    std::vector<std::vector<int>> at(grid);
+    for (int k = 0; k < static_cast<int>(bars.size()); ++k)
+    {
+        if (!bars[k].alive)
+            continue;
+        at[bars[k].a].push_back(k);
+        at[bars[k].b].push_back(k);
+    }
+    auto pinned = [&](int g)
+    { return support[g] != Free || load[g * 2] != 0.0 || load[g * 2 + 1] != 0.0; };
+    auto detach = [&](int g, int k)
+    { at[g].erase(std::find(at[g].begin(), at[g].end(), k)); };
+    std::vector<int> work(grid);
+    std::iota(work.begin(), work.end(), 0);
+    while (!work.empty())
+    {
+        int g = work.back();
+        work.pop_back();
+        if (pinned(g))
+            continue;
+        if (at[g].size() == 1)
+        {
+            int k = at[g][0];
+            int other = bars[k].a == g ? bars[k].b : bars[k].a;
+            bars[k].alive = false;
+            at[g].clear();
+            detach(other, k);
+            work.push_back(other);
+        }
+        else if (at[g].size() == 2)
+        {
+            int k1 = at[g][0], k2 = at[g][1];
+            int p = bars[k1].a == g ? bars[k1].b : bars[k1].a;
+            int q = bars[k2].a == g ? bars[k2].b : bars[k2].a;
+            double ux = (column_of(p) - column_of(g)) * hx, uy = (row_of(p) - row_of(g)) * hy;
+            double vx = (column_of(q) - column_of(g)) * hx, vy = (row_of(q) - row_of(g)) * hy;
+            if (ux * vx + uy * vy > -(1.0 - 1e-9) * std::hypot(ux, uy) * std::hypot(vx, vy))
+                continue;
+            bars[k1].alive = bars[k2].alive = false;
+            at[g].clear();
+            detach(p, k1);
+            detach(q, k2);
+            bars.push_back({std::min(p, q), std::max(p, q), 0.5 * (bars[k1].force + bars[k2].force),
+                            std::max(bars[k1].area, bars[k2].area), true});
+            int k = static_cast<int>(bars.size()) - 1;
+            at[p].push_back(k);
+            at[q].push_back(k);
+            work.push_back(p);
+            work.push_back(q);
+        }
+    }
+
+    // layout nodes are the grid nodes still reached by a member
+    std::vector<int> index(grid, -1);
+    for (int g = 0; g < grid; ++g)
+    {
+        if (at[g].empty())
+            continue;
+        index[g] = static_cast<int>(out.nodes.size());
+        out.nodes.emplace_back(static_cast<float>(x_min + column_of(g) * hx), static_cast<float>(y_min + row_of(g) * hy),
+                               support[g], support_angle[g]);
+    }
+    out.forces = Eigen::VectorXd::Zero(out.nodes.size() * 3);
+    for (int g = 0; g < grid; ++g)
+    {
+        if (index[g] < 0)
+            continue;
+        out.forces(index[g] * 3) = load[g * 2];
+        out.forces(index[g] * 3 + 1) = load[g * 2 + 1];
+    }
+    for (const Bar &bar : bars)
+    {
+        if (!bar.alive)
+            continue;
+        out.member_nodes.push_back(index[bar.a]);
+        out.member_nodes.push_back(index[bar.b]);
+        out.member_force.push_back(bar.force);
+        out.member_area.push_back(bar.area);
+    }
+    out.volume = out.history.back().volume;
+    out.wall_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return result;
+}
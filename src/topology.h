@@ -0,0 +1,57 @@
+#pragma once
+#include <vector>
+#include <Eigen/Eigen>
+#include "node.h"
+
+struct TopologyOptions
+{
+    int divisions_x = 24;            // grid over the bounding box of the model's nodes
+    int divisions_y = 12;
+    double tension_limit = 165e6;    // Pa
+    double compression_limit = 165e6;
+    double max_length = 0.0;         // m, longest candidate member (0: no limit)
+    double add_fraction = 0.1;       // members added per round, as a fraction of those in the LP
+    int max_rounds = 50;
+    double tolerance = 1e-4;         // virtual strain over the limit that still adds a member
+    double area_cutoff = 1e-3;       // members thinner than this fraction of the thickest are dropped
+};
+
+struct TopologyRound
+{
+    double volume = 0.0; // m^3, optimum over the members in the LP
+    int members = 0;     // in the LP
+    int added = 0;       // violating candidates added for the next round
+    int iterations = 0;  // interior point iterations
+};
+
+// The optimal layout, as pin-jointed members between the grid nodes that carry force.
+// Collinear chains through unloaded, unsupported nodes are merged into single members.
+struct TopologyResults
+{
+    std::vector<Node> nodes;          // layout nodes, supports copied from the model
+    Eigen::VectorXd forces;           // 3 per layout node, like FEMSystem::forces
+    std::vector<int> member_nodes;    // 2 per member, into nodes
+    std::vector<double> member_force; // N, tension positive
+    std::vector<double> member_area;  // m^2, at the stress limits
+    std::vector<TopologyRound> history;
+    double volume = 0.0;              // m^3 of the LP optimum
+    int grid_nodes = 0;
+    long long potential_members = 0;  // in the full ground structure (never stored)
+    bool converged = false;           // no candidate violates its virtual strain limit
+    double wall_seconds = 0.0;
+};
+
+// Minimum-volume plastic truss layout carrying `forces` (3 per model node) to the model's
+// supports, on a grid of divisions_x x divisions_y cells over the bounding box of all of the
+// model's nodes (supports and loads each snapped to their nearest grid node). The LP
+//     min sum l (q+ / tension_limit + q- / compression_limit),  B (q+ - q-) = f,  q+, q- >= 0
+// is solved by a primal-dual interior point method on the sparse normal equations, starting
+// from the nearest-neighbour members. Its duals are virtual displacements: every member of the
+// full ground structure is generated on the fly and checked in parallel, and the most violated
+// are added until none is (member adding). Node moments are ignored.
+// Returns 0 on success, 1 if max_rounds ran out (the layout is the last round's), -1 without
+// loads, supports or a two-dimensional domain, -2 if no layout can carry the loads.
+int optimize_topology(const std::vector<Node> &nodes,
+                      const Eigen::VectorXd &forces,
+                      const TopologyOptions &options,
+                      TopologyResults &out);
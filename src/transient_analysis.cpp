@@ -0,0 +1,157 @@
+#include "transient_analysis.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+double LoadHistory::factor(double t) const
+{
+    if (t < 0.0)
+        return 0.0;
+
+    switch (type)
+    {
+    case Step:
+        return amplitude;
+    case Ramp:
+        return duration > 0.0 ? amplitude * std::min(t / duration, 1.0) : amplitude;
+    case Harmonic:
+        return amplitude * std::sin(2.0 * M_PI * frequency * t);
+    case Pulse:
+        return (t < duration) ? amplitude * std::sin(M_PI * t / duration) : 0.0;
+    case Table:
+    {
+        if (table.empty())
+            return 0.0;
+        if (t <= table.front()(0))
+            return amplitude * table.front()(1);
+        for (size_t i = 1; i < table.size(); ++i)
+        {
+            if (t <= table[i](0))
+            {
+                double span = table[i](0) - table[i - 1](0);
+                double w = span > 0.0 ? (t - table[i - 1](0)) / span : 1.0;
+                return amplitude * ((1.0 - w) * table[i - 1](1) + w * table[i](1));
+            }
+        }
+        return amplitude * table.back()(1);
+    }
+    }
+    return 0.0;
+}
+
+void rayleigh_coefficients(double zeta, double omega1, double omega2, double &mass_coeff, double &stiffness_coeff)
+{
+    double sum = omega1 + omega2;
+    if (sum <= 0.0)
+    {
+        mass_coeff = 0.0;
+        stiffness_coeff = 0.0;
+        return;
+    }
+    mass_coeff = 2.0 * zeta * omega1 * omega2 / sum;
+    stiffness_coeff = 2.0 * zeta / sum;
+}
+
+int integrate_transient(const DofMap &map,
+                        const SparseMatrix &K,
+                        const SparseMatrix &M,
+                        const Eigen::VectorXd &forces,
+                        const TransientOptions &options,
+                        SparseSolver &solver,
+                        TransientResults &out)
+{
+    out = TransientResults();
+    int n = map.num_reduced;
+    if (n == 0 || options.time_step <= 0.0 || options.duration <= 0.0)
+        return -3;
+
+    auto start = std::chrono::steady_clock::now();
+
+    double alpha = std::min(std::max(options.hht_alpha, -1.0 / 3.0), 0.0);
+    double gamma = 0.5 - alpha;
+    double beta = 0.25 * (1.0 - alpha) * (1.0 - alpha);
+    double dt = options.time_step;
+    double c_mass = options.rayleigh_mass;
+    double c_stiff = options.rayleigh_stiffness;
+
+    int steps = static_cast<int>(std::ceil(options.duration / dt - 1e-9));
+    int max_frames = std::max(options.max_frames, 2);
+    int store_every = std::max(1, (steps + max_frames - 2) / (max_frames - 1));
+    int num_frames = steps / store_every + 1;
+
+    out.time_step = dt;
+    out.steps = steps;
+    out.store_every = store_every;
+    out.times.reserve(num_frames);
+    out.frames.resize(map.total_dof, num_frames);
+    out.peak_translation.reserve(num_frames);
+
+    // with C = c_mass M + c_stiff K, the effective stiffness and every right-hand side only
+    // need M and K
+    double m_acc = 1.0 / (beta * dt * dt);
+    double c_vel = (1.0 + alpha) * gamma / (beta * dt);
+    SparseMatrix K_eff = (m_acc + c_vel * c_mass) * M + (1.0 + alpha + c_vel * c_stiff) * K;
+    if (solver.factorize(K_eff) != 0)
+        return -1;
+
+    Eigen::VectorXd F_r = map.restrict(forces);
+    Eigen::VectorXd u = Eigen::VectorXd::Zero(n);
+    Eigen::VectorXd v = Eigen::VectorXd::Zero(n);
+    Eigen::VectorXd a = Eigen::VectorXd::Zero(n);
+
+    // from rest, so M a0 = F(0); a sudden load needs the initial acceleration (massless DOFs
+    // make M singular, in which case the start is taken at zero acceleration)
+    double f0 = options.load.factor(0.0);
+    if (f0 != 0.0)
+    {
+        SparseSolver mass_solver;
+        if (mass_solver.factorize(M) == 0)
+            a = mass_solver.solve(f0 * F_r);
+    }
+
+    Eigen::VectorXd global;
+    auto store = [&](double t)
+    {
+        map.expand(u, global);
+        int frame = static_cast<int>(out.times.size());
+        out.frames.col(frame) = global.cast<float>();
+        out.times.push_back(t);
+
+        double peak = 0.0;
+        for (int i = 0; i < map.total_dof / 3; ++i)
+            peak = std::max(peak, global(i * 3) * global(i * 3) + global(i * 3 + 1) * global(i * 3 + 1));
+        out.peak_translation.push_back(static_cast<float>(std::sqrt(peak)));
+    };
+    store(0.0);
+
+    Eigen::VectorXd u_pred(n), v_pred(n), w(n), rhs(n);
+    for (int step = 1; step <= steps; ++step)
+    {
+        double t = step * dt;
+
+        // Newmark predictors from the last state
+        u_pred = u + dt * v + (dt * dt * (0.5 - beta)) * a;
+        v_pred = v + (dt * (1.0 - gamma)) * a;
+
+        // HHT: M a1 + (1 + alpha)(C v1 + K u1) - alpha (C v0 + K u0) = F(t1 + alpha dt)
+        w = (gamma / (beta * dt)) * u_pred - v_pred;
+        rhs = options.load.factor(t + alpha * dt) * F_r;
+        rhs.noalias() += M * (m_acc * u_pred + ((1.0 + alpha) * c_mass) * w + (alpha * c_mass) * v);
+        rhs.noalias() += K * (((1.0 + alpha) * c_stiff) * w + (alpha * c_stiff) * v + alpha * u);
+
+        u = solver.solve(rhs);
+        a = m_acc * (u - u_pred);
+        v = v_pred + (gamma * dt) * a;
+
+        if (step % store_every == 0)
+            store(t);
+    }
+
+    out.frames.conservativeResize(Eigen::NoChange, static_cast<Eigen::Index>(out.times.size()));
+    out.wall_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return 0;
+}
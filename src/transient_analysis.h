@@ -0,0 +1,65 @@
+#pragma once
+#include <vector>
+#include <Eigen/Eigen>
+#include "dof_map.h"
+#include "sparse_solver.h"
+
+// Time variation of the applied loads: F(t) = forces * factor(t)
+struct LoadHistory
+{
+    enum Type
+    {
+        Step,     // amplitude from t = 0 on
+        Ramp,     // linear from 0 to amplitude over `duration`, then held
+        Harmonic, // amplitude * sin(2 pi frequency t)
+        Pulse,    // half-sine of length `duration`, then zero
+        Table     // piecewise linear through `table`, held after the last point
+    };
+
+    Type type = Step;
+    double amplitude = 1.0;
+    double frequency = 1.0; // Hz (Harmonic)
+    double duration = 0.1;  // s (Ramp rise time, Pulse length)
+    std::vector<Eigen::Vector2d> table; // (t, factor) points in increasing t
+
+    double factor(double t) const;
+};
+
+struct TransientOptions
+{
+    double time_step = 1e-3; // s, fixed
+    double duration = 1.0;   // s
+    double hht_alpha = 0.0;  // in [-1/3, 0]; 0 is Newmark average acceleration, < 0 damps high modes
+    double rayleigh_mass = 0.0;      // C = rayleigh_mass * M + rayleigh_stiffness * K
+    double rayleigh_stiffness = 0.0;
+    bool lumped_mass = false;
+    int max_frames = 400; // stored frames are spread evenly over the run
+    LoadHistory load;
+};
+
+struct TransientResults
+{
+    double time_step = 0.0;
+    int steps = 0;
+    int store_every = 1;         // steps between stored frames
+    std::vector<double> times;   // of the stored frames
+    Eigen::MatrixXf frames;      // total_dof x stored frames, global displacements (floats keep it compact)
+    std::vector<float> peak_translation; // largest nodal translation of each stored frame
+    double wall_seconds = 0.0;   // time spent marching (factorization included)
+};
+
+// Rayleigh coefficients giving damping ratio `zeta` at the circular frequencies omega1 and omega2
+void rayleigh_coefficients(double zeta, double omega1, double omega2, double &mass_coeff, double &stiffness_coeff);
+
+// HHT-alpha integration of M a + C v + K u = F(t) from rest on the reduced equations of `map`.
+// The time step is fixed, so the effective stiffness M / (beta dt^2) + (1 + alpha) gamma /
+// (beta dt) C + (1 + alpha) K is factored once with `solver` and every step is a few sparse
+// matrix-vector products plus one pair of triangular solves. Unconditionally stable.
+// Returns 0 on success, -1 if the effective stiffness could not be factored, -3 for bad options.
+int integrate_transient(const DofMap &map,
+                        const SparseMatrix &K,
+                        const SparseMatrix &M,
+                        const Eigen::VectorXd &forces,
+                        const TransientOptions &options,
+                        SparseSolver &solver,
+                        TransientResults &out);